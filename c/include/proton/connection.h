@@ -490,6 +490,34 @@ PN_EXTERN pn_data_t *pn_connection_remote_properties(pn_connection_t *connection
  */
 PN_EXTERN pn_transport_t *pn_connection_transport(pn_connection_t *connection);
 
+/**
+ * **Unsettled API** - Counters for the traffic on a connection.
+ *
+ * The counters are kept by the transport and start from zero when it
+ * is created. Bytes are delivery payload bytes, not including framing.
+ */
+typedef struct pn_connection_stats_t {
+  uint64_t deliveries_sent;     /**< Complete deliveries sent */
+  uint64_t deliveries_received; /**< Complete deliveries received */
+  uint64_t bytes_sent;          /**< Delivery payload bytes sent */
+  uint64_t bytes_received;      /**< Delivery payload bytes received */
+  uint64_t frames_output;       /**< AMQP frames sent */
+  uint64_t frames_input;        /**< AMQP frames received */
+  uint64_t dispositions_output; /**< DISPOSITION frames sent */
+  uint64_t dispositions_input;  /**< DISPOSITION frames received */
+  uint64_t window_blocked;      /**< Milliseconds sessions had transfers held back by the peer's incoming window */
+} pn_connection_stats_t;
+
+/**
+ * **Unsettled API** - Get a snapshot of the counters for a connection.
+ *
+ * The counters are cheap to maintain and always enabled.
+ *
+ * @param[in] connection the connection object
+ * @return the counters, all zero if the connection is unbound
+ */
+PN_EXTERN pn_connection_stats_t pn_connection_stats(pn_connection_t *connection);
+
 /**
  * @}
  */
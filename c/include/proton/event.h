@@ -414,6 +414,28 @@ PN_EXTERN pn_event_t *pn_collector_put(pn_collector_t *collector,
                                        const pn_class_t *clazz, void *context,
                                        pn_event_type_t type);
 
+/**
+ * **Unsettled API** - Enable or disable event coalescing.
+ *
+ * By default ::pn_collector_put() only elides an event that is
+ * identical to the last event in the collector. With coalescing
+ * enabled, a ::PN_DELIVERY, ::PN_LINK_FLOW or ::PN_TRANSPORT event is
+ * also elided if an event of the same type and context is waiting
+ * anywhere in the collector. The check takes constant time.
+ *
+ * These events tell the handler to look at the current state of
+ * their context, so a handler sees the effect of all the elided
+ * events when it handles the one that was kept. The kept event is
+ * delivered in the position of the first of them.
+ *
+ * Enabling coalescing also pre-allocates a pool of events for the
+ * collector to use.
+ *
+ * @param[in] collector a collector object
+ * @param[in] coalesce true to coalesce events, false to restore the default
+ */
+PN_EXTERN void pn_collector_coalesce(pn_collector_t *collector, bool coalesce);
+
 /**
  * Access the head event contained by a collector.
  *
@@ -0,0 +1,119 @@
+#ifndef PROTON_HISTOGRAM_H
+#define PROTON_HISTOGRAM_H 1
+
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <proton/import_export.h>
+#include <proton/type_compat.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ *
+ * @copybrief pn_histogram_t
+ *
+ * @addtogroup link
+ * @{
+ */
+
+/**
+ * **Unsettled API** - A histogram of values, usually latencies in
+ * microseconds.
+ *
+ * Values are counted in log-linear buckets: each power of two is split
+ * into 8 equal buckets, so a value read back from the histogram is
+ * within 12.5% of the recorded one. Values of 2^36 (about 19 hours in
+ * microseconds) or more are counted as the largest bucket.
+ *
+ * @see pn_link_latency(), pn_proactor_stats_distribution()
+ */
+typedef struct pn_histogram_t pn_histogram_t;
+
+/**
+ * **Unsettled API** - Create an empty histogram. Must be freed with
+ * pn_histogram_free().
+ *
+ * @return the histogram or NULL if out of memory
+ */
+PN_EXTERN pn_histogram_t *pn_histogram(void);
+
+/**
+ * **Unsettled API** - Free a histogram created by pn_histogram().
+ */
+PN_EXTERN void pn_histogram_free(pn_histogram_t *histogram);
+
+/**
+ * **Unsettled API** - Record a value.
+ */
+PN_EXTERN void pn_histogram_record(pn_histogram_t *histogram, uint64_t value);
+
+/**
+ * **Unsettled API** - Add all the values recorded in @p source to
+ * @p histogram.
+ */
+PN_EXTERN void pn_histogram_add(pn_histogram_t *histogram, const pn_histogram_t *source);
+
+/**
+ * **Unsettled API** - The number of values recorded.
+ */
+PN_EXTERN uint64_t pn_histogram_count(const pn_histogram_t *histogram);
+
+/**
+ * **Unsettled API** - The smallest value recorded, 0 if there are none.
+ */
+PN_EXTERN uint64_t pn_histogram_min(const pn_histogram_t *histogram);
+
+/**
+ * **Unsettled API** - The largest value recorded, 0 if there are none.
+ */
+PN_EXTERN uint64_t pn_histogram_max(const pn_histogram_t *histogram);
+
+/**
+ * **Unsettled API** - The mean of the values recorded, 0 if there are none.
+ */
+PN_EXTERN double pn_histogram_mean(const pn_histogram_t *histogram);
+
+/**
+ * **Unsettled API** - The value at a percentile.
+ *
+ * @param[in] histogram a histogram
+ * @param[in] percentile between 0 and 100
+ * @return the highest value in the bucket holding the percentile,
+ * limited by pn_histogram_max(). 0 if there are no values.
+ */
+PN_EXTERN uint64_t pn_histogram_percentile(const pn_histogram_t *histogram, double percentile);
+
+/**
+ * **Unsettled API** - Discard all recorded values.
+ */
+PN_EXTERN void pn_histogram_clear(pn_histogram_t *histogram);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* histogram.h */
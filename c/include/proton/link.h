@@ -25,6 +25,8 @@
 #include <proton/import_export.h>
 #include <proton/type_compat.h>
 #include <proton/condition.h>
+#include <proton/histogram.h>
+#include <proton/shared_bytes.h>
 #include <proton/terminus.h>
 #include <proton/types.h>
 #include <proton/object.h>
@@ -583,6 +585,20 @@ PN_EXTERN void pn_link_offered(pn_link_t *sender, int credit);
  */
 PN_EXTERN ssize_t pn_link_send(pn_link_t *sender, const char *bytes, size_t n);
 
+/**
+ * **Unsettled API** - Send shared message data for the current delivery
+ * on a link without copying it.
+ *
+ * The delivery holds a reference to @p shared until its bytes have been
+ * written to the transport, the caller keeps its own reference. It can
+ * be mixed with pn_link_send() on the same delivery.
+ *
+ * @param[in] sender a sender link object
+ * @param[in] shared the message data
+ * @return the number of bytes sent, or an error code
+ */
+PN_EXTERN ssize_t pn_link_send_shared(pn_link_t *sender, pn_shared_bytes_t *shared);
+
 /**
  * Grant credit for incoming deliveries on a receiver.
  *
@@ -677,6 +693,76 @@ PN_EXTERN void pn_link_set_max_message_size(pn_link_t *link, uint64_t size);
  */
 PN_EXTERN uint64_t pn_link_remote_max_message_size(pn_link_t *link);
 
+/**
+ * **Unsettled API** - Counters for the traffic on a link.
+ */
+typedef struct pn_link_stats_t {
+  uint64_t deliveries;          /**< Complete deliveries sent (sender) or received (receiver) */
+  uint64_t bytes;               /**< Delivery payload bytes sent or received */
+  uint64_t settled;             /**< Deliveries settled locally */
+  uint64_t credit_blocked;      /**< Milliseconds a sender had data to send but no credit */
+} pn_link_stats_t;
+
+/**
+ * **Unsettled API** - Get a snapshot of the counters for a link.
+ *
+ * The counters are cheap to maintain and always enabled.
+ *
+ * @param[in] link a link object
+ * @return the counters for the link
+ */
+PN_EXTERN pn_link_stats_t pn_link_stats(pn_link_t *link);
+
+/**
+ * **Unsettled API** - The stages of a sent delivery measured when
+ * latency tracking is enabled on its link.
+ *
+ * @see pn_link_set_latency_tracking()
+ */
+typedef enum {
+  PN_LATENCY_QUEUED,    /**< First pn_link_send() to the last TRANSFER frame being generated */
+  PN_LATENCY_WRITTEN,   /**< Last TRANSFER frame generated to its bytes being popped from the transport */
+  PN_LATENCY_SETTLED,   /**< Bytes popped from the transport to the peer settling the delivery */
+  PN_LATENCY_TOTAL      /**< First pn_link_send() to the peer settling the delivery */
+} pn_latency_stage_t;
+
+/**
+ * **Unsettled API** - Enable or disable latency tracking on a sending link.
+ *
+ * A delivery is tracked if tracking is enabled when its first bytes are
+ * given to pn_link_send(). Tracked deliveries are timestamped as they
+ * move through the stages in ::pn_latency_stage_t and the time spent in
+ * each stage is added to a histogram for the link. Deliveries that never
+ * reach a stage, such as pre-settled ones for ::PN_LATENCY_SETTLED, are
+ * not counted in it.
+ *
+ * Disabled by default. The histograms are kept when tracking is disabled.
+ *
+ * @param[in] sender a sending link object
+ * @param[in] enabled true to enable tracking
+ */
+PN_EXTERN void pn_link_set_latency_tracking(pn_link_t *sender, bool enabled);
+
+/**
+ * **Unsettled API** - Check if latency tracking is enabled on a link.
+ *
+ * @param[in] link a link object
+ * @return true if latency tracking is enabled
+ */
+PN_EXTERN bool pn_link_get_latency_tracking(pn_link_t *link);
+
+/**
+ * **Unsettled API** - Get the latency histogram for a stage of the
+ * deliveries sent on a link.
+ *
+ * The histogram is owned by the link and is valid until the link is freed.
+ *
+ * @param[in] link a link object
+ * @param[in] stage the stage
+ * @return the histogram, or NULL if latency tracking was never enabled
+ */
+PN_EXTERN pn_histogram_t *pn_link_latency(pn_link_t *link, pn_latency_stage_t stage);
+
 /**
  * @}
  */
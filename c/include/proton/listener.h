@@ -55,6 +55,22 @@ PNP_EXTERN pn_listener_t *pn_listener(void);
  */
 PNP_EXTERN void pn_listener_free(pn_listener_t *l);
 
+/**
+ * **Unsettled API** - Listen on @p shards sockets per address.
+ *
+ * Must be called before pn_proactor_listen(). Each address is listened on
+ * by @p shards sockets sharing the address with SO_REUSEPORT. The
+ * operating system spreads incoming connections across them so they can
+ * be accepted by several threads at once, which helps when very many
+ * clients connect at the same time. The default is a single socket.
+ *
+ * Only the epoll proactor supports more than one socket per address.
+ *
+ * @return 0, or PN_ERR if @p shards is more than 1 and the proactor does not
+ * support it. The listener is unchanged on error.
+ */
+PNP_EXTERN int pn_listener_set_shards(pn_listener_t *listener, size_t shards);
+
 /**
  * Accept an incoming connection request using @p transport and @p connection,
  * which can be configured before the call.
@@ -26,6 +26,7 @@
 #include <proton/types.h>
 #include <proton/codec.h>
 #include <proton/error.h>
+#include <proton/shared_bytes.h>
 #include <proton/type_compat.h>
 
 #ifdef __cplusplus
@@ -776,6 +777,18 @@ struct pn_link_t;
  */
 PN_EXTERN ssize_t pn_message_send(pn_message_t *msg, pn_link_t *sender, pn_rwbytes_t *buf);
 
+/**
+ * **Unsettled API** - Encode a message once so it can be sent on any
+ * number of links with pn_link_send_shared() without being encoded or
+ * copied again.
+ *
+ * @param[in] msg A message object.
+ * @return The encoded message, released with pn_shared_bytes_decref(),
+ * or NULL on error. On error pn_message_error(msg) will provide more
+ * information.
+ */
+PN_EXTERN pn_shared_bytes_t *pn_message_encode_shared(pn_message_t *msg);
+
 /**
  * Save message content into a pn_data_t object data. The data object will first be cleared.
  */
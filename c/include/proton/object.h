@@ -147,6 +147,27 @@ PREFIX ## _t *PREFIX ## _new(void) {                                      \
     PREFIX ## _inspect                          \
 }
 
+/* Like PN_CLASS, for objects that are shared between threads once they are
+   built. Their reference counts are atomic, so any thread may pn_incref or
+   pn_decref them without a lock and the last pn_decref frees the object
+   safely. Nothing else about the object is made thread safe, so it must not
+   be modified while it is shared. */
+#define PN_ATOMIC_CLASS(PREFIX) {               \
+    #PREFIX,                                    \
+    CID_ ## PREFIX,                             \
+    pn_object_new,                              \
+    PREFIX ## _initialize,                      \
+    pn_object_atomic_incref,                    \
+    pn_object_atomic_decref,                    \
+    pn_object_atomic_refcount,                  \
+    PREFIX ## _finalize,                        \
+    pn_object_free,                             \
+    pn_object_reify,                            \
+    PREFIX ## _hashcode,                        \
+    PREFIX ## _compare,                         \
+    PREFIX ## _inspect                          \
+}
+
 #define PN_METACLASS(PREFIX) {                  \
     #PREFIX,                                    \
     CID_ ## PREFIX,                             \
@@ -222,6 +243,9 @@ PN_EXTERN void pn_object_incref(void *object);
 PN_EXTERN int pn_object_refcount(void *object);
 PN_EXTERN void pn_object_decref(void *object);
 PN_EXTERN void pn_object_free(void *object);
+PN_EXTERN void pn_object_atomic_incref(void *object);
+PN_EXTERN int pn_object_atomic_refcount(void *object);
+PN_EXTERN void pn_object_atomic_decref(void *object);
 
 PN_EXTERN void *pn_incref(void *object);
 PN_EXTERN int pn_decref(void *object);
@@ -304,7 +328,19 @@ PN_EXTERN void *pn_iterator_start(pn_iterator_t *iterator,
                                   pn_iterator_next_t next, size_t size);
 PN_EXTERN void *pn_iterator_next(pn_iterator_t *iterator);
 
+/**
+   Well-known handles, reserved for proton's own use. They are small integers
+   so they can't clash with a PN_HANDLE address, anything else should use
+   PN_HANDLE below. PN_LEGCTX is defined on every record.
+
+   A well-known handle is shared by every kind of object that uses it, so it
+   must not be used twice on the same record. The C++ binding keeps its
+   connection, session, link and listener contexts in PN_CPPCTX, the proactor
+   keeps its per-connection state in PN_PROACTORCTX.
+ */
 #define PN_LEGCTX ((pn_handle_t) 0)
+#define PN_CPPCTX ((pn_handle_t) 1)
+#define PN_PROACTORCTX ((pn_handle_t) 2)
 
 /**
    PN_HANDLE is a trick to define a unique identifier by using the address of a static variable.
@@ -22,6 +22,7 @@
 
 #include <proton/condition.h>
 #include <proton/event.h>
+#include <proton/histogram.h>
 #include <proton/import_export.h>
 #include <proton/types.h>
 
@@ -95,6 +96,21 @@ PNP_EXTERN pn_proactor_t *pn_proactor(void);
  */
 PNP_EXTERN void pn_proactor_free(pn_proactor_t *proactor);
 
+/**
+ * **Unsettled API** - Run @p loops independent event loops.
+ *
+ * Must be called before any connections or listeners are added to the
+ * proactor. New connections and listeners are spread over the loops, and
+ * each loop can be run by a different thread calling pn_proactor_wait()
+ * at the same time. With fewer threads than loops, a waiting thread
+ * leads one loop and is woken when a loop without a thread has IO or a
+ * timer due, so the loops take turns. The default is a single loop.
+ *
+ * Ignored by proactors that already handle IO in all threads at once,
+ * and by the libuv proactor on Windows.
+ */
+PNP_EXTERN void pn_proactor_set_loops(pn_proactor_t *proactor, size_t loops);
+
 /**
  * Connect @p transport to @p addr and bind to @p connection.
  * Errors are returned as  @ref PN_TRANSPORT_CLOSED events by pn_proactor_wait().
@@ -155,6 +171,45 @@ PNP_EXTERN void pn_proactor_connect(pn_proactor_t *proactor, pn_connection_t *co
  */
 PNP_EXTERN void pn_proactor_listen(pn_proactor_t *proactor, pn_listener_t *listener, const char *addr, int backlog);
 
+/**
+ * **Unsettled API** - Socket options for pn_connection_set_socket_option()
+ * and pn_listener_set_socket_option().
+ *
+ * Options that are not set keep the proactor's default. Options that the
+ * platform does not support are ignored.
+ */
+typedef enum {
+  PN_SOCKET_NODELAY,       /**< TCP_NODELAY, non-zero to disable Nagle's algorithm. Default 1 with the epoll proactor. */
+  PN_SOCKET_SNDBUF,        /**< SO_SNDBUF, kernel send buffer size in bytes */
+  PN_SOCKET_RCVBUF,        /**< SO_RCVBUF, kernel receive buffer size in bytes */
+  PN_SOCKET_QUICKACK,      /**< TCP_QUICKACK, non-zero to send ACKs immediately. Set once when the socket is opened, the kernel may return to delayed ACKs later. */
+  PN_SOCKET_NOTSENT_LOWAT, /**< TCP_NOTSENT_LOWAT, limit in bytes on unsent data in the send buffer */
+  PN_SOCKET_BUSY_POLL,     /**< SO_BUSY_POLL, microseconds to busy poll the device when receiving */
+  PN_SOCKET_USER_TIMEOUT   /**< TCP_USER_TIMEOUT, milliseconds unacknowledged data may remain before the connection is closed */
+} pn_socket_option_t;
+
+/**
+ * **Unsettled API** - Set a socket option for @p connection.
+ *
+ * Must be called before pn_proactor_connect2() or pn_listener_accept2(). The
+ * option is applied to every socket used by the connection. For accepted
+ * connections it overrides the same option set on the listener.
+ *
+ * @return 0 or PN_ARG_ERR if @p option is not a valid ::pn_socket_option_t.
+ */
+PNP_EXTERN int pn_connection_set_socket_option(pn_connection_t *connection, pn_socket_option_t option, int value);
+
+/**
+ * **Unsettled API** - Set a socket option for @p listener.
+ *
+ * Must be called before pn_proactor_listen(). The option is applied to the
+ * listening sockets, so buffer sizes take effect from the first packet, and
+ * to every connection accepted by @p listener.
+ *
+ * @return 0 or PN_ARG_ERR if @p option is not a valid ::pn_socket_option_t.
+ */
+PNP_EXTERN int pn_listener_set_socket_option(pn_listener_t *listener, pn_socket_option_t option, int value);
+
 /**
  * Disconnect all connections and listeners belonging to the proactor.
  *
@@ -312,6 +367,102 @@ PNP_EXTERN pn_proactor_t *pn_event_proactor(pn_event_t *event);
  */
 PNP_EXTERN pn_millis_t pn_proactor_now(void);
 
+/**
+ * **Unsettled API** - Counters for the work done by the threads using a
+ * proactor, see pn_proactor_stats().
+ *
+ * Nothing is counted unless pn_proactor_set_stats_enabled() is on.
+ * busy_ns / (busy_ns + idle_ns) is the utilisation of a thread.
+ */
+typedef struct pn_proactor_stats_t {
+  uint64_t polls;         /**< Returns from the poller, e.g. epoll_wait() */
+  uint64_t batches;       /**< Batches returned by pn_proactor_wait() or pn_proactor_get() */
+  uint64_t events;        /**< Events taken from those batches */
+  uint64_t wakes;         /**< Wake ups of connections, listeners or the proactor handled */
+  uint64_t hog_limits;    /**< Batches ended to give other connections a turn */
+  uint64_t rearms;        /**< System calls to re-arm a polled file descriptor */
+  uint64_t locks;         /**< Times the proactor's own lock was taken */
+  uint64_t lock_held_ns;  /**< Nanoseconds the proactor's own lock was held */
+  uint64_t busy_ns;       /**< Nanoseconds from getting a batch to pn_proactor_done() */
+  uint64_t idle_ns;       /**< Nanoseconds blocked in pn_proactor_wait() with nothing to do */
+} pn_proactor_stats_t;
+
+/**
+ * **Unsettled API** - Distributions recorded with the proactor
+ * statistics, see pn_proactor_stats_distribution().
+ */
+typedef enum {
+  PN_PROACTOR_BATCH_EVENTS,     /**< Events per batch */
+  PN_PROACTOR_WAKE_LATENCY,     /**< Microseconds from a wake up to it being handled */
+  PN_PROACTOR_LOCK_HELD         /**< Nanoseconds the proactor's own lock was held each time */
+} pn_proactor_distribution_t;
+
+/**
+ * **Unsettled API** - Turn statistics on or off, they are off by default.
+ *
+ * Statistics are kept separately for each thread that uses the proactor so
+ * threads don't contend to record them. Turning statistics off keeps the
+ * values recorded so far.
+ *
+ * Ignored by proactors that don't keep statistics.
+ *
+ * @note Thread-safe
+ */
+PNP_EXTERN void pn_proactor_set_stats_enabled(pn_proactor_t *proactor, bool enabled);
+
+/**
+ * **Unsettled API** - True if statistics are on.
+ *
+ * @note Thread-safe
+ */
+PNP_EXTERN bool pn_proactor_get_stats_enabled(pn_proactor_t *proactor);
+
+/**
+ * **Unsettled API** - The number of threads that have recorded statistics.
+ *
+ * Threads are numbered from 0 in the order they first used the proactor with
+ * statistics on. A thread's statistics are kept after it stops using the
+ * proactor.
+ *
+ * @note Thread-safe
+ */
+PNP_EXTERN int pn_proactor_stats_threads(pn_proactor_t *proactor);
+
+/**
+ * **Unsettled API** - Get the counters for a thread, or the totals for all threads.
+ *
+ * @note Thread-safe
+ *
+ * @param[in] proactor the proactor
+ * @param[in] thread the thread number or -1 for all threads
+ * @param[out] stats set to the counters
+ * @return 0 or ::PN_ARG_ERR if there is no such thread
+ */
+PNP_EXTERN int pn_proactor_stats(pn_proactor_t *proactor, int thread, pn_proactor_stats_t *stats);
+
+/**
+ * **Unsettled API** - Get a distribution for a thread, or for all threads.
+ *
+ * @note Thread-safe
+ *
+ * @param[in] proactor the proactor
+ * @param[in] thread the thread number or -1 for all threads
+ * @param[in] distribution the distribution to get
+ * @param[out] histogram a histogram created by pn_histogram(), its values
+ * are replaced by the distribution's
+ * @return 0 or ::PN_ARG_ERR if there is no such thread or distribution
+ */
+PNP_EXTERN int pn_proactor_stats_distribution(pn_proactor_t *proactor, int thread,
+                                              pn_proactor_distribution_t distribution,
+                                              pn_histogram_t *histogram);
+
+/**
+ * **Unsettled API** - Reset the statistics of all threads to zero.
+ *
+ * @note Thread-safe
+ */
+PNP_EXTERN void pn_proactor_clear_stats(pn_proactor_t *proactor);
+
 /**
  * @}
  */
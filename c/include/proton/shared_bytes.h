@@ -0,0 +1,94 @@
+#ifndef PROTON_SHARED_BYTES_H
+#define PROTON_SHARED_BYTES_H 1
+
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <proton/import_export.h>
+#include <proton/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ *
+ * @copybrief pn_shared_bytes_t
+ *
+ * @addtogroup delivery
+ * @{
+ */
+
+/**
+ * **Unsettled API** - An immutable, reference counted block of bytes,
+ * usually an encoded message, that can be sent on many links without
+ * being copied.
+ *
+ * pn_link_send_shared() adds a reference to the bytes to the current
+ * delivery instead of copying them, and the transport writes large
+ * pieces of them straight out of the shared block. A broker can encode
+ * a message once and deliver it to every subscriber this way.
+ *
+ * The reference count is atomic: references may be added and released
+ * on any thread, so the same bytes can be sent on connections served by
+ * different threads. The bytes are freed when the last reference is
+ * released.
+ */
+typedef struct pn_shared_bytes_t pn_shared_bytes_t;
+
+/**
+ * **Unsettled API** - Make a shared copy of @p size bytes.
+ *
+ * The caller holds one reference, released with
+ * pn_shared_bytes_decref().
+ *
+ * @return the shared bytes, or NULL if out of memory
+ */
+PN_EXTERN pn_shared_bytes_t *pn_shared_bytes(const char *bytes, size_t size);
+
+/**
+ * **Unsettled API** - Add a reference, for example before passing the
+ * bytes to another thread.
+ *
+ * @return @p shared
+ */
+PN_EXTERN pn_shared_bytes_t *pn_shared_bytes_incref(pn_shared_bytes_t *shared);
+
+/**
+ * **Unsettled API** - Release a reference. The bytes are freed when no
+ * references remain, including those held by deliveries.
+ */
+PN_EXTERN void pn_shared_bytes_decref(pn_shared_bytes_t *shared);
+
+/**
+ * **Unsettled API** - The bytes. They are valid for as long as a
+ * reference is held and must not be modified.
+ */
+PN_EXTERN pn_bytes_t pn_shared_bytes_get(pn_shared_bytes_t *shared);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* shared_bytes.h */
@@ -52,6 +52,7 @@ extern "C" {
  * - ::PN_TRACE_FRM
  * - ::PN_TRACE_DRV
  * - ::PN_TRACE_EVT
+ * - ::PN_TRACE_BIN
  *
  * @internal XXX Deprecate when logging is made independent
  */
@@ -100,6 +101,24 @@ typedef void (*pn_tracer_t)(pn_transport_t *transport, const char *message);
  */
 #define PN_TRACE_EVT (8)
 
+/**
+ * **Unsettled API** - Record protocol frames going in and out of the
+ * transport in binary form.
+ *
+ * Frames are copied into a ring buffer owned by the transport instead
+ * of being formatted and logged, which is cheap enough to leave on in
+ * production. The ring keeps the most recent frames, it is written to
+ * a file by pn_transport_dump_trace(). The `trace-decode` tool prints a
+ * dump in the same format as ::PN_TRACE_FRM.
+ *
+ * Enabled for new transports if the PN_TRACE_BIN environment variable
+ * is set. If the PN_TRACE_DUMP environment variable names a directory,
+ * the ring is also dumped there when the transport has an error.
+ *
+ * @see pn_transport_set_trace_ring()
+ */
+#define PN_TRACE_BIN (16)
+
 /**
  * Factory for creating a transport.
  *
@@ -286,6 +305,32 @@ PN_EXTERN void pn_transport_set_tracer(pn_transport_t *transport, pn_tracer_t tr
  */
 PN_EXTERN pn_tracer_t pn_transport_get_tracer(pn_transport_t *transport);
 
+/**
+ * **Unsettled API** - Configure the ring used by ::PN_TRACE_BIN.
+ *
+ * Frames recorded so far are discarded. If this is not called, a ring
+ * of 1MB that records 32 payload bytes per frame is created when the
+ * first frame is recorded.
+ *
+ * @param[in] transport a transport object
+ * @param[in] size the size of the ring in bytes, 0 to free the ring
+ * @param[in] payload the most payload bytes to record per frame, at most 1024
+ * @return 0 on success or ::PN_OUT_OF_MEMORY
+ */
+PN_EXTERN int pn_transport_set_trace_ring(pn_transport_t *transport, size_t size, size_t payload);
+
+/**
+ * **Unsettled API** - Write the frames recorded by ::PN_TRACE_BIN to a file.
+ *
+ * The file is replaced if it exists. A transport that has recorded
+ * nothing writes a valid dump with no frames.
+ *
+ * @param[in] transport a transport object
+ * @param[in] path the file to write
+ * @return 0 on success or ::PN_ERR if the file could not be written
+ */
+PN_EXTERN int pn_transport_dump_trace(pn_transport_t *transport, const char *path);
+
 /**
  * Get the application context that is associated with a transport object.
  *
@@ -469,6 +514,41 @@ PN_EXTERN void pn_transport_set_idle_timeout(pn_transport_t *transport, pn_milli
  */
 PN_EXTERN pn_millis_t pn_transport_get_remote_idle_timeout(pn_transport_t *transport);
 
+/**
+ * **Unsettled API** - Limit the output waiting to be written.
+ *
+ * While at least @p limit bytes of output are waiting to be written, the
+ * transport stops encoding new transfer frames. Other frames are still sent,
+ * and transfers resume as the output is written. This keeps the queue of
+ * output short on latency-sensitive connections. Waiting output includes the
+ * transport's own buffers and any bytes reported by
+ * pn_transport_set_output_queued().
+ *
+ * Deliveries that have already started are not held back, so the output can
+ * exceed the limit by the data of those deliveries.
+ *
+ * @param[in] transport a transport object
+ * @param[in] limit the limit in bytes, 0 (the default) for no limit
+ */
+PN_EXTERN void pn_transport_set_output_limit(pn_transport_t *transport, size_t limit);
+
+/**
+ * **Unsettled API** - Get the limit set by pn_transport_set_output_limit().
+ */
+PN_EXTERN size_t pn_transport_get_output_limit(pn_transport_t *transport);
+
+/**
+ * **Unsettled API** - Report output that has been taken from the transport
+ * but not yet sent, for example bytes in the kernel socket send queue.
+ *
+ * Counted against the limit set by pn_transport_set_output_limit(). Normally
+ * called by the IO integration, such as a proactor, after each write.
+ *
+ * @param[in] transport a transport object
+ * @param[in] queued the number of bytes still queued
+ */
+PN_EXTERN void pn_transport_set_output_queued(pn_transport_t *transport, size_t queued);
+
 /**
  * **Deprecated** - Use the @ref connection_driver API.
  */
@@ -0,0 +1,275 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include <proton/error.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chain.h"
+#include "util.h"
+
+// Released segments kept by a chain for reuse
+#define PNI_CHAIN_SPARES (2)
+
+typedef struct pni_segment_t {
+  struct pni_segment_t *next;
+  pn_shared_bytes_t *shared;    /* Bytes referenced by the segment, see below */
+  size_t capacity;
+  size_t start;                 /* Offset of the first unread byte */
+  size_t end;                   /* Offset of the first free byte */
+} pni_segment_t;
+
+struct pn_chain_t {
+  pni_segment_t *head;
+  pni_segment_t *tail;
+  pni_segment_t *spares;
+  size_t spare_count;
+  pni_segment_t *shared_spare;  /* A released header for a shared segment */
+  size_t first;                 /* Capacity of the first segment */
+  size_t size;
+};
+
+// The bytes of a segment follow the header in the same allocation, unless
+// it refers to shared bytes. A shared segment is full, its capacity is its end.
+static inline char *pni_segment_bytes(pni_segment_t *seg)
+{
+  return seg->shared ? (char *) pn_shared_bytes_get(seg->shared).start : (char *) (seg + 1);
+}
+
+pn_chain_t *pn_chain(size_t segment)
+{
+  pn_chain_t *chain = (pn_chain_t *) malloc(sizeof(pn_chain_t));
+  if (chain) {
+    chain->first = pn_max(segment, PNI_CHAIN_SEGMENT_MIN);
+    chain->head = NULL;
+    chain->tail = NULL;
+    chain->spares = NULL;
+    chain->spare_count = 0;
+    chain->shared_spare = NULL;
+    chain->size = 0;
+  }
+  return chain;
+}
+
+static void pni_segments_free(pni_segment_t *seg)
+{
+  while (seg) {
+    pni_segment_t *next = seg->next;
+    pn_shared_bytes_decref(seg->shared);
+    free(seg);
+    seg = next;
+  }
+}
+
+void pn_chain_free(pn_chain_t *chain)
+{
+  if (!chain) return;
+  pni_segments_free(chain->head);
+  pni_segments_free(chain->spares);
+  free(chain->shared_spare);
+  free(chain);
+}
+
+size_t pn_chain_size(pn_chain_t *chain)
+{
+  return chain->size;
+}
+
+static pni_segment_t *pni_segment(pn_chain_t *chain, size_t size)
+{
+  size_t last = (chain->tail && !chain->tail->shared) ? chain->tail->capacity : 0;
+  pni_segment_t *seg = chain->spares;
+  if (seg) {
+    chain->spares = seg->next;
+    chain->spare_count--;
+    // Don't let small early segments keep coming back, the head of a
+    // chain is also what gets written out in one go.
+    if (seg->capacity < last) {
+      free(seg);
+      seg = NULL;
+    }
+  }
+  if (!seg) {
+    size_t capacity = last ? last * 2 : chain->first;
+    capacity = pn_max(pn_min(pn_max(capacity, size), PNI_CHAIN_SEGMENT_MAX), chain->first);
+    seg = (pni_segment_t *) malloc(sizeof(pni_segment_t) + capacity);
+    if (!seg) return NULL;
+    seg->capacity = capacity;
+  }
+  seg->next = NULL;
+  seg->shared = NULL;
+  seg->start = 0;
+  seg->end = 0;
+  return seg;
+}
+
+static void pni_segment_release(pn_chain_t *chain, pni_segment_t *seg)
+{
+  if (seg->shared) {
+    pn_shared_bytes_decref(seg->shared);
+    if (!chain->shared_spare) {
+      chain->shared_spare = seg;
+    } else {
+      free(seg);
+    }
+  } else if (chain->spare_count < PNI_CHAIN_SPARES) {
+    seg->next = chain->spares;
+    chain->spares = seg;
+    chain->spare_count++;
+  } else {
+    free(seg);
+  }
+}
+
+int pn_chain_append(pn_chain_t *chain, const char *bytes, size_t size)
+{
+  while (size) {
+    pni_segment_t *tail = chain->tail;
+    if (!tail || tail->end == tail->capacity) {
+      pni_segment_t *seg = pni_segment(chain, size);
+      if (!seg) return PN_OUT_OF_MEMORY;
+      if (tail) {
+        tail->next = seg;
+      } else {
+        chain->head = seg;
+      }
+      chain->tail = tail = seg;
+    }
+    size_t n = pn_min(size, tail->capacity - tail->end);
+    memcpy(pni_segment_bytes(tail) + tail->end, bytes, n);
+    tail->end += n;
+    chain->size += n;
+    bytes += n;
+    size -= n;
+  }
+  return 0;
+}
+
+int pn_chain_append_shared(pn_chain_t *chain, pn_shared_bytes_t *shared, size_t offset, size_t size)
+{
+  if (!size) return 0;
+  pni_segment_t *seg = chain->shared_spare;
+  if (seg) {
+    chain->shared_spare = NULL;
+  } else {
+    seg = (pni_segment_t *) malloc(sizeof(pni_segment_t));
+    if (!seg) return PN_OUT_OF_MEMORY;
+  }
+  seg->next = NULL;
+  seg->shared = pn_shared_bytes_incref(shared);
+  seg->start = offset;
+  seg->end = seg->capacity = offset + size;
+  if (chain->tail) {
+    chain->tail->next = seg;
+  } else {
+    chain->head = seg;
+  }
+  chain->tail = seg;
+  chain->size += size;
+  return 0;
+}
+
+int pn_chain_copy(pn_chain_t *chain, pn_chain_t *src, size_t size)
+{
+  for (pni_segment_t *seg = src->head; seg && size; seg = seg->next) {
+    size_t n = pn_min(size, seg->end - seg->start);
+    int err = (seg->shared && n >= PNI_CHAIN_SHARE_MIN) ?
+      pn_chain_append_shared(chain, seg->shared, seg->start, n) :
+      pn_chain_append(chain, pni_segment_bytes(seg) + seg->start, n);
+    if (err) return err;
+    size -= n;
+  }
+  return 0;
+}
+
+size_t pn_chain_get(pn_chain_t *chain, size_t offset, size_t size, char *dst)
+{
+  size_t copied = 0;
+  for (pni_segment_t *seg = chain->head; seg && size; seg = seg->next) {
+    size_t len = seg->end - seg->start;
+    if (offset >= len) {
+      offset -= len;
+      continue;
+    }
+    size_t n = pn_min(size, len - offset);
+    memcpy(dst + copied, pni_segment_bytes(seg) + seg->start + offset, n);
+    offset = 0;
+    copied += n;
+    size -= n;
+  }
+  return copied;
+}
+
+void pn_chain_trim(pn_chain_t *chain, size_t size)
+{
+  size = pn_min(size, chain->size);
+  chain->size -= size;
+  while (chain->head) {
+    pni_segment_t *seg = chain->head;
+    size_t len = seg->end - seg->start;
+    if (size < len) {
+      seg->start += size;
+      return;
+    }
+    size -= len;
+    if (seg == chain->tail && !seg->shared) {
+      // Keep the last segment so an emptied chain doesn't allocate again
+      seg->start = seg->end = 0;
+      return;
+    }
+    chain->head = seg->next;
+    if (seg == chain->tail) chain->tail = NULL;
+    pni_segment_release(chain, seg);
+  }
+}
+
+void pn_chain_clear(pn_chain_t *chain)
+{
+  pn_chain_trim(chain, chain->size);
+}
+
+size_t pn_chain_segments(pn_chain_t *chain, pn_bytes_t *segments, size_t max)
+{
+  size_t count = 0;
+  for (pni_segment_t *seg = chain->head; seg && count < max; seg = seg->next) {
+    if (seg->end > seg->start) {
+      segments[count++] = pn_bytes(seg->end - seg->start, pni_segment_bytes(seg) + seg->start);
+    }
+  }
+  return count;
+}
+
+int pn_chain_quote(pn_chain_t *chain, pn_string_t *str, size_t offset, size_t size)
+{
+  for (pni_segment_t *seg = chain->head; seg && size; seg = seg->next) {
+    size_t len = seg->end - seg->start;
+    if (offset >= len) {
+      offset -= len;
+      continue;
+    }
+    size_t n = pn_min(size, len - offset);
+    int err = pn_quote(str, pni_segment_bytes(seg) + seg->start + offset, n);
+    if (err) return err;
+    offset = 0;
+    size -= n;
+  }
+  return 0;
+}
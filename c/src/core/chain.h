@@ -0,0 +1,74 @@
+#ifndef PROTON_CHAIN_H
+#define PROTON_CHAIN_H 1
+
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include <proton/import_export.h>
+#include <proton/object.h>
+#include <proton/shared_bytes.h>
+#include <proton/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A byte queue held as a chain of segments.
+ *
+ * Unlike pn_buffer_t the bytes are never moved once written: appending adds
+ * segments at the tail and trimming releases them from the head, so neither
+ * depends on the amount of data already queued. The contents are read with
+ * pn_chain_get() or a segment at a time with pn_chain_segments(), there is no
+ * contiguous view and so no need to defragment.
+ *
+ * Segments start at the size given to pn_chain() and double up to
+ * PNI_CHAIN_SEGMENT_MAX.
+ * Released segments are kept for reuse by the same chain.
+ *
+ * pn_chain_append_shared() adds a segment that refers to a piece of a
+ * pn_shared_bytes_t instead of copying it. pn_chain_copy() passes such pieces
+ * on by reference too if they are at least PNI_CHAIN_SHARE_MIN bytes, smaller
+ * ones are cheaper to copy than to write out as separate segments.
+ */
+typedef struct pn_chain_t pn_chain_t;
+
+#define PNI_CHAIN_SEGMENT_MIN (256)
+#define PNI_CHAIN_SEGMENT_MAX (64*1024)
+#define PNI_CHAIN_SHARE_MIN (4*1024)
+
+pn_chain_t *pn_chain(size_t segment);
+void pn_chain_free(pn_chain_t *chain);
+size_t pn_chain_size(pn_chain_t *chain);
+int pn_chain_append(pn_chain_t *chain, const char *bytes, size_t size);
+int pn_chain_append_shared(pn_chain_t *chain, pn_shared_bytes_t *shared, size_t offset, size_t size);
+int pn_chain_copy(pn_chain_t *chain, pn_chain_t *src, size_t size);
+size_t pn_chain_get(pn_chain_t *chain, size_t offset, size_t size, char *dst);
+void pn_chain_trim(pn_chain_t *chain, size_t size);
+void pn_chain_clear(pn_chain_t *chain);
+size_t pn_chain_segments(pn_chain_t *chain, pn_bytes_t *segments, size_t max);
+int pn_chain_quote(pn_chain_t *chain, pn_string_t *string, size_t offset, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* chain.h */
@@ -24,6 +24,7 @@
 #include "framing.h"
 #include "protocol.h"
 #include "engine-internal.h"
+#include "probes.h"
 
 #include "dispatch_actions.h"
 
@@ -77,12 +78,20 @@ static inline int pni_dispatch_action(pn_transport_t* transport, uint64_t lcode,
 static int pni_dispatch_frame(pn_transport_t * transport, pn_data_t *args, pn_frame_t frame)
 {
   if (frame.size == 0) { // ignore null frames
+    if (transport->trace & PN_TRACE_BIN)
+      pni_trace_bin(transport, IN, frame.type, frame.channel, NULL, 0, NULL, NULL, 0);
     if (transport->trace & PN_TRACE_FRM)
       pn_transport_logf(transport, "%u <- (EMPTY FRAME)", frame.channel);
     return 0;
   }
 
   ssize_t dsize = pn_data_decode(args, frame.payload, frame.size);
+  if (transport->trace & PN_TRACE_BIN) {
+    // Keep the whole of a frame that can't be decoded
+    size_t psize = dsize < 0 ? frame.size : (size_t) dsize;
+    pni_trace_bin(transport, IN, frame.type, frame.channel, frame.payload, psize,
+                  frame.payload + psize, NULL, frame.size - psize);
+  }
   if (dsize < 0) {
     pn_string_format(transport->scratch,
                      "Error decoding frame: %s %s\n", pn_code(dsize),
@@ -132,6 +141,7 @@ ssize_t pn_dispatcher_input(pn_transport_t *transport, const char *bytes, size_t
       read += n;
       available -= n;
       transport->input_frames_ct += 1;
+      PN_PROBE4(frame_read, transport, frame.channel, frame.type, frame.size);
       int e = pni_dispatch_frame(transport, transport->args, frame);
       if (e) return e;
     } else if (n < 0) {
@@ -149,8 +159,9 @@ ssize_t pn_dispatcher_input(pn_transport_t *transport, const char *bytes, size_t
 
 ssize_t pn_dispatcher_output(pn_transport_t *transport, char *bytes, size_t size)
 {
-    int n = pn_buffer_get(transport->output_buffer, 0, size, bytes);
-    pn_buffer_trim(transport->output_buffer, n, 0);
+    size_t n = pn_chain_get(transport->output_buffer, 0, size, bytes);
+    pn_chain_trim(transport->output_buffer, n);
+    transport->output_trimmed += n;
     // XXX: need to check for errors
     return n;
 }
@@ -27,7 +27,10 @@
 #include <proton/types.h>
 
 #include "buffer.h"
+#include "chain.h"
 #include "dispatcher.h"
+#include "histogram_private.h"
+#include "trace_ring.h"
 #include "util.h"
 
 typedef enum pn_endpoint_type_t {CONNECTION, SESSION, SENDER, RECEIVER} pn_endpoint_type_t;
@@ -56,6 +59,12 @@ struct pn_endpoint_t {
   bool referenced;
 };
 
+// A list of modified endpoints, linked through transport_next/prev
+typedef struct {
+  pn_endpoint_t *transport_head;  // reference counted
+  pn_endpoint_t *transport_tail;
+} pn_endpoint_list_t;
+
 typedef struct {
   pn_sequence_t id;
   bool sending;
@@ -125,6 +134,7 @@ typedef struct pni_ssl_t pni_ssl_t;
 
 struct pn_transport_t {
   pn_tracer_t tracer;
+  pni_trace_ring_t *trace_ring; /* PN_TRACE_BIN records, created on first use */
   pni_sasl_t *sasl;
   pni_ssl_t *ssl;
   pn_connection_t *connection;  // reference counted
@@ -167,7 +177,7 @@ struct pn_transport_t {
   pn_buffer_t *frame;  // frame under construction
 
   // Temporary - ??
-  pn_buffer_t *output_buffer;
+  pn_chain_t *output_buffer;
 
   /* statistics */
   uint64_t bytes_input;
@@ -180,6 +190,13 @@ struct pn_transport_t {
   size_t output_size;
   size_t output_pending;
   char *output_buf;
+  bool output_direct;           /* pending output is the front of output_buffer, not output_buf */
+  size_t output_limit;          /* stop encoding transfers at this much waiting output, 0 = no limit */
+  size_t output_queued;         /* output written but queued outside the transport */
+  pn_connection_stats_t stats;  /* frames_* are filled in from the *_frames_ct counters */
+  uint64_t output_trimmed;      /* bytes taken from the front of output_buffer */
+  pn_list_t *latency_pending;   /* tracked deliveries not yet popped, ordered by latency.end */
+  size_t latency_head;          /* first entry of latency_pending still waiting */
 
   /* input from peer */
   size_t input_size;
@@ -223,14 +240,18 @@ struct pn_transport_t {
   bool encryption_required;
 
   bool referenced;
+  bool event_queued;     // PN_TRANSPORT event queued on a coalescing collector
 };
 
 struct pn_connection_t {
   pn_endpoint_t endpoint;
   pn_endpoint_t *endpoint_head;
   pn_endpoint_t *endpoint_tail;
-  pn_endpoint_t *transport_head;  // reference counted
-  pn_endpoint_t *transport_tail;
+  // modified endpoints, kept per endpoint type so each processing phase
+  // only visits the endpoints it acts on
+  pn_endpoint_list_t modified_connection;
+  pn_endpoint_list_t modified_sessions;
+  pn_endpoint_list_t modified_links;
   pn_list_t *sessions;
   pn_list_t *freed;
   pn_transport_t *transport;
@@ -263,6 +284,7 @@ struct pn_session_t {
   pn_sequence_t incoming_deliveries;
   pn_sequence_t outgoing_deliveries;
   pn_sequence_t outgoing_window;
+  pn_timestamp_t window_blocked_since; /* pni_clock() when transfers were held back, 0 if not */
   pn_session_state_t state;
 };
 
@@ -300,6 +322,9 @@ struct pn_link_t {
   pn_sequence_t available;
   pn_sequence_t credit;
   pn_sequence_t queued;
+  pn_link_stats_t stats;
+  pn_timestamp_t credit_blocked_since; /* pni_clock() when a sender ran out of credit, 0 if not */
+  pn_histogram_t *latency;      /* one per pn_latency_stage_t, NULL until tracking is enabled */
   int drained; // number of drained credits
   uint8_t snd_settle_mode;
   uint8_t rcv_settle_mode;
@@ -308,6 +333,8 @@ struct pn_link_t {
   bool drain_flag_mode; // receiver only
   bool drain;
   bool detached;
+  bool flow_event_queued; // PN_LINK_FLOW event queued on a coalescing collector
+  bool latency_tracking;
 };
 
 struct pn_disposition_t {
@@ -322,6 +349,14 @@ struct pn_disposition_t {
   bool settled;
 };
 
+/* pni_clock_us() times of a delivery on a link with latency tracking, 0 if not reached */
+typedef struct pni_latency_stamps_t {
+  uint64_t sent;                /* first pn_link_send() */
+  uint64_t written;             /* last TRANSFER frame generated */
+  uint64_t popped;              /* last byte of that frame popped from the transport */
+  uint64_t end;                 /* output_trimmed after the last byte of that frame */
+} pni_latency_stamps_t;
+
 struct pn_delivery_t {
   pn_disposition_t local;
   pn_disposition_t remote;
@@ -334,8 +369,9 @@ struct pn_delivery_t {
   pn_delivery_t *tpwork_next;
   pn_delivery_t *tpwork_prev;
   pn_delivery_state_t state;
-  pn_buffer_t *bytes;
+  pn_chain_t *bytes;
   pn_record_t *context;
+  pni_latency_stamps_t latency;
   bool updated;
   bool settled; // tracks whether we're in the unsettled list or not
   bool work;
@@ -343,6 +379,7 @@ struct pn_delivery_t {
   bool done;
   bool referenced;
   bool aborted;
+  bool event_queued; // PN_DELIVERY event queued on a coalescing collector
 };
 
 #define PN_SET_LOCAL(OLD, NEW)                                          \
@@ -363,12 +400,14 @@ void pn_real_settle(pn_delivery_t *delivery);  // will free delivery if link is
 void pn_clear_tpwork(pn_delivery_t *delivery);
 void pn_work_update(pn_connection_t *connection, pn_delivery_t *delivery);
 void pn_clear_modified(pn_connection_t *connection, pn_endpoint_t *endpoint);
+pn_endpoint_list_t *pn_modified_list(pn_connection_t *connection, pn_endpoint_type_t type);
 void pn_connection_bound(pn_connection_t *conn);
 void pn_connection_unbound(pn_connection_t *conn);
 int pn_do_error(pn_transport_t *transport, const char *condition, const char *fmt, ...);
 void pn_set_error_layer(pn_transport_t *transport);
 void pn_session_unbound(pn_session_t* ssn);
 void pn_link_unbound(pn_link_t* link);
+void pni_link_unblocked(pn_link_t *link);
 void pn_ep_incref(pn_endpoint_t *endpoint);
 void pn_ep_decref(pn_endpoint_t *endpoint);
 
@@ -376,6 +415,9 @@ int pn_post_frame(pn_transport_t *transport, uint8_t type, uint16_t ch, const ch
 
 typedef enum {IN, OUT} pn_dir_t;
 
+void pni_trace_bin(pn_transport_t *transport, pn_dir_t dir, uint8_t type, uint16_t ch,
+                   const char *performative, size_t psize,
+                   const char *payload, pn_chain_t *chain, size_t payload_size);
 void pn_do_trace(pn_transport_t *transport, uint16_t ch, pn_dir_t dir,
                  pn_data_t *args, const char *payload, size_t size);
 
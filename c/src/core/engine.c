@@ -32,6 +32,7 @@
 #include "platform/platform.h"
 #include "platform/platform_fmt.h"
 #include "transport.h"
+#include "probes.h"
 
 static void pni_session_bound(pn_session_t *ssn);
 static void pni_link_bound(pn_link_t *link);
@@ -166,8 +167,13 @@ void pn_connection_unbound(pn_connection_t *connection)
     // connection has been freed prior to unbinding, thus it
     // cannot be re-assigned to a new transport.  Clear the
     // transport work lists to allow the connection to be freed.
-    while (connection->transport_head) {
-        pn_clear_modified(connection, connection->transport_head);
+    pn_endpoint_list_t *lists[] = {&connection->modified_connection,
+                                   &connection->modified_sessions,
+                                   &connection->modified_links};
+    for (size_t i = 0; i < sizeof(lists)/sizeof(lists[0]); ++i) {
+      while (lists[i]->transport_head) {
+        pn_clear_modified(connection, lists[i]->transport_head);
+      }
     }
     while (connection->tpwork_head) {
       pn_clear_tpwork(connection->tpwork_head);
@@ -201,6 +207,30 @@ pn_transport_t *pn_connection_transport(pn_connection_t *connection)
   return connection->transport;
 }
 
+pn_connection_stats_t pn_connection_stats(pn_connection_t *connection)
+{
+  assert(connection);
+  pn_transport_t *transport = connection->transport;
+  if (!transport) {
+    pn_connection_stats_t stats = {0};
+    return stats;
+  }
+  pn_connection_stats_t stats = transport->stats;
+  stats.frames_output = transport->output_frames_ct;
+  stats.frames_input = transport->input_frames_ct;
+  // Include sessions that are blocked right now
+  pn_timestamp_t now = 0;
+  size_t n = pn_list_size(connection->sessions);
+  for (size_t i = 0; i < n; ++i) {
+    pn_session_t *ssn = (pn_session_t *) pn_list_get(connection->sessions, i);
+    if (ssn->window_blocked_since) {
+      if (!now) now = pni_clock();
+      stats.window_blocked += now - ssn->window_blocked_since;
+    }
+  }
+  return stats;
+}
+
 void pn_condition_init(pn_condition_t *condition)
 {
   condition->name = pn_string(NULL);
@@ -518,8 +548,12 @@ pn_connection_t *pn_connection()
   conn->endpoint_head = NULL;
   conn->endpoint_tail = NULL;
   pn_endpoint_init(&conn->endpoint, CONNECTION, conn);
-  conn->transport_head = NULL;
-  conn->transport_tail = NULL;
+  conn->modified_connection.transport_head = NULL;
+  conn->modified_connection.transport_tail = NULL;
+  conn->modified_sessions.transport_head = NULL;
+  conn->modified_sessions.transport_tail = NULL;
+  conn->modified_links.transport_head = NULL;
+  conn->modified_links.transport_tail = NULL;
   conn->sessions = pn_list(PN_WEAKREF, 0);
   conn->freed = pn_list(PN_WEAKREF, 0);
   conn->transport = NULL;
@@ -749,9 +783,9 @@ void pn_clear_tpwork(pn_delivery_t *delivery)
   }
 }
 
-void pn_dump(pn_connection_t *conn)
+static void pni_dump_modified(pn_endpoint_list_t *list)
 {
-  pn_endpoint_t *endpoint = conn->transport_head;
+  pn_endpoint_t *endpoint = list->transport_head;
   while (endpoint)
   {
     printf("%p", (void *) endpoint);
@@ -762,10 +796,27 @@ void pn_dump(pn_connection_t *conn)
   printf("\n");
 }
 
+void pn_dump(pn_connection_t *conn)
+{
+  pni_dump_modified(&conn->modified_connection);
+  pni_dump_modified(&conn->modified_sessions);
+  pni_dump_modified(&conn->modified_links);
+}
+
+pn_endpoint_list_t *pn_modified_list(pn_connection_t *connection, pn_endpoint_type_t type)
+{
+  switch (type) {
+  case CONNECTION: return &connection->modified_connection;
+  case SESSION: return &connection->modified_sessions;
+  default: return &connection->modified_links;
+  }
+}
+
 void pn_modified(pn_connection_t *connection, pn_endpoint_t *endpoint, bool emit)
 {
   if (!endpoint->modified) {
-    LL_ADD(connection, transport, endpoint);
+    pn_endpoint_list_t *list = pn_modified_list(connection, endpoint->type);
+    LL_ADD(list, transport, endpoint);
     endpoint->modified = true;
   }
 
@@ -778,7 +829,8 @@ void pn_modified(pn_connection_t *connection, pn_endpoint_t *endpoint, bool emit
 void pn_clear_modified(pn_connection_t *connection, pn_endpoint_t *endpoint)
 {
   if (endpoint->modified) {
-    LL_REMOVE(connection, transport, endpoint);
+    pn_endpoint_list_t *list = pn_modified_list(connection, endpoint->type);
+    LL_REMOVE(list, transport, endpoint);
     endpoint->transport_next = NULL;
     endpoint->transport_prev = NULL;
     endpoint->modified = false;
@@ -931,7 +983,8 @@ static bool pni_preserve_child(pn_endpoint_t *endpoint)
     pn_decref(parent);
     return true;
   } else {
-    LL_REMOVE(conn, transport, endpoint);
+    pn_endpoint_list_t *list = pn_modified_list(conn, endpoint->type);
+    LL_REMOVE(list, transport, endpoint);
     return false;
   }
 }
@@ -994,6 +1047,7 @@ pn_session_t *pn_session(pn_connection_t *conn)
   ssn->incoming_deliveries = 0;
   ssn->outgoing_deliveries = 0;
   ssn->outgoing_window = AMQP_MAX_WINDOW_SIZE;
+  ssn->window_blocked_since = 0;
 
   // begin transport state
   memset(&ssn->state, 0, sizeof(ssn->state));
@@ -1122,6 +1176,7 @@ static void pn_link_finalize(void *object)
   }
 
   pn_free(link->context);
+  free(link->latency);
   pni_terminus_free(&link->source);
   pni_terminus_free(&link->target);
   pni_terminus_free(&link->remote_source);
@@ -1169,6 +1224,10 @@ pn_link_t *pn_link_new(int type, pn_session_t *session, const char *name)
   link->available = 0;
   link->credit = 0;
   link->queued = 0;
+  memset(&link->stats, 0, sizeof(link->stats));
+  link->credit_blocked_since = 0;
+  link->latency = NULL;
+  link->latency_tracking = false;
   link->drain = false;
   link->drain_flag_mode = true;
   link->drained = 0;
@@ -1178,6 +1237,7 @@ pn_link_t *pn_link_new(int type, pn_session_t *session, const char *name)
   link->remote_snd_settle_mode = PN_SND_MIXED;
   link->remote_rcv_settle_mode = PN_RCV_FIRST;
   link->detached = false;
+  link->flow_event_queued = false;
 
   // begin transport state
   link->state.local_handle = -1;
@@ -1205,6 +1265,7 @@ void pn_link_unbound(pn_link_t* link)
   link->state.remote_handle = -1;
   link->state.delivery_count = 0;
   link->state.link_credit = 0;
+  pni_link_unblocked(link);
 }
 
 pn_terminus_t *pn_link_source(pn_link_t *link)
@@ -1453,7 +1514,7 @@ static void pn_delivery_finalize(void *object)
                         : &link->session->state.incoming,
                         delivery);
     pn_buffer_clear(delivery->tag);
-    pn_buffer_clear(delivery->bytes);
+    pn_chain_clear(delivery->bytes);
     pn_record_clear(delivery->context);
     delivery->settled = true;
     pn_connection_t *conn = link->session->connection;
@@ -1470,7 +1531,7 @@ static void pn_delivery_finalize(void *object)
   if (!pooled) {
     pn_free(delivery->context);
     pn_buffer_free(delivery->tag);
-    pn_buffer_free(delivery->bytes);
+    pn_chain_free(delivery->bytes);
     pn_disposition_finalize(&delivery->local);
     pn_disposition_finalize(&delivery->remote);
   }
@@ -1537,7 +1598,7 @@ pn_delivery_t *pn_delivery(pn_link_t *link, pn_delivery_tag_t tag)
     delivery = (pn_delivery_t *) pn_class_new(&clazz, sizeof(pn_delivery_t));
     if (!delivery) return NULL;
     delivery->tag = pn_buffer(16);
-    delivery->bytes = pn_buffer(64);
+    delivery->bytes = pn_chain(PNI_CHAIN_SEGMENT_MIN);
     pn_disposition_init(&delivery->local);
     pn_disposition_init(&delivery->remote);
     delivery->context = pn_record();
@@ -1560,9 +1621,11 @@ pn_delivery_t *pn_delivery(pn_link_t *link, pn_delivery_tag_t tag)
   delivery->tpwork_next = NULL;
   delivery->tpwork_prev = NULL;
   delivery->tpwork = false;
-  pn_buffer_clear(delivery->bytes);
+  pn_chain_clear(delivery->bytes);
+  memset(&delivery->latency, 0, sizeof(delivery->latency));
   delivery->done = false;
   delivery->aborted = false;
+  delivery->event_queued = false;
   pn_record_clear(delivery->context);
 
   // begin delivery state
@@ -1575,6 +1638,7 @@ pn_delivery_t *pn_delivery(pn_link_t *link, pn_delivery_tag_t tag)
     link->current = delivery;
 
   link->unsettled_count++;
+  PN_PROBE2(delivery_create, delivery, link);
 
   pn_work_update(link->session->connection, delivery);
 
@@ -1593,7 +1657,7 @@ bool pn_delivery_buffered(pn_delivery_t *delivery)
     if (state->sent) {
       return false;
     } else {
-      return delivery->done || (pn_buffer_size(delivery->bytes) > 0);
+      return delivery->done || (pn_chain_size(delivery->bytes) > 0);
     }
   } else {
     return false;
@@ -1772,8 +1836,8 @@ static void pni_advance_receiver(pn_link_t *link)
   link->session->incoming_deliveries--;
 
   pn_delivery_t *current = link->current;
-  link->session->incoming_bytes -= pn_buffer_size(current->bytes);
-  pn_buffer_clear(current->bytes);
+  link->session->incoming_bytes -= pn_chain_size(current->bytes);
+  pn_chain_clear(current->bytes);
 
   if (!link->session->state.incoming_window) {
     pni_add_tpwork(current);
@@ -1871,7 +1935,9 @@ void pn_delivery_settle(pn_delivery_t *delivery)
     }
 
     link->unsettled_count--;
+    link->stats.settled++;
     delivery->local.settled = true;
+    PN_PROBE2(delivery_settle, delivery, link);
     pni_add_tpwork(delivery);
     pn_work_update(delivery->link->session->connection, delivery);
     pn_incref(delivery);
@@ -1889,7 +1955,27 @@ ssize_t pn_link_send(pn_link_t *sender, const char *bytes, size_t n)
   pn_delivery_t *current = pn_link_current(sender);
   if (!current) return PN_EOS;
   if (!bytes || !n) return 0;
-  pn_buffer_append(current->bytes, bytes, n);
+  if (sender->latency_tracking && !current->latency.sent) {
+    current->latency.sent = pni_clock_us();
+  }
+  pn_chain_append(current->bytes, bytes, n);
+  sender->session->outgoing_bytes += n;
+  pni_add_tpwork(current);
+  return n;
+}
+
+ssize_t pn_link_send_shared(pn_link_t *sender, pn_shared_bytes_t *shared)
+{
+  pn_delivery_t *current = pn_link_current(sender);
+  if (!current) return PN_EOS;
+  if (!shared) return 0;
+  size_t n = pn_shared_bytes_get(shared).size;
+  if (!n) return 0;
+  if (sender->latency_tracking && !current->latency.sent) {
+    current->latency.sent = pni_clock_us();
+  }
+  int err = pn_chain_append_shared(current->bytes, shared, 0, n);
+  if (err) return err;
   sender->session->outgoing_bytes += n;
   pni_add_tpwork(current);
   return n;
@@ -1921,8 +2007,8 @@ ssize_t pn_link_recv(pn_link_t *receiver, char *bytes, size_t n)
   pn_delivery_t *delivery = receiver->current;
   if (!delivery) return PN_STATE_ERR;
   if (delivery->aborted) return PN_ABORTED;
-  size_t size = pn_buffer_get(delivery->bytes, 0, n, bytes);
-  pn_buffer_trim(delivery->bytes, size, 0);
+  size_t size = pn_chain_get(delivery->bytes, 0, n, bytes);
+  pn_chain_trim(delivery->bytes, size);
   if (size) {
     receiver->session->incoming_bytes -= size;
     if (!receiver->session->state.incoming_window) {
@@ -1940,6 +2026,7 @@ void pn_link_flow(pn_link_t *receiver, int credit)
   assert(receiver);
   assert(pn_link_is_receiver(receiver));
   receiver->credit += credit;
+  PN_PROBE2(link_flow, receiver, receiver->credit);
   pn_modified(receiver->session->connection, &receiver->endpoint, true);
   if (!receiver->drain_flag_mode) {
     pn_link_set_drain(receiver, false);
@@ -1987,6 +2074,48 @@ uint64_t pn_link_remote_max_message_size(pn_link_t *link)
   return link->remote_max_message_size;
 }
 
+// Stop timing a sender held back by credit, if it was
+void pni_link_unblocked(pn_link_t *link)
+{
+  if (link->credit_blocked_since) {
+    link->stats.credit_blocked += pni_clock() - link->credit_blocked_since;
+    link->credit_blocked_since = 0;
+  }
+}
+
+pn_link_stats_t pn_link_stats(pn_link_t *link)
+{
+  assert(link);
+  pn_link_stats_t stats = link->stats;
+  if (link->credit_blocked_since) {
+    stats.credit_blocked += pni_clock() - link->credit_blocked_since;
+  }
+  return stats;
+}
+
+void pn_link_set_latency_tracking(pn_link_t *sender, bool enabled)
+{
+  assert(sender);
+  if (enabled && !sender->latency) {
+    sender->latency = (pn_histogram_t *) calloc(PN_LATENCY_TOTAL + 1, sizeof(pn_histogram_t));
+    if (!sender->latency) return;
+  }
+  sender->latency_tracking = enabled;
+}
+
+bool pn_link_get_latency_tracking(pn_link_t *link)
+{
+  assert(link);
+  return link->latency_tracking;
+}
+
+pn_histogram_t *pn_link_latency(pn_link_t *link, pn_latency_stage_t stage)
+{
+  assert(link);
+  if (!link->latency || (unsigned) stage > PN_LATENCY_TOTAL) return NULL;
+  return &link->latency[stage];
+}
+
 pn_link_t *pn_delivery_link(pn_delivery_t *delivery)
 {
   assert(delivery);
@@ -2065,7 +2194,7 @@ size_t pn_delivery_pending(pn_delivery_t *delivery)
      the PN_ABORTED error return code.
   */
   if (delivery->aborted) return 1;
-  return pn_buffer_size(delivery->bytes);
+  return pn_chain_size(delivery->bytes);
 }
 
 bool pn_delivery_partial(pn_delivery_t *delivery)
@@ -2075,6 +2204,14 @@ bool pn_delivery_partial(pn_delivery_t *delivery)
 
 void pn_delivery_abort(pn_delivery_t *delivery) {
   if (!delivery->local.settled) { /* Can't abort a settled delivery */
+    pn_link_t *link = delivery->link;
+    if (pn_link_is_sender(link) && delivery->done && !delivery->state.sending) {
+      /* Advanced but no frames sent, it will be dropped. Undo the accounting in
+         pni_advance_sender() so the link doesn't appear to have data queued. */
+      link->queued--;
+      link->credit++;
+      link->session->outgoing_deliveries--;
+    }
     delivery->aborted = true;
     pn_delivery_settle(delivery);
   }
@@ -24,12 +24,19 @@
 #include <proton/reactor.h>
 #include <assert.h>
 
+#include "engine-internal.h"
+#include "probes.h"
+
+/* Number of events allocated up front when coalescing is enabled */
+#define PN_COLLECTOR_PREALLOC 64
+
 struct pn_collector_t {
   pn_list_t *pool;
   pn_event_t *head;
   pn_event_t *tail;
   pn_event_t *prev;         /* event returned by previous call to pn_collector_next() */
   bool freed;
+  bool coalesce;
 };
 
 struct pn_event_t {
@@ -39,6 +46,7 @@ struct pn_event_t {
   pn_record_t *attachments;
   pn_event_t *next;
   pn_event_type_t type;
+  bool coalesced;   // set the queued flag of its context, see pni_event_queued()
 };
 
 static void pn_collector_initialize(pn_collector_t *collector)
@@ -48,6 +56,7 @@ static void pn_collector_initialize(pn_collector_t *collector)
   collector->tail = NULL;
   collector->prev = NULL;
   collector->freed = false;
+  collector->coalesce = false;
 }
 
 void pn_collector_drain(pn_collector_t *collector)
@@ -121,6 +130,40 @@ void pn_collector_release(pn_collector_t *collector)
 
 pn_event_t *pn_event(void);
 
+void pn_collector_coalesce(pn_collector_t *collector, bool coalesce)
+{
+  assert(collector);
+  collector->coalesce = coalesce;
+  if (coalesce && !collector->freed) {
+    /* Events are returned to the pool when finalized, so after this the
+       collector only allocates if more events are outstanding at once. */
+    for (size_t n = pn_list_size(collector->pool); n < PN_COLLECTOR_PREALLOC; ++n) {
+      pn_event_t *event = pn_event();
+      pn_list_add(collector->pool, event);
+      pn_decref(event);
+    }
+  }
+}
+
+/* Flag on the context object that records that an event of this type is
+   queued on a coalescing collector, or NULL if the event type is never
+   coalesced. Only notifications that mean "look at the current state of
+   this object" are coalesced, the handler loses nothing by seeing one of
+   them instead of several. */
+static bool *pni_event_queued(const pn_class_t *clazz, void *context, pn_event_type_t type)
+{
+  switch (type) {
+  case PN_DELIVERY:
+    return pn_class_id(clazz) == CID_pn_delivery ? &((pn_delivery_t *) context)->event_queued : NULL;
+  case PN_LINK_FLOW:
+    return pn_class_id(clazz) == CID_pn_link ? &((pn_link_t *) context)->flow_event_queued : NULL;
+  case PN_TRANSPORT:
+    return pn_class_id(clazz) == CID_pn_transport ? &((pn_transport_t *) context)->event_queued : NULL;
+  default:
+    return NULL;
+  }
+}
+
 pn_event_t *pn_collector_put(pn_collector_t *collector,
                              const pn_class_t *clazz, void *context,
                              pn_event_type_t type)
@@ -142,6 +185,12 @@ pn_event_t *pn_collector_put(pn_collector_t *collector,
 
   clazz = clazz->reify(context);
 
+  bool *queued = collector->coalesce ? pni_event_queued(clazz, context, type) : NULL;
+  if (queued) {
+    if (*queued) return NULL;
+    *queued = true;
+  }
+
   pn_event_t *event = (pn_event_t *) pn_list_pop(collector->pool);
 
   if (!event) {
@@ -162,7 +211,9 @@ pn_event_t *pn_collector_put(pn_collector_t *collector,
   event->clazz = clazz;
   event->context = context;
   event->type = type;
+  event->coalesced = (queued != NULL);
   pn_class_incref(clazz, event->context);
+  PN_PROBE3(event_put, collector, type, context);
 
   return event;
 }
@@ -176,10 +227,16 @@ pn_event_t *pn_collector_peek(pn_collector_t *collector)
 static pn_event_t *pop_internal(pn_collector_t *collector) {
   pn_event_t *event = collector->head;
   if (event) {
+    PN_PROBE3(event_get, collector, event->type, event->context);
     collector->head = event->next;
     if (!collector->head) {
       collector->tail = NULL;
     }
+    if (event->coalesced) {
+      /* Changes made from now on need a new event */
+      *pni_event_queued(event->clazz, event->context, event->type) = false;
+      event->coalesced = false;
+    }
   }
   return event;
 }
@@ -217,6 +274,7 @@ static void pn_event_initialize(pn_event_t *event)
   event->clazz = NULL;
   event->context = NULL;
   event->next = NULL;
+  event->coalesced = false;
   event->attachments = pn_record();
 }
 
@@ -83,26 +83,30 @@ ssize_t pn_read_frame(pn_frame_t *frame, const char *bytes, size_t available, ui
   return size;
 }
 
-size_t pn_write_frame(pn_buffer_t* buffer, pn_frame_t frame)
+size_t pn_write_frame(pn_chain_t* output, pn_frame_t frame)
 {
-  size_t size = AMQP_HEADER_SIZE + frame.ex_size + frame.size;
-  if (size <= pn_buffer_available(buffer))
-  {
-    // Prepare header
-    char bytes[8];
-    pn_i_write32(&bytes[0], size);
-    int doff = (frame.ex_size + AMQP_HEADER_SIZE - 1)/4 + 1;
-    bytes[4] = doff;
-    bytes[5] = frame.type;
-    pn_i_write16(&bytes[6], frame.channel);
+  return pn_write_frame_payload(output, frame, NULL, 0);
+}
+
+size_t pn_write_frame_payload(pn_chain_t* output, pn_frame_t frame, pn_chain_t* payload, size_t size)
+{
+  size_t frame_size = AMQP_HEADER_SIZE + frame.ex_size + frame.size + size;
+
+  // Prepare header
+  char bytes[8];
+  pn_i_write32(&bytes[0], frame_size);
+  int doff = (frame.ex_size + AMQP_HEADER_SIZE - 1)/4 + 1;
+  bytes[4] = doff;
+  bytes[5] = frame.type;
+  pn_i_write16(&bytes[6], frame.channel);
 
-    // Write header then rest of frame
-    pn_buffer_append(buffer, bytes, 8);
-    if (frame.extended)
-        pn_buffer_append(buffer, frame.extended, frame.ex_size);
-    pn_buffer_append(buffer, frame.payload, frame.size);
-    return size;
-  } else {
-    return 0;
-  }
+  // Write header then rest of frame
+  int err = pn_chain_append(output, bytes, 8);
+  if (!err && frame.extended)
+    err = pn_chain_append(output, frame.extended, frame.ex_size);
+  if (!err)
+    err = pn_chain_append(output, frame.payload, frame.size);
+  if (!err && size)
+    err = pn_chain_copy(output, payload, size);
+  return err ? 0 : frame_size;
 }
@@ -22,7 +22,7 @@
  *
  */
 
-#include "buffer.h"
+#include "chain.h"
 
 #include <proton/import_export.h>
 #include <proton/type_compat.h>
@@ -42,6 +42,9 @@ typedef struct {
 } pn_frame_t;
 
 ssize_t pn_read_frame(pn_frame_t *frame, const char *bytes, size_t available, uint32_t max);
-size_t pn_write_frame(pn_buffer_t* buffer, pn_frame_t frame);
+size_t pn_write_frame(pn_chain_t* output, pn_frame_t frame);
+// As pn_write_frame, but the frame body is frame.payload followed by the
+// first size bytes of payload. payload is not modified.
+size_t pn_write_frame_payload(pn_chain_t* output, pn_frame_t frame, pn_chain_t* payload, size_t size);
 
 #endif /* framing.h */
@@ -0,0 +1,132 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "histogram_private.h"
+
+#define PNI_HISTOGRAM_SUB (1 << PNI_HISTOGRAM_SUB_BITS)
+
+// Index of the most significant set bit, value must not be 0
+static inline unsigned pni_msb(uint64_t value)
+{
+#if defined(__GNUC__)
+  return 63 - __builtin_clzll(value);
+#else
+  unsigned bit = 0;
+  while (value >>= 1) bit++;
+  return bit;
+#endif
+}
+
+static inline size_t pni_bucket(uint64_t value)
+{
+  if (value < PNI_HISTOGRAM_SUB) return value;
+  if (value >> PNI_HISTOGRAM_MAX_BITS) return PNI_HISTOGRAM_BUCKETS - 1;
+  unsigned shift = pni_msb(value) - PNI_HISTOGRAM_SUB_BITS;
+  return ((size_t) (shift + 1) << PNI_HISTOGRAM_SUB_BITS) + ((value >> shift) & (PNI_HISTOGRAM_SUB - 1));
+}
+
+// The highest value that goes in a bucket
+static inline uint64_t pni_bucket_top(size_t bucket)
+{
+  if (bucket < PNI_HISTOGRAM_SUB) return bucket;
+  unsigned shift = (bucket >> PNI_HISTOGRAM_SUB_BITS) - 1;
+  uint64_t low = (uint64_t) (PNI_HISTOGRAM_SUB + (bucket & (PNI_HISTOGRAM_SUB - 1))) << shift;
+  return low + ((uint64_t) 1 << shift) - 1;
+}
+
+pn_histogram_t *pn_histogram(void)
+{
+  return (pn_histogram_t *) calloc(1, sizeof(pn_histogram_t));
+}
+
+void pn_histogram_free(pn_histogram_t *histogram)
+{
+  free(histogram);
+}
+
+void pn_histogram_record(pn_histogram_t *histogram, uint64_t value)
+{
+  if (!histogram->count || value < histogram->min) histogram->min = value;
+  if (value > histogram->max) histogram->max = value;
+  histogram->count++;
+  histogram->sum += value;
+  histogram->buckets[pni_bucket(value)]++;
+}
+
+void pn_histogram_add(pn_histogram_t *histogram, const pn_histogram_t *source)
+{
+  if (!source->count) return;
+  if (!histogram->count || source->min < histogram->min) histogram->min = source->min;
+  if (source->max > histogram->max) histogram->max = source->max;
+  histogram->count += source->count;
+  histogram->sum += source->sum;
+  for (size_t i = 0; i < PNI_HISTOGRAM_BUCKETS; ++i) {
+    histogram->buckets[i] += source->buckets[i];
+  }
+}
+
+uint64_t pn_histogram_count(const pn_histogram_t *histogram)
+{
+  return histogram->count;
+}
+
+uint64_t pn_histogram_min(const pn_histogram_t *histogram)
+{
+  return histogram->min;
+}
+
+uint64_t pn_histogram_max(const pn_histogram_t *histogram)
+{
+  return histogram->max;
+}
+
+double pn_histogram_mean(const pn_histogram_t *histogram)
+{
+  return histogram->count ? (double) histogram->sum / histogram->count : 0.0;
+}
+
+uint64_t pn_histogram_percentile(const pn_histogram_t *histogram, double percentile)
+{
+  if (!histogram->count) return 0;
+  if (percentile < 0) percentile = 0;
+  if (percentile > 100) percentile = 100;
+  uint64_t rank = (uint64_t) (percentile / 100 * histogram->count + 0.5);
+  if (rank < 1) rank = 1;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < PNI_HISTOGRAM_BUCKETS; ++i) {
+    seen += histogram->buckets[i];
+    if (seen >= rank) {
+      uint64_t top = pni_bucket_top(i);
+      return top < histogram->max ? top : histogram->max;
+    }
+  }
+  assert(false);
+  return histogram->max;
+}
+
+void pn_histogram_clear(pn_histogram_t *histogram)
+{
+  memset(histogram, 0, sizeof(*histogram));
+}
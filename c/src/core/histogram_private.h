@@ -0,0 +1,44 @@
+#ifndef PROTON_HISTOGRAM_PRIVATE_H
+#define PROTON_HISTOGRAM_PRIVATE_H 1
+
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include <proton/histogram.h>
+
+/*
+ * Log-linear buckets: values below 2^PNI_HISTOGRAM_SUB_BITS have a bucket
+ * each, above that every power of two is split into 2^PNI_HISTOGRAM_SUB_BITS
+ * buckets. Values of 2^PNI_HISTOGRAM_MAX_BITS or more go in the last bucket.
+ */
+#define PNI_HISTOGRAM_SUB_BITS (3)
+#define PNI_HISTOGRAM_MAX_BITS (36)
+#define PNI_HISTOGRAM_BUCKETS ((PNI_HISTOGRAM_MAX_BITS - PNI_HISTOGRAM_SUB_BITS + 1) << PNI_HISTOGRAM_SUB_BITS)
+
+struct pn_histogram_t {
+  uint64_t count;
+  uint64_t min;
+  uint64_t max;
+  uint64_t sum;
+  uint64_t buckets[PNI_HISTOGRAM_BUCKETS];
+};
+
+#endif /* histogram_private.h */
@@ -923,6 +923,18 @@ ssize_t pn_message_encode2(pn_message_t *msg, pn_rwbytes_t *buffer) {
   return err == 0 ? (ssize_t)size : err;
 }
 
+pn_shared_bytes_t *pn_message_encode_shared(pn_message_t *msg) {
+  pn_rwbytes_t buffer = { 0 };
+  pn_shared_bytes_t *shared = NULL;
+  ssize_t size = pn_message_encode2(msg, &buffer);
+  if (size >= 0) {
+    shared = pn_shared_bytes(buffer.start, size);
+    if (!shared) pn_error_set(pn_message_error(msg), PN_OUT_OF_MEMORY, "cannot allocate shared message");
+  }
+  free(buffer.start);
+  return shared;
+}
+
 ssize_t pn_message_send(pn_message_t *msg, pn_link_t *sender, pn_rwbytes_t *buffer) {
   pn_rwbytes_t local_buf = { 0 };
   if (!buffer) buffer = &local_buf;
@@ -20,9 +20,21 @@
  */
 
 #include <proton/object.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
 
+#if defined(__GNUC__)
+/* Builtins below */
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__sun)
+#include <atomic.h>
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+#define PNI_STDATOMIC 1
+#include <stdatomic.h>
+#endif
+
 #define pn_object_initialize NULL
 #define pn_object_finalize NULL
 #define pn_object_inspect NULL
@@ -82,14 +94,23 @@ int pn_class_refcount(const pn_class_t *clazz, void *object)
   return clazz->refcount(object);
 }
 
+static int pni_object_atomic_release(void *object);
+
 int pn_class_decref(const pn_class_t *clazz, void *object)
 {
   assert(clazz);
 
   if (object) {
     clazz = clazz->reify(object);
-    clazz->decref(object);
-    int rc = clazz->refcount(object);
+    int rc;
+    if (clazz->decref == pn_object_atomic_decref) {
+      // Other threads may release at the same time, so only the count this
+      // thread's decrement produced can say if it was the last reference.
+      rc = pni_object_atomic_release(object);
+    } else {
+      clazz->decref(object);
+      rc = clazz->refcount(object);
+    }
     if (rc == 0) {
       if (clazz->finalize) {
         clazz->finalize(object);
@@ -243,6 +264,70 @@ void pn_object_free(void *object)
   free(head);
 }
 
+/*
+ * Atomic reference counts for objects shared between threads. Taking a
+ * reference needs no ordering, the thread that gives one up must publish its
+ * writes to whichever thread frees the object, so the decrement is a release
+ * and the final one an acquire as well.
+ */
+#if defined(__GNUC__)
+#define pni_atomic_inc(P) __atomic_add_fetch((P), 1, __ATOMIC_RELAXED)
+#define pni_atomic_dec(P) __atomic_sub_fetch((P), 1, __ATOMIC_ACQ_REL)
+#define pni_atomic_load(P) __atomic_load_n((P), __ATOMIC_ACQUIRE)
+#elif defined(_MSC_VER)
+#define pni_atomic_inc(P) _InterlockedIncrement((volatile long *) (P))
+#define pni_atomic_dec(P) _InterlockedDecrement((volatile long *) (P))
+#define pni_atomic_load(P) (*(volatile int *) (P))
+#elif defined(__sun)
+#define pni_atomic_inc(P) ((int) atomic_inc_uint_nv((volatile uint_t *) (P)))
+#define pni_atomic_load(P) (*(volatile int *) (P))
+static inline int pni_atomic_dec(int *p) {
+  membar_exit();
+  int rc = (int) atomic_dec_uint_nv((volatile uint_t *) p);
+  if (rc == 0) membar_enter();
+  return rc;
+}
+#elif defined(PNI_STDATOMIC)
+#define pni_atomic_inc(P) ((void) atomic_fetch_add_explicit((_Atomic int *) (P), 1, memory_order_relaxed))
+#define pni_atomic_dec(P) (atomic_fetch_sub_explicit((_Atomic int *) (P), 1, memory_order_acq_rel) - 1)
+#define pni_atomic_load(P) atomic_load_explicit((_Atomic int *) (P), memory_order_acquire)
+#else
+/* Only objects of a PN_ATOMIC_CLASS need atomics, fail if one is used */
+static int pni_atomic_missing(void) {
+  fprintf(stderr, "proton: atomic reference counts are not implemented for this compiler\n");
+  abort();
+  return 0;
+}
+#define pni_atomic_inc(P) ((void) (P), (void) pni_atomic_missing())
+#define pni_atomic_dec(P) ((void) (P), pni_atomic_missing())
+#define pni_atomic_load(P) ((void) (P), pni_atomic_missing())
+#endif
+
+void pn_object_atomic_incref(void *object)
+{
+  if (object) {
+    pni_atomic_inc(&pni_head(object)->refcount);
+  }
+}
+
+int pn_object_atomic_refcount(void *object)
+{
+  assert(object);
+  return pni_atomic_load(&pni_head(object)->refcount);
+}
+
+static int pni_object_atomic_release(void *object)
+{
+  int rc = pni_atomic_dec(&pni_head(object)->refcount);
+  assert(rc >= 0);
+  return rc;
+}
+
+void pn_object_atomic_decref(void *object)
+{
+  pni_object_atomic_release(object);
+}
+
 void *pn_incref(void *object)
 {
   return pn_class_incref(PN_OBJECT, object);
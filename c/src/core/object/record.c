@@ -29,7 +29,12 @@ typedef struct {
   void *value;
 } pni_field_t;
 
+/*
+ * PN_LEGCTX is defined on every record so it is kept inline in legctx, other
+ * handles are searched for in fields[].
+ */
 struct pn_record_t {
+  pni_field_t legctx;
   size_t size;
   size_t capacity;
   pni_field_t *fields;
@@ -38,6 +43,9 @@ struct pn_record_t {
 static void pn_record_initialize(void *object)
 {
   pn_record_t *record = (pn_record_t *) object;
+  record->legctx.key = PN_LEGCTX;
+  record->legctx.clazz = PN_VOID;
+  record->legctx.value = NULL;
   record->size = 0;
   record->capacity = 0;
   record->fields = NULL;
@@ -60,12 +68,13 @@ static void pn_record_finalize(void *object)
 pn_record_t *pn_record(void)
 {
   static const pn_class_t clazz = PN_CLASS(pn_record);
-  pn_record_t *record = (pn_record_t *) pn_class_new(&clazz, sizeof(pn_record_t));
-  pn_record_def(record, PN_LEGCTX, PN_VOID);
-  return record;
+  return (pn_record_t *) pn_class_new(&clazz, sizeof(pn_record_t));
 }
 
-static pni_field_t *pni_record_find(pn_record_t *record, pn_handle_t key) {
+static inline pni_field_t *pni_record_find(pn_record_t *record, pn_handle_t key) {
+  if (key == PN_LEGCTX) {
+    return &record->legctx;
+  }
   for (size_t i = 0; i < record->size; i++) {
     pni_field_t *field = &record->fields[i];
     if (field->key == key) {
@@ -75,14 +84,16 @@ static pni_field_t *pni_record_find(pn_record_t *record, pn_handle_t key) {
   return NULL;
 }
 
-static pni_field_t *pni_record_create(pn_record_t *record) {
-  record->size++;
-  if (record->size > record->capacity) {
-    record->fields = (pni_field_t *) realloc(record->fields, record->size * sizeof(pni_field_t));
-    record->capacity = record->size;
+static pni_field_t *pni_record_create(pn_record_t *record, pn_handle_t key) {
+  if (record->size == record->capacity) {
+    size_t capacity = record->capacity ? 2 * record->capacity : 4;
+    pni_field_t *fields = (pni_field_t *) realloc(record->fields, capacity * sizeof(pni_field_t));
+    if (!fields) return NULL;
+    record->fields = fields;
+    record->capacity = capacity;
   }
-  pni_field_t *field = &record->fields[record->size - 1];
-  field->key = 0;
+  pni_field_t *field = &record->fields[record->size++];
+  field->key = key;
   field->clazz = NULL;
   field->value = NULL;
   return field;
@@ -97,9 +108,8 @@ void pn_record_def(pn_record_t *record, pn_handle_t key, const pn_class_t *clazz
   if (field) {
     assert(field->clazz == clazz);
   } else {
-    field = pni_record_create(record);
-    field->key = key;
-    field->clazz = clazz;
+    field = pni_record_create(record, key);
+    if (field) field->clazz = clazz;
   }
 }
 
@@ -141,6 +151,7 @@ void pn_record_set(pn_record_t *record, pn_handle_t key, void *value)
 void pn_record_clear(pn_record_t *record)
 {
   assert(record);
+  record->legctx.value = NULL;
   for (size_t i = 0; i < record->size; i++) {
     pni_field_t *field = &record->fields[i];
     pn_class_decref(field->clazz, field->value);
@@ -149,5 +160,4 @@ void pn_record_clear(pn_record_t *record)
     field->value = NULL;
   }
   record->size = 0;
-  pn_record_def(record, PN_LEGCTX, PN_VOID);
 }
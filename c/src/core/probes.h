@@ -0,0 +1,76 @@
+#ifndef PROTON_PROBES_H
+#define PROTON_PROBES_H 1
+
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+/*
+ * USDT static probes for bpftrace, perf and systemtap.
+ *
+ * Probes are compiled in when proton is configured with
+ * -DENABLE_USDT_PROBES=ON, which needs <sys/sdt.h>, and are compiled out
+ * completely otherwise. A probe is a nop instruction plus an ELF note that
+ * names it, so a probe that is not attached costs no more than working out
+ * its arguments, which are all values already at hand. List the probes in a
+ * library with `readelf -n`, and attach to one with for example:
+ *
+ *   bpftrace -e 'usdt:/usr/lib64/libqpid-proton-core.so:proton:frame_write { @[arg2] = count(); }'
+ *
+ * Probes of the "proton" provider, in libqpid-proton-core:
+ *
+ *   frame_read(transport, channel, type, size)       a frame was received, size is of the frame body
+ *   frame_write(transport, channel, type, size)      a frame was written to the output
+ *   delivery_create(delivery, link)
+ *   delivery_settle(delivery, link)                  settled locally
+ *   delivery_remote_settle(delivery, link, state)    settled by the peer, state is PN_ACCEPTED etc. or 0
+ *   link_flow(link, credit)                          a receiver gave credit, credit is the new total
+ *   link_remote_flow(link, credit)                   the peer gave a sender credit, credit is the new total
+ *   event_put(collector, type, context)              an event was queued
+ *   event_get(collector, type, context)              an event was taken from the queue
+ *
+ * and in libqpid-proton-proactor, for the epoll proactor:
+ *
+ *   wake(context)                                    a connection, listener or the proactor was woken
+ *   wake_handled(context)                            a thread is handling the wake
+ *   rearm(fd, events)                                a file descriptor was re-armed in epoll
+ *
+ * Pointers identify objects, they can be matched between probes.
+ */
+
+#ifdef PN_USDT_PROBES
+
+#include <sys/sdt.h>
+
+#define PN_PROBE1(name, a) DTRACE_PROBE1(proton, name, a)
+#define PN_PROBE2(name, a, b) DTRACE_PROBE2(proton, name, a, b)
+#define PN_PROBE3(name, a, b, c) DTRACE_PROBE3(proton, name, a, b, c)
+#define PN_PROBE4(name, a, b, c, d) DTRACE_PROBE4(proton, name, a, b, c, d)
+
+#else
+
+#define PN_PROBE1(name, a) ((void) 0)
+#define PN_PROBE2(name, a, b) ((void) 0)
+#define PN_PROBE3(name, a, b, c) ((void) 0)
+#define PN_PROBE4(name, a, b, c, d) ((void) 0)
+
+#endif
+
+#endif /* probes.h */
@@ -0,0 +1,68 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include <proton/object.h>
+#include <proton/shared_bytes.h>
+#include <string.h>
+
+struct pn_shared_bytes_t {
+  size_t size;
+  /* The bytes follow in the same allocation */
+};
+
+#define CID_pn_shared_bytes CID_pn_object
+#define pn_shared_bytes_initialize NULL
+#define pn_shared_bytes_finalize NULL
+#define pn_shared_bytes_hashcode NULL
+#define pn_shared_bytes_compare NULL
+#define pn_shared_bytes_inspect NULL
+
+static const pn_class_t pn_shared_bytes_class = PN_ATOMIC_CLASS(pn_shared_bytes);
+
+static inline char *pni_shared_bytes_start(pn_shared_bytes_t *shared)
+{
+  return (char *) (shared + 1);
+}
+
+pn_shared_bytes_t *pn_shared_bytes(const char *bytes, size_t size)
+{
+  pn_shared_bytes_t *shared =
+    (pn_shared_bytes_t *) pn_class_new(&pn_shared_bytes_class, sizeof(pn_shared_bytes_t) + size);
+  if (!shared) return NULL;
+  shared->size = size;
+  if (size) memcpy(pni_shared_bytes_start(shared), bytes, size);
+  return shared;
+}
+
+pn_shared_bytes_t *pn_shared_bytes_incref(pn_shared_bytes_t *shared)
+{
+  return (pn_shared_bytes_t *) pn_class_incref(&pn_shared_bytes_class, shared);
+}
+
+void pn_shared_bytes_decref(pn_shared_bytes_t *shared)
+{
+  pn_class_decref(&pn_shared_bytes_class, shared);
+}
+
+pn_bytes_t pn_shared_bytes_get(pn_shared_bytes_t *shared)
+{
+  return pn_bytes(shared->size, pni_shared_bytes_start(shared));
+}
@@ -0,0 +1,136 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include <proton/error.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace_ring.h"
+#include "util.h"
+
+struct pni_trace_ring_t {
+  char *bytes;
+  size_t capacity;
+  size_t head;                  /* Offset of the oldest record */
+  size_t used;
+  size_t payload;
+};
+
+pni_trace_ring_t *pni_trace_ring(size_t capacity, size_t payload)
+{
+  pni_trace_ring_t *ring = (pni_trace_ring_t *) malloc(sizeof(pni_trace_ring_t));
+  if (!ring) return NULL;
+  ring->capacity = pn_max(capacity, 2 * PNI_TRACE_RECORD_HEADER);
+  ring->bytes = (char *) malloc(ring->capacity);
+  if (!ring->bytes) {
+    free(ring);
+    return NULL;
+  }
+  ring->head = 0;
+  ring->used = 0;
+  ring->payload = pn_min(payload, PNI_TRACE_PAYLOAD_MAX);
+  return ring;
+}
+
+void pni_trace_ring_free(pni_trace_ring_t *ring)
+{
+  if (!ring) return;
+  free(ring->bytes);
+  free(ring);
+}
+
+size_t pni_trace_ring_payload(pni_trace_ring_t *ring)
+{
+  return ring->payload;
+}
+
+static size_t pni_ring_write(pni_trace_ring_t *ring, size_t offset, const char *src, size_t n)
+{
+  if (!n) return offset;
+  size_t first = pn_min(n, ring->capacity - offset);
+  memcpy(ring->bytes + offset, src, first);
+  memcpy(ring->bytes, src + first, n - first);
+  offset += n;
+  return offset >= ring->capacity ? offset - ring->capacity : offset;
+}
+
+static uint32_t pni_ring_read_length(pni_trace_ring_t *ring, size_t offset)
+{
+  uint32_t length = 0;
+  for (int i = 0; i < 4; ++i) {
+    length = (length << 8) | (uint8_t) ring->bytes[(offset + i) % ring->capacity];
+  }
+  return length;
+}
+
+static char *pni_put_uint(char *p, uint64_t value, int size)
+{
+  for (int i = size - 1; i >= 0; --i) {
+    *p++ = (char) (0xFF & (value >> (8 * i)));
+  }
+  return p;
+}
+
+void pni_trace_ring_add(pni_trace_ring_t *ring, uint64_t time, bool out, uint8_t type, uint16_t channel,
+                        size_t size, const char *performative, size_t psize, const char *payload, size_t n)
+{
+  n = pn_min(n, ring->payload);
+  // A record must fit in the ring, the performative is truncated if it has to be
+  size_t room = ring->capacity - PNI_TRACE_RECORD_HEADER;
+  n = pn_min(n, room);
+  psize = pn_min(psize, room - n);
+  size_t length = PNI_TRACE_RECORD_HEADER + psize + n;
+
+  while (ring->capacity - ring->used < length) {
+    uint32_t oldest = pni_ring_read_length(ring, ring->head);
+    ring->head = (ring->head + oldest) % ring->capacity;
+    ring->used -= oldest;
+  }
+
+  char header[PNI_TRACE_RECORD_HEADER];
+  char *p = pni_put_uint(header, length, 4);
+  p = pni_put_uint(p, time, 8);
+  p = pni_put_uint(p, size, 4);
+  p = pni_put_uint(p, channel, 2);
+  p = pni_put_uint(p, type, 1);
+  pni_put_uint(p, out, 1);
+
+  size_t offset = (ring->head + ring->used) % ring->capacity;
+  offset = pni_ring_write(ring, offset, header, sizeof(header));
+  offset = pni_ring_write(ring, offset, performative, psize);
+  pni_ring_write(ring, offset, payload, n);
+  ring->used += length;
+}
+
+int pni_trace_ring_dump(pni_trace_ring_t *ring, FILE *file)
+{
+  char header[PNI_TRACE_FILE_HEADER];
+  memcpy(header, PNI_TRACE_MAGIC, 8);
+  char *p = pni_put_uint(header + 8, pni_wallclock_us(), 8);
+  pni_put_uint(p, pni_clock_us(), 8);
+  if (fwrite(header, sizeof(header), 1, file) != 1) return PN_ERR;
+  if (ring && ring->used) {
+    size_t first = pn_min(ring->used, ring->capacity - ring->head);
+    if (fwrite(ring->bytes + ring->head, first, 1, file) != 1) return PN_ERR;
+    if (first < ring->used && fwrite(ring->bytes, ring->used - first, 1, file) != 1) return PN_ERR;
+  }
+  return 0;
+}
@@ -0,0 +1,64 @@
+#ifndef PROTON_TRACE_RING_H
+#define PROTON_TRACE_RING_H 1
+
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include <proton/type_compat.h>
+
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+ * A fixed size ring of binary frame records for PN_TRACE_BIN.
+ *
+ * Recording a frame is a copy of its performative and the start of its
+ * payload, nothing is formatted. When the ring is full the oldest records are
+ * dropped to make room. A ring belongs to one transport, so like the rest of
+ * the transport it needs no locking.
+ *
+ * The dump format, all integers big-endian:
+ *
+ *   file:   "PNTRACE1" u64:wall-clock-us u64:clock-us record*
+ *   record: u32:length u64:clock-us u32:frame-size u16:channel u8:type u8:dir body
+ *
+ * clock-us is pni_clock_us(), the file header gives the wall clock time that
+ * matches a clock-us so records can be converted to wall clock time. length
+ * covers the whole record. frame-size is the size of the frame body, body is
+ * the performative followed by at most the configured number of payload bytes.
+ * dir is 0 for received frames and 1 for sent ones.
+ */
+typedef struct pni_trace_ring_t pni_trace_ring_t;
+
+#define PNI_TRACE_MAGIC "PNTRACE1"
+#define PNI_TRACE_FILE_HEADER (8 + 8 + 8)
+#define PNI_TRACE_RECORD_HEADER (4 + 8 + 4 + 2 + 1 + 1)
+#define PNI_TRACE_PAYLOAD_MAX (1024)
+
+pni_trace_ring_t *pni_trace_ring(size_t capacity, size_t payload);
+void pni_trace_ring_free(pni_trace_ring_t *ring);
+/* The most payload bytes to record per frame */
+size_t pni_trace_ring_payload(pni_trace_ring_t *ring);
+void pni_trace_ring_add(pni_trace_ring_t *ring, uint64_t time, bool out, uint8_t type, uint16_t channel,
+                        size_t size, const char *performative, size_t psize, const char *payload, size_t n);
+int pni_trace_ring_dump(pni_trace_ring_t *ring, FILE *file);
+
+#endif /* trace_ring.h */
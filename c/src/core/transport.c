@@ -27,10 +27,12 @@
 #include "ssl/ssl-internal.h"
 
 #include "autodetect.h"
+#include "encodings.h"
 #include "protocol.h"
 #include "dispatch_actions.h"
 #include "config.h"
 #include "log_private.h"
+#include "probes.h"
 
 #include "proton/event.h"
 
@@ -411,6 +413,7 @@ static void pn_transport_initialize(void *object)
   transport->input_buf = NULL;
   transport->input_size =  PN_TRANSPORT_INITIAL_BUFFER_SIZE;
   transport->tracer = pni_default_tracer;
+  transport->trace_ring = NULL;
   transport->sasl = NULL;
   transport->ssl = NULL;
 
@@ -419,7 +422,11 @@ static void pn_transport_initialize(void *object)
   transport->output_args = pn_data(16);
   transport->frame = pn_buffer(PN_TRANSPORT_INITIAL_FRAME_SIZE);
   transport->input_frames_ct = 0;
+  memset(&transport->stats, 0, sizeof(transport->stats));
   transport->output_frames_ct = 0;
+  transport->output_trimmed = 0;
+  transport->latency_pending = NULL;
+  transport->latency_head = 0;
 
   transport->connection = NULL;
   transport->context = pn_record();
@@ -483,6 +490,9 @@ static void pn_transport_initialize(void *object)
 
   transport->input_pending = 0;
   transport->output_pending = 0;
+  transport->output_direct = false;
+  transport->output_limit = 0;
+  transport->output_queued = 0;
 
   transport->done_processing = false;
 
@@ -495,12 +505,14 @@ static void pn_transport_initialize(void *object)
   transport->encryption_required = false;
 
   transport->referenced = true;
+  transport->event_queued = false;
 
   transport->trace =
     (pn_env_bool("PN_TRACE_RAW") ? PN_TRACE_RAW : PN_TRACE_OFF) |
     (pn_env_bool("PN_TRACE_FRM") ? PN_TRACE_FRM : PN_TRACE_OFF) |
     (pn_env_bool("PN_TRACE_DRV") ? PN_TRACE_DRV : PN_TRACE_OFF) |
-    (pn_env_bool("PN_TRACE_EVT") ? PN_TRACE_EVT : PN_TRACE_OFF) ;
+    (pn_env_bool("PN_TRACE_EVT") ? PN_TRACE_EVT : PN_TRACE_OFF) |
+    (pn_env_bool("PN_TRACE_BIN") ? PN_TRACE_BIN : PN_TRACE_OFF) ;
 }
 
 
@@ -579,7 +591,7 @@ pn_transport_t *pn_transport(void)
     return NULL;
   }
 
-  transport->output_buffer = pn_buffer(4*1024);
+  transport->output_buffer = pn_chain(PN_TRANSPORT_INITIAL_BUFFER_SIZE);
   if (!transport->output_buffer) {
     pn_transport_free(transport);
     return NULL;
@@ -636,6 +648,71 @@ bool pn_transport_is_encrypted(pn_transport_t *transport)
     return transport && transport->ssl && pn_ssl_get_ssf((pn_ssl_t*)transport)>0;
 }
 
+/*
+ * Latency tracking. When the last TRANSFER of a tracked delivery is generated
+ * the delivery is queued with the output position where that frame ends, it
+ * is taken off the queue when pn_transport_pop() has gone past that position.
+ */
+static void pni_latency_written(pn_transport_t *transport, pn_delivery_t *delivery)
+{
+  pn_histogram_t *latency = delivery->link->latency;
+  uint64_t now = pni_clock_us();
+  pn_histogram_record(&latency[PN_LATENCY_QUEUED], now - delivery->latency.sent);
+  if (!transport->latency_pending) {
+    transport->latency_pending = pn_list(PN_WEAKREF, 0);
+  }
+  delivery->latency.written = now;
+  delivery->latency.end = transport->output_trimmed + pn_chain_size(transport->output_buffer);
+  pn_incref(delivery);
+  pn_list_add(transport->latency_pending, delivery);
+}
+
+static void pni_latency_popped(pn_transport_t *transport)
+{
+  // Output already copied out of output_buffer is only gone once output_buf is empty
+  if (!transport->output_direct && transport->output_pending) return;
+  pn_list_t *pending = transport->latency_pending;
+  size_t size = pn_list_size(pending);
+  uint64_t now = 0;
+  while (transport->latency_head < size) {
+    pn_delivery_t *delivery = (pn_delivery_t *) pn_list_get(pending, transport->latency_head);
+    if (delivery->latency.end > transport->output_trimmed) break;
+    if (!now) now = pni_clock_us();
+    delivery->latency.popped = now;
+    pn_histogram_record(&delivery->link->latency[PN_LATENCY_WRITTEN], now - delivery->latency.written);
+    transport->latency_head++;
+    pn_decref(delivery);
+  }
+  // Drop the consumed entries in bulk rather than shifting the list each time
+  if (transport->latency_head == size) {
+    pn_list_clear(pending);
+    transport->latency_head = 0;
+  } else if (transport->latency_head >= 64 && transport->latency_head * 2 >= size) {
+    pn_list_del(pending, 0, transport->latency_head);
+    transport->latency_head = 0;
+  }
+}
+
+static void pni_latency_settled(pn_delivery_t *delivery)
+{
+  pn_histogram_t *latency = delivery->link->latency;
+  uint64_t now = pni_clock_us();
+  pn_histogram_record(&latency[PN_LATENCY_SETTLED], now - delivery->latency.popped);
+  pn_histogram_record(&latency[PN_LATENCY_TOTAL], now - delivery->latency.sent);
+}
+
+static void pni_latency_release(pn_transport_t *transport)
+{
+  pn_list_t *pending = transport->latency_pending;
+  if (!pending) return;
+  size_t size = pn_list_size(pending);
+  for (size_t i = transport->latency_head; i < size; ++i) {
+    pn_decref(pn_list_get(pending, i));
+  }
+  pn_list_clear(pending);
+  transport->latency_head = 0;
+}
+
 void pn_transport_free(pn_transport_t *transport)
 {
   if (!transport) return;
@@ -681,7 +758,9 @@ static void pn_transport_finalize(void *object)
   pn_data_free(transport->output_args);
   pn_buffer_free(transport->frame);
   pn_free(transport->context);
-  pn_buffer_free(transport->output_buffer);
+  pn_chain_free(transport->output_buffer);
+  pn_free(transport->latency_pending);
+  pni_trace_ring_free(transport->trace_ring);
 }
 
 static void pni_post_remote_open_events(pn_transport_t *transport, pn_connection_t *connection) {
@@ -760,6 +839,7 @@ void pni_transport_unbind_channels(pn_hash_t *channels)
     pni_delivery_map_clear(&ssn->state.outgoing);
     pni_transport_unbind_handles(ssn->state.local_handles, true);
     pni_transport_unbind_handles(ssn->state.remote_handles, true);
+    ssn->window_blocked_since = 0;
     pn_session_unbound(ssn);
     pn_ep_decref(&ssn->endpoint);
     pn_hash_del(channels, key);
@@ -778,6 +858,8 @@ int pn_transport_unbind(pn_transport_t *transport)
 
   pn_collector_put(conn->collector, PN_OBJECT, conn, PN_CONNECTION_UNBOUND);
 
+  pni_latency_release(transport);
+
   // XXX: what happens if the endpoints are freed before we get here?
   pn_session_t *ssn = pn_session_head(conn, 0);
   while (ssn) {
@@ -887,8 +969,9 @@ static int pni_disposition_encode(pn_disposition_t *disposition, pn_data_t *data
 }
 
 
-void pn_do_trace(pn_transport_t *transport, uint16_t ch, pn_dir_t dir,
-                 pn_data_t *args, const char *payload, size_t size)
+// As pn_do_trace but only the first quoted bytes of a payload of size bytes are given.
+static void pni_do_trace(pn_transport_t *transport, uint16_t ch, pn_dir_t dir,
+                         pn_data_t *args, const char *payload, size_t quoted, size_t size)
 {
   if (transport->trace & PN_TRACE_FRM) {
     pn_string_format(transport->scratch, "%u %s ", ch, dir == OUT ? "->" : "<-");
@@ -900,15 +983,59 @@ void pn_do_trace(pn_transport_t *transport, uint16_t ch, pn_dir_t dir,
 
     if (size) {
       char buf[1024];
-      int e = pn_quote_data(buf, 1024, payload, size);
+      int e = pn_quote_data(buf, 1024, payload, quoted);
       pn_string_addf(transport->scratch, " (%" PN_ZU ") \"%s\"%s", size, buf,
-                     e == PN_OVERFLOW ? "... (truncated)" : "");
+                     e == PN_OVERFLOW || quoted < size ? "... (truncated)" : "");
     }
 
     pn_transport_log(transport, pn_string_get(transport->scratch));
   }
 }
 
+void pn_do_trace(pn_transport_t *transport, uint16_t ch, pn_dir_t dir,
+                 pn_data_t *args, const char *payload, size_t size)
+{
+  pni_do_trace(transport, ch, dir, args, payload, size, size);
+}
+
+#define PNI_TRACE_RING_SIZE (1024*1024)
+#define PNI_TRACE_RING_PAYLOAD (32)
+
+// Record a frame for PN_TRACE_BIN. The start of the payload is taken from
+// payload if it is set, otherwise from chain.
+void pni_trace_bin(pn_transport_t *transport, pn_dir_t dir, uint8_t type, uint16_t ch,
+                   const char *performative, size_t psize,
+                   const char *payload, pn_chain_t *chain, size_t payload_size)
+{
+  if (!transport->trace_ring) {
+    transport->trace_ring = pni_trace_ring(PNI_TRACE_RING_SIZE, PNI_TRACE_RING_PAYLOAD);
+    if (!transport->trace_ring) return;
+  }
+  size_t n = pn_min(payload_size, pni_trace_ring_payload(transport->trace_ring));
+  char buf[PNI_TRACE_PAYLOAD_MAX];
+  if (!payload && n) {
+    n = pn_chain_get(chain, 0, n, buf);
+    payload = buf;
+  }
+  pni_trace_ring_add(transport->trace_ring, pni_clock_us(), dir == OUT, type, ch,
+                     psize + payload_size, performative, psize, payload, n);
+}
+
+// Dump the trace ring to PN_TRACE_DUMP, if set, after an error
+static void pni_trace_dump_error(pn_transport_t *transport)
+{
+  const char *dir = getenv("PN_TRACE_DUMP");
+  if (!dir || !*dir) return;
+  char path[1024];
+  pni_snprintf(path, sizeof(path), "%s/proton-trace-%p.bin", dir, (void *) transport);
+  int err = pn_transport_dump_trace(transport, path);
+  if (err) {
+    pn_transport_logf(transport, "cannot write trace dump %s: %s", path, pn_code(err));
+  } else if (transport->trace & PN_TRACE_DRV) {
+    pn_transport_logf(transport, "trace dumped to %s", path);
+  }
+}
+
 int pn_post_frame(pn_transport_t *transport, uint8_t type, uint16_t ch, const char *fmt, ...)
 {
   pn_buffer_t *frame_buf = transport->frame;
@@ -947,12 +1074,17 @@ int pn_post_frame(pn_transport_t *transport, uint8_t type, uint16_t ch, const ch
   frame.channel = ch;
   frame.payload = buf.start;
   frame.size = wr;
-  pn_buffer_ensure(transport->output_buffer, AMQP_HEADER_SIZE+frame.ex_size+frame.size);
-  pn_write_frame(transport->output_buffer, frame);
+  size_t size = pn_write_frame(transport->output_buffer, frame);
+  if (!size) return PN_OUT_OF_MEMORY;
   transport->output_frames_ct += 1;
+  PN_PROBE4(frame_write, transport, ch, type, wr);
+  if (transport->trace & PN_TRACE_BIN) {
+    pni_trace_bin(transport, OUT, type, ch, buf.start, wr, NULL, NULL, 0);
+  }
   if (transport->trace & PN_TRACE_RAW) {
     pn_string_set(transport->scratch, "RAW: \"");
-    pn_buffer_quote(transport->output_buffer, transport->scratch, AMQP_HEADER_SIZE+frame.ex_size+frame.size);
+    pn_chain_quote(transport->output_buffer, transport->scratch,
+                   pn_chain_size(transport->output_buffer) - size, size);
     pn_string_addf(transport->scratch, "\"");
     pn_transport_log(transport, pn_string_get(transport->scratch));
   }
@@ -960,10 +1092,64 @@ int pn_post_frame(pn_transport_t *transport, uint8_t type, uint16_t ch, const ch
   return 0;
 }
 
+// Largest delivery tag handled by pni_encode_simple_transfer
+#define PNI_SIMPLE_TAG_MAX (32)
+// Upper bound on the size of a performative from pni_encode_simple_transfer
+#define PNI_SIMPLE_TRANSFER_MAX (3 + 9 + 5 + 5 + 2 + PNI_SIMPLE_TAG_MAX + 2 + 1 + 1)
+
+static inline char *pni_encode_uint32(char *p, uint32_t value)
+{
+  *p++ = (char) (0xFF & (value >> 24));
+  *p++ = (char) (0xFF & (value >> 16));
+  *p++ = (char) (0xFF & (value >>  8));
+  *p++ = (char) (0xFF & (value      ));
+  return p;
+}
+
+static inline char *pni_encode_uint(char *p, uint32_t value)
+{
+  if (value < 256) {
+    *p++ = (char) PNE_SMALLUINT;
+    *p++ = (char) value;
+  } else {
+    *p++ = (char) PNE_UINT;
+    p = pni_encode_uint32(p, value);
+  }
+  return p;
+}
+
+// Encode the TRANSFER performative for the common case of a transfer with
+// no delivery state, message-format 0 and no resume, aborted or batchable
+// flags directly, without going through pn_data_t. The result is
+// identical to what pn_data_encode produces for the same fields. dst must
+// have room for PNI_SIMPLE_TRANSFER_MAX bytes.
+static size_t pni_encode_simple_transfer(char *dst, uint32_t handle, pn_sequence_t id,
+                                         const pn_bytes_t *tag, bool settled, bool more)
+{
+  char *p = dst;
+  *p++ = (char) PNE_DESCRIPTOR;
+  *p++ = (char) PNE_SMALLULONG;
+  *p++ = (char) TRANSFER;
+  *p++ = (char) PNE_LIST32;
+  char *size = p;
+  p = pni_encode_uint32(p + 4, more ? 6 : settled ? 5 : 4);
+  p = pni_encode_uint(p, handle);
+  p = pni_encode_uint(p, id);
+  *p++ = (char) PNE_VBIN8;
+  *p++ = (char) tag->size;
+  memcpy(p, tag->start, tag->size);
+  p += tag->size;
+  p = pni_encode_uint(p, 0); // message-format
+  if (settled || more) *p++ = (char) (settled ? PNE_TRUE : PNE_NULL);
+  if (more) *p++ = (char) PNE_TRUE;
+  pni_encode_uint32(size, p - size - 4);
+  return p - dst;
+}
+
 static int pni_post_amqp_transfer_frame(pn_transport_t *transport, uint16_t ch,
                                         uint32_t handle,
                                         pn_sequence_t id,
-                                        pn_bytes_t *payload,
+                                        pn_chain_t *payload,
                                         const pn_bytes_t *tag,
                                         uint32_t message_format,
                                         bool settled,
@@ -979,6 +1165,30 @@ static int pni_post_amqp_transfer_frame(pn_transport_t *transport, uint16_t ch,
   unsigned framecount = 0;
   pn_buffer_t *frame = transport->frame;
 
+  // fast path: a small untraced transfer that fits in a single frame
+  if (!message_format && !code && !resume && !aborted && !batchable && frame_limit > 0 &&
+      tag->size <= PNI_SIMPLE_TAG_MAX && !(transport->trace & (PN_TRACE_FRM | PN_TRACE_RAW))) {
+    char performative[PNI_SIMPLE_TRANSFER_MAX];
+    size_t size = pni_encode_simple_transfer(performative, handle, id, tag, settled, more);
+    size_t available = pn_chain_size(payload);
+    if (!transport->remote_max_frame || available + size <= transport->remote_max_frame - 8) {
+      pn_frame_t frame = {AMQP_FRAME_TYPE};
+      frame.channel = ch;
+      frame.payload = performative;
+      frame.size = size;
+      if (!pn_write_frame_payload(transport->output_buffer, frame, payload, available)) {
+        return PN_OUT_OF_MEMORY;
+      }
+      transport->output_frames_ct += 1;
+      PN_PROBE4(frame_write, transport, ch, AMQP_FRAME_TYPE, size + available);
+      if (transport->trace & PN_TRACE_BIN) {
+        pni_trace_bin(transport, OUT, AMQP_FRAME_TYPE, ch, performative, size, NULL, payload, available);
+      }
+      pn_chain_trim(payload, available);
+      return 1;
+    }
+  }
+
   // create preformatives, assuming 'more' flag need not change
 
  compute_performatives:
@@ -1020,7 +1230,7 @@ static int pni_post_amqp_transfer_frame(pn_transport_t *transport, uint16_t ch,
     buf.size = wr;
 
     // check if we need to break up the outbound frame
-    size_t available = payload->size;
+    size_t available = pn_chain_size(payload);
     if (transport->remote_max_frame) {
       if ((available + buf.size) > transport->remote_max_frame - 8) {
         available = transport->remote_max_frame - 8 - buf.size;
@@ -1035,35 +1245,37 @@ static int pni_post_amqp_transfer_frame(pn_transport_t *transport, uint16_t ch,
       }
     }
 
-    if (pn_buffer_available( frame ) < (available + buf.size)) {
-      // not enough room for payload - try again...
-      pn_buffer_ensure( frame, available + buf.size );
-      goto encode_performatives;
+    if (transport->trace & PN_TRACE_FRM) {
+      // Only the start of the payload is quoted, there is no need to gather more
+      char quoted[1024];
+      size_t n = pn_chain_get(payload, 0, pn_min(available, sizeof(quoted)), quoted);
+      pni_do_trace(transport, ch, OUT, transport->output_args, quoted, n, available);
     }
 
-    pn_do_trace(transport, ch, OUT, transport->output_args, payload->start, available);
-
-    memmove( buf.start + buf.size, payload->start, available);
-    payload->start += available;
-    payload->size -= available;
-    buf.size += available;
-
     pn_frame_t frame = {AMQP_FRAME_TYPE};
     frame.channel = ch;
     frame.payload = buf.start;
     frame.size = buf.size;
 
-    pn_buffer_ensure(transport->output_buffer, AMQP_HEADER_SIZE+frame.ex_size+frame.size);
-    pn_write_frame(transport->output_buffer, frame);
+    // the payload is copied straight from the delivery into the output, large
+    // pieces of shared bytes are referenced rather than copied
+    size_t size = pn_write_frame_payload(transport->output_buffer, frame, payload, available);
+    if (!size) return PN_OUT_OF_MEMORY;
+    if (transport->trace & PN_TRACE_BIN) {
+      pni_trace_bin(transport, OUT, AMQP_FRAME_TYPE, ch, buf.start, buf.size, NULL, payload, available);
+    }
+    pn_chain_trim(payload, available);
     transport->output_frames_ct += 1;
+    PN_PROBE4(frame_write, transport, ch, AMQP_FRAME_TYPE, buf.size + available);
     framecount++;
     if (transport->trace & PN_TRACE_RAW) {
       pn_string_set(transport->scratch, "RAW: \"");
-      pn_buffer_quote(transport->output_buffer, transport->scratch, AMQP_HEADER_SIZE+frame.ex_size+frame.size);
+      pn_chain_quote(transport->output_buffer, transport->scratch,
+                     pn_chain_size(transport->output_buffer) - size, size);
       pn_string_addf(transport->scratch, "\"");
       pn_transport_log(transport, pn_string_get(transport->scratch));
     }
-  } while (payload->size > 0 && framecount < frame_limit);
+  } while (pn_chain_size(payload) > 0 && framecount < frame_limit);
 
   return framecount;
 }
@@ -1146,6 +1358,9 @@ int pn_do_error(pn_transport_t *transport, const char *condition, const char *fm
   if (transport->trace & PN_TRACE_DRV) {
     pn_transport_logf(transport, "ERROR %s %s", condition, buf);
   }
+  if (transport->trace_ring) {
+    pni_trace_dump_error(transport);
+  }
 
   for (int i = 0; i<PN_IO_LAYER_CT; ++i) {
     if (transport->io_layers[i] && transport->io_layers[i]->handle_error)
@@ -1524,7 +1739,7 @@ int pn_do_transfer(pn_transport_t *transport, uint8_t frame_type, uint16_t chann
     link->queued++;
   }
 
-  pn_buffer_append(delivery->bytes, payload->start, payload->size);
+  pn_chain_append(delivery->bytes, payload->start, payload->size);
   ssn->incoming_bytes += payload->size;
   delivery->done = !more;
 
@@ -1543,16 +1758,55 @@ int pn_do_transfer(pn_transport_t *transport, uint8_t frame_type, uint16_t chann
     pni_post_flow(transport, ssn, link);
   }
 
+  link->stats.bytes += payload->size;
+  transport->stats.bytes_received += payload->size;
   if ((delivery->aborted = aborted)) {
     delivery->remote.settled = true;
     delivery->done = true;
     delivery->updated = true;
     pn_work_update(transport->connection, delivery);
+  } else if (!more) {
+    link->stats.deliveries++;
+    transport->stats.deliveries_received++;
   }
   pn_collector_put(transport->connection->collector, PN_OBJECT, delivery, PN_DELIVERY);
   return 0;
 }
 
+static void pni_session_unblocked(pn_transport_t *transport, pn_session_t *ssn)
+{
+  if (ssn->window_blocked_since) {
+    transport->stats.window_blocked += pni_clock() - ssn->window_blocked_since;
+    ssn->window_blocked_since = 0;
+  }
+}
+
+// True if a sender has data it could send given credit and window
+static bool pni_sender_pending(pn_link_t *link)
+{
+  pn_delivery_t *current = link->current;
+  return pn_link_is_sender(link) && (int32_t) link->state.local_handle >= 0 &&
+    (link->queued > 0 || (current && pn_chain_size(current->bytes) > 0));
+}
+
+// Stop timing a session once none of its senders has anything to hold back
+static void pni_session_idle(pn_transport_t *transport, pn_session_t *ssn)
+{
+  if (!ssn->window_blocked_since) return;
+  size_t n = pn_list_size(ssn->links);
+  for (size_t i = 0; i < n; ++i) {
+    if (pni_sender_pending((pn_link_t *) pn_list_get(ssn->links, i))) return;
+  }
+  pni_session_unblocked(transport, ssn);
+}
+
+static void pni_sender_idle(pn_transport_t *transport, pn_link_t *link)
+{
+  if (pni_sender_pending(link)) return;
+  pni_link_unblocked(link);
+  pni_session_idle(transport, link->session);
+}
+
 int pn_do_flow(pn_transport_t *transport, uint8_t frame_type, uint16_t channel, pn_data_t *args, const pn_bytes_t *payload)
 {
   pn_sequence_t onext, inext, delivery_count;
@@ -1574,6 +1828,9 @@ int pn_do_flow(pn_transport_t *transport, uint8_t frame_type, uint16_t channel,
   } else {
     ssn->state.remote_incoming_window = iwin;
   }
+  if (ssn->state.remote_incoming_window > 0) {
+    pni_session_unblocked(transport, ssn);
+  }
 
   if (handle_init) {
     pn_link_t *link = pni_handle_state(ssn, handle);
@@ -1592,6 +1849,10 @@ int pn_do_flow(pn_transport_t *transport, uint8_t frame_type, uint16_t channel,
       link->state.link_credit = receiver_count + link_credit - link->state.delivery_count;
       link->credit += link->state.link_credit - old;
       link->drain = drain;
+      PN_PROBE2(link_remote_flow, link, link->credit);
+      if (link->state.link_credit > 0) {
+        pni_link_unblocked(link);
+      }
       pn_delivery_t *delivery = pn_link_current(link);
       if (delivery) pn_work_update(transport->connection, delivery);
     } else {
@@ -1686,6 +1947,10 @@ static int pni_do_delivery_disposition(pn_transport_t * transport, pn_delivery_t
     }
   }
 
+  if (settled && !remote->settled) {
+    PN_PROBE3(delivery_remote_settle, delivery, delivery->link, type_init ? type : 0);
+    if (delivery->latency.popped) pni_latency_settled(delivery);
+  }
   remote->settled = settled;
   delivery->updated = true;
   pn_work_update(transport->connection, delivery);
@@ -1706,6 +1971,7 @@ int pn_do_disposition(pn_transport_t *transport, uint8_t frame_type, uint16_t ch
                          transport->disp_data);
   if (err) return err;
   if (!last_init) last = first;
+  transport->stats.dispositions_input++;
 
   pn_session_t *ssn = pni_channel_state(transport, channel);
   if (!ssn) {
@@ -2147,6 +2413,7 @@ static int pni_flush_disp(pn_transport_t *transport, pn_session_t *ssn)
                             settled, settled,
                             (bool)code, code);
     if (err) return err;
+    transport->stats.dispositions_output++;
     ssn->state.disp_type = 0;
     ssn->state.disp_code = 0;
     ssn->state.disp_settled = 0;
@@ -2175,6 +2442,7 @@ static int pni_post_disp(pn_transport_t *transport, pn_delivery_t *delivery)
   if (!pni_disposition_batchable(&delivery->local)) {
     pn_data_clear(transport->disp_data);
     PN_RETURN_IF_ERROR(pni_disposition_encode(&delivery->local, transport->disp_data));
+    transport->stats.dispositions_output++;
     return pn_post_frame(transport, AMQP_FRAME_TYPE, ssn->state.local_channel,
       "DL[oIn?o?DLC]", DISPOSITION,
       role, state->id,
@@ -2209,6 +2477,14 @@ static int pni_post_disp(pn_transport_t *transport, pn_delivery_t *delivery)
   return 0;
 }
 
+// True if no new transfers should be encoded until some output is written
+static inline bool pni_output_full(pn_transport_t *transport)
+{
+  return transport->output_limit &&
+    pn_chain_size(transport->output_buffer) + transport->output_pending + transport->output_queued
+      >= transport->output_limit;
+}
+
 static int pni_process_tpwork_sender(pn_transport_t *transport, pn_delivery_t *delivery, bool *settle)
 {
   pn_link_t *link = delivery->link;
@@ -2217,6 +2493,7 @@ static int pni_process_tpwork_sender(pn_transport_t *transport, pn_delivery_t *d
     // Aborted delivery with no data yet sent, drop it and issue a FLOW as we may have credit.
     *settle = true;
     state->sent = true;
+    pni_sender_idle(transport, link);
     pn_collector_put(transport->connection->collector, PN_OBJECT, link, PN_LINK_FLOW);
     return 0;
   }
@@ -2225,21 +2502,32 @@ static int pni_process_tpwork_sender(pn_transport_t *transport, pn_delivery_t *d
   pn_link_state_t *link_state = &link->state;
   bool xfr_posted = false;
   if ((int16_t) ssn_state->local_channel >= 0 && (int32_t) link_state->local_handle >= 0) {
-    if (!state->sent && (delivery->done || pn_buffer_size(delivery->bytes) > 0) &&
-        ssn_state->remote_incoming_window > 0 && link_state->link_credit > 0) {
+    if (!state->sent && (delivery->done || pn_chain_size(delivery->bytes) > 0)) {
+      // Start timing if the peer is holding us back. Without credit we
+      // can't tell if the window would also have stopped us.
+      if (link_state->link_credit <= 0) {
+        if (!link->credit_blocked_since) link->credit_blocked_since = pni_clock();
+      } else if (ssn_state->remote_incoming_window <= 0) {
+        if (!link->session->window_blocked_since) link->session->window_blocked_since = pni_clock();
+      }
+    }
+    if (!state->sent && (delivery->done || pn_chain_size(delivery->bytes) > 0) &&
+        ssn_state->remote_incoming_window > 0 && link_state->link_credit > 0 &&
+        (state->sending || !pni_output_full(transport))) {
       if (!state->init) {
         state = pni_delivery_map_push(&ssn_state->outgoing, delivery);
       }
 
-      pn_bytes_t bytes = pn_buffer_bytes(delivery->bytes);
-      size_t full_size = bytes.size;
+      size_t full_size = pn_chain_size(delivery->bytes);
       pn_bytes_t tag = pn_buffer_bytes(delivery->tag);
       pn_data_clear(transport->disp_data);
-      PN_RETURN_IF_ERROR(pni_disposition_encode(&delivery->local, transport->disp_data));
+      if (delivery->local.type) {
+        PN_RETURN_IF_ERROR(pni_disposition_encode(&delivery->local, transport->disp_data));
+      }
       int count = pni_post_amqp_transfer_frame(transport,
                                                ssn_state->local_channel,
                                                link_state->local_handle,
-                                               state->id, &bytes, &tag,
+                                               state->id, delivery->bytes, &tag,
                                                0, // message-format
                                                delivery->local.settled,
                                                !delivery->done,
@@ -2256,10 +2544,16 @@ static int pni_process_tpwork_sender(pn_transport_t *transport, pn_delivery_t *d
       ssn_state->outgoing_transfer_count += count;
       ssn_state->remote_incoming_window -= count;
 
-      int sent = full_size - bytes.size;
-      pn_buffer_trim(delivery->bytes, sent, 0);
+      int sent = full_size - pn_chain_size(delivery->bytes);
       link->session->outgoing_bytes -= sent;
-      if (!pn_buffer_size(delivery->bytes) && delivery->done) {
+      link->stats.bytes += sent;
+      transport->stats.bytes_sent += sent;
+      if (!pn_chain_size(delivery->bytes) && delivery->done) {
+        if (!delivery->aborted) {
+          link->stats.deliveries++;
+          transport->stats.deliveries_sent++;
+          if (delivery->latency.sent) pni_latency_written(transport, delivery);
+        }
         state->sent = true;
         link_state->delivery_count++;
         link_state->link_credit--;
@@ -2419,7 +2713,9 @@ static int pni_process_link_teardown(pn_transport_t *transport, pn_endpoint_t *e
                         !link->detached, !link->detached,
                         (bool)name, ERROR, name, description, info);
       if (err) return err;
-      pni_unmap_local_handle(link);
+      pni_link_unblocked(link);
+      pni_unmap_local_handle(link); // may delete link
+      pni_session_idle(transport, session);
     }
 
     pn_clear_modified(transport->connection, endpoint);
@@ -2493,6 +2789,11 @@ static int pni_process_ssn_teardown(pn_transport_t *transport, pn_endpoint_t *en
                               (bool) name, ERROR, name, description, info);
       if (err) return err;
       pni_unmap_local_channel(session);
+      pni_session_unblocked(transport, session);
+      size_t n = pn_list_size(session->links);
+      for (size_t i = 0; i < n; ++i) {
+        pni_link_unblocked((pn_link_t *) pn_list_get(session->links, i));
+      }
     }
 
     pn_clear_modified(transport->connection, endpoint);
@@ -2516,10 +2817,14 @@ static int pni_process_conn_teardown(pn_transport_t *transport, pn_endpoint_t *e
   return 0;
 }
 
-static int pni_phase(pn_transport_t *transport, int (*phase)(pn_transport_t *, pn_endpoint_t *))
+// Run a processing phase over the modified endpoints of one type. Each
+// phase only acts on a single endpoint type, so there is no need to visit
+// the others.
+static int pni_phase(pn_transport_t *transport, pn_endpoint_type_t type,
+                     int (*phase)(pn_transport_t *, pn_endpoint_t *))
 {
   pn_connection_t *conn = transport->connection;
-  pn_endpoint_t *endpoint = conn->transport_head;
+  pn_endpoint_t *endpoint = pn_modified_list(conn, type)->transport_head;
   while (endpoint)
   {
     pn_endpoint_t *next = endpoint->transport_next;
@@ -2533,23 +2838,23 @@ static int pni_phase(pn_transport_t *transport, int (*phase)(pn_transport_t *, p
 static int pni_process(pn_transport_t *transport)
 {
   int err;
-  if ((err = pni_phase(transport, pni_process_conn_setup))) return err;
-  if ((err = pni_phase(transport, pni_process_ssn_setup))) return err;
-  if ((err = pni_phase(transport, pni_process_link_setup))) return err;
-  if ((err = pni_phase(transport, pni_process_flow_receiver))) return err;
+  if ((err = pni_phase(transport, CONNECTION, pni_process_conn_setup))) return err;
+  if ((err = pni_phase(transport, SESSION, pni_process_ssn_setup))) return err;
+  if ((err = pni_phase(transport, SENDER, pni_process_link_setup))) return err;
+  if ((err = pni_phase(transport, SENDER, pni_process_flow_receiver))) return err;
 
   // XXX: this has to happen two times because we might settle stuff
   // on the first pass and create space for more work to be done on the
   // second pass
-  if ((err = pni_phase(transport, pni_process_tpwork))) return err;
-  if ((err = pni_phase(transport, pni_process_tpwork))) return err;
+  if ((err = pni_phase(transport, CONNECTION, pni_process_tpwork))) return err;
+  if ((err = pni_phase(transport, CONNECTION, pni_process_tpwork))) return err;
 
-  if ((err = pni_phase(transport, pni_process_flush_disp))) return err;
+  if ((err = pni_phase(transport, SESSION, pni_process_flush_disp))) return err;
 
-  if ((err = pni_phase(transport, pni_process_flow_sender))) return err;
-  if ((err = pni_phase(transport, pni_process_link_teardown))) return err;
-  if ((err = pni_phase(transport, pni_process_ssn_teardown))) return err;
-  if ((err = pni_phase(transport, pni_process_conn_teardown))) return err;
+  if ((err = pni_phase(transport, SENDER, pni_process_flow_sender))) return err;
+  if ((err = pni_phase(transport, SENDER, pni_process_link_teardown))) return err;
+  if ((err = pni_phase(transport, SESSION, pni_process_ssn_teardown))) return err;
+  if ((err = pni_phase(transport, CONNECTION, pni_process_conn_teardown))) return err;
 
   if (transport->connection->tpwork_head) {
     pn_modified(transport->connection, &transport->connection->endpoint, false);
@@ -2654,10 +2959,10 @@ static pn_timestamp_t pn_tick_amqp(pn_transport_t* transport, unsigned int layer
       transport->last_bytes_output = transport->bytes_output;
     } else if (transport->keepalive_deadline <= now) {
       transport->keepalive_deadline = now + (pn_timestamp_t)(transport->remote_idle_timeout/2.0);
-      if (pn_buffer_size(transport->output_buffer) == 0) {    // no outbound data pending
+      if (pn_chain_size(transport->output_buffer) == 0) {    // no outbound data pending
         // so send empty frame (and account for it!)
         pn_post_frame(transport, AMQP_FRAME_TYPE, 0, "");
-        transport->last_bytes_output += pn_buffer_size(transport->output_buffer);
+        transport->last_bytes_output += pn_chain_size(transport->output_buffer);
       }
     }
     timeout = pn_timestamp_min( timeout, transport->keepalive_deadline );
@@ -2686,7 +2991,8 @@ static ssize_t pn_output_write_amqp_header(pn_transport_t* transport, unsigned i
   return 8;
 }
 
-static ssize_t pn_output_write_amqp(pn_transport_t* transport, unsigned int layer, char* bytes, size_t available)
+// Generate frames into output_buffer, return PN_EOS when there will be no more
+static ssize_t pni_output_amqp(pn_transport_t* transport)
 {
   if (transport->connection && !transport->done_processing) {
     int err = pni_process(transport);
@@ -2699,13 +3005,31 @@ static ssize_t pn_output_write_amqp(pn_transport_t* transport, unsigned int laye
   // write out any buffered data _before_ returning PN_EOS, else we
   // could truncate an outgoing Close frame containing a useful error
   // status
-  if (!pn_buffer_size(transport->output_buffer) && transport->close_sent) {
+  if (!pn_chain_size(transport->output_buffer) && transport->close_sent) {
     return PN_EOS;
   }
+  return 0;
+}
 
+static ssize_t pn_output_write_amqp(pn_transport_t* transport, unsigned int layer, char* bytes, size_t available)
+{
+  ssize_t n = pni_output_amqp(transport);
+  if (n < 0) return n;
   return pn_dispatcher_output(transport, bytes, available);
 }
 
+// True if frames from the AMQP layer are written out unchanged: the header
+// exchange is done and no SSL or SASL security layer transforms the bytes.
+static bool pni_output_direct(pn_transport_t *transport)
+{
+  unsigned int layer = 0;
+  while (layer < PN_IO_LAYER_CT-1 && transport->io_layers[layer] == &pni_passthru_layer) {
+    ++layer;
+  }
+  const pn_io_layer_t *io_layer = transport->io_layers[layer];
+  return io_layer && io_layer->process_output == pn_output_write_amqp;
+}
+
 // Mark transport output as closed and send event
 static void pni_close_head(pn_transport_t *transport)
 {
@@ -2722,6 +3046,23 @@ static ssize_t transport_produce(pn_transport_t *transport)
 {
   if (transport->head_closed) return PN_EOS;
 
+  // Hand out output_buffer's first segment rather than copying it into
+  // output_buf, unless output_buf still holds earlier bytes.
+  if (!transport->output_pending && pni_output_direct(transport)) {
+    ssize_t n = pni_output_amqp(transport);
+    pn_bytes_t head;
+    transport->output_direct = pn_chain_segments(transport->output_buffer, &head, 1);
+    if (transport->output_direct) return head.size;
+    if (n < 0) {
+      if (transport->trace & (PN_TRACE_RAW | PN_TRACE_FRM)) {
+        pn_transport_log(transport, "  -> EOS");
+      }
+      pni_close_head(transport);
+    }
+    return n;
+  }
+  transport->output_direct = false;
+
   ssize_t space = transport->output_size - transport->output_pending;
 
   if (space <= 0) {     // can we expand the buffer?
@@ -2784,6 +3125,28 @@ void pn_transport_trace(pn_transport_t *transport, pn_trace_t trace)
   transport->trace = trace;
 }
 
+int pn_transport_set_trace_ring(pn_transport_t *transport, size_t size, size_t payload)
+{
+  assert(transport);
+  pni_trace_ring_free(transport->trace_ring);
+  transport->trace_ring = NULL;
+  if (size) {
+    transport->trace_ring = pni_trace_ring(size, payload);
+    if (!transport->trace_ring) return PN_OUT_OF_MEMORY;
+  }
+  return 0;
+}
+
+int pn_transport_dump_trace(pn_transport_t *transport, const char *path)
+{
+  assert(transport);
+  FILE *file = fopen(path, "wb");
+  if (!file) return PN_ERR;
+  int err = pni_trace_ring_dump(transport->trace_ring, file);
+  if (fclose(file) && !err) err = PN_ERR;
+  return err;
+}
+
 void pn_transport_set_tracer(pn_transport_t *transport, pn_tracer_t tracer)
 {
   assert(transport);
@@ -2904,6 +3267,21 @@ void pn_transport_set_idle_timeout(pn_transport_t *transport, pn_millis_t timeou
   transport->local_idle_timeout = timeout;
 }
 
+void pn_transport_set_output_limit(pn_transport_t *transport, size_t limit)
+{
+  transport->output_limit = limit;
+}
+
+size_t pn_transport_get_output_limit(pn_transport_t *transport)
+{
+  return transport->output_limit;
+}
+
+void pn_transport_set_output_queued(pn_transport_t *transport, size_t queued)
+{
+  transport->output_queued = queued;
+}
+
 pn_millis_t pn_transport_get_remote_idle_timeout(pn_transport_t *transport)
 {
   return transport->remote_idle_timeout;
@@ -3026,7 +3404,10 @@ ssize_t pn_transport_pending(pn_transport_t *transport)      /* <0 == done */
 
 const char *pn_transport_head(pn_transport_t *transport)
 {
-  if (transport && transport->output_pending) {
+  if (transport && transport->output_direct) {
+    pn_bytes_t head;
+    if (pn_chain_segments(transport->output_buffer, &head, 1)) return head.start;
+  } else if (transport && transport->output_pending) {
     return transport->output_buf;
   }
   return NULL;
@@ -3055,12 +3436,21 @@ ssize_t pn_transport_peek(pn_transport_t *transport, char *dst, size_t size)
 void pn_transport_pop(pn_transport_t *transport, size_t size)
 {
   if (transport) {
-    assert( transport->output_pending >= size );
-    transport->output_pending -= size;
+    if (transport->output_direct) {
+      assert( pn_chain_size(transport->output_buffer) >= size );
+      pn_chain_trim(transport->output_buffer, size);
+      transport->output_trimmed += size;
+    } else {
+      assert( transport->output_pending >= size );
+      transport->output_pending -= size;
+      if (transport->output_pending) {
+        memmove( transport->output_buf,  &transport->output_buf[size],
+                 transport->output_pending );
+      }
+    }
     transport->bytes_output += size;
-    if (transport->output_pending) {
-      memmove( transport->output_buf,  &transport->output_buf[size],
-               transport->output_pending );
+    if (transport->latency_pending && transport->latency_head < pn_list_size(transport->latency_pending)) {
+      pni_latency_popped(transport);
     }
 
     if (transport->output_pending==0 && pn_transport_pending(transport) < 0) {
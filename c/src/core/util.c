@@ -19,6 +19,11 @@
  *
  */
 
+#ifndef _WIN32
+/* For clock_gettime() */
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include "buffer.h"
 #include "util.h"
 
@@ -145,3 +150,54 @@ pn_timestamp_t pn_timestamp_min( pn_timestamp_t a, pn_timestamp_t b )
   return b;
 }
 
+#ifdef _WIN32
+#include <windows.h>
+pn_timestamp_t pni_clock(void)
+{
+  return GetTickCount64();
+}
+
+uint64_t pni_clock_us(void)
+{
+  static LARGE_INTEGER freq;
+  LARGE_INTEGER t;
+  if (!freq.QuadPart) QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&t);
+  return (uint64_t) (t.QuadPart / freq.QuadPart) * 1000000 +
+    (uint64_t) (t.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart;
+}
+
+uint64_t pni_wallclock_us(void)
+{
+  FILETIME ft;
+  ULARGE_INTEGER t;
+  GetSystemTimeAsFileTime(&ft);
+  t.LowPart = ft.dwLowDateTime;
+  t.HighPart = ft.dwHighDateTime;
+  // FILETIME counts 100ns intervals since 1601
+  return (t.QuadPart - 116444736000000000ULL) / 10;
+}
+#else
+#include <time.h>
+pn_timestamp_t pni_clock(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return ((pn_timestamp_t)t.tv_sec) * 1000 + t.tv_nsec / 1000000;
+}
+
+uint64_t pni_clock_us(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return ((uint64_t)t.tv_sec) * 1000000 + t.tv_nsec / 1000;
+}
+
+uint64_t pni_wallclock_us(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_REALTIME, &t);
+  return ((uint64_t)t.tv_sec) * 1000000 + t.tv_nsec / 1000;
+}
+#endif
+
@@ -38,6 +38,12 @@ ssize_t pn_quote_data(char *dst, size_t capacity, const char *src, size_t size);
 int pn_quote(pn_string_t *dst, const char *src, size_t size);
 bool pn_env_bool(const char *name);
 pn_timestamp_t pn_timestamp_min(pn_timestamp_t a, pn_timestamp_t b);
+/* Monotonic milliseconds from an arbitrary start, for measuring intervals */
+pn_timestamp_t pni_clock(void);
+/* Monotonic microseconds from an arbitrary start */
+uint64_t pni_clock_us(void);
+/* Wall clock microseconds since the epoch */
+uint64_t pni_wallclock_us(void);
 
 char *pn_strdup(const char *src);
 char *pn_strndup(const char *src, size_t n);
@@ -2086,7 +2086,8 @@ int pn_messenger_settle(pn_messenger_t *messenger, pn_tracker_t tracker, int fla
 // true if all pending output has been sent to peer
 bool pn_messenger_sent(pn_messenger_t *messenger)
 {
-  int total = pni_store_size(messenger->outgoing);
+  // unsent messages, and sent messages still waiting for an outcome
+  int total = pni_store_size(messenger->outgoing) + pni_store_pending(messenger->outgoing);
 
   for (size_t i = 0; i < pn_list_size(messenger->connections); i++)
   {
@@ -2103,14 +2104,6 @@ bool pn_messenger_sent(pn_messenger_t *messenger)
     while (link) {
       if (pn_link_is_sender(link)) {
         total += pn_link_queued(link);
-
-        pn_delivery_t *d = pn_unsettled_head(link);
-        while (d) {
-          if (!pn_delivery_remote_state(d) && !pn_delivery_settled(d)) {
-            total++;
-          }
-          d = pn_unsettled_next(d);
-        }
       }
       link = pn_link_next(link, PN_LOCAL_ACTIVE);
     }
@@ -31,14 +31,30 @@
 #include "core/util.h"
 #include "store.h"
 
+/*
+ * Tracked entries, those with ids from lwm up to hwm, are kept in a ring
+ * indexed by id, so looking up a tracker is a single array access. The
+ * ring grows as needed, a power of two at a time.
+ *
+ * Message buffers of freed entries are kept in a small pool for reuse.
+ */
+#define PNI_STORE_POOL (256)
+#define PNI_STORE_POOL_BUFFER_MAX (64*1024)
+
 typedef struct pni_stream_t pni_stream_t;
 
 struct pni_store_t {
   pni_stream_t *streams;
+  pn_map_t *index;              /* address -> pni_stream_t */
+  pn_string_t *probe;
   pni_entry_t *store_head;
   pni_entry_t *store_tail;
-  pn_hash_t *tracked;
+  pni_entry_t **tracked;        /* entry with id i is at tracked[i & (capacity-1)] */
+  size_t capacity;
+  pn_buffer_t *pool[PNI_STORE_POOL];
+  size_t pooled;
   size_t size;
+  size_t pending;               /* entries with a delivery waiting for an outcome */
   unsigned window;
   pn_sequence_t lwm;
   pn_sequence_t hwm;
@@ -64,6 +80,7 @@ struct pni_entry_t {
   pn_status_t status;
   pn_sequence_t id;
   bool free;
+  bool pending;
 };
 
 void pni_entry_finalize(void *object)
@@ -83,13 +100,18 @@ pni_store_t *pni_store()
   if (!store) return NULL;
 
   store->size = 0;
+  store->pending = 0;
   store->streams = NULL;
+  store->index = pn_map(PN_WEAKREF, PN_VOID, 0, 0.75);
+  store->probe = pn_string(NULL);
   store->store_head = NULL;
   store->store_tail = NULL;
   store->window = 0;
   store->lwm = 0;
   store->hwm = 0;
-  store->tracked = pn_hash(PN_OBJECT, 0, 0.75);
+  store->capacity = 16;
+  store->tracked = (pni_entry_t **) calloc(store->capacity, sizeof(pni_entry_t *));
+  store->pooled = 0;
 
   return store;
 }
@@ -100,20 +122,20 @@ size_t pni_store_size(pni_store_t *store)
   return store->size;
 }
 
+size_t pni_store_pending(pni_store_t *store)
+{
+  assert(store);
+  return store->pending;
+}
+
 pni_stream_t *pni_stream(pni_store_t *store, const char *address, bool create)
 {
   assert(store);
   assert(address);
 
-  pni_stream_t *prev = NULL;
-  pni_stream_t *stream = store->streams;
-  while (stream) {
-    if (!strcmp(pn_string_get(stream->address), address)) {
-      return stream;
-    }
-    prev = stream;
-    stream = stream->next;
-  }
+  pn_string_set(store->probe, address);
+  pni_stream_t *stream = (pni_stream_t *) pn_map_get(store->index, store->probe);
+  if (stream) return stream;
 
   if (create) {
     stream = (pni_stream_t *) malloc(sizeof(pni_stream_t));
@@ -124,11 +146,14 @@ pni_stream_t *pni_stream(pni_store_t *store, const char *address, bool create)
       stream->stream_tail = NULL;
       stream->next = NULL;
 
-      if (prev) {
-        prev->next = stream;
+      pni_stream_t *last = store->streams;
+      while (last && last->next) last = last->next;
+      if (last) {
+        last->next = stream;
       } else {
         store->streams = stream;
       }
+      pn_map_put(store->index, stream->address, stream);
     }
   }
 
@@ -156,7 +181,13 @@ void pni_entry_free(pni_entry_t *entry)
   LL_REMOVE(store, store, entry);
   entry->free = true;
 
-  pn_buffer_free(entry->bytes);
+  if (store->pooled < PNI_STORE_POOL &&
+      pn_buffer_capacity(entry->bytes) <= PNI_STORE_POOL_BUFFER_MAX) {
+    pn_buffer_clear(entry->bytes);
+    store->pool[store->pooled++] = entry->bytes;
+  } else {
+    pn_buffer_free(entry->bytes);
+  }
   entry->bytes = NULL;
   pn_decref(entry);
   store->size--;
@@ -177,13 +208,22 @@ void pni_stream_free(pni_stream_t *stream)
 void pni_store_free(pni_store_t *store)
 {
   if (!store) return;
-  pn_free(store->tracked);
+  for (pn_sequence_t id = store->lwm; id != store->hwm; id++) {
+    pni_entry_t *e = store->tracked[id & (store->capacity - 1)];
+    if (e) pn_decref(e);
+  }
+  free(store->tracked);
+  pn_free(store->index);
   pni_stream_t *stream = store->streams;
   while (stream) {
     pni_stream_t *next = stream->next;
     pni_stream_free(stream);
     stream = next;
   }
+  for (size_t i = 0; i < store->pooled; i++) {
+    pn_buffer_free(store->pool[i]);
+  }
+  pn_free(store->probe);
   free(store);
 }
 
@@ -222,7 +262,8 @@ pni_entry_t *pni_store_put(pni_store_t *store, const char *address)
   entry->store_next = NULL;
   entry->store_prev = NULL;
   entry->delivery = NULL;
-  entry->bytes = pn_buffer(64);
+  entry->pending = false;
+  entry->bytes = store->pooled ? store->pool[--store->pooled] : pn_buffer(64);
   entry->status = PN_STATUS_UNKNOWN;
   LL_ADD(stream, stream, entry);
   LL_ADD(store, store, entry);
@@ -314,10 +355,20 @@ static pn_status_t disp2status(uint64_t disp)
 }
 
 
+static void pni_entry_set_pending(pni_entry_t *entry, bool pending)
+{
+  if (entry->pending != pending) {
+    entry->pending = pending;
+    if (pending) entry->stream->store->pending++;
+    else entry->stream->store->pending--;
+  }
+}
+
 void pni_entry_updated(pni_entry_t *entry)
 {
   assert(entry);
   pn_delivery_t *d = entry->delivery;
+  pni_entry_set_pending(entry, d && !pn_delivery_remote_state(d) && !pn_delivery_settled(d));
   if (d) {
     if (pn_delivery_remote_state(d)) {
       entry->status = disp2status(pn_delivery_remote_state(d));
@@ -343,7 +394,17 @@ pn_sequence_t pni_entry_id(pni_entry_t *entry)
 pni_entry_t *pni_store_entry(pni_store_t *store, pn_sequence_t id)
 {
   assert(store);
-  return (pni_entry_t *) pn_hash_get(store->tracked, id);
+  if (id - store->lwm >= store->hwm - store->lwm) return NULL;
+  return store->tracked[id & (store->capacity - 1)];
+}
+
+/* Stop tracking the entry with this id, which must be tracked */
+static void pni_store_untrack(pni_store_t *store, pn_sequence_t id)
+{
+  pni_entry_t **slot = &store->tracked[id & (store->capacity - 1)];
+  pni_entry_t *e = *slot;
+  *slot = NULL;
+  pn_decref(e);
 }
 
 bool pni_store_tracking(pni_store_t *store, pn_sequence_t id)
@@ -356,14 +417,24 @@ pn_sequence_t pni_entry_track(pni_entry_t *entry)
   assert(entry);
 
   pni_store_t *store = entry->stream->store;
+  if (store->hwm - store->lwm == store->capacity) {
+    size_t capacity = 2*store->capacity;
+    pni_entry_t **tracked = (pni_entry_t **) calloc(capacity, sizeof(pni_entry_t *));
+    for (pn_sequence_t id = store->lwm; id != store->hwm; id++) {
+      tracked[id & (capacity - 1)] = store->tracked[id & (store->capacity - 1)];
+    }
+    free(store->tracked);
+    store->tracked = tracked;
+    store->capacity = capacity;
+  }
   entry->id = store->hwm++;
-  pn_hash_put(store->tracked, entry->id, entry);
+  store->tracked[entry->id & (store->capacity - 1)] = entry;
+  pn_incref(entry);
 
   if (store->window < INT32_MAX) {
     while (store->hwm - store->lwm > store->window) {
-      pni_entry_t *e = pni_store_entry(store, store->lwm);
-      if (e) {
-        pn_hash_del(store->tracked, store->lwm);
+      if (pni_store_entry(store, store->lwm)) {
+        pni_store_untrack(store, store->lwm);
       }
       store->lwm++;
     }
@@ -381,14 +452,9 @@ int pni_store_update(pni_store_t *store, pn_sequence_t id, pn_status_t status,
     return 0;
   }
 
-  size_t start;
-  if (PN_CUMULATIVE & flags) {
-    start = store->lwm;
-  } else {
-    start = id;
-  }
-
-  for (pn_sequence_t i = start; i <= id; i++) {
+  /* A cumulative update walks the ring directly, from the oldest entry */
+  pn_sequence_t start = (PN_CUMULATIVE & flags) ? store->lwm : id;
+  for (pn_sequence_t i = start; i - start <= id - start; i++) {
     pni_entry_t *e = pni_store_entry(store, i);
     if (e) {
       pn_delivery_t *d = e->delivery;
@@ -415,14 +481,15 @@ int pni_store_update(pni_store_t *store, pn_sequence_t id, pn_status_t status,
       if (settle) {
         if (d) {
           pn_delivery_settle(d);
+          pni_entry_set_pending(e, false);
         }
-        pn_hash_del(store->tracked, e->id);
+        pni_store_untrack(store, i);
       }
     }
   }
 
   while (store->hwm - store->lwm > 0 &&
-         !pn_hash_get(store->tracked, store->lwm)) {
+         !store->tracked[store->lwm & (store->capacity - 1)]) {
     store->lwm++;
   }
 
@@ -19,11 +19,24 @@
  *
  */
 
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include <ctype.h>
 #include "transform.h"
 
+/*
+ * Rules are applied in the order they were added, the first match wins.
+ *
+ * To avoid trying every rule on every address, the rules are indexed by the
+ * literal prefix of their pattern (the text before the first wildcard) in
+ * a trie. Only the rules whose prefix is a prefix of the address are
+ * candidates, and only those are matched against the full pattern.
+ *
+ * Results are also kept in a small LRU cache keyed by address, which is
+ * cleared whenever a rule is added.
+ */
+
 typedef struct {
   const char *start;
   size_t size;
@@ -41,8 +54,34 @@ typedef struct {
   pn_string_t *substitution;
 } pn_rule_t;
 
+typedef struct pni_trie_t {
+  struct pni_trie_t *child;
+  struct pni_trie_t *sibling;
+  size_t *rules;                /* Rules with this prefix, in order */
+  size_t size;
+  size_t capacity;
+  char c;
+} pni_trie_t;
+
+#define PNI_TRANSFORM_CACHE (256)
+
+typedef struct pni_cached_t {
+  pn_string_t *address;
+  pn_string_t *result;
+  struct pni_cached_t *prev;
+  struct pni_cached_t *next;
+  bool matched;
+} pni_cached_t;
+
 struct pn_transform_t {
   pn_list_t *rules;
+  pni_trie_t trie;
+  size_t *candidates;
+  size_t candidates_capacity;
+  pn_map_t *cache;              /* address -> pni_cached_t */
+  pni_cached_t entries[PNI_TRANSFORM_CACHE];
+  pni_cached_t *lru;            /* Most recently used entry */
+  pn_string_t *probe;
   pn_matcher_t matcher;
   bool matched;
 };
@@ -69,10 +108,50 @@ pn_rule_t *pn_rule(const char *pattern, const char *substitution)
   return rule;
 }
 
+static void pni_trie_free(pni_trie_t *node)
+{
+  while (node) {
+    pni_trie_t *next = node->sibling;
+    pni_trie_free(node->child);
+    free(node->rules);
+    free(node);
+    node = next;
+  }
+}
+
+static void pni_trie_add(pni_trie_t *node, const char *pattern, size_t rule)
+{
+  for (const char *p = pattern; *p && *p != '%' && *p != '*'; p++) {
+    pni_trie_t *child = node->child;
+    while (child && child->c != *p) child = child->sibling;
+    if (!child) {
+      child = (pni_trie_t *) calloc(1, sizeof(pni_trie_t));
+      child->c = *p;
+      child->sibling = node->child;
+      node->child = child;
+    }
+    node = child;
+  }
+  if (node->size == node->capacity) {
+    node->capacity = node->capacity ? 2*node->capacity : 4;
+    node->rules = (size_t *) realloc(node->rules, node->capacity*sizeof(size_t));
+  }
+  node->rules[node->size++] = rule;
+}
+
 static void pn_transform_finalize(void *object)
 {
   pn_transform_t *transform = (pn_transform_t *) object;
   pn_free(transform->rules);
+  pni_trie_free(transform->trie.child);
+  free(transform->trie.rules);
+  free(transform->candidates);
+  pn_free(transform->cache);
+  for (size_t i = 0; i < PNI_TRANSFORM_CACHE; i++) {
+    pn_free(transform->entries[i].address);
+    pn_free(transform->entries[i].result);
+  }
+  pn_free(transform->probe);
 }
 
 #define CID_pn_transform CID_pn_object
@@ -86,17 +165,45 @@ pn_transform_t *pn_transform()
   static const pn_class_t clazz = PN_CLASS(pn_transform);
   pn_transform_t *transform = (pn_transform_t *) pn_class_new(&clazz, sizeof(pn_transform_t));
   transform->rules = pn_list(PN_OBJECT, 0);
+  memset(&transform->trie, 0, sizeof(transform->trie));
+  transform->candidates = NULL;
+  transform->candidates_capacity = 0;
+  transform->cache = pn_map(PN_WEAKREF, PN_VOID, 2*PNI_TRANSFORM_CACHE, 0.75);
+  /* Entries form a circular list, most recently used first */
+  for (size_t i = 0; i < PNI_TRANSFORM_CACHE; i++) {
+    pni_cached_t *entry = &transform->entries[i];
+    entry->address = pn_string(NULL);
+    entry->result = pn_string(NULL);
+    entry->next = &transform->entries[(i + 1) % PNI_TRANSFORM_CACHE];
+    entry->prev = &transform->entries[(i + PNI_TRANSFORM_CACHE - 1) % PNI_TRANSFORM_CACHE];
+    entry->matched = false;
+  }
+  transform->lru = &transform->entries[0];
+  transform->probe = pn_string(NULL);
   transform->matched = false;
   return transform;
 }
 
+static void pni_cache_clear(pn_transform_t *transform)
+{
+  for (size_t i = 0; i < PNI_TRANSFORM_CACHE; i++) {
+    pni_cached_t *entry = &transform->entries[i];
+    if (pn_string_get(entry->address)) {
+      pn_map_del(transform->cache, entry->address);
+      pn_string_set(entry->address, NULL);
+    }
+  }
+}
+
 void pn_transform_rule(pn_transform_t *transform, const char *pattern,
                        const char *substitution)
 {
   assert(transform);
   pn_rule_t *rule = pn_rule(pattern, substitution);
+  pni_trie_add(&transform->trie, pattern, pn_list_size(transform->rules));
   pn_list_add(transform->rules, rule);
   pn_decref(rule);
+  pni_cache_clear(transform);
 }
 
 static void pni_sub(pn_matcher_t *matcher, size_t group, const char *text, size_t matched)
@@ -207,12 +314,41 @@ static size_t pni_substitute(pn_matcher_t *matcher, const char *pattern, char *d
   return result;
 }
 
-int pn_transform_apply(pn_transform_t *transform, const char *src,
-                       pn_string_t *dst)
+static void pni_add_candidates(pn_transform_t *transform, size_t *count, pni_trie_t *node)
+{
+  if (*count + node->size > transform->candidates_capacity) {
+    size_t capacity = transform->candidates_capacity ? transform->candidates_capacity : 16;
+    while (capacity < *count + node->size) capacity *= 2;
+    transform->candidates = (size_t *) realloc(transform->candidates, capacity*sizeof(size_t));
+    transform->candidates_capacity = capacity;
+  }
+  memcpy(transform->candidates + *count, node->rules, node->size*sizeof(size_t));
+  *count += node->size;
+}
+
+static int pni_compare_rules(const void *a, const void *b)
 {
-  for (size_t i = 0; i < pn_list_size(transform->rules); i++)
+  size_t x = *(const size_t *) a, y = *(const size_t *) b;
+  return (x > y) - (x < y);
+}
+
+static int pni_apply(pn_transform_t *transform, const char *src, pn_string_t *dst)
+{
+  /* Collect the rules whose literal prefix matches src */
+  size_t count = 0;
+  pni_trie_t *node = &transform->trie;
+  pni_add_candidates(transform, &count, node);
+  for (const char *c = src ? src : ""; *c; c++) {
+    node = node->child;
+    while (node && node->c != *c) node = node->sibling;
+    if (!node) break;
+    pni_add_candidates(transform, &count, node);
+  }
+  qsort(transform->candidates, count, sizeof(size_t), pni_compare_rules);
+
+  for (size_t i = 0; i < count; i++)
   {
-    pn_rule_t *rule = (pn_rule_t *) pn_list_get(transform->rules, i);
+    pn_rule_t *rule = (pn_rule_t *) pn_list_get(transform->rules, transform->candidates[i]);
     if (pni_match(&transform->matcher, pn_string_get(rule->pattern), src)) {
       transform->matched = true;
       if (!pn_string_get(rule->substitution)) {
@@ -237,6 +373,50 @@ int pn_transform_apply(pn_transform_t *transform, const char *src,
   return pn_string_set(dst, src);
 }
 
+/* Make entry the most recently used */
+static void pni_cache_touch(pn_transform_t *transform, pni_cached_t *entry)
+{
+  if (transform->lru == entry) return;
+  entry->prev->next = entry->next;
+  entry->next->prev = entry->prev;
+  entry->next = transform->lru;
+  entry->prev = transform->lru->prev;
+  entry->prev->next = entry;
+  entry->next->prev = entry;
+  transform->lru = entry;
+}
+
+int pn_transform_apply(pn_transform_t *transform, const char *src,
+                       pn_string_t *dst)
+{
+  if (!src || !pn_list_size(transform->rules)) {
+    return pni_apply(transform, src, dst);
+  }
+
+  pn_string_set(transform->probe, src);
+  pni_cached_t *entry = (pni_cached_t *) pn_map_get(transform->cache, transform->probe);
+  if (entry) {
+    pni_cache_touch(transform, entry);
+    transform->matched = entry->matched;
+    return pn_string_set(dst, pn_string_get(entry->result));
+  }
+
+  int err = pni_apply(transform, src, dst);
+  if (err) return err;
+
+  /* Replace the least recently used entry */
+  entry = transform->lru->prev;
+  if (pn_string_get(entry->address)) {
+    pn_map_del(transform->cache, entry->address);
+  }
+  pn_string_set(entry->address, src);
+  pn_string_set(entry->result, pn_string_get(dst));
+  entry->matched = transform->matched;
+  pn_map_put(transform->cache, entry->address, entry);
+  transform->lru = entry;
+  return 0;
+}
+
 bool pn_transform_matched(pn_transform_t *transform)
 {
   return transform->matched;
@@ -19,14 +19,15 @@
  *
  */
 
-/* Enable POSIX features beyond c99 for modern pthread and standard strerror_r() */
-#ifndef _POSIX_C_SOURCE
-#define _POSIX_C_SOURCE 200809L
+/* Enable POSIX features beyond c99 for modern pthread, and the Linux
+ * socket extensions accept4() and SO_REUSEPORT. Note this selects the GNU
+ * strerror_r() on glibc, see pstrerror() */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
 #endif
-/* Avoid GNU extensions, in particular the incompatible alternative strerror_r() */
-#undef _GNU_SOURCE
 
 #include "../core/log_private.h"
+#include "../core/probes.h"
 #include "./proactor-internal.h"
 
 #include <proton/condition.h>
@@ -52,7 +53,10 @@
 #include <fcntl.h>
 #include <netinet/tcp.h>
 #include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <linux/sockios.h>
 #include <limits.h>
+#include <poll.h>
 #include <time.h>
 
 #include "./netaddr-internal.h" /* Include after socket/inet headers */
@@ -73,8 +77,14 @@ typedef char strerrorbuf[1024];      /* used for pstrerror message buffer */
 
 /* Like strerror_r but provide a default message if strerror_r fails */
 static void pstrerror(int err, strerrorbuf msg) {
+#if defined(__GLIBC__)
+  /* The GNU strerror_r() may return a static string instead of using msg */
+  const char *s = strerror_r(err, msg, sizeof(strerrorbuf));
+  if (s != msg) snprintf(msg, sizeof(strerrorbuf), "%s", s ? s : "unknown error");
+#else
   int e = strerror_r(err, msg, sizeof(strerrorbuf));
   if (e) snprintf(msg, sizeof(strerrorbuf), "unknown error %d", err);
+#endif
 }
 
 /* Internal error, no recovery */
@@ -375,6 +385,7 @@ typedef struct pcontext_t {
   bool working;
   int wake_ops;             // unprocessed eventfd wake callback (convert to bool?)
   struct pcontext_t *wake_next; // wake list, guarded by proactor eventfd_mutex
+  uint64_t wake_time;           // microseconds, for statistics, guarded by proactor eventfd_mutex
   bool closing;
   // Next 4 are protected by the proactor mutex
   struct pcontext_t* next;  /* Protected by proactor.mutex */
@@ -406,6 +417,86 @@ typedef struct psocket_t {
   const char *host, *port;
 } psocket_t;
 
+/*
+ * Host names are resolved by a small pool of resolver threads so that
+ * pn_proactor_connect2() never blocks on DNS. Results are cached for
+ * RESOLVE_CACHE_TTL milliseconds, so reconnects to the same host are
+ * immediate.
+ *
+ * When there are several addresses the resolver thread also races the
+ * connection attempts, "happy eyeballs" style (RFC 8305): address families
+ * are interleaved and a new attempt is started every CONNECT_ATTEMPT_DELAY
+ * milliseconds while earlier ones are still pending. The first to connect
+ * wins and is handed to the connection. If none has connected
+ * CONNECT_ATTEMPT_DELAY after the last attempt started, the most preferred
+ * one still pending is handed over instead and the connection waits for it
+ * like any other connect, so a thread is never held for the kernel's
+ * connect timeout.
+ *
+ * The resolver thread does not touch the connection's socket or polling
+ * state: it leaves the result in pc->resolved and wakes the connection,
+ * which starts using it in pconnection_process().
+ *
+ * A connection that is closed while its request is in progress abandons the
+ * request, and any race is stopped at once. A lookup cannot be interrupted,
+ * so the resolver state is shared by the proactor and its threads and freed
+ * by whichever finishes last: pn_proactor_free() does not wait for a thread
+ * blocked in getaddrinfo().
+ */
+#define RESOLVER_THREADS 4
+#define RESOLVE_CACHE_SIZE 64
+#define RESOLVE_CACHE_TTL 30000
+#define CONNECT_ATTEMPT_DELAY 250
+#define CONNECT_ATTEMPTS_MAX 16
+
+typedef struct resolve_cache_entry_t {
+  char host[PN_MAX_ADDR];
+  char port[16];
+  pn_timestamp_t expires;
+  struct addrinfo *addrinfo;    /* Owned copy, NULL if the entry is unused */
+} resolve_cache_entry_t;
+
+typedef enum {
+  RESOLVE_QUEUED,               /* Waiting for a resolver thread */
+  RESOLVE_RUNNING,              /* Being resolved and connected by a thread */
+  RESOLVE_CLAIMED,              /* The thread is handing the result to the connection */
+  RESOLVE_DONE                  /* Finished after shutdown, the connection frees it */
+} resolve_state_t;
+
+/* A connection's name lookup and connection attempts. Guarded by the
+   resolver mutex. Copies everything it needs, so it does not refer to the
+   connection once abandoned. */
+typedef struct resolve_request_t {
+  struct resolve_request_t *next;    /* In the resolver queue */
+  struct pconnection_t *pc;          /* NULL once abandoned by the connection */
+  resolve_state_t state;
+  int abortfd;                       /* eventfd, readable once abandoned */
+  bool has_host;
+  char host[PN_MAX_ADDR];
+  char port[PN_MAX_ADDR];
+  pni_socket_options_t sockopts;
+  /* Result, owned by the request till the connection takes it */
+  int gai_error;
+  int fd;                            /* Socket from the race, or -1 */
+  int err;                           /* Why the race failed if fd is -1 */
+  struct addrinfo *addrinfo;
+} resolve_request_t;
+
+/* Resolver threads and cache, shared by a proactor and its threads */
+typedef struct resolver_t {
+  pmutex mutex;
+  pthread_cond_t cond;
+  resolve_request_t *first;          /* Queued requests */
+  resolve_request_t *last;
+  int refs;                          /* The proactor and each running thread */
+  int threads;                       /* Running threads */
+  int idle;                          /* Threads waiting for work */
+  int claimed;                       /* Requests in RESOLVE_CLAIMED */
+  bool stop;
+  pni_resolver_t *lookup;            /* NULL for getaddrinfo(), see pni_proactor_set_resolver() */
+  resolve_cache_entry_t cache[RESOLVE_CACHE_SIZE];
+} resolver_t;
+
 struct pn_proactor_t {
   pcontext_t context;
   int epollfd;
@@ -437,10 +528,200 @@ struct pn_proactor_t {
   // If the process runs out of file descriptors, disarm listening sockets temporarily and save them here.
   acceptor_t *overflow;
   pmutex overflow_mutex;
+  // Name resolution and connection attempts for pn_proactor_connect2(), off the caller's thread.
+  resolver_t *resolver;
+  // Statistics, see pstats_t
+  bool stats_enabled;                  /* Atomic, read without a lock */
+  uint64_t stats_id;                   /* Immutable, unique to this proactor */
+  pmutex stats_mutex;
+  struct pstats_t *stats;              /* Guarded by stats_mutex, in order of first use */
+  int stats_count;
+  uint64_t lock_time;                  /* When context.mutex was taken if recording, guarded by it */
 };
 
 static void rearm(pn_proactor_t *p, epoll_extended_t *ee);
 
+// ========================================================================
+// Statistics, see pn_proactor_set_stats_enabled()
+// ========================================================================
+
+/*
+ * Each thread that records statistics for a proactor has its own pstats_t,
+ * so recording only ever takes an uncontended lock. Readers lock each
+ * pstats_t in turn. A thread finds its pstats_t through a thread-local cache
+ * keyed by the proactor's stats_id rather than its address, since the memory
+ * of a freed proactor may be reused.
+ *
+ * The batch a thread is working on is thread-local too: its events are
+ * counted there and added to the thread's statistics by pn_proactor_done().
+ * Only the latest batch returned to a thread is counted.
+ */
+#define PSTATS_DISTRIBUTIONS (PN_PROACTOR_LOCK_HELD + 1)
+
+typedef struct pstats_t {
+  struct pstats_t *next;
+  pthread_t thread;
+  pmutex mutex;
+  pn_proactor_stats_t counters;
+  pn_histogram_t *distributions[PSTATS_DISTRIBUTIONS];
+} pstats_t;
+
+typedef struct pstats_thread_t {
+  uint64_t proactor_id;
+  pstats_t *stats;              /* Cached statistics for proactor_id */
+  pn_event_batch_t *batch;      /* Batch being counted, NULL if none */
+  uint64_t batch_start;
+  uint64_t batch_events;
+} pstats_thread_t;
+
+static __thread pstats_thread_t pstats_thread;
+static uint64_t pstats_last_id;
+
+static inline bool pstats_enabled(pn_proactor_t *p) {
+  return __atomic_load_n(&p->stats_enabled, __ATOMIC_RELAXED);
+}
+
+/* Monotonic nanoseconds */
+static inline uint64_t pstats_now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+static void pstats_free(pstats_t *s) {
+  for (int i = 0; i < PSTATS_DISTRIBUTIONS; ++i)
+    pn_histogram_free(s->distributions[i]);
+  pmutex_finalize(&s->mutex);
+  free(s);
+}
+
+static pstats_t *pstats_new(void) {
+  pstats_t *s = (pstats_t*)calloc(1, sizeof(*s));
+  if (!s) return NULL;
+  pmutex_init(&s->mutex);
+  for (int i = 0; i < PSTATS_DISTRIBUTIONS; ++i) {
+    if (!(s->distributions[i] = pn_histogram())) {
+      pstats_free(s);
+      return NULL;
+    }
+  }
+  s->thread = pthread_self();
+  return s;
+}
+
+/* The calling thread's statistics for p, NULL if out of memory */
+static pstats_t *pstats_get(pn_proactor_t *p) {
+  pstats_thread_t *t = &pstats_thread;
+  if (t->stats && t->proactor_id == p->stats_id)
+    return t->stats;
+  pthread_t self = pthread_self();
+  lock(&p->stats_mutex);
+  pstats_t **s = &p->stats;
+  while (*s && !pthread_equal((*s)->thread, self))
+    s = &(*s)->next;
+  if (!*s && (*s = pstats_new()))
+    p->stats_count++;
+  pstats_t *found = *s;
+  unlock(&p->stats_mutex);
+  if (found) {
+    t->proactor_id = p->stats_id;
+    t->stats = found;
+  }
+  return found;
+}
+
+/* Add n to the counter at offset in the calling thread's pn_proactor_stats_t */
+static void pstats_add(pn_proactor_t *p, size_t offset, uint64_t n) {
+  pstats_t *s = pstats_get(p);
+  if (!s) return;
+  lock(&s->mutex);
+  *(uint64_t*)((char*)&s->counters + offset) += n;
+  unlock(&s->mutex);
+}
+
+#define PSTATS_ADD(P, COUNTER, N)                                       \
+  do {                                                                  \
+    if (pstats_enabled(P))                                              \
+      pstats_add((P), offsetof(pn_proactor_stats_t, COUNTER), (N));     \
+  } while (0)
+
+/* A return from epoll_wait(), start is when a blocking wait started or 0 */
+static void pstats_poll(pn_proactor_t *p, uint64_t start) {
+  pstats_t *s = pstats_get(p);
+  if (!s) return;
+  uint64_t idle = start ? pstats_now() - start : 0;
+  lock(&s->mutex);
+  s->counters.polls++;
+  s->counters.idle_ns += idle;
+  unlock(&s->mutex);
+}
+
+/* A wake handled, woken is when it was requested in microseconds */
+static void pstats_wake(pn_proactor_t *p, uint64_t woken) {
+  pstats_t *s = pstats_get(p);
+  if (!s) return;
+  uint64_t now = pstats_now() / 1000;
+  lock(&s->mutex);
+  s->counters.wakes++;
+  pn_histogram_record(s->distributions[PN_PROACTOR_WAKE_LATENCY], now > woken ? now - woken : 0);
+  unlock(&s->mutex);
+}
+
+static void pstats_lock_held(pn_proactor_t *p, uint64_t held) {
+  pstats_t *s = pstats_get(p);
+  if (!s) return;
+  lock(&s->mutex);
+  s->counters.locks++;
+  s->counters.lock_held_ns += held;
+  pn_histogram_record(s->distributions[PN_PROACTOR_LOCK_HELD], held);
+  unlock(&s->mutex);
+}
+
+/* Start counting a batch returned to the calling thread */
+static pn_event_batch_t *pstats_batch(pn_proactor_t *p, pn_event_batch_t *batch) {
+  pstats_thread_t *t = &pstats_thread;
+  if (batch && pstats_enabled(p)) {
+    t->batch = batch;
+    t->batch_start = pstats_now();
+    t->batch_events = 0;
+  }
+  return batch;
+}
+
+static inline pn_event_t *pstats_event(pn_event_batch_t *batch, pn_event_t *e) {
+  if (e && pstats_thread.batch == batch)
+    pstats_thread.batch_events++;
+  return e;
+}
+
+static void pstats_batch_done(pn_proactor_t *p, pn_event_batch_t *batch) {
+  pstats_thread_t *t = &pstats_thread;
+  if (t->batch != batch) return;
+  t->batch = NULL;
+  pstats_t *s = pstats_get(p);
+  if (!s) return;
+  uint64_t busy = pstats_now() - t->batch_start;
+  lock(&s->mutex);
+  s->counters.batches++;
+  s->counters.events += t->batch_events;
+  s->counters.busy_ns += busy;
+  pn_histogram_record(s->distributions[PN_PROACTOR_BATCH_EVENTS], t->batch_events);
+  unlock(&s->mutex);
+}
+
+/* Take and release the proactor's own lock, timing how long it is held */
+static inline void proactor_lock(pn_proactor_t *p) {
+  lock(&p->context.mutex);
+  p->lock_time = pstats_enabled(p) ? pstats_now() : 0;
+}
+
+static inline void proactor_unlock(pn_proactor_t *p) {
+  uint64_t locked = p->lock_time;
+  unlock(&p->context.mutex);
+  if (locked)
+    pstats_lock_held(p, pstats_now() - locked);
+}
+
 /*
  * Wake strategy with eventfd.
  *  - wakees can be in the list only once
@@ -461,6 +742,8 @@ static bool wake(pcontext_t *ctx) {
       ctx->wake_ops++;
       pn_proactor_t *p = ctx->proactor;
       lock(&p->eventfd_mutex);
+      ctx->wake_time = pstats_enabled(p) ? pstats_now() / 1000 : 0;
+      PN_PROBE1(wake, ctx);
       if (!p->wake_list_first) {
         p->wake_list_first = p->wake_list_last = ctx;
       } else {
@@ -490,6 +773,7 @@ static inline void wake_notify(pcontext_t *ctx) {
 // call with no locks
 static pcontext_t *wake_pop_front(pn_proactor_t *p) {
   pcontext_t *ctx = NULL;
+  uint64_t woken = 0;
   lock(&p->eventfd_mutex);
   assert(p->wakes_in_progress);
   if (p->wake_list_first) {
@@ -497,6 +781,8 @@ static pcontext_t *wake_pop_front(pn_proactor_t *p) {
     p->wake_list_first = ctx->wake_next;
     if (!p->wake_list_first) p->wake_list_last = NULL;
     ctx->wake_next = NULL;
+    woken = ctx->wake_time;
+    PN_PROBE1(wake_handled, ctx);
 
     if (!p->wake_list_first) {
       /* Reset the eventfd until a future write.
@@ -509,6 +795,8 @@ static pcontext_t *wake_pop_front(pn_proactor_t *p) {
   }
   unlock(&p->eventfd_mutex);
   rearm(p, &p->epoll_wake);
+  if (woken && pstats_enabled(p))
+    pstats_wake(p, woken);
   return ctx;
 }
 
@@ -519,6 +807,8 @@ static inline void wake_done(pcontext_t *ctx) {
 }
 
 
+static void addrinfo_free(struct addrinfo *list);
+
 static void psocket_init(psocket_t* ps, pn_proactor_t* p, pn_listener_t *listener, const char *addr)
 {
   ps->epoll_io.psocket = ps;
@@ -543,6 +833,7 @@ typedef struct pconnection_t {
   bool timer_armed;
   bool queued_disconnect;     /* deferred from pn_proactor_disconnect() */
   pn_condition_t *disconnect_condition;
+  pni_socket_options_t sockopts; /* see pn_connection_set_socket_option() */
   ptimer_t timer;  // TODO: review one timerfd per connection
   // Following values only changed by (sole) working context:
   uint32_t current_arm;  // active epoll io events
@@ -550,13 +841,17 @@ typedef struct pconnection_t {
   bool connected;
   bool read_blocked;
   bool write_blocked;
+  bool output_held;           /* Unsent socket output is over the transport output limit */
+  size_t output_limit;        /* Last pn_transport_get_output_limit() seen */
   bool disconnected;
   int hog_count; // thread hogging limiter
   pn_event_batch_t batch;
   pn_connection_driver_t driver;
   struct pn_netaddr_t local, remote; /* Actual addresses */
-  struct addrinfo *addrinfo;         /* Resolved address list */
+  struct addrinfo *addrinfo;         /* Resolved address list, see addrinfo_copy() */
   struct addrinfo *ai;               /* Current connect address */
+  resolve_request_t *resolving;      /* Name lookup in progress, see resolve_queue_lh() */
+  resolve_request_t *resolved;       /* Finished lookup, see pconnection_resolved_lh() */
   pmutex rearm_mutex;                /* protects pconnection_rearm from out of order arming*/
   epoll_extended_t epoll_io_2;
   epoll_extended_t *rearm_target;    /* main or secondary epollfd */
@@ -588,17 +883,24 @@ static void set_pconnection(pn_connection_t* c, pconnection_t *pc) {
 }
 
 /*
- * A listener can have mutiple sockets (as specified in the addrinfo).  They
- * are armed separately.  The individual psockets can be part of at most one
- * list: the global proactor overflow retry list or the per-listener list of
- * pending accepts (valid inbound socket obtained, but pn_listener_accept not
- * yet called by the application).  These lists will be small and quick to
- * traverse.
+ * A listener can have mutiple sockets (as specified in the addrinfo, times the
+ * number of shards).  They are armed separately.  The individual psockets can
+ * be part of at most one list: the global proactor overflow retry list or the
+ * per-listener list of pending accepts (valid inbound sockets obtained, but
+ * pn_listener_accept not yet called by the application).  These lists will be
+ * small and quick to traverse.
+ *
+ * Each wakeup of a listening socket accepts up to ACCEPT_BATCH inbound
+ * sockets.  The socket is re-armed once the application has accepted them all.
  */
 
+#define ACCEPT_BATCH 16
+
 struct acceptor_t{
   psocket_t psocket;
-  int accepted_fd;
+  int accepted_fds[ACCEPT_BATCH];  /* accepted sockets, pending from accepted_head */
+  size_t accepted_head;
+  size_t accepted_count;
   bool armed;
   bool overflowed;
   acceptor_t *next;              /* next listener list member */
@@ -619,6 +921,7 @@ struct pn_listener_t {
   int pending_count;
   bool unclaimed;                 /* attach event dispatched but no pn_listener_attach() call yet */
   size_t backlog;
+  size_t shards;                  /* sockets per listening address, see pn_listener_set_shards() */
   bool close_dispatched;
   pmutex rearm_mutex;             /* orders rearms/disarms, nothing else */
 };
@@ -628,6 +931,9 @@ static void write_flush(pconnection_t *pc);
 static void listener_begin_close(pn_listener_t* l);
 static void proactor_add(pcontext_t *ctx);
 static bool proactor_remove(pcontext_t *ctx);
+static void resolve_abandon(pconnection_t *pc);
+static void resolve_request_free(resolve_request_t *req);
+static void pconnection_resolved_lh(pconnection_t *pc);
 
 static inline pconnection_t *psocket_pconnection(psocket_t* ps) {
   return ps->listener ? NULL : (pconnection_t*)ps;
@@ -719,6 +1025,8 @@ static void rearm(pn_proactor_t *p, epoll_extended_t *ee) {
   memory_barrier(ee);
   if (epoll_ctl(p->epollfd, EPOLL_CTL_MOD, ee->fd, &ev) == -1)
     EPOLL_FATAL("arming polled file descriptor", errno);
+  PSTATS_ADD(p, rearms, 1);
+  PN_PROBE2(rearm, ee->fd, ev.events);
 }
 
 // Only used by pconnection_t if two separate epoll interests in play
@@ -736,6 +1044,8 @@ static void rearm_2(pn_proactor_t *p, epoll_extended_t *ee) {
     memory_barrier(ee);
     if (epoll_ctl(p->epollfd_2, EPOLL_CTL_MOD, ee->fd, &ev) == -1)
       EPOLL_FATAL("arming polled file descriptor (secondary)", errno);
+    PSTATS_ADD(p, rearms, 1);
+    PN_PROBE2(rearm, ee->fd, ev.events);
   }
 }
 
@@ -871,7 +1181,8 @@ static const char *pconnection_setup(pconnection_t *pc, pn_proactor_t *p, pn_con
 // Call with lock held and closing == true (i.e. pn_connection_driver_finished() == true), timer cancelled.
 // Return true when all possible outstanding epoll events associated with this pconnection have been processed.
 static inline bool pconnection_is_final(pconnection_t *pc) {
-  return !pc->current_arm && !pc->current_arm_2 && !pc->timer_armed && !pc->context.wake_ops;
+  return !pc->current_arm && !pc->current_arm_2 && !pc->timer_armed && !pc->context.wake_ops &&
+    !pc->resolving;
 }
 
 static void pconnection_final_free(pconnection_t *pc) {
@@ -881,9 +1192,8 @@ static void pconnection_final_free(pconnection_t *pc) {
   if (pc->driver.connection) {
     set_pconnection(pc->driver.connection, NULL);
   }
-  if (pc->addrinfo) {
-    freeaddrinfo(pc->addrinfo);
-  }
+  if (pc->resolved) resolve_request_free(pc->resolved);
+  addrinfo_free(pc->addrinfo);
   pmutex_finalize(&pc->rearm_mutex);
   pn_condition_free(pc->disconnect_condition);
   pn_connection_driver_destroy(&pc->driver);
@@ -910,6 +1220,7 @@ static void pconnection_cleanup(pconnection_t *pc) {
 static void pconnection_begin_close(pconnection_t *pc) {
   if (!pc->context.closing) {
     pc->context.closing = true;
+    resolve_abandon(pc);
     if (pc->current_arm || pc->current_arm_2) {
       // Force EPOLLHUP callback(s)
       shutdown(pc->psocket.sockfd, SHUT_RDWR);
@@ -952,9 +1263,11 @@ static pn_event_t *pconnection_batch_next(pn_event_batch_t *batch) {
       if (pconnection_process(pc, 0, false, true, false)) {
         e = pn_connection_driver_next_event(&pc->driver);
       }
+    } else if (!e) {
+      PSTATS_ADD(pc->psocket.proactor, hog_limits, 1);
     }
   }
-  return e;
+  return pstats_event(batch, e);
 }
 
 /* Shortcuts */
@@ -976,13 +1289,14 @@ static inline bool pconnection_wclosed(pconnection_t  *pc) {
    close/shutdown.  Let read()/write() return 0 or -1 to trigger cleanup logic.
 */
 static bool pconnection_rearm_check(pconnection_t *pc) {
+  if (pc->resolving || pc->resolved) return false;  // No socket yet
   if (pc->current_arm && pc->current_arm_2) return false;  // Maxed out
   if (pconnection_rclosed(pc) && pconnection_wclosed(pc)) {
     return false;
   }
   uint32_t wanted_now = (pc->read_blocked && !pconnection_rclosed(pc)) ? EPOLLIN : 0;
   if (!pconnection_wclosed(pc)) {
-    if (pc->write_blocked)
+    if (pc->write_blocked || pc->output_held)
       wanted_now |= EPOLLOUT;
     else {
       pn_bytes_t wbuf = pn_connection_driver_write_buffer(&pc->driver);
@@ -1021,7 +1335,8 @@ static inline void pconnection_rearm(pconnection_t *pc) {
 }
 
 static inline bool pconnection_work_pending(pconnection_t *pc) {
-  if (pc->new_events || pc->new_events_2 || pc->wake_count || pc->tick_pending || pc->queued_disconnect)
+  if (pc->new_events || pc->new_events_2 || pc->wake_count || pc->tick_pending || pc->queued_disconnect ||
+      pc->resolved)
     return true;
   if (!pc->read_blocked && !pconnection_rclosed(pc))
     return true;
@@ -1052,12 +1367,35 @@ static void pconnection_done(pconnection_t *pc) {
   return;
 }
 
+/* Tell the transport how much output is still unsent in the socket, so it can
+   hold back transfers while the total is over pn_transport_set_output_limit().
+   TCP_NOTSENT_LOWAT is set to the limit (unless the user set it) so EPOLLOUT
+   fires when the socket has drained below the limit.
+*/
+static void output_queued_update(pconnection_t *pc) {
+  pn_transport_t *t = pc->driver.transport;
+  size_t limit = pn_transport_get_output_limit(t);
+  if (limit != pc->output_limit) {
+    pc->output_limit = limit;
+    if (!(pc->sockopts.set & (1u << PN_SOCKET_NOTSENT_LOWAT)))
+      pni_set_socket_option(pc->psocket.sockfd, PN_SOCKET_NOTSENT_LOWAT,
+                            (limit && limit < INT_MAX) ? (int)limit : INT_MAX);
+  }
+  pc->output_held = false;
+  if (!limit) return;
+  int queued = 0;
+  if (ioctl(pc->psocket.sockfd, SIOCOUTQNSD, &queued) < 0 || queued < 0) queued = 0;
+  pn_transport_set_output_queued(t, queued);
+  pc->output_held = (size_t)queued >= limit;
+}
+
 // Return true unless error
 static bool pconnection_write(pconnection_t *pc, pn_bytes_t wbuf) {
   ssize_t n = send(pc->psocket.sockfd, wbuf.start, wbuf.size, MSG_NOSIGNAL);
   if (n > 0) {
     pn_connection_driver_write_done(&pc->driver, n);
     if ((size_t) n < wbuf.size) pc->write_blocked = true;
+    if (pc->output_limit) output_queued_update(pc);
   } else if (errno == EWOULDBLOCK) {
     pc->write_blocked = true;
   } else if (!(errno == EAGAIN || errno == EINTR)) {
@@ -1068,6 +1406,7 @@ static bool pconnection_write(pconnection_t *pc, pn_bytes_t wbuf) {
 
 static void write_flush(pconnection_t *pc) {
   if (!pc->write_blocked && !pconnection_wclosed(pc)) {
+    output_queued_update(pc);
     pn_bytes_t wbuf = pn_connection_driver_write_buffer(&pc->driver);
     if (wbuf.size > 0) {
       if (!pconnection_write(pc, wbuf)) {
@@ -1157,6 +1496,9 @@ static pn_event_batch_t *pconnection_process(pconnection_t *pc, uint32_t events,
     }
   }
 
+  if (pc->resolved)  // From resolve_connection()
+    pconnection_resolved_lh(pc);
+
   if (pconnection_has_event(pc)) {
     unlock(&pc->context.mutex);
     return &pc->batch;
@@ -1285,23 +1627,19 @@ static pn_event_batch_t *pconnection_process(pconnection_t *pc, uint32_t events,
   return NULL;
 }
 
-static void configure_socket(int sock) {
+static void configure_socket(int sock, const pni_socket_options_t *opts) {
   int flags = fcntl(sock, F_GETFL);
   flags |= O_NONBLOCK;
   (void)fcntl(sock, F_SETFL, flags); // TODO: check for error
-
-  int tcp_nodelay = 1;
-  (void)setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (void*) &tcp_nodelay, sizeof(tcp_nodelay));
+  pni_configure_socket(sock, opts);
 }
 
 /* Called with context.lock held */
 void pconnection_connected_lh(pconnection_t *pc) {
   if (!pc->connected) {
     pc->connected = true;
-    if (pc->addrinfo) {
-      freeaddrinfo(pc->addrinfo);
-      pc->addrinfo = NULL;
-    }
+    addrinfo_free(pc->addrinfo);
+    pc->addrinfo = NULL;
     pc->ai = NULL;
     socklen_t len = sizeof(pc->remote.ss);
     (void)getpeername(pc->psocket.sockfd, (struct sockaddr*)&pc->remote.ss, &len);
@@ -1338,7 +1676,7 @@ static void pconnection_maybe_connect_lh(pconnection_t *pc) {
       pc->ai = pc->ai->ai_next; /* Move to next address in case this fails */
       int fd = socket(ai->ai_family, SOCK_STREAM, 0);
       if (fd >= 0) {
-        configure_socket(fd);
+        configure_socket(fd, &pc->sockopts);
         if (!connect(fd, ai->ai_addr, ai->ai_addrlen) || errno == EINPROGRESS) {
           pc->psocket.sockfd = fd;
           pconnection_start(pc);
@@ -1349,7 +1687,7 @@ static void pconnection_maybe_connect_lh(pconnection_t *pc) {
       }
       /* connect failed immediately, go round the loop to try the next addr */
     }
-    freeaddrinfo(pc->addrinfo);
+    addrinfo_free(pc->addrinfo);
     pc->addrinfo = NULL;
     /* If there was a previous attempted connection, let the poller discover the
        errno from its socket, otherwise set the current error. */
@@ -1382,6 +1720,465 @@ static bool wake_if_inactive(pn_proactor_t *p) {
   return false;
 }
 
+// ========================================================================
+// Name resolution and happy eyeballs connection attempts
+// ========================================================================
+
+/* Copy an addrinfo list into memory we own, so it can be cached and shared */
+static struct addrinfo *addrinfo_copy(const struct addrinfo *list) {
+  struct addrinfo *first = NULL, **next = &first;
+  for (; list; list = list->ai_next) {
+    struct addrinfo *ai = (struct addrinfo*)malloc(sizeof(struct addrinfo) + list->ai_addrlen);
+    if (!ai) break;
+    *ai = *list;
+    ai->ai_canonname = NULL;
+    ai->ai_addr = (struct sockaddr*)(ai + 1);
+    memcpy(ai->ai_addr, list->ai_addr, list->ai_addrlen);
+    ai->ai_next = NULL;
+    *next = ai;
+    next = &ai->ai_next;
+  }
+  return first;
+}
+
+static void addrinfo_free(struct addrinfo *list) {
+  while (list) {
+    struct addrinfo *next = list->ai_next;
+    free(list);
+    list = next;
+  }
+}
+
+/* Call with the resolver mutex held. Returns a copy of the cached addresses or NULL. */
+static struct addrinfo *resolve_cache_get_lh(resolver_t *r, const char *host, const char *port) {
+  if (!host) host = "";
+  pn_timestamp_t now = pn_i_now2();
+  for (size_t i = 0; i < RESOLVE_CACHE_SIZE; ++i) {
+    resolve_cache_entry_t *e = &r->cache[i];
+    if (e->addrinfo && !strcmp(e->host, host) && !strcmp(e->port, port)) {
+      if (now < e->expires) return addrinfo_copy(e->addrinfo);
+      addrinfo_free(e->addrinfo);
+      e->addrinfo = NULL;
+      return NULL;
+    }
+  }
+  return NULL;
+}
+
+/* Call with the resolver mutex held. Replaces the least recently added entry when full. */
+static void resolve_cache_put_lh(resolver_t *r, const char *host, const char *port, const struct addrinfo *list) {
+  if (!host) host = "";
+  if (strlen(host) >= sizeof(r->cache[0].host) || strlen(port) >= sizeof(r->cache[0].port))
+    return;
+  resolve_cache_entry_t *e = &r->cache[0];
+  for (size_t i = 0; i < RESOLVE_CACHE_SIZE; ++i) {
+    resolve_cache_entry_t *c = &r->cache[i];
+    if (!c->addrinfo || (!strcmp(c->host, host) && !strcmp(c->port, port))) {
+      e = c;
+      break;
+    }
+    if (c->expires < e->expires) e = c;
+  }
+  addrinfo_free(e->addrinfo);
+  strcpy(e->host, host);
+  strcpy(e->port, port);
+  e->expires = pn_i_now2() + RESOLVE_CACHE_TTL;
+  e->addrinfo = addrinfo_copy(list);
+}
+
+/* Resolve and cache host:port. Called without locks, may block. */
+static int resolve(resolver_t *r, const char *host, const char *port, struct addrinfo **res) {
+  lock(&r->mutex);
+  *res = resolve_cache_get_lh(r, host, port);
+  pni_resolver_t *lookup = r->lookup;
+  unlock(&r->mutex);
+  if (*res) return 0;
+
+  struct addrinfo *result = NULL;
+  int gai_error = lookup ? lookup(host, port, &result) : pgetaddrinfo(host, port, 0, &result);
+  if (gai_error) return gai_error;
+  *res = addrinfo_copy(result);
+  lock(&r->mutex);
+  resolve_cache_put_lh(r, host, port, result);
+  unlock(&r->mutex);
+  freeaddrinfo(result);
+  return *res ? 0 : EAI_MEMORY;
+}
+
+static void resolve_cache_forget(resolver_t *r, const char *host, const char *port) {
+  if (!host) host = "";
+  lock(&r->mutex);
+  for (size_t i = 0; i < RESOLVE_CACHE_SIZE; ++i) {
+    resolve_cache_entry_t *e = &r->cache[i];
+    if (e->addrinfo && !strcmp(e->host, host) && !strcmp(e->port, port)) {
+      addrinfo_free(e->addrinfo);
+      e->addrinfo = NULL;
+    }
+  }
+  unlock(&r->mutex);
+}
+
+/* Start a non-blocking connect, return the fd or -1 and set *err */
+static int connect_start(const struct addrinfo *ai, const pni_socket_options_t *opts, bool *connected, int *err) {
+  int fd = socket(ai->ai_family, SOCK_STREAM, 0);
+  if (fd < 0) {
+    *err = errno;
+    return -1;
+  }
+  configure_socket(fd, opts);
+  if (!connect(fd, ai->ai_addr, ai->ai_addrlen)) {
+    *connected = true;
+    return fd;
+  }
+  if (errno == EINPROGRESS) return fd;
+  *err = errno;
+  close(fd);
+  return -1;
+}
+
+/*
+ * Race connection attempts to the addresses in list, starting a new attempt
+ * every CONNECT_ATTEMPT_DELAY ms until one connects. Address families are
+ * interleaved, starting with the family of the first address.
+ *
+ * Returns the connected fd. If nothing has connected CONNECT_ATTEMPT_DELAY ms
+ * after the last attempt started, returns the most preferred attempt still in
+ * progress for the caller to wait for. Returns -1 with *err set if every
+ * attempt failed or abortfd became readable.
+ */
+static int connect_race(struct addrinfo *list, const pni_socket_options_t *opts, int abortfd, int *err) {
+  const struct addrinfo *order[CONNECT_ATTEMPTS_MAX];
+  size_t n = 0;
+  int family = list->ai_family;
+  /* Interleave: alternate between addresses of the first family and the rest */
+  const struct addrinfo *same = list, *other = list;
+  while (n < CONNECT_ATTEMPTS_MAX) {
+    while (same && same->ai_family != family) same = same->ai_next;
+    while (other && other->ai_family == family) other = other->ai_next;
+    if (!same && !other) break;
+    if (same) { order[n++] = same; same = same->ai_next; }
+    if (other && n < CONNECT_ATTEMPTS_MAX) { order[n++] = other; other = other->ai_next; }
+  }
+
+  struct pollfd fds[CONNECT_ATTEMPTS_MAX + 1];
+  size_t rank[CONNECT_ATTEMPTS_MAX + 1]; /* Position in order[] of each attempt */
+  size_t pending = 0;           /* attempts in progress, fds[1..pending] */
+  size_t next = 0;              /* next address to try */
+  fds[0].fd = abortfd;
+  fds[0].events = POLLIN;
+  *err = ECONNREFUSED;
+  while (next < n || pending) {
+    if (next < n) {             /* Start the next attempt */
+      bool connected = false;
+      int fd = connect_start(order[next++], opts, &connected, err);
+      if (fd >= 0) {
+        if (connected) {
+          for (size_t i = 1; i <= pending; ++i) close(fds[i].fd);
+          return fd;
+        }
+        ++pending;
+        fds[pending].fd = fd;
+        fds[pending].events = POLLOUT;
+        rank[pending] = next - 1;
+      }
+      if (!pending) continue;   /* Failed immediately, try the next one now */
+    }
+    int r = poll(fds, pending + 1, CONNECT_ATTEMPT_DELAY);
+    if (r < 0 && errno != EINTR) {
+      *err = errno;
+      break;
+    }
+    if (r == 0 && next == n) {  /* Out of addresses, hand over the best attempt */
+      size_t best = 1;
+      for (size_t i = 2; i <= pending; ++i) {
+        if (rank[i] < rank[best]) best = i;
+      }
+      for (size_t i = 1; i <= pending; ++i) {
+        if (i != best) close(fds[i].fd);
+      }
+      return fds[best].fd;
+    }
+    if (r <= 0) continue;       /* Timed out, start another attempt */
+    if (fds[0].revents) {
+      *err = ECANCELED;
+      break;
+    }
+    for (size_t i = 1; i <= pending; ++i) {
+      if (!fds[i].revents) continue;
+      int fd = fds[i].fd;
+      int so_err = 0;
+      socklen_t len = sizeof(so_err);
+      if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &so_err, &len)) so_err = errno;
+      if (!so_err) {            /* Connected, abandon the others */
+        for (size_t j = 1; j <= pending; ++j) {
+          if (j != i) close(fds[j].fd);
+        }
+        return fd;
+      }
+      *err = so_err;
+      close(fd);
+      rank[i] = rank[pending];
+      fds[i--] = fds[pending--];
+    }
+  }
+  for (size_t i = 1; i <= pending; ++i) close(fds[i].fd);
+  return -1;
+}
+
+static resolver_t *resolver_new(void) {
+  resolver_t *r = (resolver_t*)calloc(1, sizeof(resolver_t));
+  if (!r) return NULL;
+  pmutex_init(&r->mutex);
+  pthread_cond_init(&r->cond, NULL);
+  r->refs = 1;
+  return r;
+}
+
+/* Drop a reference, the last one frees the resolver */
+static void resolver_release(resolver_t *r) {
+  lock(&r->mutex);
+  bool last = (--r->refs == 0);
+  unlock(&r->mutex);
+  if (last) {
+    for (size_t i = 0; i < RESOLVE_CACHE_SIZE; ++i)
+      addrinfo_free(r->cache[i].addrinfo);
+    pmutex_finalize(&r->mutex);
+    pthread_cond_destroy(&r->cond);
+    free(r);
+  }
+}
+
+static resolve_request_t *resolve_request(pconnection_t *pc) {
+  resolve_request_t *req = (resolve_request_t*)calloc(1, sizeof(resolve_request_t));
+  if (!req) {
+    errno = ENOMEM;
+    return NULL;
+  }
+  const char *host = pc->psocket.host, *port = pc->psocket.port;
+  if ((host && strlen(host) >= sizeof(req->host)) || strlen(port) >= sizeof(req->port)) {
+    free(req);
+    errno = ENAMETOOLONG;
+    return NULL;
+  }
+  req->abortfd = eventfd(0, EFD_NONBLOCK);
+  if (req->abortfd < 0) {
+    free(req);
+    return NULL;
+  }
+  req->pc = pc;
+  req->state = RESOLVE_QUEUED;
+  req->fd = -1;
+  req->has_host = (host != NULL);
+  if (host) strcpy(req->host, host);
+  strcpy(req->port, port);
+  req->sockopts = pc->sockopts;
+  return req;
+}
+
+static void resolve_request_free(resolve_request_t *req) {
+  if (req->fd >= 0) close(req->fd);
+  addrinfo_free(req->addrinfo);
+  close(req->abortfd);
+  free(req);
+}
+
+/* Call with pc locked, when it closes. Abandons its request unless the result
+   is being handed over, in which case pc->resolving is cleared shortly. */
+static void resolve_abandon(pconnection_t *pc) {
+  resolve_request_t *req = pc->resolving;
+  if (!req) return;
+  resolver_t *r = pc->psocket.proactor->resolver;
+  lock(&r->mutex);
+  switch (req->state) {
+   case RESOLVE_QUEUED: {         /* Not started, take it off the queue */
+     resolve_request_t **pp = &r->first;
+     while (*pp != req) pp = &(*pp)->next;
+     *pp = req->next;
+     if (r->last == req) {
+       r->last = NULL;
+       for (resolve_request_t *q = r->first; q; q = q->next) r->last = q;
+     }
+     resolve_request_free(req);
+     pc->resolving = NULL;
+     break;
+   }
+   case RESOLVE_RUNNING: {        /* Stop any race, the thread frees the request */
+     uint64_t one = 1;
+     req->pc = NULL;
+     (void)!write(req->abortfd, &one, sizeof(one));
+     pc->resolving = NULL;
+     break;
+   }
+   case RESOLVE_DONE:
+    resolve_request_free(req);
+    pc->resolving = NULL;
+    break;
+   case RESOLVE_CLAIMED:
+    break;
+  }
+  unlock(&r->mutex);
+}
+
+/* Resolve and connect on a resolver thread, then hand the result to the connection */
+static void resolve_connection(resolver_t *r, resolve_request_t *req) {
+  const char *host = req->has_host ? req->host : NULL, *port = req->port;
+  req->gai_error = resolve(r, host, port, &req->addrinfo);
+  if (!req->gai_error && req->addrinfo->ai_next) {
+    req->fd = connect_race(req->addrinfo, &req->sockopts, req->abortfd, &req->err);
+    if (req->fd < 0 && req->err != ECANCELED) resolve_cache_forget(r, host, port);  /* Look up afresh next time */
+  }
+
+  lock(&r->mutex);
+  pconnection_t *pc = req->pc;
+  bool claimed = pc && !r->stop;
+  if (claimed) {
+    req->state = RESOLVE_CLAIMED;
+    r->claimed++;
+  } else if (pc) {
+    req->state = RESOLVE_DONE;  /* The proactor is being freed, it will clean up */
+  }
+  unlock(&r->mutex);
+  if (!claimed) {
+    if (!pc) resolve_request_free(req);  /* Abandoned */
+    return;
+  }
+
+  /* The connection owns req from here, see pconnection_resolved_lh() */
+  lock(&pc->context.mutex);
+  pc->resolving = NULL;
+  pc->resolved = req;
+  bool notify = wake(&pc->context);
+  unlock(&pc->context.mutex);
+  if (notify) wake_notify(&pc->context);
+
+  lock(&r->mutex);
+  if (--r->claimed == 0 && r->stop) pthread_cond_broadcast(&r->cond);
+  unlock(&r->mutex);
+}
+
+/* Called by the working context with context.lock held. Use the result of
+   resolve_connection() to start connecting, or report its error. */
+static void pconnection_resolved_lh(pconnection_t *pc) {
+  resolve_request_t *req = pc->resolved;
+  pc->resolved = NULL;
+  if (pc->context.closing) {
+    /* Nothing to do, the result is freed below */
+  } else if (req->gai_error) {
+    psocket_gai_error(&pc->psocket, req->gai_error, "connect to ");
+  } else {
+    pc->addrinfo = req->addrinfo;
+    req->addrinfo = NULL;
+    if (req->fd >= 0) {         /* From the race, wait for the connected event */
+      pc->ai = NULL;
+      pc->psocket.sockfd = req->fd;
+      req->fd = -1;
+      pconnection_start(pc);
+    } else if (pc->addrinfo->ai_next) {
+      pc->ai = NULL;
+      psocket_error(&pc->psocket, req->err, "on connect");
+      pc->disconnected = true;
+    } else {
+      pc->ai = pc->addrinfo;
+      pconnection_maybe_connect_lh(pc); /* Single address, connect as usual */
+    }
+  }
+  resolve_request_free(req);
+}
+
+static void *resolver_thread(void *arg) {
+  resolver_t *r = (resolver_t*)arg;
+  lock(&r->mutex);
+  while (!r->stop) {
+    resolve_request_t *req = r->first;
+    if (!req) {
+      r->idle++;
+      pthread_cond_wait(&r->cond, &r->mutex);
+      r->idle--;
+      continue;
+    }
+    r->first = req->next;
+    if (!r->first) r->last = NULL;
+    req->next = NULL;
+    req->state = RESOLVE_RUNNING;
+    unlock(&r->mutex);
+    resolve_connection(r, req);
+    lock(&r->mutex);
+  }
+  r->threads--;
+  unlock(&r->mutex);
+  resolver_release(r);
+  return NULL;
+}
+
+/* Call with pc locked. Queue a request to resolve and connect pc. */
+static bool resolve_queue_lh(pconnection_t *pc) {
+  resolver_t *r = pc->psocket.proactor->resolver;
+  resolve_request_t *req = resolve_request(pc);
+  if (!req) return false;
+  lock(&r->mutex);
+  if (r->last) r->last->next = req;
+  else r->first = req;
+  r->last = req;
+  unlock(&r->mutex);
+  pc->resolving = req;
+  return true;
+}
+
+/* Get a resolver thread to work on the queue, starting a new thread if none is free. */
+static void resolver_wake(pn_proactor_t *p) {
+  resolver_t *r = p->resolver;
+  lock(&r->mutex);
+  if (!r->idle && r->threads < RESOLVER_THREADS) {
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (!pthread_create(&thread, &attr, resolver_thread, r)) {
+      r->threads++;
+      r->refs++;
+    }
+    pthread_attr_destroy(&attr);
+  }
+  resolve_request_t *req = r->first;
+  if (!r->threads && req) {
+    /* No thread to do the work, resolve on this thread after all */
+    r->first = req->next;
+    if (!r->first) r->last = NULL;
+    req->next = NULL;
+    req->state = RESOLVE_RUNNING;
+    unlock(&r->mutex);
+    resolve_connection(r, req);
+    return;
+  }
+  pthread_cond_signal(&r->cond);
+  unlock(&r->mutex);
+}
+
+/* Stop the resolver threads. Waits for results being handed to connections,
+   but not for lookups or connection attempts: those are abandoned when the
+   connections are shut down. */
+static void resolver_stop(pn_proactor_t *p) {
+  resolver_t *r = p->resolver;
+  lock(&r->mutex);
+  r->stop = true;
+  pthread_cond_broadcast(&r->cond);
+  while (r->claimed)
+    pthread_cond_wait(&r->cond, &r->mutex);
+  unlock(&r->mutex);
+}
+
+bool pni_proactor_set_resolver(pn_proactor_t *p, pni_resolver_t *lookup) {
+  resolver_t *r = p->resolver;
+  lock(&r->mutex);
+  r->lookup = lookup;
+  for (size_t i = 0; i < RESOLVE_CACHE_SIZE; ++i) {
+    addrinfo_free(r->cache[i].addrinfo);
+    r->cache[i].addrinfo = NULL;
+  }
+  unlock(&r->mutex);
+  return true;
+}
+
 void pn_proactor_connect2(pn_proactor_t *p, pn_connection_t *c, pn_transport_t *t, const char *addr) {
   pconnection_t *pc = (pconnection_t*) calloc(1, sizeof(pconnection_t));
   assert(pc); // TODO: memory safety
@@ -1390,6 +2187,7 @@ void pn_proactor_connect2(pn_proactor_t *p, pn_connection_t *c, pn_transport_t *
     pn_logf("pn_proactor_connect failure: %s", err);
     return;
   }
+  pni_connection_socket_options(pc->driver.connection, &pc->sockopts);
   // TODO: check case of proactor shutting down
 
   lock(&pc->context.mutex);
@@ -1397,29 +2195,41 @@ void pn_proactor_connect2(pn_proactor_t *p, pn_connection_t *c, pn_transport_t *
   pn_connection_open(pc->driver.connection); /* Auto-open */
 
   bool notify = false;
-  bool notify_proactor = false;
+  bool queue = false;
 
   if (pc->disconnected) {
     notify = wake(&pc->context);    /* Error during initialization */
   } else {
-    int gai_error = pgetaddrinfo(pc->psocket.host, pc->psocket.port, 0, &pc->addrinfo);
-    if (!gai_error) {
-      pn_connection_open(pc->driver.connection); /* Auto-open */
+    /* Connect right away to a numeric or single cached address, otherwise
+       let a resolver thread look up the host and race the connection attempts */
+    struct addrinfo *ai = NULL;
+    if (!pgetaddrinfo(pc->psocket.host, pc->psocket.port, AI_NUMERICHOST, &ai)) {
+      pc->addrinfo = addrinfo_copy(ai);
+      freeaddrinfo(ai);
+    } else {
+      lock(&p->resolver->mutex);
+      pc->addrinfo = resolve_cache_get_lh(p->resolver, pc->psocket.host, pc->psocket.port);
+      unlock(&p->resolver->mutex);
+      if (pc->addrinfo && pc->addrinfo->ai_next) {
+        addrinfo_free(pc->addrinfo);
+        pc->addrinfo = NULL;
+      }
+    }
+    if (pc->addrinfo) {
       pc->ai = pc->addrinfo;
       pconnection_maybe_connect_lh(pc); /* Start connection attempts */
       if (pc->disconnected) notify = wake(&pc->context);
+    } else if (resolve_queue_lh(pc)) {
+      queue = true;
     } else {
-      psocket_gai_error(&pc->psocket, gai_error, "connect to ");
+      psocket_error(&pc->psocket, errno, "connect to ");
+      pc->disconnected = true;
       notify = wake(&pc->context);
-      lock(&p->context.mutex);
-      notify_proactor = wake_if_inactive(p);
-      unlock(&p->context.mutex);
     }
   }
-  /* We need to issue INACTIVE on immediate failure */
   unlock(&pc->context.mutex);
   if (notify) wake_notify(&pc->context);
-  if (notify_proactor) wake_notify(&p->context);
+  if (queue) resolver_wake(p);
 }
 
 static void pconnection_tick(pconnection_t *pc) {
@@ -1498,6 +2308,8 @@ void pn_proactor_listen(pn_proactor_t *p, pn_listener_t *l, const char *addr, in
   char addr_buf[PN_MAX_ADDR];
   const char *host, *port;
   pni_parse_addr(addr, addr_buf, PN_MAX_ADDR, &host, &port);
+  pni_socket_options_t sockopts = { { 0 }, 0 };
+  pni_listener_socket_options(l, &sockopts);
 
   struct addrinfo *addrinfo = NULL;
   int gai_err = pgetaddrinfo(host, port, AI_PASSIVE | AI_ALL, &addrinfo);
@@ -1508,47 +2320,60 @@ void pn_proactor_listen(pn_proactor_t *p, pn_listener_t *l, const char *addr, in
       ++len;
     }
     assert(len > 0);            /* guaranteed by getaddrinfo */
+    size_t shards = l->shards ? l->shards : 1;
+    len *= shards;
     l->acceptors = (acceptor_t*)calloc(len, sizeof(acceptor_t));
     assert(l->acceptors);      /* TODO aconway 2017-05-05: memory safety */
     l->acceptors_size = 0;
     uint16_t dynamic_port = 0;  /* Record dynamic port from first bind(0) */
+    struct pn_netaddr_t *last_addr = NULL;
     /* Find working listen addresses */
     for (struct addrinfo *ai = addrinfo; ai; ai = ai->ai_next) {
-      if (dynamic_port) set_port(ai->ai_addr, dynamic_port);
-      int fd = socket(ai->ai_family, SOCK_STREAM, ai->ai_protocol);
-      static int on = 1;
-      if (fd >= 0) {
-        if (!setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) &&
-            /* We listen to v4/v6 on separate sockets, don't let v6 listen for v4 */
-            (ai->ai_family != AF_INET6 ||
-             !setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &on, sizeof(on))) &&
-            !bind(fd, ai->ai_addr, ai->ai_addrlen) &&
-            !listen(fd, backlog))
-        {
-          acceptor_t *acceptor = &l->acceptors[l->acceptors_size++];
-          /* Get actual address */
-          socklen_t len = pn_netaddr_socklen(&acceptor->addr);
-          (void)getsockname(fd, (struct sockaddr*)(&acceptor->addr.ss), &len);
-          if (acceptor == l->acceptors) { /* First acceptor, check for dynamic port */
-            dynamic_port = check_dynamic_port(ai->ai_addr, pn_netaddr_sockaddr(&acceptor->addr));
-          } else {              /* Link addr to previous addr */
-            (acceptor-1)->addr.next = &acceptor->addr;
+      bool listening = false;
+      for (size_t shard = 0; shard < shards; ++shard) {
+        if (dynamic_port) set_port(ai->ai_addr, dynamic_port);
+        int fd = socket(ai->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+        static int on = 1;
+        if (fd >= 0) {
+          /* Accepted sockets inherit buffer sizes, so the window is scaled to match */
+          pni_configure_socket(fd, &sockopts);
+          if (!setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) &&
+              /* Shards share the address, the kernel balances connections between them */
+              (shards == 1 || !setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on))) &&
+              /* We listen to v4/v6 on separate sockets, don't let v6 listen for v4 */
+              (ai->ai_family != AF_INET6 ||
+               !setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &on, sizeof(on))) &&
+              !bind(fd, ai->ai_addr, ai->ai_addrlen) &&
+              !listen(fd, backlog))
+          {
+            acceptor_t *acceptor = &l->acceptors[l->acceptors_size++];
+            /* Get actual address */
+            socklen_t len = pn_netaddr_socklen(&acceptor->addr);
+            (void)getsockname(fd, (struct sockaddr*)(&acceptor->addr.ss), &len);
+            if (acceptor == l->acceptors) { /* First acceptor, check for dynamic port */
+              dynamic_port = check_dynamic_port(ai->ai_addr, pn_netaddr_sockaddr(&acceptor->addr));
+            }
+            if (!listening) {     /* Link first socket for each address to previous addr */
+              if (last_addr) last_addr->next = &acceptor->addr;
+              last_addr = &acceptor->addr;
+              listening = true;
+            }
+
+            acceptor->accepted_head = acceptor->accepted_count = 0;
+            psocket_t *ps = &acceptor->psocket;
+            psocket_init(ps, p, l, addr);
+            ps->sockfd = fd;
+            ps->epoll_io.fd = fd;
+            ps->epoll_io.wanted = EPOLLIN;
+            ps->epoll_io.polling = false;
+            lock(&l->rearm_mutex);
+            start_polling(&ps->epoll_io, ps->proactor->epollfd);  // TODO: check for error
+            l->active_count++;
+            acceptor->armed = true;
+            unlock(&l->rearm_mutex);
+          } else {
+            close(fd);
           }
-
-          acceptor->accepted_fd = -1;
-          psocket_t *ps = &acceptor->psocket;
-          psocket_init(ps, p, l, addr);
-          ps->sockfd = fd;
-          ps->epoll_io.fd = fd;
-          ps->epoll_io.wanted = EPOLLIN;
-          ps->epoll_io.polling = false;
-          lock(&l->rearm_mutex);
-          start_polling(&ps->epoll_io, ps->proactor->epollfd);  // TODO: check for error
-          l->active_count++;
-          acceptor->armed = true;
-          unlock(&l->rearm_mutex);
-        } else {
-          close(fd);
         }
       }
     }
@@ -1563,7 +2388,6 @@ void pn_proactor_listen(pn_proactor_t *p, pn_listener_t *l, const char *addr, in
     l->acceptors_size = 1;
     memset(l->acceptors, 0, sizeof(acceptor_t));
     psocket_init(&l->acceptors[0].psocket, p, l, addr);
-    l->acceptors[0].accepted_fd = -1;
     if (gai_err) {
       psocket_gai_error(&l->acceptors[0].psocket, gai_err, "listen on");
     } else {
@@ -1635,9 +2459,11 @@ static void listener_begin_close(pn_listener_t* l) {
     if (l->unclaimed) l->pending_count++;
     acceptor_t *a = listener_list_next(&l->pending_acceptors);
     while (a) {
-      close(a->accepted_fd);
-      a->accepted_fd = -1;
-      l->pending_count--;
+      for (; a->accepted_head < a->accepted_count; ++a->accepted_head) {
+        close(a->accepted_fds[a->accepted_head]);
+        l->pending_count--;
+      }
+      a->accepted_head = a->accepted_count = 0;
       a = listener_list_next(&l->pending_acceptors);
     }
     assert(!l->pending_count);
@@ -1674,29 +2500,38 @@ static void listener_forced_shutdown(pn_listener_t *l) {
   pn_listener_free(l);
 }
 
-/* Accept a connection as part of listener_process(). Called with listener context lock held. */
+/* Accept connections as part of listener_process(). Called with listener context lock held. */
 static void listener_accept_lh(psocket_t *ps) {
   pn_listener_t *l = psocket_listener(ps);
   acceptor_t *acceptor = psocket_acceptor(ps);
-  assert(acceptor->accepted_fd < 0); /* Shouldn't already have an accepted_fd */
-  acceptor->accepted_fd = accept(ps->sockfd, NULL, 0);
-  if (acceptor->accepted_fd >= 0) {
-    //    acceptor_t *acceptor = listener_list_next(pending_acceptors);
+  assert(acceptor->accepted_count == 0); /* Shouldn't already have accepted sockets */
+  int err = 0;
+  while (acceptor->accepted_count < ACCEPT_BATCH) {
+    int fd = accept4(ps->sockfd, NULL, 0, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      err = errno;
+      break;
+    }
+    acceptor->accepted_fds[acceptor->accepted_count++] = fd;
+  }
+  if (acceptor->accepted_count) {
     listener_list_append(&l->pending_acceptors, acceptor);
-    l->pending_count++;
+    l->pending_count += acceptor->accepted_count;
+  } else if (err == ENFILE || err == EMFILE) {
+    listener_set_overflow(acceptor);
+  } else if (err == EAGAIN || err == EWOULDBLOCK || err == ECONNABORTED) {
+    /* Nothing to accept after all, wait for the next connection */
+    lock(&l->rearm_mutex);
+    acceptor->armed = true;
+    rearm(ps->proactor, &ps->epoll_io);
+    unlock(&l->rearm_mutex);
   } else {
-    int err = errno;
-    if (err == ENFILE || err == EMFILE) {
-      listener_set_overflow(acceptor);
-    } else {
-      psocket_error(ps, err, "accept");
-    }
+    psocket_error(ps, err, "accept");
   }
 }
 
 /* Process a listening socket */
 static pn_event_batch_t *listener_process(psocket_t *ps, uint32_t events) {
-  // TODO: some parallelization of the accept mechanism.
   pn_listener_t *l = psocket_listener(ps);
   acceptor_t *a = psocket_acceptor(ps);
   lock(&l->context.mutex);
@@ -1753,7 +2588,7 @@ static pn_event_t *listener_batch_next(pn_event_batch_t *batch) {
   if (e && pn_event_type(e) == PN_LISTENER_CLOSE)
     l->close_dispatched = true;
   unlock(&l->context.mutex);
-  return log_event(l, e);
+  return pstats_event(batch, log_event(l, e));
 }
 
 static void listener_done(pn_listener_t *l) {
@@ -1775,6 +2610,16 @@ pn_proactor_t *pn_listener_proactor(pn_listener_t* l) {
   return l ? l->acceptors[0].psocket.proactor : NULL;
 }
 
+void pn_proactor_set_loops(pn_proactor_t *p, size_t loops) {
+  /* Not needed, every thread calling pn_proactor_wait() already polls for IO */
+  (void)p; (void)loops;
+}
+
+int pn_listener_set_shards(pn_listener_t *l, size_t shards) {
+  l->shards = shards;
+  return 0;
+}
+
 pn_condition_t* pn_listener_condition(pn_listener_t* l) {
   return l->condition;
 }
@@ -1799,6 +2644,9 @@ void pn_listener_accept2(pn_listener_t *l, pn_connection_t *c, pn_transport_t *t
     pn_logf("pn_listener_accept failure: %s", err);
     return;
   }
+  /* Connection options override the listener's */
+  pni_listener_socket_options(l, &pc->sockopts);
+  pni_connection_socket_options(pc->driver.connection, &pc->sockopts);
   // TODO: fuller sanity check on input args
 
   int err2 = 0;
@@ -1810,14 +2658,19 @@ void pn_listener_accept2(pn_listener_t *l, pn_connection_t *c, pn_transport_t *t
     err2 = EBADF;
   else if (l->unclaimed) {
     l->unclaimed = false;
-    acceptor_t *a = listener_list_next(&l->pending_acceptors);
+    acceptor_t *a = l->pending_acceptors;
     assert(a);
     assert(!a->armed);
-    fd = a->accepted_fd;
-    a->accepted_fd = -1;
-    lock(&l->rearm_mutex);
-    rearming_ps = &a->psocket;
-    a->armed = true;
+    assert(a->accepted_head < a->accepted_count);
+    fd = a->accepted_fds[a->accepted_head++];
+    if (a->accepted_head == a->accepted_count) {
+      /* All of this socket's connections have been accepted, listen for more */
+      listener_list_next(&l->pending_acceptors);
+      a->accepted_head = a->accepted_count = 0;
+      lock(&l->rearm_mutex);
+      rearming_ps = &a->psocket;
+      a->armed = true;
+    }
   }
   else err2 = EWOULDBLOCK;
 
@@ -1825,7 +2678,7 @@ void pn_listener_accept2(pn_listener_t *l, pn_connection_t *c, pn_transport_t *t
   lock(&pc->context.mutex);
   pc->psocket.sockfd = fd;
   if (fd >= 0) {
-    configure_socket(fd);
+    configure_socket(fd, &pc->sockopts);
     pconnection_start(pc);
     pconnection_connected_lh(pc);
   }
@@ -1873,9 +2726,12 @@ pn_proactor_t *pn_proactor() {
   p->epollfd = p->eventfd = p->timer.timerfd = -1;
   pcontext_init(&p->context, PROACTOR, p, p);
   pmutex_init(&p->eventfd_mutex);
+  pmutex_init(&p->stats_mutex);
+  p->stats_id = __atomic_add_fetch(&pstats_last_id, 1, __ATOMIC_RELAXED);
+  p->resolver = resolver_new();
   ptimer_init(&p->timer, 0);
 
-  if ((p->epollfd = epoll_create(1)) >= 0 && (p->epollfd_2 = epoll_create(1)) >= 0) {
+  if (p->resolver && (p->epollfd = epoll_create(1)) >= 0 && (p->epollfd_2 = epoll_create(1)) >= 0) {
     if ((p->eventfd = eventfd(0, EFD_NONBLOCK)) >= 0) {
       if ((p->interruptfd = eventfd(0, EFD_NONBLOCK)) >= 0) {
         if (p->timer.timerfd >= 0)
@@ -1895,6 +2751,8 @@ pn_proactor_t *pn_proactor() {
   if (p->epollfd_2 >= 0) close(p->epollfd_2);
   if (p->eventfd >= 0) close(p->eventfd);
   if (p->interruptfd >= 0) close(p->interruptfd);
+  if (p->resolver) resolver_release(p->resolver);
+  pmutex_finalize(&p->stats_mutex);
   ptimer_finalize(&p->timer);
   if (p->collector) pn_free(p->collector);
   free (p);
@@ -1903,6 +2761,7 @@ pn_proactor_t *pn_proactor() {
 
 void pn_proactor_free(pn_proactor_t *p) {
   //  No competing threads, not even a pending timer
+  resolver_stop(p);
   p->shutting_down = true;
   close(p->epollfd);
   p->epollfd = -1;
@@ -1930,6 +2789,13 @@ void pn_proactor_free(pn_proactor_t *p) {
 
   pn_collector_free(p->collector);
   pmutex_finalize(&p->eventfd_mutex);
+  resolver_release(p->resolver);  /* Threads still resolving keep it till they finish */
+  while (p->stats) {
+    pstats_t *s = p->stats;
+    p->stats = s->next;
+    pstats_free(s);
+  }
+  pmutex_finalize(&p->stats_mutex);
   pcontext_finalize(&p->context);
   free(p);
 }
@@ -1975,18 +2841,18 @@ static bool proactor_update_batch(pn_proactor_t *p) {
 
 static pn_event_t *proactor_batch_next(pn_event_batch_t *batch) {
   pn_proactor_t *p = batch_proactor(batch);
-  lock(&p->context.mutex);
+  proactor_lock(p);
   proactor_update_batch(p);
   pn_event_t *e = pn_collector_next(p->collector);
   if (e && pn_event_type(e) == PN_PROACTOR_TIMEOUT)
     p->timeout_processed = true;
-  unlock(&p->context.mutex);
-  return log_event(p, e);
+  proactor_unlock(p);
+  return pstats_event(batch, log_event(p, e));
 }
 
 static pn_event_batch_t *proactor_process(pn_proactor_t *p, pn_event_type_t event) {
   bool timer_fired = (event == PN_PROACTOR_TIMEOUT) && ptimer_callback(&p->timer) != 0;
-  lock(&p->context.mutex);
+  proactor_lock(p);
   if (event == PN_PROACTOR_INTERRUPT) {
     p->need_interrupt = true;
   } else if (event == PN_PROACTOR_TIMEOUT) {
@@ -2000,13 +2866,13 @@ static pn_event_batch_t *proactor_process(pn_proactor_t *p, pn_event_type_t even
   if (!p->context.working) {       /* Can generate proactor events */
     if (proactor_update_batch(p)) {
       p->context.working = true;
-      unlock(&p->context.mutex);
+      proactor_unlock(p);
       return &p->batch;
     }
   }
   bool rearm_timer = !p->timer_armed && !p->timer.shutting_down;
   p->timer_armed = true;
-  unlock(&p->context.mutex);
+  proactor_unlock(p);
   if (rearm_timer)
     rearm(p, &p->timer.epoll_io);
   return NULL;
@@ -2016,6 +2882,8 @@ static pn_event_batch_t *proactor_chained_epoll_wait(pn_proactor_t *p) {
   // process one ready pconnection socket event from the secondary/chained epollfd_2
   struct epoll_event ev = {0};
   int n = epoll_wait(p->epollfd_2, &ev, 1, 0);
+  if (pstats_enabled(p))
+    pstats_poll(p, 0);
   if (n < 0) {
     if (errno != EINTR)
       perror("epoll_wait"); // TODO: proper log
@@ -2034,28 +2902,28 @@ static pn_event_batch_t *proactor_chained_epoll_wait(pn_proactor_t *p) {
 
 static void proactor_add(pcontext_t *ctx) {
   pn_proactor_t *p = ctx->proactor;
-  lock(&p->context.mutex);
+  proactor_lock(p);
   if (p->contexts) {
     p->contexts->prev = ctx;
     ctx->next = p->contexts;
   }
   p->contexts = ctx;
-  unlock(&p->context.mutex);
+  proactor_unlock(p);
 }
 
 // call with psocket's mutex held
 // return true if safe for caller to free psocket
 static bool proactor_remove(pcontext_t *ctx) {
   pn_proactor_t *p = ctx->proactor;
-  lock(&p->context.mutex);
+  proactor_lock(p);
   bool can_free = true;
   if (ctx->disconnecting) {
-    // No longer on contexts list
-    if (--ctx->disconnect_ops == 0) {
-      --p->disconnects_pending;
-    }
-    else                  // procator_disconnect() still processing
-      can_free = false;   // this psocket
+    // No longer on contexts list. Called once per context, so the disconnect
+    // is no longer pending even if pn_proactor_disconnect() is still
+    // processing this psocket. If so, it does the free.
+    --p->disconnects_pending;
+    if (--ctx->disconnect_ops != 0)
+      can_free = false;
   }
   else {
     // normal case
@@ -2072,7 +2940,7 @@ static bool proactor_remove(pcontext_t *ctx) {
     }
   }
   bool notify = wake_if_inactive(p);
-  unlock(&p->context.mutex);
+  proactor_unlock(p);
   if (notify) wake_notify(&p->context);
   return can_free;
 }
@@ -2104,7 +2972,10 @@ static pn_event_batch_t *proactor_do_epoll(struct pn_proactor_t* p, bool can_blo
   while(true) {
     pn_event_batch_t *batch = NULL;
     struct epoll_event ev = {0};
+    uint64_t start = (can_block && pstats_enabled(p)) ? pstats_now() : 0;
     int n = epoll_wait(p->epollfd, &ev, 1, timeout);
+    if (pstats_enabled(p))
+      pstats_poll(p, start);
 
     if (n < 0) {
       if (errno != EINTR)
@@ -2153,14 +3024,16 @@ static pn_event_batch_t *proactor_do_epoll(struct pn_proactor_t* p, bool can_blo
 }
 
 pn_event_batch_t *pn_proactor_wait(struct pn_proactor_t* p) {
-  return proactor_do_epoll(p, true);
+  return pstats_batch(p, proactor_do_epoll(p, true));
 }
 
 pn_event_batch_t *pn_proactor_get(struct pn_proactor_t* p) {
-  return proactor_do_epoll(p, false);
+  return pstats_batch(p, proactor_do_epoll(p, false));
 }
 
 void pn_proactor_done(pn_proactor_t *p, pn_event_batch_t *batch) {
+  if (pstats_thread.batch)
+    pstats_batch_done(p, batch);
   pconnection_t *pc = batch_pconnection(batch);
   if (pc) {
     pconnection_done(pc);
@@ -2174,7 +3047,7 @@ void pn_proactor_done(pn_proactor_t *p, pn_event_batch_t *batch) {
   pn_proactor_t *bp = batch_proactor(batch);
   if (bp == p) {
     bool notify = false;
-    lock(&p->context.mutex);
+    proactor_lock(p);
     bool rearm_timer = !p->timer_armed && !p->shutting_down;
     p->timer_armed = true;
     p->context.working = false;
@@ -2187,7 +3060,7 @@ void pn_proactor_done(pn_proactor_t *p, pn_event_batch_t *batch) {
     if (proactor_has_event(p))
       if (wake(&p->context))
         notify = true;
-    unlock(&p->context.mutex);
+    proactor_unlock(p);
     if (notify)
       wake_notify(&p->context);
     if (rearm_timer)
@@ -2206,7 +3079,7 @@ void pn_proactor_interrupt(pn_proactor_t *p) {
 
 void pn_proactor_set_timeout(pn_proactor_t *p, pn_millis_t t) {
   bool notify = false;
-  lock(&p->context.mutex);
+  proactor_lock(p);
   p->timeout_set = true;
   if (t == 0) {
     ptimer_set(&p->timer, 0);
@@ -2215,17 +3088,17 @@ void pn_proactor_set_timeout(pn_proactor_t *p, pn_millis_t t) {
   } else {
     ptimer_set(&p->timer, t);
   }
-  unlock(&p->context.mutex);
+  proactor_unlock(p);
   if (notify) wake_notify(&p->context);
 }
 
 void pn_proactor_cancel_timeout(pn_proactor_t *p) {
-  lock(&p->context.mutex);
+  proactor_lock(p);
   p->timeout_set = false;
   p->need_timeout = false;
   ptimer_set(&p->timer, 0);
   bool notify = wake_if_inactive(p);
-  unlock(&p->context.mutex);
+  proactor_unlock(p);
   if (notify) wake_notify(&p->context);
 }
 
@@ -2237,7 +3110,7 @@ pn_proactor_t *pn_connection_proactor(pn_connection_t* c) {
 void pn_proactor_disconnect(pn_proactor_t *p, pn_condition_t *cond) {
   bool notify = false;
 
-  lock(&p->context.mutex);
+  proactor_lock(p);
   // Move the whole contexts list into a disconnecting state
   pcontext_t *disconnecting_pcontexts = p->contexts;
   p->contexts = NULL;
@@ -2250,7 +3123,7 @@ void pn_proactor_disconnect(pn_proactor_t *p, pn_condition_t *cond) {
     ctx = ctx->next;
   }
   notify = wake_if_inactive(p);
-  unlock(&p->context.mutex);
+  proactor_unlock(p);
   if (!disconnecting_pcontexts) {
     if (notify) wake_notify(&p->context);
     return;
@@ -2299,7 +3172,7 @@ void pn_proactor_disconnect(pn_proactor_t *p, pn_condition_t *cond) {
       }
     }
 
-    lock(&p->context.mutex);
+    proactor_lock(p);
     if (--ctx->disconnect_ops == 0) {
       do_free = true;
       ctx_notify = false;
@@ -2309,7 +3182,7 @@ void pn_proactor_disconnect(pn_proactor_t *p, pn_condition_t *cond) {
       if (ctx_notify)
         ctx_notify = wake(ctx);
     }
-    unlock(&p->context.mutex);
+    proactor_unlock(p);
     unlock(ctx_mutex);
 
     if (do_free) {
@@ -2338,6 +3211,79 @@ const pn_netaddr_t *pn_listener_addr(pn_listener_t *l) {
   return l->acceptors_size > 0 ? &l->acceptors[0].addr : NULL;
 }
 
+void pn_proactor_set_stats_enabled(pn_proactor_t *p, bool enabled) {
+  __atomic_store_n(&p->stats_enabled, enabled, __ATOMIC_RELAXED);
+}
+
+bool pn_proactor_get_stats_enabled(pn_proactor_t *p) {
+  return pstats_enabled(p);
+}
+
+int pn_proactor_stats_threads(pn_proactor_t *p) {
+  lock(&p->stats_mutex);
+  int n = p->stats_count;
+  unlock(&p->stats_mutex);
+  return n;
+}
+
+static void pstats_sum(pn_proactor_stats_t *total, const pn_proactor_stats_t *s) {
+  total->polls += s->polls;
+  total->batches += s->batches;
+  total->events += s->events;
+  total->wakes += s->wakes;
+  total->hog_limits += s->hog_limits;
+  total->rearms += s->rearms;
+  total->locks += s->locks;
+  total->lock_held_ns += s->lock_held_ns;
+  total->busy_ns += s->busy_ns;
+  total->idle_ns += s->idle_ns;
+}
+
+int pn_proactor_stats(pn_proactor_t *p, int thread, pn_proactor_stats_t *stats) {
+  memset(stats, 0, sizeof(*stats));
+  if (thread < -1) return PN_ARG_ERR;
+  lock(&p->stats_mutex);
+  int i = 0;
+  for (pstats_t *s = p->stats; s && (thread < 0 || i <= thread); s = s->next, ++i) {
+    if (thread < 0 || i == thread) {
+      lock(&s->mutex);
+      pstats_sum(stats, &s->counters);
+      unlock(&s->mutex);
+    }
+  }
+  unlock(&p->stats_mutex);
+  return (thread < 0 || i > thread) ? 0 : PN_ARG_ERR;
+}
+
+int pn_proactor_stats_distribution(pn_proactor_t *p, int thread, pn_proactor_distribution_t distribution,
+                                   pn_histogram_t *histogram) {
+  pn_histogram_clear(histogram);
+  if (thread < -1 || (unsigned)distribution >= PSTATS_DISTRIBUTIONS) return PN_ARG_ERR;
+  lock(&p->stats_mutex);
+  int i = 0;
+  for (pstats_t *s = p->stats; s && (thread < 0 || i <= thread); s = s->next, ++i) {
+    if (thread < 0 || i == thread) {
+      lock(&s->mutex);
+      pn_histogram_add(histogram, s->distributions[distribution]);
+      unlock(&s->mutex);
+    }
+  }
+  unlock(&p->stats_mutex);
+  return (thread < 0 || i > thread) ? 0 : PN_ARG_ERR;
+}
+
+void pn_proactor_clear_stats(pn_proactor_t *p) {
+  lock(&p->stats_mutex);
+  for (pstats_t *s = p->stats; s; s = s->next) {
+    lock(&s->mutex);
+    memset(&s->counters, 0, sizeof(s->counters));
+    for (int i = 0; i < PSTATS_DISTRIBUTIONS; ++i)
+      pn_histogram_clear(s->distributions[i]);
+    unlock(&s->mutex);
+  }
+  unlock(&p->stats_mutex);
+}
+
 pn_millis_t pn_proactor_now(void) {
   struct timespec t;
   clock_gettime(CLOCK_MONOTONIC, &t);
@@ -47,6 +47,12 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 /*
   libuv functions are thread unsafe, we use a"leader-worker-follower" model as follows:
 
@@ -63,6 +69,16 @@
   roles as required at run-time. Monitored sockets (connections or listeners) are passed
   between threads on thread-safe queues.
 
+  The proactor can have several UV loops, see pn_proactor_set_loops(). Each connection or
+  listener belongs to one loop for its lifetime, and each loop has its own leader so IO
+  for different loops is handled in parallel. New connections go to the least loaded loop.
+  Connections accepted by a listener on another loop are handed over as a duplicated socket.
+  Proactor timeouts and interrupts are handled by the first loop.
+
+  With fewer threads than loops, a leader that blocks in uv_run() also watches the backend
+  fd and next timer of each loop without a leader. When one of them is ready the leader
+  gives up its own loop and takes the next turn, so every loop is served without polling.
+
   Function naming:
   - on_*() - libuv callbacks, called in leader thread via  uv_run().
   - leader_* - only called in leader thread from
@@ -111,11 +127,14 @@ static int unqueued;            /* Provide invalid address for _unqueued pointer
 /* All work structs and UV callback data structs start with a struct_type member  */
 typedef enum { T_CONNECTION, T_LISTENER, T_LSOCKET } struct_type;
 
+struct loop_t;
+
 /* A stream of serialized work for the proactor */
 typedef struct work_t {
   /* Immutable */
   struct_type type;
   pn_proactor_t *proactor;
+  struct loop_t *loop;               /* Loop that does IO for this work */
 
   /* Protected by proactor.lock */
   struct work_t* next;
@@ -124,8 +143,12 @@ typedef struct work_t {
 
 QUEUE_DECL(work)
 
-static void work_init(work_t* w, pn_proactor_t* p, struct_type type) {
+static struct loop_t *loop_assign(pn_proactor_t *p, struct loop_t *loop);
+
+/* Assign to loop, or to the least loaded loop if loop is NULL */
+static void work_init(work_t* w, pn_proactor_t* p, struct_type type, struct loop_t *loop) {
   w->proactor = p;
+  w->loop = loop_assign(p, loop);
   w->next = work_unqueued;
   w->type = type;
   w->working = true;
@@ -169,6 +192,13 @@ typedef struct pconnection_t {
   int connected;      /* 0: not connected, <0: connecting after error, 1 = connected ok */
 
   lsocket_t *lsocket;           /* Incoming connection only */
+  pni_socket_options_t sockopts; /* see pn_connection_set_socket_option() */
+
+  /* Incoming connection accepted by a listener on another loop, see leader_accept_handoff_lh() */
+  uv_tcp_t accept_tcp;          /* Accepted in the listener's loop */
+  int accept_fd;                /* Duplicate socket to open in this loop, -1 if none */
+  int accept_err;               /* Error accepting the socket */
+  bool handoff;                 /* Needs leader_accept_open() */
 
   struct pn_netaddr_t local, remote; /* Actual addresses */
   uv_timer_t timer;
@@ -198,6 +228,7 @@ struct pn_listener_t {
   /* Only used by owner thread */
   pn_event_batch_t batch;
   pn_record_t *attachments;
+  pni_socket_options_t sockopts; /* see pn_listener_set_socket_option() */
   void *context;
   size_t backlog;
 
@@ -222,15 +253,32 @@ struct pn_listener_t {
 
 typedef enum { TM_NONE, TM_REQUEST, TM_PENDING, TM_FIRED } timeout_state_t;
 
+/* A UV loop with its own leader */
+typedef struct loop_t {
+  pn_proactor_t *proactor;
+  uv_loop_t loop;
+  uv_async_t notify;
+
+  /* Only used by leader */
+  uv_poll_t **watch;     /* Backend fds of the other loops, by loop index */
+  size_t watch_len;
+  uv_timer_t watch_timer; /* Next timer of the other loops */
+  bool woken;            /* A watched loop is ready */
+
+  /* Protected by proactor.lock */
+  work_queue_t leader_q; /* waiting for attention by the leader of this loop */
+  size_t load;           /* connections and listeners assigned to this loop */
+  bool has_leader;       /* A thread is working as leader */
+  bool disconnect;       /* disconnect requested */
+} loop_t;
+
 struct pn_proactor_t {
   /* Notification */
-  uv_async_t notify;
   uv_async_t interrupt;
 
-  /* Leader thread  */
+  /* Leader threads  */
   uv_cond_t cond;
-  uv_loop_t loop;
-  uv_timer_t timer;
+  uv_timer_t timer;             /* In the first loop */
 
   /* Owner thread: proactor collector and batch can belong to leader or a worker */
   pn_collector_t *collector;
@@ -238,14 +286,16 @@ struct pn_proactor_t {
 
   /* Protected by lock */
   uv_mutex_t lock;
+  loop_t **loops;        /* Only grows, loops are never moved or freed till pn_proactor_free() */
+  size_t loops_len;
+  size_t next_leader;    /* Next loop to look at for a leader, so loops take turns */
+  size_t followers;      /* Threads waiting on cond */
   work_queue_t worker_q; /* ready for work, to be returned via pn_proactor_wait()  */
-  work_queue_t leader_q; /* waiting for attention by the leader thread */
   timeout_state_t timeout_state;
   pn_millis_t timeout;
   size_t active;         /* connection/listener count for INACTIVE events */
   pn_condition_t *disconnect_cond; /* disconnect condition */
 
-  bool has_leader;             /* A thread is working as leader */
   bool disconnect;             /* disconnect requested */
   bool batch_working;          /* batch is being processed in a worker thread */
   bool need_interrupt;         /* Need a PN_PROACTOR_INTERRUPT event */
@@ -253,9 +303,33 @@ struct pn_proactor_t {
 };
 
 
-/* Notify the leader thread that there is something to do outside of uv_run() */
-static inline void notify(pn_proactor_t* p) {
-  uv_async_send(&p->notify);
+/* Notify the leader thread of loop that there is something to do outside of uv_run() */
+static inline void notify(loop_t *loop) {
+  uv_async_send(&loop->notify);
+}
+
+/* Add work to loop, or to the loop with the fewest connections and listeners if NULL */
+static loop_t *loop_assign(pn_proactor_t *p, loop_t *loop) {
+  uv_mutex_lock(&p->lock);
+  if (!loop) {
+    loop = p->loops[0];
+    for (size_t i = 1; i < p->loops_len; ++i) {
+      if (p->loops[i]->load < loop->load) loop = p->loops[i];
+    }
+  }
+  ++loop->load;
+  uv_mutex_unlock(&p->lock);
+  return loop;
+}
+
+/* Release the loop assigned by work_init() */
+static void loop_release(work_t *w) {
+  if (w->loop) {
+    uv_mutex_lock(&w->proactor->lock);
+    --w->loop->load;
+    uv_mutex_unlock(&w->proactor->lock);
+    w->loop = NULL;
+  }
 }
 
 /* Set the interrupt flag in the leader thread to avoid race conditions. */
@@ -273,8 +347,8 @@ static void work_notify(work_t *w) {
      It will be processed in pn_proactor_done() or when the queue it is on is processed.
   */
   if (!w->working && w->next == work_unqueued) {
-    work_push(&w->proactor->leader_q, w);
-    notify(w->proactor);
+    work_push(&w->loop->leader_q, w);
+    notify(w->loop);
   }
   uv_mutex_unlock(&w->proactor->lock);
 }
@@ -284,10 +358,10 @@ static void work_start(work_t *w) {
   uv_mutex_lock(&w->proactor->lock);
   if (w->next == work_unqueued) {  /* No-op if already queued */
     w->working = false;
-    work_push(&w->proactor->leader_q, w);
-    notify(w->proactor);
-    uv_mutex_unlock(&w->proactor->lock);
+    work_push(&w->loop->leader_q, w);
+    notify(w->loop);
   }
+  uv_mutex_unlock(&w->proactor->lock);
 }
 
 static void parse_addr(addr_t *addr, const char *str) {
@@ -324,13 +398,14 @@ static void set_pconnection(pn_connection_t* c, pconnection_t *pc) {
   uv_mutex_unlock(&driver_ptr_mutex);
 }
 
-static pconnection_t *pconnection(pn_proactor_t *p, pn_connection_t *c, pn_transport_t *t, bool server) {
+static pconnection_t *pconnection(pn_proactor_t *p, pn_connection_t *c, pn_transport_t *t, bool server, loop_t *loop) {
   pconnection_t *pc = (pconnection_t*)calloc(1, sizeof(*pc));
   if (!pc || pn_connection_driver_init(&pc->driver, c, t) != 0) {
     return NULL;
   }
-  work_init(&pc->work, p,  T_CONNECTION);
+  work_init(&pc->work, p,  T_CONNECTION, loop);
   pc->next = pconnection_unqueued;
+  pc->accept_fd = -1;
   pc->write.data = &pc->work;
   uv_mutex_init(&pc->lock);
   if (server) {
@@ -347,6 +422,10 @@ static void pconnection_free(pconnection_t *pc) {
   if (pc->addr.getaddrinfo.addrinfo) {
     uv_freeaddrinfo(pc->addr.getaddrinfo.addrinfo); /* Interrupted after resolve */
   }
+#ifndef _WIN32
+  if (pc->accept_fd >= 0) close(pc->accept_fd); /* Interrupted during hand-off */
+#endif
+  loop_release(&pc->work);
   uv_mutex_destroy(&pc->lock);
   free(pc);
 }
@@ -486,11 +565,11 @@ static void listener_error(pn_listener_t *l, int err, const char* what) {
 
 static int pconnection_init(pconnection_t *pc) {
   int err = 0;
-  err = uv_tcp_init(&pc->work.proactor->loop, &pc->tcp);
+  err = uv_tcp_init(&pc->work.loop->loop, &pc->tcp);
   if (!err) {
     pc->tcp.data = pc;
     pc->connect.data = pc;
-    err = uv_timer_init(&pc->work.proactor->loop, &pc->timer);
+    err = uv_timer_init(&pc->work.loop->loop, &pc->timer);
     if (!err) {
       pc->timer.data = pc;
     } else {
@@ -510,7 +589,7 @@ static void try_connect(pconnection_t *pc);
 static void on_connect_fail(uv_handle_t *handle) {
   pconnection_t *pc = (pconnection_t*)handle->data;
   /* Create a new TCP socket, the current one is closed */
-  int err = uv_tcp_init(&pc->work.proactor->loop, &pc->tcp);
+  int err = uv_tcp_init(&pc->work.loop->loop, &pc->tcp);
   if (err) {
     pc->connected = err;
     pc->addr.addrinfo = NULL; /* No point in trying anymore, we can't create a socket */
@@ -527,7 +606,38 @@ static void pconnection_addresses(pconnection_t *pc) {
   uv_tcp_getpeername(&pc->tcp, (struct sockaddr*)&pc->remote.ss, &len);
 }
 
+/* Apply the socket options that were set once the handle has a socket.
+   Unlike the epoll proactor there are no defaults, other options are left alone. */
+static void tcp_configure(uv_tcp_t *tcp, const pni_socket_options_t *opts) {
+#ifndef _WIN32
+  uv_os_fd_t fd;
+  if (opts->set && !uv_fileno((uv_handle_t*)tcp, &fd)) pni_set_socket_options(fd, opts);
+#else
+  (void)tcp; (void)opts;        /* Not supported */
+#endif
+}
+
+/* Give pc->tcp a socket for ai with the options applied before it connects, as
+   buffer sizes only affect the TCP window if set before the handshake. If there
+   are no options uv_tcp_connect() creates the socket. */
+static int tcp_open_configured(pconnection_t *pc, const struct addrinfo *ai) {
+#ifndef _WIN32
+  if (!pc->sockopts.set) return 0;
+  int fd = socket(ai->ai_family, SOCK_STREAM, 0);
+  if (fd < 0) return uv_translate_sys_error(errno);
+  (void)fcntl(fd, F_SETFD, FD_CLOEXEC);
+  pni_set_socket_options(fd, &pc->sockopts);
+  int err = uv_tcp_open(&pc->tcp, fd);
+  if (err) close(fd);
+  return err;
+#else
+  (void)pc; (void)ai;           /* Not supported */
+  return 0;
+#endif
+}
+
 /* Outgoing connection */
+
 static void on_connect(uv_connect_t *connect, int err) {
   pconnection_t *pc = (pconnection_t*)connect->data;
   if (!err) {
@@ -565,7 +675,7 @@ static void on_connection(uv_stream_t* server, int err) {
 }
 
 /* Common address resolution for leader_listen and leader_connect */
-static int leader_resolve(pn_proactor_t *p, addr_t *addr, bool listen) {
+static int leader_resolve(loop_t *loop, addr_t *addr, bool listen) {
   struct addrinfo hints = { 0 };
   hints.ai_family = AF_UNSPEC;
   hints.ai_socktype = SOCK_STREAM;
@@ -573,7 +683,7 @@ static int leader_resolve(pn_proactor_t *p, addr_t *addr, bool listen) {
   if (listen) {
     hints.ai_flags |= AI_PASSIVE | AI_ALL;
   }
-  int err = uv_getaddrinfo(&p->loop, &addr->getaddrinfo, NULL, addr->host, addr->port, &hints);
+  int err = uv_getaddrinfo(&loop->loop, &addr->getaddrinfo, NULL, addr->host, addr->port, &hints);
   addr->addrinfo = addr->getaddrinfo.addrinfo; /* Start with the first addrinfo */
   return err;
 }
@@ -589,7 +699,8 @@ static void try_connect(pconnection_t *pc) {
     work_notify(&pc->work);
   } else {
     pc->addr.addrinfo = ai->ai_next; /* Advance for next attempt */
-    int err = uv_tcp_connect(&pc->connect, &pc->tcp, ai->ai_addr, on_connect);
+    int err = tcp_open_configured(pc, ai);
+    if (!err) err = uv_tcp_connect(&pc->connect, &pc->tcp, ai->ai_addr, on_connect);
     if (err) {
       pconnection_bad_connect(pc, err);
       uv_close((uv_handle_t*)&pc->tcp, on_connect_fail); /* Queue up next attempt */
@@ -599,7 +710,7 @@ static void try_connect(pconnection_t *pc) {
 
 static bool leader_connect(pconnection_t *pc) {
   int err = pconnection_init(pc);
-  if (!err) err = leader_resolve(pc->work.proactor, &pc->addr, false);
+  if (!err) err = leader_resolve(pc->work.loop, &pc->addr, false);
   if (err) {
     pconnection_error(pc, err, "on connect resolving");
     return true;
@@ -615,13 +726,14 @@ static int lsocket(pn_listener_t *l, struct addrinfo *ai) {
   ls->tcp.data = ls;
   ls->parent = NULL;
   ls->next = NULL;
-  int err = uv_tcp_init(&l->work.proactor->loop, &ls->tcp);
+  int err = uv_tcp_init(&l->work.loop->loop, &ls->tcp);
   if (err) {
     free(ls);                   /* Will never be closed */
   } else {
     if (l->dynamic_port) set_port(ai->ai_addr, l->dynamic_port);
     int flags = (ai->ai_family == AF_INET6) ? UV_TCP_IPV6ONLY : 0;
     err = uv_tcp_bind(&ls->tcp, ai->ai_addr, flags);
+    if (!err) tcp_configure(&ls->tcp, &l->sockopts);
     if (!err) err = uv_listen((uv_stream_t*)&ls->tcp, l->backlog, on_connection);
     if (!err) {
       /* Get actual listening address */
@@ -649,7 +761,7 @@ static int lsocket(pn_listener_t *l, struct addrinfo *ai) {
 /* Listen on all available addresses */
 static void leader_listen_lh(pn_listener_t *l) {
   add_active(l->work.proactor);
-  int err = leader_resolve(l->work.proactor, &l->addr, true);
+  int err = leader_resolve(l->work.loop, &l->addr, true);
   if (!err) {
     /* Allocate enough space for the pn_netaddr_t addresses */
     size_t len = 0;
@@ -693,11 +805,69 @@ void pn_listener_free(pn_listener_t *l) {
       free(ls);
     }
     assert(!l->accept.front);
+    loop_release(&l->work);
     uv_mutex_destroy(&l->lock);
     free(l);
   }
 }
 
+#ifndef _WIN32
+
+static void on_accept_handoff(uv_handle_t *h) {
+  pconnection_t *pc = (pconnection_t*)h->data;
+  work_start(&pc->work);        /* Continue in the connection's loop */
+}
+
+/* Accept a connection that belongs to another loop. A UV handle can't move between loops
+   so accept in the listener's loop, duplicate the socket and close the handle.
+   The connection's leader opens the duplicate with leader_accept_open().
+*/
+static void leader_accept_handoff_lh(pn_listener_t *l, pconnection_t *pc) {
+  pc->handoff = true;
+  int err = uv_tcp_init(&l->work.loop->loop, &pc->accept_tcp);
+  if (err) {
+    pc->accept_err = err;
+    work_start(&pc->work);
+    return;
+  }
+  pc->accept_tcp.data = pc;
+  err = uv_accept((uv_stream_t*)&pc->lsocket->tcp, (uv_stream_t*)&pc->accept_tcp);
+  uv_os_fd_t fd;
+  if (!err) err = uv_fileno((uv_handle_t*)&pc->accept_tcp, &fd);
+  if (!err) {
+    pc->accept_fd = dup(fd);
+    if (pc->accept_fd < 0) err = uv_translate_sys_error(errno);
+  }
+  if (err) {
+    listener_error_lh(l, err, "accepting from");
+    pc->accept_err = err;
+  }
+  uv_close((uv_handle_t*)&pc->accept_tcp, on_accept_handoff);
+}
+
+/* Open a socket accepted by leader_accept_handoff_lh() in the connection's own loop */
+static void leader_accept_open(pconnection_t *pc) {
+  pc->handoff = false;
+  int err = pconnection_init(pc);
+  if (!err) {                   /* Otherwise pconnection_init() reports the error */
+    err = pc->accept_err;
+    if (!err) err = uv_tcp_open(&pc->tcp, pc->accept_fd);
+    if (!err) {
+      pc->accept_fd = -1;       /* Owned by pc->tcp */
+      tcp_configure(&pc->tcp, &pc->sockopts);
+      pconnection_addresses(pc);
+    } else {
+      pconnection_error(pc, err, "accepting from");
+    }
+  }
+  if (pc->accept_fd >= 0) {
+    close(pc->accept_fd);
+    pc->accept_fd = -1;
+  }
+}
+
+#endif
+
 /* Process a listener, return true if it has events for a worker thread */
 static bool leader_process_listener(pn_listener_t *l) {
   /* NOTE: l may be concurrently accessed by on_connection() */
@@ -706,12 +876,19 @@ static bool leader_process_listener(pn_listener_t *l) {
 
   /* Process accepted connections */
   for (pconnection_t *pc = pconnection_pop(&l->accept); pc; pc = pconnection_pop(&l->accept)) {
+#ifndef _WIN32
+    if (pc->work.loop != l->work.loop) {
+      leader_accept_handoff_lh(l, pc);
+      continue;
+    }
+#endif
     int err = pconnection_init(pc);
     if (!err) err = uv_accept((uv_stream_t*)&pc->lsocket->tcp, (uv_stream_t*)&pc->tcp);
     if (!err) {
+      tcp_configure(&pc->tcp, &pc->sockopts);
       pconnection_addresses(pc);
     } else {
-      listener_error(l, err, "accepting from");
+      listener_error_lh(l, err, "accepting from");
       pconnection_error(pc, err, "accepting from");
     }
     work_start(&pc->work);      /* Process events for the accepted/failed connection */
@@ -801,7 +978,7 @@ static void on_timeout(uv_timer_t *timer) {
   if (p->timeout_state == TM_PENDING) { /* Only fire if still pending */
     p->timeout_state = TM_FIRED;
   }
-  uv_stop(&p->loop);            /* UV does not always stop after on_timeout without this */
+  uv_stop(timer->loop);         /* UV does not always stop after on_timeout without this */
   uv_mutex_unlock(&p->lock);
 }
 
@@ -885,6 +1062,11 @@ static void check_wake(pconnection_t *pc) {
 /* Process a pconnection, return true if it has events for a worker thread */
 static bool leader_process_pconnection(pconnection_t *pc) {
   /* Important to do the following steps in order */
+#ifndef _WIN32
+  if (pc->handoff) {
+    leader_accept_open(pc);
+  }
+#endif
   if (!pc->connected) {
     return leader_connect(pc);
   }
@@ -930,6 +1112,7 @@ static bool leader_process_pconnection(pconnection_t *pc) {
       if (!err && rbuf.size > 0) {
         what = "read";
         err = uv_read_start((uv_stream_t*)&pc->tcp, alloc_read_buffer, on_read);
+        if (err == UV_EALREADY) err = 0; /* Still reading, libuv >= 1.38 reports this as an error */
       }
       if (err) {
         /* Some IO requests failed, generate the error events */
@@ -949,7 +1132,7 @@ void pconnection_detach(pconnection_t *pc) {
 }
 
 static void on_proactor_disconnect(uv_handle_t* h, void* v) {
-  if (h->type == UV_TCP) {
+  if (h->type == UV_TCP && !uv_is_closing(h)) {
     switch (*(struct_type*)h->data) {
      case T_CONNECTION: {
        pconnection_t *pc = (pconnection_t*)h->data;
@@ -978,27 +1161,94 @@ static void on_proactor_disconnect(uv_handle_t* h, void* v) {
   }
 }
 
-/* Process the leader_q and the UV loop, in the leader thread */
-static pn_event_batch_t *leader_lead_lh(pn_proactor_t *p, uv_run_mode mode) {
+#ifndef _WIN32
+
+static void on_watch(uv_poll_t *watch, int status, int events) {
+  (void)status; (void)events;
+  ((loop_t*)watch->data)->woken = true;
+  uv_poll_stop(watch);          /* Until the next leader_watch_lh() */
+}
+
+static void on_watch_timeout(uv_timer_t *timer) {
+  ((loop_t*)timer->data)->woken = true;
+}
+
+/* Before blocking in loop, watch the loops with no leader for IO and timers */
+static void leader_watch_lh(loop_t *loop) {
+  pn_proactor_t *p = loop->proactor;
+  if (loop->watch_len < p->loops_len) {
+    uv_poll_t **grow = (uv_poll_t**)realloc(loop->watch, p->loops_len * sizeof(uv_poll_t*));
+    if (!grow) return;
+    loop->watch = grow;
+    for (size_t i = loop->watch_len; i < p->loops_len; ++i) {
+      uv_poll_t *w = NULL;
+      if (p->loops[i] != loop && (w = (uv_poll_t*)malloc(sizeof(uv_poll_t)))) {
+        if (uv_poll_init(&loop->loop, w, uv_backend_fd(&p->loops[i]->loop)) == 0) {
+          w->data = loop;
+        } else {
+          free(w);
+          w = NULL;
+        }
+      }
+      loop->watch[i] = w;
+    }
+    loop->watch_len = p->loops_len;
+  }
+  uv_update_time(&loop->loop);
+  int64_t timeout = -1;
+  for (size_t i = 0; i < loop->watch_len; ++i) {
+    loop_t *other = p->loops[i];
+    if (!loop->watch[i] || other->has_leader) continue;
+    uv_poll_start(loop->watch[i], UV_READABLE, on_watch);
+    /* Timers are due relative to the other loop's idea of now */
+    int t = uv_backend_timeout(&other->loop);
+    if (t >= 0) {
+      int64_t due = t - (int64_t)(uv_now(&loop->loop) - uv_now(&other->loop));
+      if (due < 0) due = 0;
+      if (timeout < 0 || due < timeout) timeout = due;
+    }
+  }
+  if (timeout >= 0) uv_timer_start(&loop->watch_timer, on_watch_timeout, timeout, 0);
+}
+
+static void leader_unwatch(loop_t *loop) {
+  for (size_t i = 0; i < loop->watch_len; ++i) {
+    if (loop->watch[i]) uv_poll_stop(loop->watch[i]);
+  }
+  uv_timer_stop(&loop->watch_timer);
+}
+
+#else  /* Windows has no backend fd to watch, pn_proactor_set_loops() is ignored */
+
+static void leader_watch_lh(loop_t *loop) { (void)loop; }
+static void leader_unwatch(loop_t *loop) { (void)loop; }
+
+#endif
+
+/* Process the leader_q and the UV loop, in the leader thread of loop */
+static pn_event_batch_t *leader_lead_lh(loop_t *loop, uv_run_mode mode) {
+  pn_proactor_t *p = loop->proactor;
+  bool first = (loop == p->loops[0]);
   /* Set timeout timer if there was a request, let it count down while we process work */
-  if (p->timeout_state == TM_REQUEST) {
+  if (first && p->timeout_state == TM_REQUEST) {
     p->timeout_state = TM_PENDING;
     uv_timer_stop(&p->timer);
     uv_timer_start(&p->timer, on_timeout, p->timeout, 0);
   }
   /* If disconnect was requested, walk the socket list */
-  if (p->disconnect) {
-    p->disconnect = false;
+  if (loop->disconnect) {
+    loop->disconnect = false;
+    if (first) p->disconnect = false;
     if (p->active) {
       uv_mutex_unlock(&p->lock);
-      uv_walk(&p->loop, on_proactor_disconnect, NULL);
+      uv_walk(&loop->loop, on_proactor_disconnect, NULL);
       uv_mutex_lock(&p->lock);
-    } else {
+    } else if (first) {
       p->need_inactive = true;  /* Send INACTIVE right away, nothing to do. */
     }
   }
   pn_event_batch_t *batch = NULL;
-  for (work_t *w = work_pop(&p->leader_q); w; w = work_pop(&p->leader_q)) {
+  for (work_t *w = work_pop(&loop->leader_q); w; w = work_pop(&loop->leader_q)) {
     assert(!w->working);
 
     uv_mutex_unlock(&p->lock);  /* Unlock to process each item, may add more items to leader_q */
@@ -1025,25 +1275,67 @@ static pn_event_batch_t *leader_lead_lh(pn_proactor_t *p, uv_run_mode mode) {
   }
   batch = get_batch_lh(p);      /* Check for work */
   if (!batch) {                 /* No work, run the UV loop */
+    loop->woken = false;
+    if (mode == UV_RUN_ONCE) leader_watch_lh(loop);
     uv_mutex_unlock(&p->lock);  /* Unlock to run UV loop */
-    uv_run(&p->loop, mode);
+    uv_run(&loop->loop, mode);
+    leader_unwatch(loop);
     uv_mutex_lock(&p->lock);
     batch = get_batch_lh(p);
+  } else if (p->loops_len > 1) {
+    /* The loop may be left with no leader, register any IO started above in its
+       backend fd so it can be watched from other loops */
+    uv_mutex_unlock(&p->lock);
+    uv_run(&loop->loop, UV_RUN_NOWAIT);
+    uv_mutex_lock(&p->lock);
   }
   return batch;
 }
 
+/* Find a loop with no leader. The next call starts after the loop found so loops take
+   turns and none is starved.
+*/
+static loop_t *leaderless_loop_lh(pn_proactor_t *p) {
+  for (size_t i = 0; i < p->loops_len; ++i) {
+    size_t n = (p->next_leader + i) % p->loops_len;
+    if (!p->loops[n]->has_leader) {
+      p->next_leader = (n + 1) % p->loops_len;
+      return p->loops[n];
+    }
+  }
+  return NULL;
+}
+
 /**** public API ****/
 
+/* Give up leading loop. If there is no follower to take over, wake another leader that
+   may be blocked in its own loop so it can take turns with this one.
+*/
+static void leader_release_lh(loop_t *loop) {
+  pn_proactor_t *p = loop->proactor;
+  loop->has_leader = false;
+  if (p->followers) {
+    uv_cond_broadcast(&p->cond); /* Signal followers. One takes over, many can work. */
+  } else {
+    for (size_t i = 0; i < p->loops_len; ++i) {
+      if (p->loops[i]->has_leader) {
+        notify(p->loops[i]);
+        break;
+      }
+    }
+  }
+}
+
 pn_event_batch_t *pn_proactor_get(struct pn_proactor_t* p) {
   uv_mutex_lock(&p->lock);
   pn_event_batch_t *batch = get_batch_lh(p);
-  if (batch == NULL && !p->has_leader) {
-    /* Try a non-blocking lead to generate some work */
-    p->has_leader = true;
-    batch = leader_lead_lh(p, UV_RUN_NOWAIT);
-    p->has_leader = false;
-    uv_cond_broadcast(&p->cond);   /* Signal followers for possible work */
+  /* Try a non-blocking lead of each loop without a leader to generate some work */
+  for (size_t i = 0; batch == NULL && i < p->loops_len; ++i) {
+    loop_t *loop = leaderless_loop_lh(p);
+    if (!loop) break;
+    loop->has_leader = true;
+    batch = leader_lead_lh(loop, UV_RUN_NOWAIT);
+    leader_release_lh(loop);
   }
   uv_mutex_unlock(&p->lock);
   return batch;
@@ -1052,17 +1344,20 @@ pn_event_batch_t *pn_proactor_get(struct pn_proactor_t* p) {
 pn_event_batch_t *pn_proactor_wait(struct pn_proactor_t* p) {
   uv_mutex_lock(&p->lock);
   pn_event_batch_t *batch = get_batch_lh(p);
-  while (!batch && p->has_leader) {
-    uv_cond_wait(&p->cond, &p->lock); /* Follow the leader */
-    batch = get_batch_lh(p);
-  }
-  if (!batch) {                 /* Become leader */
-    p->has_leader = true;
-    do {
-      batch = leader_lead_lh(p, UV_RUN_ONCE);
-    } while (!batch);
-    p->has_leader = false;
-    uv_cond_broadcast(&p->cond); /* Signal a followers. One takes over, many can work. */
+  while (!batch) {
+    loop_t *loop = leaderless_loop_lh(p);
+    if (!loop) {
+      ++p->followers;
+      uv_cond_wait(&p->cond, &p->lock); /* Follow the leaders */
+      --p->followers;
+    } else {                    /* Become leader */
+      loop->has_leader = true;
+      do {
+        batch = leader_lead_lh(loop, UV_RUN_ONCE);
+      } while (!batch && !loop->woken); /* Take turns if a loop with no leader is ready */
+      leader_release_lh(loop);
+    }
+    if (!batch) batch = get_batch_lh(p);
   }
   uv_mutex_unlock(&p->lock);
   return batch;
@@ -1072,18 +1367,20 @@ void pn_proactor_done(pn_proactor_t *p, pn_event_batch_t *batch) {
   if (!batch) return;
   uv_mutex_lock(&p->lock);
   work_t *w = batch_work(batch);
+  /* Once w is back on the queue the leader may free it, take its loop now */
+  loop_t *loop = w ? w->loop : p->loops[0];
   if (w) {
     assert(w->working);
     assert(w->next == work_unqueued);
     w->working = false;
-    work_push(&p->leader_q, w);
+    work_push(&w->loop->leader_q, w);
   }
   pn_proactor_t *bp = batch_proactor(batch); /* Proactor events */
   if (bp == p) {
     p->batch_working = false;
   }
   uv_mutex_unlock(&p->lock);
-  notify(p);
+  notify(loop);
 }
 
 pn_listener_t *pn_event_listener(pn_event_t *e) {
@@ -1129,7 +1426,10 @@ void pn_proactor_disconnect(pn_proactor_t *p, pn_condition_t *cond) {
     } else {
       pn_condition_clear(p->disconnect_cond);
     }
-    notify(p);
+    for (size_t i = 0; i < p->loops_len; ++i) {
+      p->loops[i]->disconnect = true;
+      notify(p->loops[i]);
+    }
   }
   uv_mutex_unlock(&p->lock);
 }
@@ -1141,7 +1441,7 @@ void pn_proactor_set_timeout(pn_proactor_t *p, pn_millis_t t) {
   if (p->timeout_state == TM_NONE) ++p->active;
   p->timeout_state = TM_REQUEST;
   uv_mutex_unlock(&p->lock);
-  notify(p);
+  notify(p->loops[0]);
 }
 
 void pn_proactor_cancel_timeout(pn_proactor_t *p) {
@@ -1149,23 +1449,25 @@ void pn_proactor_cancel_timeout(pn_proactor_t *p) {
   if (p->timeout_state != TM_NONE) {
     p->timeout_state = TM_NONE;
     remove_active_lh(p);
-    notify(p);
+    notify(p->loops[0]);
   }
   uv_mutex_unlock(&p->lock);
 }
 
 void pn_proactor_connect2(pn_proactor_t *p, pn_connection_t *c, pn_transport_t *t, const char *addr) {
-  pconnection_t *pc = pconnection(p, c, t, false);
+  pconnection_t *pc = pconnection(p, c, t, false, NULL);
   assert(pc);                                  /* TODO aconway 2017-03-31: memory safety */
   pn_connection_open(pc->driver.connection);   /* Auto-open */
+  pni_connection_socket_options(pc->driver.connection, &pc->sockopts);
   parse_addr(&pc->addr, addr);
   work_start(&pc->work);
 }
 
 void pn_proactor_listen(pn_proactor_t *p, pn_listener_t *l, const char *addr, int backlog) {
-  work_init(&l->work, p, T_LISTENER);
+  work_init(&l->work, p, T_LISTENER, NULL);
   parse_addr(&l->addr, addr);
   l->backlog = backlog;
+  pni_listener_socket_options(l, &l->sockopts);
   work_start(&l->work);
 }
 
@@ -1181,7 +1483,7 @@ static void on_proactor_free(uv_handle_t* h, void* v) {
      default: break;
     }
     if (w && w->next == work_unqueued) {
-      work_push(&w->proactor->leader_q, w); /* Save to be freed after all closed */
+      work_push(&w->loop->leader_q, w); /* Save to be freed after all closed */
     }
   }
 }
@@ -1194,41 +1496,128 @@ static void work_free(work_t *w) {
   }
 }
 
+static loop_t *loop(pn_proactor_t *p) {
+  loop_t *loop = (loop_t*)calloc(1, sizeof(loop_t));
+  if (loop) {
+    loop->proactor = p;
+    uv_loop_init(&loop->loop);
+    uv_async_init(&loop->loop, &loop->notify, NULL);
+    uv_timer_init(&loop->loop, &loop->watch_timer);
+    loop->watch_timer.data = loop;
+  }
+  return loop;
+}
+
 pn_proactor_t *pn_proactor() {
   uv_once(&global_init_once, global_init_fn);
   pn_proactor_t *p = (pn_proactor_t*)calloc(1, sizeof(pn_proactor_t));
   p->collector = pn_collector();
-  if (!p->collector) {
+  p->loops = (loop_t**)calloc(1, sizeof(loop_t*));
+  if (p->loops) p->loops[0] = loop(p);
+  if (!p->collector || !p->loops || !p->loops[0]) {
+    if (p->collector) pn_collector_free(p->collector);
+    free(p->loops);
     free(p);
     return NULL;
   }
+  p->loops_len = 1;
   p->batch.next_event = &proactor_batch_next;
-  uv_loop_init(&p->loop);
   uv_mutex_init(&p->lock);
   uv_cond_init(&p->cond);
-  uv_async_init(&p->loop, &p->notify, NULL);
-  uv_async_init(&p->loop, &p->interrupt, on_interrupt);
+  uv_loop_t *first = &p->loops[0]->loop;
+  uv_async_init(first, &p->interrupt, on_interrupt);
   p->interrupt.data = p;
-  uv_timer_init(&p->loop, &p->timer);
+  uv_timer_init(first, &p->timer);
   p->timer.data = p;
   p->disconnect_cond = pn_condition();
   return p;
 }
 
+void pn_proactor_set_loops(pn_proactor_t *p, size_t loops) {
+#ifndef _WIN32
+  uv_mutex_lock(&p->lock);
+  bool unused = true;           /* Work is never moved, so only add loops before there is any */
+  for (size_t i = 0; i < p->loops_len; ++i) {
+    if (p->loops[i]->load) unused = false;
+  }
+  if (unused && loops > p->loops_len) {
+    loop_t **grow = (loop_t**)realloc(p->loops, loops * sizeof(loop_t*));
+    if (grow) {
+      p->loops = grow;
+      while (p->loops_len < loops && (p->loops[p->loops_len] = loop(p))) {
+        ++p->loops_len;
+      }
+    }
+  }
+  uv_mutex_unlock(&p->lock);
+#else
+  (void)p; (void)loops;         /* Loops can't watch each other, see leader_watch_lh() */
+#endif
+}
+
+/* Statistics are only kept by the epoll proactor */
+void pn_proactor_set_stats_enabled(pn_proactor_t *p, bool enabled) {
+  (void)p; (void)enabled;
+}
+
+bool pn_proactor_get_stats_enabled(pn_proactor_t *p) {
+  (void)p;
+  return false;
+}
+
+int pn_proactor_stats_threads(pn_proactor_t *p) {
+  (void)p;
+  return 0;
+}
+
+int pn_proactor_stats(pn_proactor_t *p, int thread, pn_proactor_stats_t *stats) {
+  (void)p;
+  memset(stats, 0, sizeof(*stats));
+  return thread == -1 ? 0 : PN_ARG_ERR;
+}
+
+int pn_proactor_stats_distribution(pn_proactor_t *p, int thread, pn_proactor_distribution_t distribution,
+                                   pn_histogram_t *histogram) {
+  (void)p; (void)distribution;
+  pn_histogram_clear(histogram);
+  return thread == -1 ? 0 : PN_ARG_ERR;
+}
+
+void pn_proactor_clear_stats(pn_proactor_t *p) {
+  (void)p;
+}
+
 void pn_proactor_free(pn_proactor_t *p) {
-  /* Close all open handles */
-  uv_walk(&p->loop, on_proactor_free, NULL);
-  while (uv_loop_alive(&p->loop)) {
-    uv_run(&p->loop, UV_RUN_DEFAULT); /* Finish closing the proactor handles */
+  /* Close all open handles in every loop before running any of them. Closing a
+     connection's accept_tcp in one loop can queue the connection on another. */
+  for (size_t i = 0; i < p->loops_len; ++i) {
+    uv_walk(&p->loops[i]->loop, on_proactor_free, NULL);
+  }
+  for (size_t i = 0; i < p->loops_len; ++i) {
+    while (uv_loop_alive(&p->loops[i]->loop)) {
+      uv_run(&p->loops[i]->loop, UV_RUN_DEFAULT); /* Finish closing the proactor handles */
+    }
   }
   /* Free all work items */
-  for (work_t *w = work_pop(&p->leader_q); w; w = work_pop(&p->leader_q)) {
-    work_free(w);
+  for (size_t i = 0; i < p->loops_len; ++i) {
+    work_queue_t *q = &p->loops[i]->leader_q;
+    for (work_t *w = work_pop(q); w; w = work_pop(q)) {
+      work_free(w);
+    }
   }
   for (work_t *w = work_pop(&p->worker_q); w; w = work_pop(&p->worker_q)) {
     work_free(w);
   }
-  uv_loop_close(&p->loop);
+  for (size_t i = 0; i < p->loops_len; ++i) {
+    loop_t *loop = p->loops[i];
+    uv_loop_close(&loop->loop);
+    for (size_t j = 0; j < loop->watch_len; ++j) {
+      free(loop->watch[j]);     /* Closed by on_proactor_free() */
+    }
+    free(loop->watch);
+    free(loop);
+  }
+  free(p->loops);
   uv_mutex_destroy(&p->lock);
   uv_cond_destroy(&p->cond);
   pn_collector_free(p->collector);
@@ -1293,6 +1682,18 @@ pn_proactor_t *pn_listener_proactor(pn_listener_t* l) {
   return l ? l->work.proactor : NULL;
 }
 
+int pn_listener_set_shards(pn_listener_t *l, size_t shards) {
+  /* Not supported, always a single socket per address */
+  (void)l;
+  return shards > 1 ? PN_ERR : 0;
+}
+
+bool pni_proactor_set_resolver(pn_proactor_t *p, pni_resolver_t *resolver) {
+  /* Not supported, libuv resolves names with uv_getaddrinfo() */
+  (void)p; (void)resolver;
+  return false;
+}
+
 pn_condition_t* pn_listener_condition(pn_listener_t* l) {
   return l->condition;
 }
@@ -1311,7 +1712,12 @@ pn_record_t *pn_listener_attachments(pn_listener_t *l) {
 
 void pn_listener_accept2(pn_listener_t *l, pn_connection_t *c, pn_transport_t *t) {
   uv_mutex_lock(&l->lock);
-  pconnection_t *pc = pconnection(l->work.proactor, c, t, true);
+#ifdef _WIN32
+  loop_t *loop = l->work.loop; /* Sockets can't be handed over to another loop */
+#else
+  loop_t *loop = NULL;
+#endif
+  pconnection_t *pc = pconnection(l->work.proactor, c, t, true, loop);
   assert(pc);
   /* Get the socket from the accept event that we are processing */
   pn_event_t *e = pn_collector_prev(l->collector);
@@ -1319,6 +1725,8 @@ void pn_listener_accept2(pn_listener_t *l, pn_connection_t *c, pn_transport_t *t
   assert(pn_event_listener(e) == l);
   pc->lsocket = (lsocket_t*)pn_event_context(e);
   pc->connected = 1;            /* Don't need to connect() */
+  pni_listener_socket_options(l, &pc->sockopts); /* Connection options override the listener's */
+  pni_connection_socket_options(pc->driver.connection, &pc->sockopts);
   pconnection_push(&l->accept, pc);
   uv_mutex_unlock(&l->lock);
   work_notify(&l->work);
@@ -20,16 +20,42 @@
 
 /* Common platform-independent implementation for proactor libraries */
 
+/* Enable the Linux socket options in the libc headers */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include "proactor-internal.h"
+#include <proton/connection.h>
 #include <proton/error.h>
 #include <proton/listener.h>
 #include <proton/netaddr.h>
+#include <proton/object.h>
 #include <proton/proactor.h>
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#ifdef __linux__
+/* Options missing from older libc headers */
+#ifndef TCP_QUICKACK
+#define TCP_QUICKACK 12
+#endif
+#ifndef TCP_USER_TIMEOUT
+#define TCP_USER_TIMEOUT 18
+#endif
+#ifndef TCP_NOTSENT_LOWAT
+#define TCP_NOTSENT_LOWAT 25
+#endif
+#endif
+#endif
+
 
 static const char *AMQP_PORT = "5672";
 static const char *AMQP_PORT_NAME = "amqp";
@@ -87,6 +113,98 @@ void pni_proactor_set_cond(
   }
 }
 
+/* Socket options are kept in the connection or listener attachments until used */
+
+#define CID_pni_socket_options CID_pn_object
+#define pni_socket_options_initialize NULL
+#define pni_socket_options_finalize NULL
+#define pni_socket_options_hashcode NULL
+#define pni_socket_options_compare NULL
+#define pni_socket_options_inspect NULL
+
+static const pn_class_t socket_options_class = PN_CLASS(pni_socket_options);
+
+PN_HANDLE(PNI_SOCKET_OPTIONS_KEY)
+
+static int socket_option_set(pn_record_t *r, pn_socket_option_t option, int value) {
+  if ((int)option < 0 || option >= PNI_SOCKET_OPTIONS) return PN_ARG_ERR;
+  pni_socket_options_t *opts = (pni_socket_options_t*)pn_record_get(r, PNI_SOCKET_OPTIONS_KEY);
+  if (!opts) {
+    opts = (pni_socket_options_t*)pn_class_new(&socket_options_class, sizeof(pni_socket_options_t));
+    if (!opts) return PN_OUT_OF_MEMORY;
+    pn_record_def(r, PNI_SOCKET_OPTIONS_KEY, &socket_options_class);
+    pn_record_set(r, PNI_SOCKET_OPTIONS_KEY, opts);
+    pn_decref(opts);
+  }
+  opts->value[option] = value;
+  opts->set |= 1u << option;
+  return 0;
+}
+
+static void socket_options_merge(pn_record_t *r, pni_socket_options_t *opts) {
+  pni_socket_options_t *from = (pni_socket_options_t*)pn_record_get(r, PNI_SOCKET_OPTIONS_KEY);
+  if (from) {
+    for (int i = 0; i < PNI_SOCKET_OPTIONS; ++i) {
+      if (from->set & (1u << i)) opts->value[i] = from->value[i];
+    }
+    opts->set |= from->set;
+  }
+}
+
+int pn_connection_set_socket_option(pn_connection_t *c, pn_socket_option_t option, int value) {
+  return socket_option_set(pn_connection_attachments(c), option, value);
+}
+
+int pn_listener_set_socket_option(pn_listener_t *l, pn_socket_option_t option, int value) {
+  return socket_option_set(pn_listener_attachments(l), option, value);
+}
+
+void pni_connection_socket_options(pn_connection_t *c, pni_socket_options_t *opts) {
+  socket_options_merge(pn_connection_attachments(c), opts);
+}
+
+void pni_listener_socket_options(pn_listener_t *l, pni_socket_options_t *opts) {
+  socket_options_merge(pn_listener_attachments(l), opts);
+}
+
+#ifndef _WIN32
+
+static void set_int_option(int fd, int level, int name, int value) {
+  (void)setsockopt(fd, level, name, (void*)&value, sizeof(value));
+}
+
+void pni_set_socket_option(int fd, pn_socket_option_t option, int value) {
+  switch (option) {
+   case PN_SOCKET_NODELAY: set_int_option(fd, IPPROTO_TCP, TCP_NODELAY, value); break;
+   case PN_SOCKET_SNDBUF: set_int_option(fd, SOL_SOCKET, SO_SNDBUF, value); break;
+   case PN_SOCKET_RCVBUF: set_int_option(fd, SOL_SOCKET, SO_RCVBUF, value); break;
+#ifdef __linux__
+   case PN_SOCKET_QUICKACK: set_int_option(fd, IPPROTO_TCP, TCP_QUICKACK, value); break;
+   case PN_SOCKET_NOTSENT_LOWAT: set_int_option(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, value); break;
+   case PN_SOCKET_USER_TIMEOUT: set_int_option(fd, IPPROTO_TCP, TCP_USER_TIMEOUT, value); break;
+#ifdef SO_BUSY_POLL
+   case PN_SOCKET_BUSY_POLL: set_int_option(fd, SOL_SOCKET, SO_BUSY_POLL, value); break;
+#endif
+#endif
+   default: break;            /* Not supported on this platform */
+  }
+}
+
+void pni_set_socket_options(int fd, const pni_socket_options_t *opts) {
+  for (int i = 0; i < PNI_SOCKET_OPTIONS; ++i) {
+    if (opts->set & (1u << i))
+      pni_set_socket_option(fd, (pn_socket_option_t)i, opts->value[i]);
+  }
+}
+
+void pni_configure_socket(int fd, const pni_socket_options_t *opts) {
+  if (!opts || !(opts->set & (1u << PN_SOCKET_NODELAY)))
+    pni_set_socket_option(fd, PN_SOCKET_NODELAY, true);
+  if (opts) pni_set_socket_options(fd, opts);
+}
+
+#endif
+
 // Backwards compatibility signatures.
 
 void pn_proactor_connect(pn_proactor_t *p, pn_connection_t *c, const char *addr) {
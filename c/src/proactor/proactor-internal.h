@@ -22,7 +22,9 @@
 
 #include <proton/condition.h>
 #include <proton/import_export.h>
+#include <proton/proactor.h>
 #include <proton/type_compat.h>
+#include <proton/types.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -41,6 +43,54 @@ extern "C" {
  */
 PNP_EXTERN int pni_parse_addr(const char *addr, char *buf, size_t len, const char **host, const char **port);
 
+struct addrinfo;
+
+/**
+ * Look up the addresses to connect to for host and port, like getaddrinfo().
+ * The result is released with freeaddrinfo().
+ */
+typedef int pni_resolver_t(const char *host, const char *port, struct addrinfo **res);
+
+/**
+ * Replace the name resolver used by pn_proactor_connect2() and clear any
+ * cached addresses. NULL restores the default, getaddrinfo().
+ *
+ * @return false if the proactor does not support a replacement resolver.
+ */
+PNP_EXTERN bool pni_proactor_set_resolver(pn_proactor_t *p, pni_resolver_t *resolver);
+
+#define PNI_SOCKET_OPTIONS (PN_SOCKET_USER_TIMEOUT + 1)
+
+/**
+ * Socket options set by pn_connection_set_socket_option() or
+ * pn_listener_set_socket_option().
+ */
+typedef struct pni_socket_options_t {
+  int value[PNI_SOCKET_OPTIONS];
+  unsigned int set;             /* Bit (1 << option) is set if value[option] is valid */
+} pni_socket_options_t;
+
+/**
+ * Get the socket options for a connection or listener, merged into *opts.
+ * Options already set in *opts are overridden.
+ */
+void pni_connection_socket_options(pn_connection_t *c, pni_socket_options_t *opts);
+void pni_listener_socket_options(pn_listener_t *l, pni_socket_options_t *opts);
+
+#ifndef _WIN32
+/**
+ * Apply opts to a socket. PN_SOCKET_NODELAY is set unless opts says otherwise.
+ * Errors are ignored, options are a best-effort hint.
+ */
+void pni_configure_socket(int fd, const pni_socket_options_t *opts);
+
+/** Apply only the options set in opts to a socket, ignoring errors. */
+void pni_set_socket_options(int fd, const pni_socket_options_t *opts);
+
+/** Set a single option on a socket, ignoring errors. */
+void pni_set_socket_option(int fd, pn_socket_option_t option, int value);
+#endif
+
 /**
  * Condition name for error conditions related to proton-IO.
  */
@@ -1605,7 +1605,7 @@ static int pgetaddrinfo(const char *host, const char *port, int flags, struct ad
 }
 
 const char *COND_NAME = "proactor";
-PN_HANDLE(PN_PROACTOR)
+static const pn_handle_t PN_PROACTOR = PN_PROACTORCTX;  // Well-known record handle
 
 // The number of times a connection event batch may be replenished for
 // a thread between calls to wait().
@@ -3116,6 +3116,55 @@ pn_proactor_t *pn_listener_proactor(pn_listener_t* l) {
   return l ? l->context.proactor : NULL;
 }
 
+void pn_proactor_set_loops(pn_proactor_t *p, size_t loops) {
+  /* Not needed, completions are delivered to all threads */
+  (void)p; (void)loops;
+}
+
+/* Statistics are only kept by the epoll proactor */
+void pn_proactor_set_stats_enabled(pn_proactor_t *p, bool enabled) {
+  (void)p; (void)enabled;
+}
+
+bool pn_proactor_get_stats_enabled(pn_proactor_t *p) {
+  (void)p;
+  return false;
+}
+
+int pn_proactor_stats_threads(pn_proactor_t *p) {
+  (void)p;
+  return 0;
+}
+
+int pn_proactor_stats(pn_proactor_t *p, int thread, pn_proactor_stats_t *stats) {
+  (void)p;
+  memset(stats, 0, sizeof(*stats));
+  return thread == -1 ? 0 : PN_ARG_ERR;
+}
+
+int pn_proactor_stats_distribution(pn_proactor_t *p, int thread, pn_proactor_distribution_t distribution,
+                                   pn_histogram_t *histogram) {
+  (void)p; (void)distribution;
+  pn_histogram_clear(histogram);
+  return thread == -1 ? 0 : PN_ARG_ERR;
+}
+
+void pn_proactor_clear_stats(pn_proactor_t *p) {
+  (void)p;
+}
+
+int pn_listener_set_shards(pn_listener_t *l, size_t shards) {
+  /* Not supported, always a single socket per address */
+  (void)l;
+  return shards > 1 ? PN_ERR : 0;
+}
+
+bool pni_proactor_set_resolver(pn_proactor_t *p, pni_resolver_t *resolver) {
+  /* Not supported, names are resolved by getaddrinfo() */
+  (void)p; (void)resolver;
+  return false;
+}
+
 pn_condition_t* pn_listener_condition(pn_listener_t* l) {
   return l->condition;
 }
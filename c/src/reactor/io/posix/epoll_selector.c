@@ -0,0 +1,413 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+/*
+ * A pn_selector_t using epoll.
+ *
+ * Unlike the poll() selector the cost of add, update and remove does not
+ * depend on the number of selectables, and pn_selector_next() only visits
+ * the selectables that are ready or expired.
+ *
+ * Each selectable has a slot, its selector index. Free slots are reused, so
+ * the epoll data carries a generation count as well as the slot, to ignore
+ * stale events for a selectable removed during iteration. Deadlines are
+ * kept in a binary heap.
+ */
+
+#include "core/util.h"
+#include "platform/platform.h" // pn_i_now, pn_i_error_from_errno
+#include "reactor/io.h"
+#include "reactor/selector.h"
+#include "reactor/selectable.h"
+
+#include <proton/error.h>
+
+#include <sys/epoll.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <assert.h>
+
+#define MAX_READY (1024)
+
+typedef struct {
+  pn_selectable_t *selectable;  /* NULL if the slot is free */
+  pn_socket_t fd;               /* Registered fd, PN_INVALID_SOCKET if none */
+  pn_timestamp_t deadline;
+  int heap;                     /* Position in the deadline heap, -1 if no deadline */
+  int next_free;
+  uint32_t generation;
+  uint32_t reported;            /* Value of selects when last returned by pn_selector_next */
+} pni_slot_t;
+
+struct pn_selector_t {
+  int epollfd;
+  pni_slot_t *slots;
+  size_t capacity;
+  size_t size;
+  int free_slot;
+  int *heap;                    /* Slots with deadlines, earliest first */
+  size_t heap_size;
+  int *owners;                  /* Slot registered for each fd, -1 if none */
+  size_t owners_size;
+  struct epoll_event *ready;
+  int ready_capacity;
+  int ready_count;
+  int ready_current;
+  uint64_t *expired;            /* Generation and slot of each expired selectable */
+  size_t expired_capacity;
+  size_t expired_count;
+  size_t expired_current;
+  uint32_t selects;
+  pn_timestamp_t awoken;
+  pn_error_t *error;
+};
+
+static inline uint64_t pni_slot_key(pn_selector_t *selector, int idx) {
+  return ((uint64_t) selector->slots[idx].generation << 32) | (uint32_t) idx;
+}
+
+/* Return the live slot for key, or NULL if it has been removed since */
+static inline pni_slot_t *pni_slot_lookup(pn_selector_t *selector, uint64_t key) {
+  size_t idx = (uint32_t) key;
+  if (idx >= selector->capacity) return NULL;
+  pni_slot_t *slot = &selector->slots[idx];
+  return (slot->selectable && slot->generation == (uint32_t) (key >> 32)) ? slot : NULL;
+}
+
+static inline bool pni_earlier(pn_selector_t *selector, size_t a, size_t b) {
+  return selector->slots[selector->heap[a]].deadline < selector->slots[selector->heap[b]].deadline;
+}
+
+static void pni_heap_swap(pn_selector_t *selector, size_t a, size_t b) {
+  int t = selector->heap[a];
+  selector->heap[a] = selector->heap[b];
+  selector->heap[b] = t;
+  selector->slots[selector->heap[a]].heap = a;
+  selector->slots[selector->heap[b]].heap = b;
+}
+
+static void pni_heap_fix(pn_selector_t *selector, size_t pos) {
+  while (pos > 0 && pni_earlier(selector, pos, (pos - 1) / 2)) {
+    pni_heap_swap(selector, pos, (pos - 1) / 2);
+    pos = (pos - 1) / 2;
+  }
+  for (;;) {
+    size_t least = pos, l = 2*pos + 1, r = 2*pos + 2;
+    if (l < selector->heap_size && pni_earlier(selector, l, least)) least = l;
+    if (r < selector->heap_size && pni_earlier(selector, r, least)) least = r;
+    if (least == pos) break;
+    pni_heap_swap(selector, pos, least);
+    pos = least;
+  }
+}
+
+static void pni_heap_remove(pn_selector_t *selector, int idx) {
+  size_t pos = selector->slots[idx].heap;
+  selector->slots[idx].heap = -1;
+  if (--selector->heap_size != pos) {
+    selector->heap[pos] = selector->heap[selector->heap_size];
+    selector->slots[selector->heap[pos]].heap = pos;
+    pni_heap_fix(selector, pos);
+  }
+}
+
+static void pni_set_deadline(pn_selector_t *selector, int idx, pn_timestamp_t deadline) {
+  pni_slot_t *slot = &selector->slots[idx];
+  if (slot->heap >= 0) {
+    if (deadline) {
+      slot->deadline = deadline;
+      pni_heap_fix(selector, slot->heap);
+    } else {
+      pni_heap_remove(selector, idx);
+    }
+  } else if (deadline) {
+    slot->deadline = deadline;
+    slot->heap = selector->heap_size++;
+    selector->heap[slot->heap] = idx;
+    pni_heap_fix(selector, slot->heap);
+  }
+  slot->deadline = deadline;
+}
+
+/* Collect the slots in the heap below pos that have expired */
+static void pni_collect_expired(pn_selector_t *selector, size_t pos) {
+  if (pos >= selector->heap_size) return;
+  int idx = selector->heap[pos];
+  if (selector->slots[idx].deadline > selector->awoken) return;
+  if (selector->expired_count == selector->expired_capacity) {
+    selector->expired_capacity = selector->expired_capacity ? 2*selector->expired_capacity : 16;
+    selector->expired = (uint64_t *) realloc(selector->expired, selector->expired_capacity*sizeof(uint64_t));
+  }
+  selector->expired[selector->expired_count++] = pni_slot_key(selector, idx);
+  pni_collect_expired(selector, 2*pos + 1);
+  pni_collect_expired(selector, 2*pos + 2);
+}
+
+static void pni_unregister(pn_selector_t *selector, int idx) {
+  pni_slot_t *slot = &selector->slots[idx];
+  pn_socket_t fd = slot->fd;
+  if (fd == PN_INVALID_SOCKET) return;
+  /* The fd may have been closed and reused by another selectable */
+  if ((size_t) fd < selector->owners_size && selector->owners[fd] == idx) {
+    epoll_ctl(selector->epollfd, EPOLL_CTL_DEL, fd, NULL);
+    selector->owners[fd] = -1;
+  }
+  slot->fd = PN_INVALID_SOCKET;
+}
+
+static void pni_register(pn_selector_t *selector, int idx, pn_selectable_t *selectable) {
+  pni_slot_t *slot = &selector->slots[idx];
+  pn_socket_t fd = pn_selectable_get_fd(selectable);
+  if (fd != slot->fd) pni_unregister(selector, idx);
+  if (fd == PN_INVALID_SOCKET || fd < 0) return;
+
+  if ((size_t) fd >= selector->owners_size) {
+    size_t size = selector->owners_size ? selector->owners_size : 64;
+    while (size <= (size_t) fd) size *= 2;
+    selector->owners = (int *) realloc(selector->owners, size*sizeof(int));
+    for (size_t i = selector->owners_size; i < size; i++) selector->owners[i] = -1;
+    selector->owners_size = size;
+  }
+
+  struct epoll_event ev = {0};
+  ev.data.u64 = pni_slot_key(selector, idx);
+  if (pn_selectable_is_reading(selectable)) ev.events |= EPOLLIN;
+  if (pn_selectable_is_writing(selectable)) ev.events |= EPOLLOUT;
+
+  if (slot->fd != fd) {
+    if (epoll_ctl(selector->epollfd, EPOLL_CTL_ADD, fd, &ev) == -1 && errno == EEXIST) {
+      epoll_ctl(selector->epollfd, EPOLL_CTL_MOD, fd, &ev);
+    }
+  } else {
+    /* Modify even if nothing changed: the fd may have been closed and
+       reopened with the same number, which drops it from the epoll set. */
+    if (epoll_ctl(selector->epollfd, EPOLL_CTL_MOD, fd, &ev) == -1 && errno == ENOENT) {
+      epoll_ctl(selector->epollfd, EPOLL_CTL_ADD, fd, &ev);
+    }
+  }
+  slot->fd = fd;
+  selector->owners[fd] = idx;
+}
+
+void pn_selector_initialize(void *obj)
+{
+  pn_selector_t *selector = (pn_selector_t *) obj;
+  selector->epollfd = epoll_create1(EPOLL_CLOEXEC);
+  selector->slots = NULL;
+  selector->capacity = 0;
+  selector->size = 0;
+  selector->free_slot = -1;
+  selector->heap = NULL;
+  selector->heap_size = 0;
+  selector->owners = NULL;
+  selector->owners_size = 0;
+  selector->ready = NULL;
+  selector->ready_capacity = 0;
+  selector->ready_count = 0;
+  selector->ready_current = 0;
+  selector->expired = NULL;
+  selector->expired_capacity = 0;
+  selector->expired_count = 0;
+  selector->expired_current = 0;
+  selector->selects = 0;
+  selector->awoken = 0;
+  selector->error = pn_error();
+}
+
+void pn_selector_finalize(void *obj)
+{
+  pn_selector_t *selector = (pn_selector_t *) obj;
+  if (selector->epollfd >= 0) close(selector->epollfd);
+  free(selector->slots);
+  free(selector->heap);
+  free(selector->owners);
+  free(selector->ready);
+  free(selector->expired);
+  pn_error_free(selector->error);
+}
+
+#define pn_selector_hashcode NULL
+#define pn_selector_compare NULL
+#define pn_selector_inspect NULL
+
+pn_selector_t *pni_selector(void)
+{
+  static const pn_class_t clazz = PN_CLASS(pn_selector);
+  pn_selector_t *selector = (pn_selector_t *) pn_class_new(&clazz, sizeof(pn_selector_t));
+  return selector;
+}
+
+void pn_selector_add(pn_selector_t *selector, pn_selectable_t *selectable)
+{
+  assert(selector);
+  assert(selectable);
+  assert(pni_selectable_get_index(selectable) < 0);
+
+  if (pni_selectable_get_index(selectable) < 0) {
+    if (selector->free_slot < 0) {
+      size_t capacity = selector->capacity ? 2*selector->capacity : 16;
+      selector->slots = (pni_slot_t *) realloc(selector->slots, capacity*sizeof(pni_slot_t));
+      selector->heap = (int *) realloc(selector->heap, capacity*sizeof(int));
+      for (size_t i = selector->capacity; i < capacity; i++) {
+        pni_slot_t *slot = &selector->slots[i];
+        slot->selectable = NULL;
+        slot->generation = 0;
+        slot->next_free = (i + 1 < capacity) ? (int) (i + 1) : -1;
+      }
+      selector->free_slot = selector->capacity;
+      selector->capacity = capacity;
+    }
+
+    int idx = selector->free_slot;
+    pni_slot_t *slot = &selector->slots[idx];
+    selector->free_slot = slot->next_free;
+    slot->selectable = selectable;
+    slot->fd = PN_INVALID_SOCKET;
+    slot->deadline = 0;
+    slot->heap = -1;
+    slot->reported = selector->selects;
+    selector->size++;
+    pni_selectable_set_index(selectable, idx);
+  }
+
+  pn_selector_update(selector, selectable);
+}
+
+void pn_selector_update(pn_selector_t *selector, pn_selectable_t *selectable)
+{
+  int idx = pni_selectable_get_index(selectable);
+  assert(idx >= 0);
+  pni_register(selector, idx, selectable);
+  pni_set_deadline(selector, idx, pn_selectable_get_deadline(selectable));
+}
+
+void pn_selector_remove(pn_selector_t *selector, pn_selectable_t *selectable)
+{
+  assert(selector);
+  assert(selectable);
+
+  int idx = pni_selectable_get_index(selectable);
+  assert(idx >= 0);
+  pni_unregister(selector, idx);
+  pni_set_deadline(selector, idx, 0);
+  pni_slot_t *slot = &selector->slots[idx];
+  slot->selectable = NULL;
+  slot->generation++;
+  slot->next_free = selector->free_slot;
+  selector->free_slot = idx;
+  selector->size--;
+  pni_selectable_set_index(selectable, -1);
+}
+
+size_t pn_selector_size(pn_selector_t *selector) {
+  assert(selector);
+  return selector->size;
+}
+
+int pn_selector_select(pn_selector_t *selector, int timeout)
+{
+  assert(selector);
+
+  if (timeout && selector->heap_size) {
+    pn_timestamp_t deadline = selector->slots[selector->heap[0]].deadline;
+    pn_timestamp_t now = pn_i_now();
+    int64_t delta = deadline - now;
+    if (delta < 0) {
+      timeout = 0;
+    } else if (delta < timeout) {
+      timeout = delta;
+    }
+  }
+
+  int wanted = selector->size < MAX_READY ? (int) selector->size : MAX_READY;
+  if (wanted < 1) wanted = 1;
+  if (selector->ready_capacity < wanted) {
+    selector->ready = (struct epoll_event *) realloc(selector->ready, wanted*sizeof(struct epoll_event));
+    selector->ready_capacity = wanted;
+  }
+
+  int error = 0;
+  int result = -1;
+  if (selector->epollfd < 0) {
+    errno = EBADF;
+  } else {
+    result = epoll_wait(selector->epollfd, selector->ready, selector->ready_capacity, timeout);
+  }
+  if (result == -1) {
+    error = pn_i_error_from_errno(selector->error, "epoll_wait");
+    selector->ready_count = 0;
+    selector->expired_count = 0;
+  } else {
+    selector->selects++;
+    selector->ready_count = result;
+    selector->ready_current = 0;
+    selector->awoken = pn_i_now();
+    selector->expired_count = 0;
+    selector->expired_current = 0;
+    pni_collect_expired(selector, 0);
+  }
+
+  return error;
+}
+
+pn_selectable_t *pn_selector_next(pn_selector_t *selector, int *events)
+{
+  while (selector->ready_current < selector->ready_count) {
+    struct epoll_event *ee = &selector->ready[selector->ready_current++];
+    pni_slot_t *slot = pni_slot_lookup(selector, ee->data.u64);
+    if (!slot) continue;
+    int ev = 0;
+    if (ee->events & EPOLLIN) {
+      ev |= PN_READABLE;
+    }
+    if (ee->events & (EPOLLERR | EPOLLHUP)) {
+      ev |= PN_ERROR;
+    }
+    if (ee->events & EPOLLOUT) {
+      ev |= PN_WRITABLE;
+    }
+    if (slot->deadline && selector->awoken >= slot->deadline) {
+      ev |= PN_EXPIRED;
+    }
+    slot->reported = selector->selects;
+    if (ev) {
+      *events = ev;
+      return slot->selectable;
+    }
+  }
+  while (selector->expired_current < selector->expired_count) {
+    pni_slot_t *slot = pni_slot_lookup(selector, selector->expired[selector->expired_current++]);
+    if (!slot || slot->reported == selector->selects) continue;
+    if (slot->deadline && selector->awoken >= slot->deadline) {
+      slot->reported = selector->selects;
+      *events = PN_EXPIRED;
+      return slot->selectable;
+    }
+  }
+  return NULL;
+}
+
+void pn_selector_free(pn_selector_t *selector)
+{
+  assert(selector);
+  pn_free(selector);
+}
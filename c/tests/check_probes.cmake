@@ -0,0 +1,62 @@
+#
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+#
+
+# Check that the USDT probes listed in c/src/core/probes.h are in the libraries,
+# with an argument description for each argument the probe passes.
+# Run with cmake -DREADELF=<readelf> -DLIBS=<comma separated libraries> -P check_probes.cmake
+
+# Probes and their argument counts
+set(core_probes frame_read:4 frame_write:4 delivery_create:2 delivery_settle:2 delivery_remote_settle:3
+  link_flow:2 link_remote_flow:2 event_put:3 event_get:3)
+set(proactor_probes wake:1 wake_handled:1 rearm:2)
+
+string(REPLACE "," ";" LIBS "${LIBS}")
+foreach(lib ${LIBS})
+  execute_process(COMMAND ${READELF} -n ${lib} OUTPUT_VARIABLE notes RESULT_VARIABLE result)
+  if (NOT result EQUAL 0)
+    message(FATAL_ERROR "${READELF} -n ${lib} failed")
+  endif ()
+  if (lib MATCHES "proactor")
+    set(probes ${proactor_probes})
+  else ()
+    set(probes ${core_probes})
+  endif ()
+  foreach(entry ${probes})
+    string(REPLACE ":" ";" entry ${entry})
+    list(GET entry 0 probe)
+    list(GET entry 1 count)
+    if (NOT notes MATCHES "Provider: proton[ \t\r\n]+Name: ${probe}[ \t\r\n]")
+      message(FATAL_ERROR "probe proton:${probe} is missing from ${lib}")
+    endif ()
+    # Every copy of the probe, the compiler may inline it in several places
+    string(REGEX MATCHALL "Name: ${probe}[ \t\r]*\n[^\n]*\n[ \t]*Arguments:[^\n]*" copies "${notes}")
+    if (NOT copies)
+      message(FATAL_ERROR "probe proton:${probe} in ${lib} has no argument descriptions")
+    endif ()
+    foreach(copy ${copies})
+      string(REGEX REPLACE ".*Arguments:[ \t]*" "" args "${copy}")
+      string(REGEX MATCHALL "[^ \t\r]+" args "${args}")
+      list(LENGTH args n)
+      if (NOT n EQUAL count)
+        message(FATAL_ERROR "probe proton:${probe} in ${lib} has ${n} arguments, expected ${count}")
+      endif ()
+    endforeach()
+  endforeach()
+  message(STATUS "${lib}: probes ${probes}")
+endforeach()
@@ -231,6 +231,181 @@ TEST_CASE("driver_message_stream") {
   free(buf2.start);
 }
 
+/* Send deliveries that span many buffer segments and frames, receive them in
+   pieces that don't line up with either */
+TEST_CASE("driver_message_large") {
+  send_client_handler client;
+  delivery_handler server;
+  pn_test::driver_pair d(client, server);
+  pn_transport_set_max_frame(d.server.transport, 10000);
+
+  d.run();
+  pn_link_t *rcv = server.link;
+  pn_link_t *snd = client.link;
+
+  static const size_t sizes[] = {1024, 64 * 1024 + 1, 1024 * 1024};
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); ++s) {
+    std::string sent(sizes[s], '\0');
+    for (size_t i = 0; i < sent.size(); ++i) sent[i] = (char)(i * 7 + s);
+    INFO("size " << sent.size());
+
+    pn_link_flow(rcv, 1);
+    d.run();
+    pn_delivery(snd, pn_bytes("x"));
+    /* Two sends, so the second appends to a partly filled segment */
+    size_t half = sent.size() / 2;
+    CHECK(ssize_t(half) == pn_link_send(snd, sent.data(), half));
+    CHECK(ssize_t(sent.size() - half) ==
+          pn_link_send(snd, sent.data() + half, sent.size() - half));
+    pn_link_advance(snd);
+
+    std::string received;
+    char piece[999];
+    for (int i = 0; i < 1000 && (!server.delivery || pn_delivery_partial(server.delivery) ||
+                                  pn_delivery_pending(server.delivery)); ++i) {
+      d.run();
+      REQUIRE(server.delivery);
+      ssize_t n;
+      while ((n = pn_link_recv(rcv, piece, sizeof(piece))) > 0) {
+        received.append(piece, n);
+      }
+    }
+    CHECK(sent.size() == received.size());
+    CHECK(sent == received);
+    pn_delivery_settle(server.delivery);
+    server.delivery = NULL;
+    d.run();
+  }
+}
+
+/* Send the same shared bytes on links of two connections, small enough to be
+   copied into the output and large enough to be referenced */
+TEST_CASE("driver_message_shared") {
+  send_client_handler client1, client2;
+  delivery_handler server1, server2;
+  pn_test::driver_pair d1(client1, server1);
+  pn_test::driver_pair d2(client2, server2);
+  d1.run();
+  d2.run();
+
+  static const size_t sizes[] = {100, 100 * 1024};
+  for (size_t s = 0; s < sizeof(sizes) / sizeof(*sizes); ++s) {
+    std::string sent(sizes[s], '\0');
+    for (size_t i = 0; i < sent.size(); ++i) sent[i] = (char)(i * 13 + s);
+    INFO("size " << sent.size());
+    pn_shared_bytes_t *shared = pn_shared_bytes(sent.data(), sent.size());
+    REQUIRE(shared);
+
+    pn_test::driver_pair *pairs[] = {&d1, &d2};
+    pn_link_t *senders[] = {client1.link, client2.link};
+    delivery_handler *servers[] = {&server1, &server2};
+    for (int c = 0; c < 2; ++c) {
+      pn_link_flow(servers[c]->link, 1);
+      pairs[c]->run();
+      pn_delivery(senders[c], pn_bytes("x"));
+      CHECK(ssize_t(sent.size()) == pn_link_send_shared(senders[c], shared));
+      CHECK(ssize_t(2) == pn_link_send(senders[c], "!!", 2)); /* Mixed with copied bytes */
+      pn_link_advance(senders[c]);
+    }
+    CHECK(pn_refcount(shared) == 3);
+
+    for (int c = 0; c < 2; ++c) {
+      std::string received;
+      char piece[4096];
+      for (int i = 0; i < 100 && (!servers[c]->delivery || pn_delivery_partial(servers[c]->delivery) ||
+                                   pn_delivery_pending(servers[c]->delivery)); ++i) {
+        pairs[c]->run();
+        REQUIRE(servers[c]->delivery);
+        ssize_t n;
+        while ((n = pn_link_recv(servers[c]->link, piece, sizeof(piece))) > 0) {
+          received.append(piece, n);
+        }
+      }
+      CHECK(sent + "!!" == received);
+      pn_delivery_settle(servers[c]->delivery);
+      servers[c]->delivery = NULL;
+      pairs[c]->run();
+    }
+    CHECK(pn_refcount(shared) == 1); /* Deliveries and transports let go */
+    pn_shared_bytes_decref(shared);
+  }
+}
+
+TEST_CASE("message_encode_shared") {
+  auto_free<pn_message_t, pn_message_free> m(pn_message());
+  pn_data_put_string(pn_message_body(m), pn_bytes("shared"));
+  pn_rwbytes_t buf = {0};
+  ssize_t size = pn_message_encode2(m, &buf);
+  REQUIRE(size > 0);
+  pn_shared_bytes_t *shared = pn_message_encode_shared(m);
+  REQUIRE(shared);
+  pn_bytes_t bytes = pn_shared_bytes_get(shared);
+  CHECK(size_t(size) == bytes.size);
+  CHECK(!memcmp(buf.start, bytes.start, size));
+  pn_shared_bytes_decref(shared);
+  free(buf.start);
+}
+
+namespace {
+/* open_handler that counts and settles complete incoming deliveries */
+struct count_delivery_handler : public open_handler {
+  int count;
+  count_delivery_handler() : count(0) {}
+
+  bool handle(pn_event_t *e) CATCH_OVERRIDE {
+    if (pn_event_type(e) == PN_DELIVERY) {
+      pn_delivery_t *dlv = pn_event_delivery(e);
+      if (!pn_delivery_partial(dlv)) {
+        char buf[256];
+        while (pn_link_recv(pn_delivery_link(dlv), buf, sizeof(buf)) > 0)
+          ;
+        pn_delivery_settle(dlv);
+        ++count;
+      }
+      return false;
+    }
+    return open_handler::handle(e);
+  }
+};
+} // namespace
+
+/* Transfers are held back while the output limit is reached */
+TEST_CASE("driver_output_limit") {
+  send_client_handler client;
+  count_delivery_handler server;
+  pn_test::driver_pair d(client, server);
+
+  d.run();
+  pn_link_t *snd = client.link;
+  pn_link_flow(server.link, 100);
+  d.run();
+
+  const size_t limit = 2000;
+  pn_transport_set_output_limit(d.client.transport, limit);
+  CHECK(limit == pn_transport_get_output_limit(d.client.transport));
+  char body[100] = {0};
+  for (int i = 0; i < 100; ++i) {
+    pn_delivery(snd, pn_dtag((const char *)&i, sizeof(i)));
+    CHECK(sizeof(body) == pn_link_send(snd, body, sizeof(body)));
+    pn_link_advance(snd);
+  }
+
+  /* Transfers stop once the limit is reached, not all 100 are encoded */
+  pn_bytes_t wb = pn_connection_driver_write_buffer(&d.client);
+  CHECK(wb.size >= limit);
+  CHECK(wb.size < limit + 2 * sizeof(body));
+
+  /* Output queued outside the transport counts against the limit */
+  pn_transport_set_output_queued(d.client.transport, limit);
+  d.server.read(d.client);
+  CHECK(0 == pn_connection_driver_write_buffer(&d.client).size);
+
+  /* Everything is sent once the queue drains */
+  pn_transport_set_output_queued(d.client.transport, 0);
+  d.run();
+  CHECK(100 == server.count);
+}
+
 // Test aborting a delivery
 TEST_CASE("driver_message_abort") {
   send_client_handler client;
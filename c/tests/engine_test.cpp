@@ -20,9 +20,16 @@
  */
 
 #include "./pn_test.hpp"
+#include "./thread.h"
 
 #include <proton/engine.h>
 
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
 // push data from one transport to another
 static int xfer(pn_transport_t *src, pn_transport_t *dest) {
   ssize_t out = pn_transport_pending(src);
@@ -316,3 +323,479 @@ TEST_CASE("engine_link_name_prefix)") {
   pn_transport_free(t2);
   pn_connection_free(c2);
 }
+
+static void discard_trace(pn_transport_t *, const char *) {}
+
+// Send deliveries over a new connection pair and collect the frames the
+// sender produces for them
+static std::string transfer_frames(bool traced) {
+  pn_connection_t *c1 = pn_connection();
+  pn_transport_t *t1 = pn_transport();
+  pn_transport_bind(t1, c1);
+  pn_connection_t *c2 = pn_connection();
+  pn_transport_t *t2 = pn_transport();
+  pn_transport_set_server(t2);
+  pn_transport_bind(t2, c2);
+  if (traced) {
+    // frame tracing bypasses the direct TRANSFER encoding
+    pn_transport_set_tracer(t1, discard_trace);
+    pn_transport_trace(t1, PN_TRACE_FRM);
+  }
+
+  test_setup(c1, t1, c2, t2);
+  pn_link_t *tx = pn_link_head(c1, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+  pn_link_t *rx = pn_link_head(c2, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+  pn_link_flow(rx, 1000);
+  pump(t1, t2);
+
+  std::string frames;
+  char body[100] = {0};
+  std::string tag = "tag";
+  for (int i = 0; i < 300; ++i) {
+    pn_delivery_t *d = pn_delivery(tx, pn_dtag(tag.data(), tag.size()));
+    pn_link_send(tx, body, sizeof(body));
+    if (i % 3) {
+      pn_link_advance(tx);  // complete, otherwise 'more' is set
+    }
+    if (i % 2) pn_delivery_settle(d);
+    ssize_t n = pn_transport_pending(t1);
+    if (n > 0) frames.append(pn_transport_head(t1), n);
+    pump(t1, t2);
+    if (!(i % 3)) {
+      pn_link_advance(tx);
+      pump(t1, t2);
+    }
+    tag.push_back('x' + i % 3);
+    if (tag.size() > 40) tag = "tag";
+  }
+
+  pn_transport_unbind(t1);
+  pn_transport_free(t1);
+  pn_connection_free(c1);
+  pn_transport_unbind(t2);
+  pn_transport_free(t2);
+  pn_connection_free(c2);
+  return frames;
+}
+
+// The direct TRANSFER encoding must produce the same frames as the general
+// encoder used when frames are traced
+TEST_CASE("engine_transfer_encoding") {
+  std::string direct = transfer_frames(false);
+  std::string general = transfer_frames(true);
+  CHECK(!direct.empty());
+  CHECK(direct == general);
+}
+
+// Aborting a delivery that was never sent gives back its credit and queue slot
+TEST_CASE("engine_abort_unsent") {
+  pn_connection_t *c1 = pn_connection();
+  pn_transport_t *t1 = pn_transport();
+  pn_transport_bind(t1, c1);
+  pn_connection_t *c2 = pn_connection();
+  pn_transport_t *t2 = pn_transport();
+  pn_transport_set_server(t2);
+  pn_transport_bind(t2, c2);
+
+  test_setup(c1, t1, c2, t2);
+  pn_link_t *tx = pn_link_head(c1, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+  pn_link_t *rx = pn_link_head(c2, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+  pn_link_flow(rx, 2);
+  pump(t1, t2);
+  CHECK(2 == pn_link_credit(tx));
+
+  // Aborted before it was advanced: nothing was counted
+  char body[10] = {0};
+  pn_delivery_t *d = pn_delivery(tx, pn_dtag("a", 1));
+  pn_link_send(tx, body, sizeof(body));
+  pn_delivery_abort(d);
+  CHECK(0 == pn_link_queued(tx));
+  CHECK(2 == pn_link_credit(tx));
+
+  // Advanced but aborted before any frame was written
+  d = pn_delivery(tx, pn_dtag("b", 1));
+  pn_link_send(tx, body, sizeof(body));
+  pn_link_advance(tx);
+  CHECK(1 == pn_link_queued(tx));
+  CHECK(1 == pn_link_credit(tx));
+  pn_delivery_abort(d);
+  CHECK(0 == pn_link_queued(tx));
+  CHECK(2 == pn_link_credit(tx));
+  pump(t1, t2);
+  CHECK(0 == pn_link_queued(tx));
+  CHECK(2 == pn_link_credit(tx));
+  CHECK(0 == pn_link_queued(rx));
+
+  // The credit is still there to use
+  pn_delivery(tx, pn_dtag("c", 1));
+  pn_link_send(tx, body, sizeof(body));
+  pn_link_advance(tx);
+  pump(t1, t2);
+  CHECK(0 == pn_link_queued(tx));
+  CHECK(1 == pn_link_credit(tx));
+  CHECK(1 == pn_link_queued(rx));
+
+  pn_transport_unbind(t1);
+  pn_transport_free(t1);
+  pn_connection_free(c1);
+  pn_transport_unbind(t2);
+  pn_transport_free(t2);
+  pn_connection_free(c2);
+}
+
+// Counters for deliveries, bytes, dispositions and time spent blocked
+TEST_CASE("engine_stats") {
+  pn_connection_t *c1 = pn_connection();
+  pn_transport_t *t1 = pn_transport();
+  pn_transport_bind(t1, c1);
+  pn_connection_t *c2 = pn_connection();
+  pn_transport_t *t2 = pn_transport();
+  pn_transport_set_server(t2);
+  pn_transport_set_max_frame(t2, 512);
+  pn_transport_bind(t2, c2);
+
+  test_setup(c1, t1, c2, t2);
+  pn_link_t *tx = pn_link_head(c1, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+  pn_link_t *rx = pn_link_head(c2, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+  // Room for 2 frames of 512 bytes
+  pn_session_set_incoming_capacity(pn_link_session(rx), 1024);
+
+  // No credit, the sender is blocked
+  char body[400] = {0};
+  for (int i = 0; i < 3; ++i) {
+    pn_delivery(tx, pn_dtag((const char *)&i, sizeof(i)));
+    pn_link_send(tx, body, sizeof(body));
+    pn_link_advance(tx);
+  }
+  pump(t1, t2);
+  millisleep(20);
+  pn_link_stats_t ts = pn_link_stats(tx);
+  CHECK(ts.credit_blocked >= 10);
+  CHECK(0 == ts.deliveries);
+  CHECK(0 == pn_connection_stats(c1).window_blocked);
+
+  // Credit for all 3, the session window only lets 2 through
+  pn_link_flow(rx, 10);
+  pump(t1, t2);
+  ts = pn_link_stats(tx);
+  CHECK(2 == ts.deliveries);
+  CHECK(2 * sizeof(body) == ts.bytes);
+  uint64_t blocked = ts.credit_blocked;
+  millisleep(20);
+  CHECK(blocked == pn_link_stats(tx).credit_blocked);
+  CHECK(pn_connection_stats(c1).window_blocked >= 10);
+
+  // Reading frees up the window, the last delivery is sent and settled
+  char buf[sizeof(body)];
+  pn_delivery_t *d = pn_link_current(rx);
+  CHECK(ssize_t(sizeof(body)) == pn_link_recv(rx, buf, sizeof(buf)));
+  pn_delivery_settle(d);
+  pump(t1, t2);
+  pn_connection_stats_t cs1 = pn_connection_stats(c1);
+  CHECK(3 == cs1.deliveries_sent);
+  CHECK(3 * sizeof(body) == cs1.bytes_sent);
+  CHECK(1 == cs1.dispositions_input);
+  CHECK(0 == cs1.dispositions_output);
+  blocked = cs1.window_blocked;
+  millisleep(20);
+  CHECK(blocked == pn_connection_stats(c1).window_blocked);
+
+  pn_link_stats_t rs = pn_link_stats(rx);
+  CHECK(3 == rs.deliveries);
+  CHECK(3 * sizeof(body) == rs.bytes);
+  CHECK(1 == rs.settled);
+  CHECK(0 == rs.credit_blocked);
+  pn_connection_stats_t cs2 = pn_connection_stats(c2);
+  CHECK(3 == cs2.deliveries_received);
+  CHECK(3 * sizeof(body) == cs2.bytes_received);
+  CHECK(1 == cs2.dispositions_output);
+  CHECK(cs2.frames_input == cs1.frames_output);
+  CHECK(cs1.frames_input == cs2.frames_output);
+
+  pn_transport_unbind(t1);
+  pn_transport_free(t1);
+  pn_connection_free(c1);
+  pn_transport_unbind(t2);
+  pn_transport_free(t2);
+  pn_connection_free(c2);
+}
+
+// Time blocked stops counting when there is nothing left to send
+TEST_CASE("engine_stats_unblocked") {
+  pn_connection_t *c1 = pn_connection();
+  pn_transport_t *t1 = pn_transport();
+  pn_transport_bind(t1, c1);
+  pn_connection_t *c2 = pn_connection();
+  pn_transport_t *t2 = pn_transport();
+  pn_transport_set_server(t2);
+  pn_transport_set_max_frame(t2, 512);
+  pn_transport_bind(t2, c2);
+
+  test_setup(c1, t1, c2, t2);
+  pn_link_t *tx = pn_link_head(c1, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+  pn_link_t *rx = pn_link_head(c2, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+  // Room for 1 frame of 512 bytes
+  pn_session_set_incoming_capacity(pn_link_session(rx), 512);
+
+  // Abort a delivery held back by credit
+  char body[400] = {0};
+  pn_delivery_t *d = pn_delivery(tx, pn_dtag("a", 1));
+  pn_link_send(tx, body, sizeof(body));
+  pn_link_advance(tx);
+  pump(t1, t2);
+  millisleep(20);
+  CHECK(pn_link_stats(tx).credit_blocked >= 10);
+  pn_delivery_abort(d);
+  pump(t1, t2);
+  uint64_t blocked = pn_link_stats(tx).credit_blocked;
+  millisleep(20);
+  CHECK(blocked == pn_link_stats(tx).credit_blocked);
+
+  // Abort a delivery held back by the session window
+  pn_link_flow(rx, 10);
+  pn_delivery(tx, pn_dtag("b", 1));
+  pn_link_send(tx, body, sizeof(body));
+  pn_link_advance(tx);
+  d = pn_delivery(tx, pn_dtag("c", 1));
+  pn_link_send(tx, body, sizeof(body));
+  pn_link_advance(tx);
+  pump(t1, t2);
+  CHECK(1 == pn_link_stats(tx).deliveries);
+  millisleep(20);
+  CHECK(pn_connection_stats(c1).window_blocked >= 10);
+  pn_delivery_abort(d);
+  pump(t1, t2);
+  blocked = pn_connection_stats(c1).window_blocked;
+  millisleep(20);
+  CHECK(blocked == pn_connection_stats(c1).window_blocked);
+
+  // Close a link with unsent data in its current delivery
+  pn_link_t *tx2 = pn_sender(pn_link_session(tx), "tx2");
+  pn_link_open(tx2);
+  pump(t1, t2);
+  pn_link_open(pn_link_head(c2, (PN_LOCAL_UNINIT | PN_REMOTE_ACTIVE)));
+  pump(t1, t2);
+  pn_delivery(tx2, pn_dtag("d", 1));
+  pn_link_send(tx2, body, sizeof(body));
+  pump(t1, t2);
+  millisleep(20);
+  CHECK(pn_link_stats(tx2).credit_blocked >= 10);
+  pn_link_close(tx2);
+  pump(t1, t2);
+  blocked = pn_link_stats(tx2).credit_blocked;
+  millisleep(20);
+  CHECK(blocked == pn_link_stats(tx2).credit_blocked);
+
+  pn_transport_unbind(t1);
+  pn_transport_free(t1);
+  pn_connection_free(c1);
+  pn_transport_unbind(t2);
+  pn_transport_free(t2);
+  pn_connection_free(c2);
+}
+
+static std::vector<std::string> trace_lines;
+static void collect_trace(pn_transport_t *, const char *line) { trace_lines.push_back(line); }
+
+static std::string read_file(const char *path) {
+  std::string bytes;
+  FILE *f = fopen(path, "rb");
+  if (f) {
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) bytes.append(buf, n);
+    fclose(f);
+  }
+  return bytes;
+}
+
+static uint64_t get_uint(const std::string &s, size_t offset, int size) {
+  uint64_t value = 0;
+  for (int i = 0; i < size; ++i) value = (value << 8) | (uint8_t)s[offset + i];
+  return value;
+}
+
+// A frame from a PN_TRACE_BIN dump, formatted like PN_TRACE_FRM without the payload
+struct trace_record {
+  bool out;
+  std::string text;
+};
+
+static std::vector<trace_record> read_trace(const char *path) {
+  std::string dump = read_file(path);
+  REQUIRE(dump.size() >= 24);
+  REQUIRE(dump.substr(0, 8) == "PNTRACE1");
+  std::vector<trace_record> records;
+  pn_data_t *data = pn_data(0);
+  pn_string_t *str = pn_string(NULL);
+  size_t offset = 24;
+  while (offset < dump.size()) {
+    size_t length = get_uint(dump, offset, 4);
+    REQUIRE(length >= 20);
+    REQUIRE(offset + length <= dump.size());
+    trace_record r;
+    r.out = dump[offset + 19];
+    pn_string_format(str, "%u %s ", unsigned(get_uint(dump, offset + 16, 2)), r.out ? "->" : "<-");
+    pn_data_clear(data);
+    CHECK(pn_data_decode(data, dump.data() + offset + 20, length - 20) > 0);
+    pn_inspect(data, str);
+    r.text = pn_string_get(str);
+    records.push_back(r);
+    offset += length;
+  }
+  pn_free(str);
+  pn_data_free(data);
+  return records;
+}
+
+TEST_CASE("engine_trace_bin") {
+  const char *path = "engine_trace_bin.dump";
+  pn_connection_t *c1 = pn_connection();
+  pn_transport_t *t1 = pn_transport();
+  pn_transport_bind(t1, c1);
+  pn_connection_t *c2 = pn_connection();
+  pn_transport_t *t2 = pn_transport();
+  pn_transport_set_server(t2);
+  pn_transport_bind(t2, c2);
+  trace_lines.clear();
+  pn_transport_set_tracer(t1, collect_trace);
+  pn_transport_trace(t1, PN_TRACE_FRM | PN_TRACE_BIN);
+  REQUIRE(0 == pn_transport_set_trace_ring(t1, 64 * 1024, 8));
+
+  test_setup(c1, t1, c2, t2);
+  pn_link_t *tx = pn_link_head(c1, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+  pn_link_t *rx = pn_link_head(c2, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+  pn_link_flow(rx, 10);
+  pump(t1, t2);
+  char body[100] = {0};
+  for (int i = 0; i < 2; ++i) {
+    pn_delivery(tx, pn_dtag((const char *)&i, sizeof(i)));
+    pn_link_send(tx, body, sizeof(body));
+    pn_link_advance(tx);
+  }
+  pump(t1, t2);
+
+  // Same frames as PN_TRACE_FRM, in the same order
+  REQUIRE(0 == pn_transport_dump_trace(t1, path));
+  std::vector<trace_record> records = read_trace(path);
+  pn_connection_stats_t stats = pn_connection_stats(c1);
+  CHECK(records.size() == stats.frames_output + stats.frames_input);
+  std::vector<std::string> frames;
+  for (size_t i = 0; i < trace_lines.size(); ++i) {
+    if (trace_lines[i].find(" -> @") != std::string::npos ||
+        trace_lines[i].find(" <- @") != std::string::npos)
+      frames.push_back(trace_lines[i]);
+  }
+  REQUIRE(frames.size() == records.size());
+  for (size_t i = 0; i < records.size(); ++i) {
+    INFO(frames[i]);
+    CHECK(frames[i].compare(0, records[i].text.size(), records[i].text) == 0);
+  }
+  CHECK(records[0].out);
+  CHECK(records[0].text.find("@open") != std::string::npos);
+  CHECK(records.back().text.find("@transfer") != std::string::npos);
+
+  // A small ring keeps only the latest frames
+  REQUIRE(0 == pn_transport_set_trace_ring(t1, 300, 0));
+  for (int i = 2; i < 10; ++i) {
+    pn_delivery(tx, pn_dtag((const char *)&i, sizeof(i)));
+    pn_link_send(tx, body, sizeof(body));
+    pn_link_advance(tx);
+    pump(t1, t2);
+  }
+  REQUIRE(0 == pn_transport_dump_trace(t1, path));
+  CHECK(read_file(path).size() <= 24 + 300);
+  records = read_trace(path);
+  CHECK(records.size() > 1);
+  CHECK(records.size() < 16);
+
+  // Without a ring the dump is empty but valid
+  REQUIRE(0 == pn_transport_set_trace_ring(t1, 0, 0));
+  REQUIRE(0 == pn_transport_dump_trace(t1, path));
+  CHECK(read_trace(path).empty());
+  remove(path);
+
+  pn_transport_unbind(t1);
+  pn_transport_free(t1);
+  pn_connection_free(c1);
+  pn_transport_unbind(t2);
+  pn_transport_free(t2);
+  pn_connection_free(c2);
+}
+
+TEST_CASE("engine_latency") {
+  pn_connection_t *c1 = pn_connection();
+  pn_transport_t *t1 = pn_transport();
+  pn_transport_bind(t1, c1);
+  pn_connection_t *c2 = pn_connection();
+  pn_transport_t *t2 = pn_transport();
+  pn_transport_set_server(t2);
+  pn_transport_bind(t2, c2);
+
+  test_setup(c1, t1, c2, t2);
+  pn_link_t *tx = pn_link_head(c1, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+  pn_link_t *rx = pn_link_head(c2, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+  CHECK(!pn_link_get_latency_tracking(tx));
+  CHECK(NULL == pn_link_latency(tx, PN_LATENCY_TOTAL));
+
+  // Not tracked
+  char body[100] = {0};
+  int tag = 0;
+  pn_delivery(tx, pn_dtag((const char *)&tag, sizeof(tag)));
+  pn_link_send(tx, body, sizeof(body));
+  pn_link_advance(tx);
+
+  pn_link_set_latency_tracking(tx, true);
+  CHECK(pn_link_get_latency_tracking(tx));
+  for (tag = 1; tag < 4; ++tag) {
+    pn_delivery(tx, pn_dtag((const char *)&tag, sizeof(tag)));
+    pn_link_send(tx, body, sizeof(body));
+    pn_link_advance(tx);
+  }
+  // Held back by credit
+  millisleep(20);
+  pn_link_flow(rx, 10);
+  pump(t1, t2);
+
+  pn_histogram_t *queued = pn_link_latency(tx, PN_LATENCY_QUEUED);
+  CHECK(3 == pn_histogram_count(queued));
+  CHECK(pn_histogram_min(queued) >= 10000);
+  CHECK(pn_histogram_percentile(queued, 50) >= pn_histogram_min(queued));
+  CHECK(pn_histogram_percentile(queued, 100) == pn_histogram_max(queued));
+  CHECK(pn_histogram_mean(queued) >= pn_histogram_min(queued));
+  CHECK(3 == pn_histogram_count(pn_link_latency(tx, PN_LATENCY_WRITTEN)));
+  CHECK(0 == pn_histogram_count(pn_link_latency(tx, PN_LATENCY_SETTLED)));
+
+  // Settle the first two tracked deliveries
+  for (pn_delivery_t *d = pn_unsettled_head(rx); d; d = pn_unsettled_next(d)) {
+    pn_bytes_t t = pn_delivery_tag(d);
+    int n;
+    memcpy(&n, t.start, sizeof(n));
+    if (n == 1 || n == 2) pn_delivery_settle(d);
+  }
+  pump(t1, t2);
+  CHECK(2 == pn_histogram_count(pn_link_latency(tx, PN_LATENCY_SETTLED)));
+  pn_histogram_t *total = pn_link_latency(tx, PN_LATENCY_TOTAL);
+  CHECK(2 == pn_histogram_count(total));
+  CHECK(pn_histogram_min(total) >= pn_histogram_min(queued));
+
+  pn_histogram_clear(total);
+  CHECK(0 == pn_histogram_count(total));
+  CHECK(0 == pn_histogram_max(total));
+  CHECK(0 == pn_histogram_percentile(total, 99));
+
+  // Generated but never popped, released on unbind
+  pn_delivery(tx, pn_dtag((const char *)&tag, sizeof(tag)));
+  pn_link_send(tx, body, sizeof(body));
+  pn_link_advance(tx);
+  CHECK(pn_transport_pending(t1) > 0);
+  CHECK(4 == pn_histogram_count(queued));
+  CHECK(3 == pn_histogram_count(pn_link_latency(tx, PN_LATENCY_WRITTEN)));
+
+  pn_transport_unbind(t1);
+  pn_transport_free(t1);
+  pn_connection_free(c1);
+  pn_transport_unbind(t2);
+  pn_transport_free(t2);
+  pn_connection_free(c2);
+}
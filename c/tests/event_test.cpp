@@ -21,8 +21,13 @@
 
 #include "./pn_test.hpp"
 
+#include <proton/connection.h>
+#include <proton/delivery.h>
 #include <proton/event.h>
+#include <proton/link.h>
 #include <proton/object.h>
+#include <proton/session.h>
+#include <proton/transport.h>
 
 TEST_CASE("event_collector") {
   pn_collector_t *collector = pn_collector();
@@ -103,3 +108,47 @@ TEST_CASE("event_incref") {
   test_event_incref(true);
   test_event_incref(false);
 }
+
+TEST_CASE("event_collector_coalesce") {
+  pn_connection_t *c = pn_connection();
+  pn_transport_t *t = pn_transport();
+  pn_link_t *l = pn_sender(pn_session(c), "x");
+  pn_delivery_t *d = pn_delivery(l, pn_dtag("1", 1));
+  pn_collector_t *collector = pn_collector();
+
+  // Without coalescing only an event identical to the tail is elided
+  CHECK(pn_collector_put(collector, PN_OBJECT, d, PN_DELIVERY));
+  CHECK(!pn_collector_put(collector, PN_OBJECT, d, PN_DELIVERY));
+  CHECK(pn_collector_put(collector, PN_OBJECT, t, PN_TRANSPORT));
+  CHECK(pn_collector_put(collector, PN_OBJECT, d, PN_DELIVERY));
+  pn_collector_drain(collector);
+
+  pn_collector_coalesce(collector, true);
+  CHECK(pn_collector_put(collector, PN_OBJECT, d, PN_DELIVERY));
+  CHECK(pn_collector_put(collector, PN_OBJECT, l, PN_LINK_FLOW));
+  CHECK(pn_collector_put(collector, PN_OBJECT, t, PN_TRANSPORT));
+  CHECK(!pn_collector_put(collector, PN_OBJECT, d, PN_DELIVERY));
+  CHECK(!pn_collector_put(collector, PN_OBJECT, l, PN_LINK_FLOW));
+  CHECK(!pn_collector_put(collector, PN_OBJECT, t, PN_TRANSPORT));
+  // Other event types are not coalesced
+  CHECK(pn_collector_put(collector, PN_OBJECT, l, PN_LINK_LOCAL_OPEN));
+  CHECK(pn_collector_put(collector, PN_OBJECT, d, PN_DELIVERY) == NULL);
+  CHECK(pn_collector_put(collector, PN_OBJECT, l, PN_LINK_LOCAL_CLOSE));
+  CHECK(pn_collector_put(collector, PN_OBJECT, l, PN_LINK_LOCAL_OPEN));
+
+  // Once an event has been taken from the collector it can be queued again
+  pn_event_t *e = pn_collector_next(collector);
+  CHECK(PN_DELIVERY == pn_event_type(e));
+  CHECK(pn_collector_put(collector, PN_OBJECT, d, PN_DELIVERY));
+  CHECK(PN_LINK_FLOW == pn_event_type(pn_collector_next(collector)));
+  CHECK(PN_TRANSPORT == pn_event_type(pn_collector_next(collector)));
+  CHECK(PN_LINK_LOCAL_OPEN == pn_event_type(pn_collector_next(collector)));
+  CHECK(PN_LINK_LOCAL_CLOSE == pn_event_type(pn_collector_next(collector)));
+  CHECK(PN_LINK_LOCAL_OPEN == pn_event_type(pn_collector_next(collector)));
+  CHECK(PN_DELIVERY == pn_event_type(pn_collector_next(collector)));
+  CHECK(!pn_collector_next(collector));
+
+  pn_collector_free(collector);
+  pn_transport_free(t);
+  pn_connection_free(c);
+}
@@ -967,3 +967,60 @@ TEST_CASE("list_heap") {
 
   pn_free(list);
 }
+
+PN_HANDLE(RECORD_TEST_A)
+PN_HANDLE(RECORD_TEST_B)
+
+TEST_CASE("record") {
+  pn_record_t *record = pn_record();
+  CHECK(pn_record_has(record, PN_LEGCTX));
+  CHECK(!pn_record_has(record, PN_CPPCTX));
+  CHECK(!pn_record_has(record, RECORD_TEST_A));
+  CHECK(pn_record_get(record, PN_CPPCTX) == NULL);
+
+  // Well-known and PN_HANDLE handles hold references independently
+  pn_string_t *s = pn_string("value");
+  pn_record_def(record, PN_CPPCTX, PN_OBJECT);
+  pn_record_set(record, PN_CPPCTX, s);
+  CHECK(pn_refcount(s) == 2);
+  pn_record_def(record, RECORD_TEST_A, PN_OBJECT);
+  pn_record_set(record, RECORD_TEST_A, s);
+  CHECK(pn_refcount(s) == 3);
+  pn_record_def(record, RECORD_TEST_B, PN_VOID);
+  pn_record_set(record, RECORD_TEST_B, (void *) 42);
+  pn_record_set(record, PN_LEGCTX, (void *) 7);
+
+  CHECK(pn_record_get(record, PN_CPPCTX) == s);
+  CHECK(pn_record_get(record, RECORD_TEST_A) == s);
+  CHECK(pn_record_get(record, RECORD_TEST_B) == (void *) 42);
+  CHECK(pn_record_get(record, PN_LEGCTX) == (void *) 7);
+  CHECK(!pn_record_has(record, PN_PROACTORCTX));
+
+  pn_record_set(record, PN_CPPCTX, NULL);
+  CHECK(pn_refcount(s) == 2);
+  CHECK(pn_record_has(record, PN_CPPCTX));
+
+  pn_record_set(record, PN_CPPCTX, s);
+  pn_record_clear(record);
+  CHECK(pn_refcount(s) == 1);
+  CHECK(pn_record_has(record, PN_LEGCTX));
+  CHECK(pn_record_get(record, PN_LEGCTX) == NULL);
+  CHECK(!pn_record_has(record, PN_CPPCTX));
+  CHECK(!pn_record_has(record, RECORD_TEST_A));
+
+  // Dynamic handles beyond the initial capacity
+  static const char keys[16] = {0};
+  for (size_t i = 0; i < sizeof(keys); i++) {
+    pn_record_def(record, &keys[i], PN_VOID);
+    pn_record_set(record, &keys[i], (void *) (i + 1));
+  }
+  for (size_t i = 0; i < sizeof(keys); i++) {
+    CHECK(pn_record_get(record, &keys[i]) == (void *) (i + 1));
+  }
+
+  pn_record_def(record, PN_CPPCTX, PN_OBJECT);
+  pn_record_set(record, PN_CPPCTX, s);
+  pn_free(record);
+  CHECK(pn_refcount(s) == 1);
+  pn_free(s);
+}
@@ -20,6 +20,7 @@
 #include "../src/proactor/proactor-internal.h"
 #include "./pn_test_proactor.hpp"
 #include "./test_config.h"
+#include "./thread.h"
 
 #include <proton/condition.h>
 #include <proton/connection.h>
@@ -35,6 +36,14 @@
 
 #include <string.h>
 
+#ifndef _WIN32
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
 #include <iostream>
 
 using namespace pn_test;
@@ -146,6 +155,228 @@ TEST_CASE("proactor_connect") {
   REQUIRE_RUN(p, PN_TRANSPORT_CLOSED);
 }
 
+namespace {
+/* close connections on open, stop after a number of transports have closed */
+struct count_closed_handler : public close_on_open_handler {
+  int remaining;
+  count_closed_handler(int n) : remaining(n) {}
+
+  bool handle(pn_event_t *e) CATCH_OVERRIDE {
+    if (pn_event_type(e) == PN_TRANSPORT_CLOSED) {
+      CHECK_THAT(*last_condition, cond_empty());
+      return --remaining == 0;
+    }
+    return close_on_open_handler::handle(e);
+  }
+};
+} // namespace
+
+/* Make many simultaneous connections, more than are accepted per wakeup */
+static void connect_many(size_t shards, size_t loops = 1) {
+  const int n = 40;
+  count_closed_handler h(2 * n);
+  proactor p(&h);
+  pn_proactor_set_loops(p, loops);
+  pn_listener_t *l = pn_listener();
+  int err = pn_listener_set_shards(l, shards);
+#ifndef PROACTOR_EPOLL
+  if (shards > 1) {             /* Only epoll listens on several sockets */
+    CHECK(PN_ERR == err);
+    pn_listener_free(l);
+    return;
+  }
+#endif
+  REQUIRE(0 == err);
+  pn_proactor_listen(p, l, "localhost:0", n);
+  REQUIRE_RUN(p, PN_LISTENER_OPEN);
+  /* Shards do not show up as extra listening addresses */
+  const pn_netaddr_t *na = pn_listener_addr(l);
+  REQUIRE(na);
+  int addrs = 0;
+  for (; na; na = pn_netaddr_next(na)) ++addrs;
+  CHECK(addrs <= 2);          /* At most one each for IPv4 and IPv6 */
+  for (int i = 0; i < n; ++i) p.connect(l);
+  CHECK(p.run() == PN_TRANSPORT_CLOSED);
+  CHECK(h.remaining == 0);
+  pn_listener_close(l);
+  REQUIRE_RUN(p, PN_LISTENER_CLOSE);
+}
+
+TEST_CASE("proactor_connect_many") {
+  connect_many(0);
+  connect_many(4);          /* SO_REUSEPORT shards */
+  connect_many(0, 4);       /* Connections accepted on other loops, one thread runs them all */
+}
+
+#ifdef PROACTOR_EPOLL
+/* Only the epoll proactor resolves names on its own threads, and lets the
+ * tests replace getaddrinfo() with test_resolver().
+ */
+namespace {
+pthread_mutex_t resolver_lock = PTHREAD_MUTEX_INITIALIZER;
+int resolver_calls = 0;
+int slow_lookup_fd = -1;        /* Lookups of "slow" read it till EOF */
+
+const char *resolve_port(const char *port) { return port ? port : "0"; }
+
+bool resolver_called(int n) {
+  pthread_mutex_lock(&resolver_lock);
+  bool called = resolver_calls >= n;
+  pthread_mutex_unlock(&resolver_lock);
+  return called;
+}
+
+void wait_resolver_called(int n) {
+  for (int i = 0; i < 1000 && !resolver_called(n); ++i) millisleep(10);
+  REQUIRE(resolver_called(n));
+}
+
+int test_resolver(const char *host, const char *port, struct addrinfo **res) {
+  pthread_mutex_lock(&resolver_lock);
+  ++resolver_calls;
+  int fd = slow_lookup_fd;
+  pthread_mutex_unlock(&resolver_lock);
+  struct addrinfo h = {};
+  if (!host) {
+    return EAI_NONAME;
+  } else if (!strcmp(host, "slow")) {
+    char c;
+    while (read(fd, &c, 1) > 0) {}
+    return EAI_NONAME;
+  } else if (!strcmp(host, "loopback")) {
+    /* The IPv6 and IPv4 loopback addresses */
+    h.ai_family = AF_UNSPEC;
+    h.ai_socktype = SOCK_STREAM;
+    return getaddrinfo(NULL, resolve_port(port), &h, res);
+  } else if (!strcmp(host, "many")) {
+    /* 127.0.0.1 once for each socket type, so several connection attempts */
+    h.ai_flags = AI_NUMERICHOST;
+    return getaddrinfo("127.0.0.1", resolve_port(port), &h, res);
+  }
+  return EAI_NONAME;
+}
+} // namespace
+
+/* Host names are resolved off the caller's thread and the result is cached.
+ * Only IPv4 is listening, so when both addresses are tried one must fail.
+ */
+TEST_CASE("proactor_connect_resolve") {
+  close_on_open_handler h;
+  proactor p(&h);
+  REQUIRE(pni_proactor_set_resolver(p, test_resolver));
+  resolver_calls = 0;
+  pn_listener_t *l = p.listen("127.0.0.1:0", &h);
+  REQUIRE_RUN(p, PN_LISTENER_OPEN);
+  std::string addr = "loopback:" + listening_port(l);
+  for (int i = 0; i < 2; ++i) {
+    p.connect(addr);
+    REQUIRE_RUN(p, PN_TRANSPORT_CLOSED);
+    CHECK_THAT(*h.last_condition, cond_empty());
+    REQUIRE_RUN(p, PN_TRANSPORT_CLOSED);
+    CHECK_THAT(*h.last_condition, cond_empty());
+  }
+  CHECK(resolver_called(1));
+  CHECK(!resolver_called(2));
+  pn_listener_close(l);
+  REQUIRE_RUN(p, PN_LISTENER_CLOSE);
+}
+
+namespace {
+/* A listening socket that never completes another connection: its
+   backlog is full, so further connection attempts wait for a SYN-ACK. */
+struct full_listener {
+  int fd, client;
+  std::string port;
+
+  full_listener() : fd(socket(AF_INET, SOCK_STREAM, 0)), client(socket(AF_INET, SOCK_STREAM, 0)) {
+    struct sockaddr_in sa = {};
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(sa);
+    REQUIRE(0 == bind(fd, (struct sockaddr *)&sa, sizeof(sa)));
+    REQUIRE(0 == listen(fd, 0));
+    REQUIRE(0 == getsockname(fd, (struct sockaddr *)&sa, &len));
+    REQUIRE(0 == connect(client, (struct sockaddr *)&sa, len)); /* Fills the backlog */
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%d", ntohs(sa.sin_port));
+    port = buf;
+  }
+  ~full_listener() { close(client); close(fd); }
+};
+
+pn_timestamp_t now_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (pn_timestamp_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+} // namespace
+
+/* Closing a connection stops its connection attempts at once */
+TEST_CASE("proactor_connect_resolve_close") {
+  full_listener fl;
+  common_handler h;
+  proactor p(&h);
+  REQUIRE(pni_proactor_set_resolver(p, test_resolver));
+  resolver_calls = 0;
+  p.connect("many:" + fl.port);
+  wait_resolver_called(1);
+  millisleep(50);               /* Let the connection attempts start */
+  pn_timestamp_t start = now_ms();
+  pn_proactor_disconnect(p, NULL);
+  REQUIRE_RUN(p, PN_PROACTOR_INACTIVE); /* The connection is gone */
+  CHECK(now_ms() - start < 1000);
+}
+
+/* Freeing the proactor waits for neither a connection race nor a lookup */
+TEST_CASE("proactor_free_resolving") {
+  full_listener fl;
+  int fds[2];
+  REQUIRE(0 == pipe(fds));
+  pthread_mutex_lock(&resolver_lock);
+  resolver_calls = 0;
+  slow_lookup_fd = fds[0];
+  pthread_mutex_unlock(&resolver_lock);
+  pn_timestamp_t start;
+  {
+    common_handler h;
+    proactor p(&h);
+    REQUIRE(pni_proactor_set_resolver(p, test_resolver));
+    p.connect("many:" + fl.port);
+    p.connect("slow:amqp");
+    wait_resolver_called(2);
+    millisleep(50);             /* Let the connection attempts start */
+    start = now_ms();
+  }                             /* Free the proactor */
+  CHECK(now_ms() - start < 1000);
+  close(fds[1]);                /* Finish the slow lookup */
+  millisleep(100);
+  close(fds[0]);
+}
+
+/* A race that cannot finish is handed to its connection after every address
+ * has had an attempt, so it does not keep a resolver thread from other lookups.
+ */
+TEST_CASE("proactor_connect_resolve_busy") {
+  full_listener fl;
+  close_on_open_handler h;
+  proactor p(&h);
+  REQUIRE(pni_proactor_set_resolver(p, test_resolver));
+  pn_listener_t *l = p.listen("127.0.0.1:0", &h);
+  REQUIRE_RUN(p, PN_LISTENER_OPEN);
+  pn_timestamp_t start = now_ms();
+  for (int i = 0; i < 8; ++i) p.connect("many:" + fl.port); /* Twice the resolver threads */
+  p.connect("loopback:" + listening_port(l));
+  REQUIRE_RUN(p, PN_TRANSPORT_CLOSED);
+  CHECK_THAT(*h.last_condition, cond_empty());
+  REQUIRE_RUN(p, PN_TRANSPORT_CLOSED);
+  CHECK_THAT(*h.last_condition, cond_empty());
+  CHECK(now_ms() - start < 5000); /* Not the kernel's connect timeout */
+  pn_listener_close(l);
+  pn_proactor_disconnect(p, NULL);
+  for (pn_event_type_t et = p.run(); et != PN_PROACTOR_INACTIVE; et = p.run()) {}
+}
+#endif
+
 namespace {
 /* Return on connection open, close and return on wake */
 struct close_on_wake_handler : public common_handler {
@@ -202,6 +433,64 @@ TEST_CASE("proactor_connection_wake") {
   pn_decref(c);
 }
 
+/* Statistics count the work of the test thread and can be read back */
+TEST_CASE("proactor_stats") {
+  close_on_wake_handler h;
+  proactor p(&h);
+  pn_proactor_set_stats_enabled(p, true);
+  if (!pn_proactor_get_stats_enabled(p)) return; /* Not kept by this proactor */
+
+  pn_listener_t *l = p.listen();
+  REQUIRE_RUN(p, PN_LISTENER_OPEN);
+  pn_connection_t *c = p.connect(l);
+  REQUIRE_RUN(p, PN_CONNECTION_REMOTE_OPEN);
+  REQUIRE_RUN(p, PN_CONNECTION_REMOTE_OPEN);
+  pn_connection_wake(c);
+  REQUIRE_RUN(p, PN_CONNECTION_WAKE);
+  REQUIRE_RUN(p, PN_TRANSPORT_CLOSED);
+  REQUIRE_RUN(p, PN_TRANSPORT_CLOSED);
+
+  CHECK(1 == pn_proactor_stats_threads(p));
+  pn_proactor_stats_t total, thread;
+  REQUIRE(0 == pn_proactor_stats(p, -1, &total));
+  REQUIRE(0 == pn_proactor_stats(p, 0, &thread));
+  CHECK(PN_ARG_ERR == pn_proactor_stats(p, 1, &thread));
+  REQUIRE(0 == pn_proactor_stats(p, 0, &thread));
+  CHECK(0 == memcmp(&total, &thread, sizeof(total)));
+  CHECK(total.polls >= total.batches);
+  CHECK(total.batches > 0);
+  CHECK(total.events > total.batches);
+  CHECK(total.wakes > 0);
+  CHECK(total.rearms > 0);
+  CHECK(total.locks > 0);
+  CHECK(total.busy_ns > 0);
+
+  pn_histogram_t *h_events = pn_histogram();
+  REQUIRE(0 == pn_proactor_stats_distribution(p, -1, PN_PROACTOR_BATCH_EVENTS, h_events));
+  CHECK(total.batches == pn_histogram_count(h_events));
+  CHECK(pn_histogram_max(h_events) > 0);
+  REQUIRE(0 == pn_proactor_stats_distribution(p, 0, PN_PROACTOR_WAKE_LATENCY, h_events));
+  CHECK(total.wakes == pn_histogram_count(h_events));
+  REQUIRE(0 == pn_proactor_stats_distribution(p, -1, PN_PROACTOR_LOCK_HELD, h_events));
+  CHECK(total.locks == pn_histogram_count(h_events));
+  CHECK(PN_ARG_ERR == pn_proactor_stats_distribution(p, 1, PN_PROACTOR_LOCK_HELD, h_events));
+  CHECK(0 == pn_histogram_count(h_events));
+
+  /* Cleared values stay at zero while statistics are off */
+  pn_proactor_clear_stats(p);
+  pn_proactor_set_stats_enabled(p, false);
+  CHECK(!pn_proactor_get_stats_enabled(p));
+  pn_listener_close(l);
+  REQUIRE_RUN(p, PN_LISTENER_CLOSE);
+  REQUIRE(0 == pn_proactor_stats(p, -1, &total));
+  CHECK(0 == total.batches);
+  CHECK(0 == total.polls);
+  CHECK(0 == total.locks);
+  REQUIRE(0 == pn_proactor_stats_distribution(p, -1, PN_PROACTOR_BATCH_EVENTS, h_events));
+  CHECK(0 == pn_histogram_count(h_events));
+  pn_histogram_free(h_events);
+}
+
 namespace {
 struct abort_handler : public common_handler {
   bool handle(pn_event_t *e) {
@@ -629,6 +918,167 @@ TEST_CASE("proactor_netaddr") {
   CHECK(strlen(cl) == len);
 }
 
+#ifdef __linux__
+/* Find our own socket with the given local and remote addresses */
+static int find_socket(const pn_netaddr_t *local, const pn_netaddr_t *remote) {
+  for (int fd = 0; fd < 1024; ++fd) {
+    struct sockaddr_storage ss;
+    socklen_t len = sizeof(ss);
+    if (getsockname(fd, (struct sockaddr *)&ss, &len) ||
+        len != pn_netaddr_socklen(local) ||
+        memcmp(&ss, pn_netaddr_sockaddr(local), len))
+      continue;
+    len = sizeof(ss);
+    if (!getpeername(fd, (struct sockaddr *)&ss, &len) &&
+        len == pn_netaddr_socklen(remote) &&
+        !memcmp(&ss, pn_netaddr_sockaddr(remote), len))
+      return fd;
+  }
+  return -1;
+}
+
+static int get_int_option(int fd, int level, int name) {
+  int value = -1;
+  socklen_t len = sizeof(value);
+  REQUIRE(0 == getsockopt(fd, level, name, &value, &len));
+  return value;
+}
+
+TEST_CASE("proactor_socket_options") {
+  common_handler h;
+  proactor p(&h);
+  pn_listener_t *l = pn_listener();
+  CHECK(PN_ARG_ERR == pn_listener_set_socket_option(l, (pn_socket_option_t)99, 1));
+  CHECK(0 == pn_listener_set_socket_option(l, PN_SOCKET_RCVBUF, 256 * 1024));
+  CHECK(0 == pn_listener_set_socket_option(l, PN_SOCKET_NOTSENT_LOWAT, 16 * 1024));
+  CHECK(0 == pn_listener_set_socket_option(l, PN_SOCKET_USER_TIMEOUT, 5000));
+  pn_proactor_listen(p, l, "127.0.0.1:0", 4);
+  REQUIRE_RUN(p, PN_LISTENER_OPEN);
+
+  /* Can busy polling be enabled without privileges? */
+  int probe = socket(AF_INET, SOCK_STREAM, 0), busy_poll = 50;
+  bool can_busy_poll = !setsockopt(probe, SOL_SOCKET, SO_BUSY_POLL, &busy_poll, sizeof(busy_poll));
+  close(probe);
+
+  pn_connection_t *c = pn_connection();
+  CHECK(0 == pn_connection_set_socket_option(c, PN_SOCKET_NODELAY, 0));
+  CHECK(0 == pn_connection_set_socket_option(c, PN_SOCKET_SNDBUF, 128 * 1024));
+  CHECK(0 == pn_connection_set_socket_option(c, PN_SOCKET_BUSY_POLL, busy_poll));
+  CHECK(0 == pn_connection_set_socket_option(c, PN_SOCKET_QUICKACK, 1));
+  p.connect(l, NULL, c);
+  REQUIRE_RUN(p, PN_CONNECTION_REMOTE_OPEN);
+  REQUIRE_RUN(p, PN_CONNECTION_REMOTE_OPEN);
+
+  pn_transport_t *ct = pn_connection_transport(c);
+  int cfd = find_socket(pn_transport_local_addr(ct), pn_transport_remote_addr(ct));
+  REQUIRE(cfd >= 0);
+  pn_transport_t *st = pn_connection_transport(h.connection);
+  int sfd = find_socket(pn_transport_local_addr(st), pn_transport_remote_addr(st));
+  REQUIRE(sfd >= 0);
+
+  /* Client: connection options, defaults otherwise */
+  CHECK(0 == get_int_option(cfd, IPPROTO_TCP, TCP_NODELAY));
+  CHECK(128 * 1024 <= get_int_option(cfd, SOL_SOCKET, SO_SNDBUF)); /* Linux doubles it */
+  CHECK(0 == get_int_option(cfd, IPPROTO_TCP, TCP_NOTSENT_LOWAT));
+  if (can_busy_poll) CHECK(busy_poll == get_int_option(cfd, SOL_SOCKET, SO_BUSY_POLL));
+
+  /* Server: listener options */
+#ifdef PROACTOR_EPOLL
+  CHECK(1 == get_int_option(sfd, IPPROTO_TCP, TCP_NODELAY)); /* Only epoll sets it by default */
+#endif
+  CHECK(256 * 1024 <= get_int_option(sfd, SOL_SOCKET, SO_RCVBUF));
+  CHECK(16 * 1024 == get_int_option(sfd, IPPROTO_TCP, TCP_NOTSENT_LOWAT));
+  CHECK(5000 == get_int_option(sfd, IPPROTO_TCP, TCP_USER_TIMEOUT));
+  CHECK(0 == get_int_option(sfd, SOL_SOCKET, SO_BUSY_POLL));
+
+  pn_listener_close(l);
+  REQUIRE_RUN(p, PN_LISTENER_CLOSE);
+}
+
+/* Send pre-settled messages as fast as credit allows, count the messages received */
+struct output_limit_handler : public common_handler {
+  size_t limit;
+  int count, sent, received;
+  pn_link_t *sender;
+
+  output_limit_handler(size_t limit_, int count_)
+      : limit(limit_), count(count_), sent(), received(), sender() {}
+
+  bool handle(pn_event_t *e) {
+    switch (pn_event_type(e)) {
+    case PN_CONNECTION_BOUND:
+      pn_transport_set_output_limit(pn_event_transport(e), limit);
+      return common_handler::handle(e);
+
+    case PN_LINK_REMOTE_OPEN:
+      common_handler::handle(e);
+      if (pn_link_is_receiver(pn_event_link(e)))
+        pn_link_flow(pn_event_link(e), count);
+      return false;
+
+    case PN_LINK_FLOW: {
+      sender = pn_event_link(e);
+      char body[1024] = {0};
+      while (pn_link_is_sender(sender) && sent < count && pn_link_credit(sender) > 0) {
+        pn_delivery_t *d = pn_delivery(sender, pn_dtag((const char *)&sent, sizeof(sent)));
+        pn_link_send(sender, body, sizeof(body));
+        pn_link_advance(sender);
+        pn_delivery_settle(d);
+        ++sent;
+      }
+      return false;
+    }
+
+    case PN_DELIVERY: {
+      pn_delivery_t *d = pn_event_delivery(e);
+      if (pn_link_is_receiver(pn_delivery_link(d)) && !pn_delivery_partial(d)) {
+        char buf[1024];
+        while (pn_link_recv(pn_delivery_link(d), buf, sizeof(buf)) > 0)
+          ;
+        pn_delivery_settle(d);
+        ++received;
+      }
+      return false;
+    }
+
+    default:
+      return common_handler::handle(e);
+    }
+  }
+};
+
+/* Transfers are held back by the output limit and resumed as the socket drains */
+TEST_CASE("proactor_output_limit") {
+  output_limit_handler h(4096, 1000);
+  proactor p(&h);
+  pn_listener_t *l = p.listen();
+  REQUIRE_RUN(p, PN_LISTENER_OPEN);
+
+  pn_connection_t *c = pn_connection();
+  CHECK(0 == pn_connection_set_socket_option(c, PN_SOCKET_SNDBUF, 8 * 1024));
+  p.connect(l, NULL, c);
+  pn_session_t *ssn = pn_session(c);
+  pn_session_open(ssn);
+  pn_link_open(pn_sender(ssn, "x"));
+  REQUIRE_RUN(p, PN_LINK_FLOW);
+
+  /* The socket drains below the limit before more transfers are written */
+  pn_transport_t *ct = pn_connection_transport(c);
+  CHECK(4096 == pn_transport_get_output_limit(ct));
+  int cfd = find_socket(pn_transport_local_addr(ct), pn_transport_remote_addr(ct));
+  REQUIRE(cfd >= 0);
+
+  while (h.received < h.count)
+    REQUIRE_RUN(p, PN_DELIVERY);
+  CHECK(h.sent == h.count);
+#ifdef PROACTOR_EPOLL
+  CHECK(4096 == get_int_option(cfd, IPPROTO_TCP, TCP_NOTSENT_LOWAT));
+#else
+  (void)cfd;                    /* Only the epoll proactor applies the limit to the socket */
+#endif
+}
+#endif
+
 TEST_CASE("proactor_parse_addr") {
   char buf[1024];
   const char *host, *port;
@@ -0,0 +1,211 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#define PN_USE_DEPRECATED_API 1
+
+#include "./pn_test.hpp"
+
+#include <proton/reactor.h>
+#include <proton/selectable.h>
+
+#include <map>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+/* Tests of the reactor's selector, through the selectables of a reactor */
+
+using namespace pn_test;
+
+namespace {
+
+struct counts {
+  int readable, writable, expired;
+  counts() : readable(0), writable(0), expired(0) {}
+};
+
+std::map<pn_selectable_t *, counts> seen;
+
+void count_readable(pn_selectable_t *sel) { ++seen[sel].readable; }
+void count_writable(pn_selectable_t *sel) { ++seen[sel].writable; }
+
+void read_readable(pn_selectable_t *sel) {
+  char buf[64];
+  ++seen[sel].readable;
+  (void)!read(pn_selectable_get_fd(sel), buf, sizeof(buf));
+}
+
+void expire_once(pn_selectable_t *sel) {
+  ++seen[sel].expired;
+  pn_selectable_set_deadline(sel, 0);
+  pn_reactor_update(pn_object_reactor(sel), sel);
+}
+
+/* The selectable removed by remove_other() */
+pn_selectable_t *other = NULL;
+
+void remove_other(pn_selectable_t *sel) {
+  read_readable(sel);
+  if (other) {
+    pn_selectable_terminate(other);
+    pn_reactor_update(pn_object_reactor(sel), other);
+    other = NULL;
+  }
+}
+
+struct socket_pair {
+  int fd[2];
+  socket_pair() { REQUIRE(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, fd)); }
+  ~socket_pair() { close(fd[0]); close(fd[1]); }
+  void send() { REQUIRE(1 == write(fd[1], "x", 1)); }
+};
+
+struct reactor {
+  pn_reactor_t *r;
+  reactor() : r(pn_reactor()) {
+    seen.clear();
+    pn_reactor_set_timeout(r, 10);
+    pn_reactor_start(r);
+  }
+  ~reactor() {
+    pn_reactor_stop(r);
+    pn_reactor_free(r);
+  }
+
+  pn_selectable_t *selectable(int fd, bool reading, bool writing) {
+    pn_selectable_t *sel = pn_reactor_selectable(r);
+    pn_selectable_set_fd(sel, fd);
+    pn_selectable_set_reading(sel, reading);
+    pn_selectable_set_writing(sel, writing);
+    pn_reactor_update(r, sel);
+    return sel;
+  }
+
+  /* Process events for ms milliseconds */
+  void run(pn_millis_t ms) {
+    pn_timestamp_t end = pn_reactor_mark(r) + ms;
+    while (pn_reactor_mark(r) < end) pn_reactor_process(r);
+  }
+
+  /* Process events until *n is non-zero, for at most 5 seconds */
+  bool run_until(const int *n) {
+    pn_timestamp_t end = pn_reactor_mark(r) + 5000;
+    while (!*n && pn_reactor_mark(r) < end) pn_reactor_process(r);
+    return *n;
+  }
+};
+
+} // namespace
+
+TEST_CASE("reactor_selectable_readable_writable") {
+  reactor r;
+  socket_pair s;
+  pn_selectable_t *sel = r.selectable(s.fd[0], true, false);
+  pn_selectable_on_readable(sel, read_readable);
+  pn_selectable_on_writable(sel, count_writable);
+  r.run(30);
+  CHECK(0 == seen[sel].readable);
+  s.send();
+  REQUIRE(r.run_until(&seen[sel].readable));
+  int readable = seen[sel].readable;
+  r.run(30); /* The data was read, nothing more to report */
+  CHECK(readable == seen[sel].readable);
+  CHECK(0 == seen[sel].writable);
+
+  pn_selectable_set_reading(sel, false);
+  pn_selectable_set_writing(sel, true);
+  pn_reactor_update(r.r, sel);
+  REQUIRE(r.run_until(&seen[sel].writable));
+  s.send();
+  r.run(30); /* Not reading any more */
+  CHECK(readable == seen[sel].readable);
+  pn_selectable_terminate(sel);
+  pn_reactor_update(r.r, sel);
+  r.run(10);
+}
+
+TEST_CASE("reactor_selectable_deadline") {
+  reactor r;
+  socket_pair s;
+  /* One selectable with a socket, one with only a deadline */
+  pn_selectable_t *a = r.selectable(s.fd[0], true, false);
+  pn_selectable_t *b = r.selectable(PN_INVALID_SOCKET, false, false);
+  pn_selectable_on_expired(a, expire_once);
+  pn_selectable_on_expired(b, expire_once);
+  pn_timestamp_t start = pn_reactor_mark(r.r);
+  pn_selectable_set_deadline(a, start + 100);
+  pn_selectable_set_deadline(b, start + 50);
+  pn_reactor_update(r.r, a);
+  pn_reactor_update(r.r, b);
+  r.run(20);
+  CHECK(0 == seen[a].expired);
+  CHECK(0 == seen[b].expired);
+  REQUIRE(r.run_until(&seen[b].expired));
+  CHECK(pn_reactor_mark(r.r) >= start + 50);
+  CHECK(0 == seen[a].expired);
+  REQUIRE(r.run_until(&seen[a].expired));
+  CHECK(pn_reactor_mark(r.r) >= start + 100);
+  r.run(30); /* No deadlines left */
+  CHECK(1 == seen[a].expired);
+  CHECK(1 == seen[b].expired);
+  pn_selectable_terminate(a);
+  pn_selectable_terminate(b);
+  pn_reactor_update(r.r, a);
+  pn_reactor_update(r.r, b);
+  r.run(10);
+}
+
+/* A selectable removed while it is ready is not reported again, and a new
+   selectable with the same fd number is. */
+TEST_CASE("reactor_selectable_remove_pending") {
+  reactor r;
+  pn_selectable_t *a, *c;
+  {
+    socket_pair sa, sb;
+    a = r.selectable(sa.fd[0], true, false);
+    pn_selectable_t *b = r.selectable(sb.fd[0], true, false);
+    pn_selectable_on_readable(a, remove_other);
+    pn_selectable_on_readable(b, count_readable); /* Leaves the data unread */
+    other = b;
+    sb.send();
+    sa.send();
+    REQUIRE(r.run_until(&seen[a].readable));
+    int readable = seen[b].readable;
+    r.run(30);
+    CHECK(readable == seen[b].readable);
+    CHECK(1 == seen[a].readable);
+
+    /* Close a's socket while it is still registered */
+    pn_selectable_on_readable(a, count_readable);
+  }
+  socket_pair sc; /* Reuses the closed fd numbers */
+  c = r.selectable(sc.fd[0], true, false);
+  pn_selectable_on_readable(c, read_readable);
+  r.run(10);
+  pn_selectable_terminate(a); /* Must not unregister c */
+  pn_reactor_update(r.r, a);
+  r.run(10);
+  sc.send();
+  REQUIRE(r.run_until(&seen[c].readable));
+  pn_selectable_terminate(c);
+  pn_reactor_update(r.r, c);
+  r.run(10);
+}
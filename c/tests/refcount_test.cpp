@@ -29,6 +29,8 @@
 #include <proton/session.h>
 #include <proton/transport.h>
 
+#include "./thread.h"
+
 /**
  * The decref order tests validate that whenever the last pointer to a
  * child object, e.g. a session or a link, is about to go away, the
@@ -369,3 +371,51 @@ TEST_CASE("test_collector_transport_connection") {
   REQUIRE(pn_refcount(transport) == 1);
   pn_collector_free(collector);
 }
+
+/* An object with an atomic reference count shared by several threads */
+typedef struct {
+  int value;
+} shared_t;
+
+static int shared_finalized = 0;
+
+#define CID_shared CID_pn_object
+#define shared_initialize NULL
+#define shared_hashcode NULL
+#define shared_compare NULL
+#define shared_inspect NULL
+static void shared_finalize(void *object) { ++shared_finalized; }
+static const pn_class_t shared_class = PN_ATOMIC_CLASS(shared);
+
+#define SHARED_ROUNDS 100000
+
+static void *shared_user(void *object) {
+  for (int i = 0; i < SHARED_ROUNDS; ++i) {
+    pn_incref(object);
+    pn_decref(object);
+  }
+  pn_decref(object);            /* Give up the reference passed in */
+  return NULL;
+}
+
+TEST_CASE("test_atomic_refcount") {
+  shared_finalized = 0;
+  shared_t *shared = (shared_t *) pn_class_new(&shared_class, sizeof(shared_t));
+  REQUIRE(pn_refcount(shared) == 1);
+  pn_incref(shared);
+  REQUIRE(pn_refcount(shared) == 2);
+  REQUIRE(pn_decref(shared) == 1);
+  REQUIRE(shared_finalized == 0);
+
+  const int threads = 4;
+  pthread_t t[threads];
+  for (int i = 0; i < threads; ++i) {
+    pn_incref(shared);
+    pthread_create(&t[i], NULL, shared_user, shared);
+  }
+  pn_decref(shared);            /* The threads now hold the only references */
+  for (int i = 0; i < threads; ++i) {
+    pthread_join(t[i], NULL);
+  }
+  REQUIRE(shared_finalized == 1);
+}
@@ -325,9 +325,10 @@ typedef struct {
   bool shutdown;
 } global;
 
-void global_init(global *g, int threads) {
+void global_init(global *g, int threads, int loops) {
   memset(g, 0, sizeof(*g));
   g->proactor = pn_proactor();
+  pn_proactor_set_loops(g->proactor, loops);
   g->threads = threads;
   lpool_init(&g->listeners, g->threads/2, listener_ctx_free);
   cpool_init(&g->connections_active, g->threads/2, connection_ctx_free);
@@ -480,11 +481,13 @@ static void* proactor_thread(void* void_g) {
 
 static const int default_runtime = 1;
 static const int default_threads = 8;
+static const int default_loops = 1;
 
 void usage(const char **argv, const char **arg) {
   fprintf(stderr, "usage: %s [options]\n", argv[0]);
   fprintf(stderr, "  -time TIME: total run-time in seconds (default %d)\n", default_runtime);
   fprintf(stderr, "  -threads THREADS: total number of threads (default %d)\n", default_threads);
+  fprintf(stderr, "  -loops LOOPS: proactor event loops, see pn_proactor_set_loops() (default %d)\n", default_loops);
   fprintf(stderr, "  -debug: print debug messages\n");
   fprintf(stderr, "Flags to enable specific actions (all enabled by default)\n");
   fprintf(stderr, " ");
@@ -510,6 +513,7 @@ int main(int argc, const char* argv[]) {
   const char **end = argv + argc;
   int runtime = default_runtime;
   int threads = default_threads;
+  int loops = default_loops;
   bool action_default = true;
   for (size_t i = 0; i < action_size; ++i) action_enabled[i] = action_default;
 
@@ -523,6 +527,10 @@ int main(int argc, const char* argv[]) {
       if (threads <= 0) usage(argv, arg);
       if (threads % 2) threads += 1; /* Round up to even: half proactor, half user */
     }
+    else if (!strcmp(*arg, "-loops") && ++arg < end) {
+      loops = atoi(*arg);
+      if (loops <= 0) usage(argv, arg);
+    }
     else if (!strcmp(*arg, "-debug")) {
       debug_enable = true;
     }
@@ -544,7 +552,7 @@ int main(int argc, const char* argv[]) {
 
   /* Set up global state, start threads */
 
-  printf("threaderciser start: threads=%d, time=%d, actions=[", threads, runtime);
+  printf("threaderciser start: threads=%d, loops=%d, time=%d, actions=[", threads, loops, runtime);
   bool comma = false;
   for (size_t i = 0; i < action_size; ++i) {
     if (action_enabled[i]) {
@@ -556,7 +564,7 @@ int main(int argc, const char* argv[]) {
   fflush(stdout);
 
   global g;
-  global_init(&g, threads);
+  global_init(&g, threads, loops);
   lpool_listen(&g.listeners, g.proactor); /* Start initial listener */
 
   pthread_t *user_threads = (pthread_t*)calloc(threads/2, sizeof(pthread_t));
@@ -0,0 +1,122 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "./pn_test.hpp"
+
+extern "C" {
+#include "messenger/transform.h"
+}
+
+#include <stdio.h>
+
+using namespace pn_test;
+
+namespace {
+
+/* Apply transform to address, return the result */
+std::string apply(pn_transform_t *t, const char *address) {
+  auto_free<pn_string_t, pn_string_free> result(pn_string(NULL));
+  REQUIRE(0 == pn_transform_apply(t, address, result));
+  const char *s = pn_string_get(result);
+  return s ? s : "<null>";
+}
+
+void transform_free(pn_transform_t *t) { pn_free(t); }
+typedef auto_free<pn_transform_t, transform_free> transform_ptr;
+
+} // namespace
+
+/* Rules are indexed by the literal prefix of their pattern, but the first
+   matching rule still wins whatever the length of its prefix. */
+TEST_CASE("transform_first_match") {
+  transform_ptr t(pn_transform());
+  pn_transform_rule(t, "amqp://host-1/*", "one/$1");
+  pn_transform_rule(t, "amqp://host-10/*", "ten/$1");
+  pn_transform_rule(t, "amqp://*/q", "short/$1");
+  pn_transform_rule(t, "amqp://host-2/*", "two/$1");
+  pn_transform_rule(t, "amqp://%/*", "any/$1/$2");
+  pn_transform_rule(t, "*", "all/$1");
+
+  CHECK("one/a" == apply(t, "amqp://host-1/a"));
+  CHECK(pn_transform_matched(t));
+  CHECK("ten/a" == apply(t, "amqp://host-10/a"));
+  CHECK("short/host-2" == apply(t, "amqp://host-2/q"));
+  CHECK("two/r" == apply(t, "amqp://host-2/r"));
+  CHECK("any/host-3/r" == apply(t, "amqp://host-3/r"));
+  CHECK("all/amqp:host" == apply(t, "amqp:host"));
+  CHECK("all/" == apply(t, ""));
+
+  /* Same rules in reverse order */
+  transform_ptr r(pn_transform());
+  pn_transform_rule(r, "amqp://%/*", "any/$1/$2");
+  pn_transform_rule(r, "amqp://host-1/*", "one/$1");
+  CHECK("any/host-1/a" == apply(r, "amqp://host-1/a"));
+}
+
+TEST_CASE("transform_no_match") {
+  transform_ptr t(pn_transform());
+  CHECK("amqp://host/a" == apply(t, "amqp://host/a"));
+  CHECK(!pn_transform_matched(t));
+  CHECK("<null>" == apply(t, NULL));
+  pn_transform_rule(t, "amqp://host/*", "$1");
+  CHECK("amqp://other/a" == apply(t, "amqp://other/a"));
+  CHECK(!pn_transform_matched(t));
+  CHECK("amqp://hos" == apply(t, "amqp://hos"));
+  CHECK(!pn_transform_matched(t));
+  CHECK("a" == apply(t, "amqp://host/a"));
+  CHECK(pn_transform_matched(t));
+}
+
+/* Cached results are dropped when a rule is added */
+TEST_CASE("transform_cache") {
+  transform_ptr t(pn_transform());
+  pn_transform_rule(t, "amqp://other/*", "other/$1");
+  CHECK("amqp://host/a" == apply(t, "amqp://host/a"));
+  CHECK(!pn_transform_matched(t));
+  CHECK("other/a" == apply(t, "amqp://other/a"));
+  CHECK(pn_transform_matched(t));
+  /* Cached, including whether a rule matched */
+  CHECK("amqp://host/a" == apply(t, "amqp://host/a"));
+  CHECK(!pn_transform_matched(t));
+
+  pn_transform_rule(t, "amqp://host/*", "host/$1");
+  CHECK("host/a" == apply(t, "amqp://host/a"));
+  CHECK(pn_transform_matched(t));
+
+  /* An earlier rule still wins over a newer one for cached addresses */
+  pn_transform_rule(t, "amqp://*", "late/$1");
+  CHECK("other/a" == apply(t, "amqp://other/a"));
+  CHECK("late/x/a" == apply(t, "amqp://x/a"));
+
+  /* Evict every entry, least recently used first */
+  char address[64];
+  for (int i = 0; i < 1000; ++i) {
+    snprintf(address, sizeof(address), "amqp://host/%d", i);
+    CHECK(std::string("host/") + (address + 12) == apply(t, address));
+  }
+  for (int i = 999; i >= 0; --i) {
+    snprintf(address, sizeof(address), "amqp://host/%d", i);
+    CHECK(std::string("host/") + (address + 12) == apply(t, address));
+  }
+  CHECK("host/a" == apply(t, "amqp://host/a"));
+  pn_transform_rule(t, "amqp://host/a", "first");
+  CHECK("host/a" == apply(t, "amqp://host/a")); /* An earlier rule matches */
+}
@@ -0,0 +1,247 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+/*
+ * Connection storm benchmark for the proactor.
+ *
+ * Starts a listener served by a number of proactor threads, then opens many
+ * plain TCP connections to it at once from several client threads, as
+ * happens when clients reconnect after a broker restart. Reports how fast
+ * the proactor accepts the connections.
+ *
+ * The clients never send anything; they close their sockets once every
+ * connection has been accepted.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "proton/condition.h"
+#include "proton/listener.h"
+#include "proton/proactor.h"
+#include "proton/event.h"
+#include "proton/netaddr.h"
+#include "msgr-common.h"
+
+#include <netdb.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+static void usage(int rc)
+{
+    printf("Usage: connection-storm [OPTIONS] \n"
+           " -n # \tNumber of connections [1000]\n"
+           " -t # \tNumber of proactor threads [4]\n"
+           " -C # \tNumber of client threads opening connections [4]\n"
+           " -s # \tNumber of listening sockets sharing the port, see pn_listener_set_shards() [1]\n"
+           " -b # \tListen backlog [1024]\n"
+           );
+    exit(rc);
+}
+
+typedef struct {
+    int connections;
+    int client_threads;
+    pn_proactor_t *proactor;
+    pn_listener_t *listener;
+    char port[16];
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    bool listening;
+    int accepted;
+    int closed;
+    double start;
+    double connected;           /* time the last client connect() returned */
+    double all_accepted;        /* time the last connection was accepted */
+} storm_t;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *proactor_thread(void *arg)
+{
+    storm_t *s = (storm_t *) arg;
+    bool finished = false;
+    while (!finished) {
+        pn_event_batch_t *batch = pn_proactor_wait(s->proactor);
+        pn_event_t *e;
+        while ((e = pn_event_batch_next(batch))) {
+            switch (pn_event_type(e)) {
+            case PN_LISTENER_OPEN: {
+                char port[16];
+                const pn_netaddr_t *na = pn_listener_addr(pn_event_listener(e));
+                pn_netaddr_host_port(na, NULL, 0, port, sizeof(port));
+                pthread_mutex_lock(&s->lock);
+                strcpy(s->port, port);
+                s->listening = true;
+                pthread_cond_broadcast(&s->cond);
+                pthread_mutex_unlock(&s->lock);
+                break;
+            }
+            case PN_LISTENER_ACCEPT:
+                pn_listener_accept2(pn_event_listener(e), NULL, NULL);
+                pthread_mutex_lock(&s->lock);
+                if (++s->accepted == s->connections) {
+                    s->all_accepted = now();
+                    pthread_cond_broadcast(&s->cond);
+                }
+                pthread_mutex_unlock(&s->lock);
+                break;
+            case PN_TRANSPORT_CLOSED:
+                pthread_mutex_lock(&s->lock);
+                if (++s->closed == s->connections) pn_listener_close(s->listener);
+                pthread_mutex_unlock(&s->lock);
+                break;
+            case PN_LISTENER_CLOSE: {
+                pn_condition_t *cond = pn_listener_condition(pn_event_listener(e));
+                if (pn_condition_is_set(cond)) {
+                    fprintf(stderr, "listener error: %s\n", pn_condition_get_description(cond));
+                    exit(1);
+                }
+                pn_proactor_interrupt(s->proactor);
+                break;
+            }
+            case PN_PROACTOR_INTERRUPT:
+                pn_proactor_interrupt(s->proactor); /* Pass it on to the next thread */
+                finished = true;
+                break;
+            default:
+                break;
+            }
+        }
+        pn_proactor_done(s->proactor, batch);
+    }
+    return NULL;
+}
+
+static void *client_thread(void *arg)
+{
+    storm_t *s = (storm_t *) arg;
+    struct addrinfo hints, *ai = NULL;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    check(getaddrinfo("localhost", s->port, &hints, &ai) == 0, "cannot resolve localhost");
+
+    int n = s->connections / s->client_threads;
+    int *fds = (int *) malloc(n * sizeof(int));
+    for (int i = 0; i < n; ++i) {
+        fds[i] = socket(ai->ai_family, SOCK_STREAM, ai->ai_protocol);
+        check(fds[i] >= 0, "socket failed");
+        check(connect(fds[i], ai->ai_addr, ai->ai_addrlen) == 0, "connect failed");
+    }
+    freeaddrinfo(ai);
+
+    pthread_mutex_lock(&s->lock);
+    double t = now();
+    if (t > s->connected) s->connected = t;
+    while (s->accepted < s->connections)
+        pthread_cond_wait(&s->cond, &s->lock);
+    pthread_mutex_unlock(&s->lock);
+
+    for (int i = 0; i < n; ++i) close(fds[i]);
+    free(fds);
+    return NULL;
+}
+
+int main(int argc, char** argv)
+{
+    storm_t s;
+    memset(&s, 0, sizeof(s));
+    s.connections = 1000;
+    s.client_threads = 4;
+    int threads = 4;
+    int shards = 1;
+    int backlog = 1024;
+
+    int c;
+    while ((c = getopt(argc, argv, "n:t:C:s:b:h")) != -1) {
+        switch (c) {
+        case 'n': s.connections = atoi(optarg); break;
+        case 't': threads = atoi(optarg); break;
+        case 'C': s.client_threads = atoi(optarg); break;
+        case 's': shards = atoi(optarg); break;
+        case 'b': backlog = atoi(optarg); break;
+        case 'h': usage(0); break;
+        default: usage(1);
+        }
+    }
+    check(threads > 0 && s.client_threads > 0 && shards > 0, "counts must be positive");
+    s.connections -= s.connections % s.client_threads;
+    check(s.connections > 0, "need at least one connection per client thread");
+
+    /* Each connection needs a socket at both ends and a timer on the server */
+    struct rlimit rl;
+    getrlimit(RLIMIT_NOFILE, &rl);
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+    if (rl.rlim_cur < (rlim_t) 3 * s.connections + 100) {
+        fprintf(stderr, "file descriptor limit %lu is too low for %d connections\n",
+                (unsigned long) rl.rlim_cur, s.connections);
+        return 1;
+    }
+
+    pthread_mutex_init(&s.lock, NULL);
+    pthread_cond_init(&s.cond, NULL);
+    s.proactor = pn_proactor();
+    s.listener = pn_listener();
+    check(pn_listener_set_shards(s.listener, shards) == 0, "this proactor cannot listen on several sockets");
+    pn_proactor_listen(s.proactor, s.listener, "localhost:0", backlog);
+
+    pthread_t *server = (pthread_t *) malloc(threads * sizeof(pthread_t));
+    for (int i = 0; i < threads; ++i)
+        pthread_create(&server[i], NULL, proactor_thread, &s);
+
+    pthread_mutex_lock(&s.lock);
+    while (!s.listening) pthread_cond_wait(&s.cond, &s.lock);
+    s.start = now();
+    pthread_mutex_unlock(&s.lock);
+
+    pthread_t *clients = (pthread_t *) malloc(s.client_threads * sizeof(pthread_t));
+    for (int i = 0; i < s.client_threads; ++i)
+        pthread_create(&clients[i], NULL, client_thread, &s);
+    for (int i = 0; i < s.client_threads; ++i)
+        pthread_join(clients[i], NULL);
+    for (int i = 0; i < threads; ++i)
+        pthread_join(server[i], NULL);
+
+    double elapsed = s.all_accepted - s.start;
+    printf("%d connections, %d proactor threads, %d shard(s): "
+           "all accepted in %.3f sec, %.0f accepts/sec (clients connected in %.3f sec)\n",
+           s.connections, threads, shards, elapsed,
+           elapsed > 0 ? s.connections / elapsed : 0.0, s.connected - s.start);
+
+    pn_proactor_free(s.proactor);
+    pthread_mutex_destroy(&s.lock);
+    pthread_cond_destroy(&s.cond);
+    free(server);
+    free(clients);
+    return 0;
+}
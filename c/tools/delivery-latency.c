@@ -0,0 +1,307 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+/*
+ * Reports where the time goes between sending a delivery and the peer
+ * settling it, see pn_link_set_latency_tracking().
+ *
+ * A sender and a receiver connect to each other over loopback TCP in one
+ * proactor. The receiver accepts and settles each delivery as it arrives and
+ * replaces the credit it used, so -w deliveries are in flight at a time.
+ * Prints a latency histogram summary for each stage, and with -s the
+ * proactor's statistics, see pn_proactor_set_stats_enabled().
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "proton/condition.h"
+#include "proton/connection.h"
+#include "proton/delivery.h"
+#include "proton/event.h"
+#include "proton/link.h"
+#include "proton/listener.h"
+#include "proton/netaddr.h"
+#include "proton/proactor.h"
+#include "proton/session.h"
+#include "proton/transport.h"
+#include "msgr-common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+static void usage(int rc)
+{
+    printf("Usage: delivery-latency [OPTIONS] \n"
+           " -c # \tNumber of deliveries to send [100000]\n"
+           " -b # \tSize of delivery body in bytes [64]\n"
+           " -w # \tCredit window, the most deliveries in flight [100]\n"
+           " -n   \tDon't track latency, to measure the cost of tracking\n"
+           " -s   \tPrint proactor statistics\n"
+           );
+    exit(rc);
+}
+
+typedef struct {
+    int count;
+    int window;
+    size_t size;
+    bool track;
+    bool stats;
+    char *body;
+
+    pn_proactor_t *proactor;
+    pn_listener_t *listener;
+    pn_link_t *sender;
+    int sent;
+    int received;
+    int settled;
+    int closed;
+    double start;
+    double end;
+} app_t;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void send_deliveries(app_t *app, pn_link_t *sender)
+{
+    while (pn_link_credit(sender) > 0 && app->sent < app->count) {
+        pn_delivery(sender, pn_dtag((const char *) &app->sent, sizeof(app->sent)));
+        pn_link_send(sender, app->body, app->size);
+        pn_link_advance(sender);
+        ++app->sent;
+    }
+}
+
+static void print_histogram(const pn_histogram_t *h, const char *name)
+{
+    printf("%-8s %10" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %8" PRIu64 " %10.1f\n",
+           name, pn_histogram_count(h), pn_histogram_min(h),
+           pn_histogram_percentile(h, 50), pn_histogram_percentile(h, 90),
+           pn_histogram_percentile(h, 99), pn_histogram_percentile(h, 99.9),
+           pn_histogram_max(h), pn_histogram_mean(h));
+}
+
+static void print_stage(pn_link_t *sender, pn_latency_stage_t stage, const char *name)
+{
+    print_histogram(pn_link_latency(sender, stage), name);
+}
+
+static void print_distribution(pn_proactor_t *p, pn_proactor_distribution_t d, pn_histogram_t *h, const char *name)
+{
+    pn_proactor_stats_distribution(p, -1, d, h);
+    print_histogram(h, name);
+}
+
+static void report_stats(app_t *app)
+{
+    pn_proactor_stats_t s;
+    pn_proactor_stats(app->proactor, -1, &s);
+    printf("\nproactor: %" PRIu64 " polls, %" PRIu64 " batches, %" PRIu64 " events, %" PRIu64 " wakes, "
+           "%" PRIu64 " hog limits, %" PRIu64 " rearms\n",
+           s.polls, s.batches, s.events, s.wakes, s.hog_limits, s.rearms);
+    printf("lock taken %" PRIu64 " times, held %.3f msec, busy %.3f msec, idle %.3f msec, utilisation %.1f%%\n",
+           s.locks, s.lock_held_ns / 1e6, s.busy_ns / 1e6, s.idle_ns / 1e6,
+           s.busy_ns + s.idle_ns ? 100.0 * s.busy_ns / (s.busy_ns + s.idle_ns) : 0.0);
+    printf("\n%-8s %10s %8s %8s %8s %8s %8s %8s %10s\n",
+           "", "count", "min", "p50", "p90", "p99", "p99.9", "max", "mean");
+    pn_histogram_t *h = pn_histogram();
+    print_distribution(app->proactor, PN_PROACTOR_BATCH_EVENTS, h, "events");
+    print_distribution(app->proactor, PN_PROACTOR_WAKE_LATENCY, h, "wake us");
+    print_distribution(app->proactor, PN_PROACTOR_LOCK_HELD, h, "lock ns");
+    pn_histogram_free(h);
+}
+
+static void report(app_t *app)
+{
+    double elapsed = app->end - app->start;
+    printf("%d deliveries of %zu bytes, window %d: %.3f sec, %.0f deliveries/sec\n",
+           app->count, app->size, app->window, elapsed,
+           elapsed > 0 ? app->count / elapsed : 0.0);
+    if (app->stats) report_stats(app);
+    if (!app->track) return;
+    printf("\n%-8s %10s %8s %8s %8s %8s %8s %8s %10s  (microseconds)\n",
+           "stage", "count", "min", "p50", "p90", "p99", "p99.9", "max", "mean");
+    print_stage(app->sender, PN_LATENCY_QUEUED, "queued");
+    print_stage(app->sender, PN_LATENCY_WRITTEN, "written");
+    print_stage(app->sender, PN_LATENCY_SETTLED, "settled");
+    print_stage(app->sender, PN_LATENCY_TOTAL, "total");
+}
+
+static void connect_sender(app_t *app)
+{
+    char port[16];
+    char addr[PN_MAX_ADDR];
+    pn_netaddr_host_port(pn_listener_addr(app->listener), NULL, 0, port, sizeof(port));
+    pn_proactor_addr(addr, sizeof(addr), "localhost", port);
+
+    pn_connection_t *c = pn_connection();
+    pn_connection_open(c);
+    pn_session_t *ssn = pn_session(c);
+    pn_session_open(ssn);
+    app->sender = pn_sender(ssn, "latency");
+    pn_link_set_latency_tracking(app->sender, app->track);
+    pn_link_open(app->sender);
+    pn_proactor_connect2(app->proactor, c, NULL, addr);
+}
+
+static void receive(app_t *app, pn_delivery_t *d)
+{
+    if (pn_delivery_partial(d)) return;
+    pn_link_t *receiver = pn_delivery_link(d);
+    char buf[4096];
+    while (pn_link_recv(receiver, buf, sizeof(buf)) > 0)
+        ;
+    pn_link_advance(receiver);
+    pn_delivery_update(d, PN_ACCEPTED);
+    pn_delivery_settle(d);
+    pn_link_flow(receiver, 1);
+    ++app->received;
+}
+
+/* Return true when all is done */
+static bool handle(app_t *app, pn_event_t *e)
+{
+    switch (pn_event_type(e)) {
+    case PN_LISTENER_OPEN:
+        connect_sender(app);
+        app->start = now();
+        break;
+
+    case PN_LISTENER_ACCEPT:
+        pn_listener_accept2(pn_event_listener(e), NULL, NULL);
+        break;
+
+    case PN_CONNECTION_REMOTE_OPEN: {
+        pn_connection_t *c = pn_event_connection(e);
+        if (pn_connection_state(c) & PN_LOCAL_UNINIT) pn_connection_open(c);
+        break;
+    }
+    case PN_SESSION_REMOTE_OPEN: {
+        pn_session_t *ssn = pn_event_session(e);
+        if (pn_session_state(ssn) & PN_LOCAL_UNINIT) pn_session_open(ssn);
+        break;
+    }
+    case PN_LINK_REMOTE_OPEN: {
+        pn_link_t *link = pn_event_link(e);
+        if (pn_link_state(link) & PN_LOCAL_UNINIT) {
+            pn_terminus_copy(pn_link_target(link), pn_link_remote_target(link));
+            pn_link_open(link);
+            pn_link_flow(link, app->window);
+        }
+        break;
+    }
+    case PN_LINK_FLOW: {
+        pn_link_t *link = pn_event_link(e);
+        if (pn_link_is_sender(link)) send_deliveries(app, link);
+        break;
+    }
+    case PN_DELIVERY: {
+        pn_delivery_t *d = pn_event_delivery(e);
+        if (pn_link_is_receiver(pn_delivery_link(d))) {
+            receive(app, d);
+        } else if (pn_delivery_remote_state(d) && pn_delivery_settled(d)) {
+            pn_delivery_settle(d);
+            if (++app->settled == app->count) {
+                app->end = now();
+                report(app);
+                pn_connection_close(pn_event_connection(e));
+            }
+        }
+        break;
+    }
+    case PN_CONNECTION_REMOTE_CLOSE: {
+        pn_connection_t *c = pn_event_connection(e);
+        if (!(pn_connection_state(c) & PN_LOCAL_CLOSED)) pn_connection_close(c);
+        break;
+    }
+    case PN_TRANSPORT_CLOSED: {
+        pn_condition_t *cond = pn_transport_condition(pn_event_transport(e));
+        if (app->settled < app->count && pn_condition_is_set(cond)) {
+            fprintf(stderr, "connection error: %s\n", pn_condition_get_description(cond));
+            exit(1);
+        }
+        if (++app->closed == 2) pn_listener_close(app->listener);
+        break;
+    }
+    case PN_LISTENER_CLOSE: {
+        pn_condition_t *cond = pn_listener_condition(pn_event_listener(e));
+        if (pn_condition_is_set(cond)) {
+            fprintf(stderr, "listener error: %s\n", pn_condition_get_description(cond));
+            exit(1);
+        }
+        return true;
+    }
+    default:
+        break;
+    }
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    app_t app;
+    memset(&app, 0, sizeof(app));
+    app.count = 100000;
+    app.size = 64;
+    app.window = 100;
+    app.track = true;
+
+    int c;
+    while ((c = getopt(argc, argv, "c:b:w:nsh")) != -1) {
+        switch (c) {
+        case 'c': app.count = atoi(optarg); break;
+        case 'b': app.size = atoi(optarg); break;
+        case 'w': app.window = atoi(optarg); break;
+        case 'n': app.track = false; break;
+        case 's': app.stats = true; break;
+        case 'h': usage(0); break;
+        default: usage(1);
+        }
+    }
+    check(app.count > 0 && app.window > 0 && app.size > 0, "counts must be positive");
+
+    app.body = (char *) calloc(app.size, 1);
+    app.proactor = pn_proactor();
+    pn_proactor_set_stats_enabled(app.proactor, app.stats);
+    app.listener = pn_listener();
+    pn_proactor_listen(app.proactor, app.listener, "localhost:0", 16);
+
+    bool finished = false;
+    while (!finished) {
+        pn_event_batch_t *batch = pn_proactor_wait(app.proactor);
+        pn_event_t *e;
+        while (!finished && (e = pn_event_batch_next(batch))) {
+            finished = handle(&app, e);
+        }
+        pn_proactor_done(app.proactor, batch);
+    }
+
+    pn_proactor_free(app.proactor);
+    free(app.body);
+    return 0;
+}
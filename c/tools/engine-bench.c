@@ -0,0 +1,314 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+/*
+ * Engine-only benchmark using a pair of connection drivers.
+ *
+ * A client and a server pn_connection_driver_t are connected back to back in
+ * memory, so the results cover message encoding and decoding, AMQP framing,
+ * flow control and settlement without any socket I/O. The client sends on a
+ * number of links in turn and the server receives, decodes and settles.
+ *
+ * Reports overall throughput, the time spent encoding and decoding messages
+ * versus in the engine, and a histogram of the time from encoding a message
+ * to the server decoding it.
+ */
+
+#include "proton/connection.h"
+#include "proton/connection_driver.h"
+#include "proton/delivery.h"
+#include "proton/event.h"
+#include "proton/link.h"
+#include "proton/message.h"
+#include "proton/session.h"
+#include "proton/transport.h"
+#include "engine-common.h"
+#include "msgr-common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define HISTOGRAM_BUCKETS 32    /* bucket i counts latencies in [2^i, 2^(i+1)) usec */
+
+static void usage(int rc)
+{
+    printf("Usage: engine-bench [OPTIONS] \n"
+           " -c # \tNumber of messages to send [1000000]\n"
+           " -b # \tSize of message body in bytes [64]\n"
+           " -l # \tNumber of links, messages are sent on each in turn [1]\n"
+           " -w # \tCredit window per link [100]\n"
+           " -u   \tSend unsettled, the receiver accepts and settles each message\n"
+           " -H   \tPrint the full latency histogram\n"
+           );
+    exit(rc);
+}
+
+typedef struct {
+    /* Options */
+    uint64_t count;
+    size_t size;
+    int links;
+    int window;
+    bool presettled;
+
+    /* Client state */
+    pn_message_t *out;
+    char *out_buf;
+    size_t out_size;
+    uint64_t sent;
+    uint64_t settled;
+    uint64_t encode_ns;
+
+    /* Server state */
+    pn_message_t *in;
+    char *in_buf;
+    size_t in_size;
+    uint64_t received;
+    uint64_t decode_ns;
+    uint64_t latency[HISTOGRAM_BUCKETS];
+    uint64_t latency_max;
+} bench_t;
+
+static void grow(char **buf, size_t *size, size_t needed)
+{
+    if (*size < needed) {
+        while (*size < needed) *size *= 2;
+        *buf = (char *) realloc(*buf, *size);
+        check(*buf, "out of memory");
+    }
+}
+
+static void send_messages(bench_t *b, pn_link_t *sender)
+{
+    while (pn_link_credit(sender) > 0 && b->sent < b->count) {
+        uint64_t start = engine_now_ns();
+        pn_atom_t id;
+        id.type = PN_ULONG;
+        id.u.as_ulong = start;  /* the server measures latency from this */
+        pn_message_set_id(b->out, id);
+        size_t size;
+        int err;
+        while (size = b->out_size, (err = pn_message_encode(b->out, b->out_buf, &size)) == PN_OVERFLOW)
+            grow(&b->out_buf, &b->out_size, b->out_size * 2);
+        check(err == 0, "message encode failed");
+        b->encode_ns += engine_now_ns() - start;
+
+        pn_delivery_t *d = pn_delivery(sender, pn_dtag((const char *) &b->sent, sizeof(b->sent)));
+        pn_link_send(sender, b->out_buf, size);
+        pn_link_advance(sender);
+        if (b->presettled) {
+            pn_delivery_settle(d);
+            ++b->settled;
+        }
+        ++b->sent;
+    }
+}
+
+static void client_event(bench_t *b, pn_event_t *e)
+{
+    switch (pn_event_type(e)) {
+    case PN_CONNECTION_INIT: {
+        pn_connection_t *c = pn_event_connection(e);
+        pn_connection_set_container(c, "engine-bench-client");
+        pn_connection_open(c);
+        pn_session_t *ssn = pn_session(c);
+        pn_session_open(ssn);
+        for (int i = 0; i < b->links; ++i) {
+            char name[32];
+            snprintf(name, sizeof(name), "link-%d", i);
+            pn_link_t *l = pn_sender(ssn, name);
+            if (b->presettled) pn_link_set_snd_settle_mode(l, PN_SND_SETTLED);
+            pn_link_open(l);
+        }
+        break;
+    }
+    case PN_LINK_FLOW:
+        send_messages(b, pn_event_link(e));
+        break;
+    case PN_DELIVERY: {
+        pn_delivery_t *d = pn_event_delivery(e);
+        if (pn_delivery_remote_state(d) == PN_ACCEPTED) {
+            pn_delivery_settle(d);
+            ++b->settled;
+        } else if (pn_delivery_remote_state(d)) {
+            msgr_die(__FILE__, __LINE__, "message not accepted");
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static void record_latency(bench_t *b, uint64_t ns)
+{
+    uint64_t usec = ns / 1000;
+    int i = 0;
+    while (usec > 1 && i < HISTOGRAM_BUCKETS - 1) {
+        usec >>= 1;
+        ++i;
+    }
+    ++b->latency[i];
+    if (ns > b->latency_max) b->latency_max = ns;
+}
+
+static void server_event(bench_t *b, pn_event_t *e)
+{
+    switch (pn_event_type(e)) {
+    case PN_CONNECTION_REMOTE_OPEN:
+        pn_connection_open(pn_event_connection(e));
+        break;
+    case PN_SESSION_REMOTE_OPEN:
+        pn_session_open(pn_event_session(e));
+        break;
+    case PN_LINK_REMOTE_OPEN: {
+        pn_link_t *l = pn_event_link(e);
+        pn_link_open(l);
+        pn_link_flow(l, b->window);
+        break;
+    }
+    case PN_DELIVERY: {
+        pn_delivery_t *d = pn_event_delivery(e);
+        pn_link_t *l = pn_delivery_link(d);
+        if (!pn_delivery_readable(d) || pn_delivery_partial(d)) break;
+        size_t size = pn_delivery_pending(d);
+        grow(&b->in_buf, &b->in_size, size);
+        check(pn_link_recv(l, b->in_buf, size) == (ssize_t) size, "receive failed");
+        pn_link_advance(l);
+
+        uint64_t start = engine_now_ns();
+        check(pn_message_decode(b->in, b->in_buf, size) == 0, "message decode failed");
+        uint64_t end = engine_now_ns();
+        b->decode_ns += end - start;
+        record_latency(b, end - pn_message_get_id(b->in).u.as_ulong);
+
+        if (!b->presettled) pn_delivery_update(d, PN_ACCEPTED);
+        pn_delivery_settle(d);
+        ++b->received;
+        if (pn_link_credit(l) <= b->window / 2)
+            pn_link_flow(l, b->window - pn_link_credit(l));
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+static uint64_t percentile(bench_t *b, double p)
+{
+    uint64_t target = (uint64_t)(b->received * p);
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+        seen += b->latency[i];
+        if (seen > target) return (uint64_t) 2 << i;  /* upper bound of bucket */
+    }
+    return b->latency_max / 1000;
+}
+
+int main(int argc, char** argv)
+{
+    bench_t b;
+    memset(&b, 0, sizeof(b));
+    b.count = 1000000;
+    b.size = 64;
+    b.links = 1;
+    b.window = 100;
+    b.presettled = true;
+    bool histogram = false;
+
+    int c;
+    while ((c = getopt(argc, argv, "c:b:l:w:uHh")) != -1) {
+        switch (c) {
+        case 'c': b.count = strtoull(optarg, NULL, 10); break;
+        case 'b': b.size = strtoul(optarg, NULL, 10); break;
+        case 'l': b.links = atoi(optarg); break;
+        case 'w': b.window = atoi(optarg); break;
+        case 'u': b.presettled = false; break;
+        case 'H': histogram = true; break;
+        case 'h': usage(0); break;
+        default: usage(1);
+        }
+    }
+    check(b.links > 0, "need at least one link");
+    check(b.window > 0, "window must be positive");
+
+    b.out = pn_message();
+    b.in = pn_message();
+    char *body = (char *) calloc(b.size ? b.size : 1, 1);
+    pn_data_put_binary(pn_message_body(b.out), pn_bytes(b.size, body));
+    free(body);
+    b.out_size = b.in_size = b.size + 128;
+    b.out_buf = (char *) malloc(b.out_size);
+    b.in_buf = (char *) malloc(b.in_size);
+
+    pn_connection_driver_t client, server;
+    check(pn_connection_driver_init(&client, NULL, NULL) == 0, "client init failed");
+    check(pn_connection_driver_init(&server, NULL, NULL) == 0, "server init failed");
+    pn_transport_set_server(server.transport);
+
+    uint64_t start = engine_now_ns();
+    clock_t cpu_start = clock();
+    while (b.received < b.count || b.settled < b.count) {
+        pn_event_t *e;
+        bool busy = false;
+        while ((e = pn_connection_driver_next_event(&client))) {
+            client_event(&b, e);
+            busy = true;
+        }
+        while ((e = pn_connection_driver_next_event(&server))) {
+            server_event(&b, e);
+            busy = true;
+        }
+        busy = engine_driver_exchange(&client, &server) || busy;
+        check(busy, "no progress");
+    }
+    double cpu = (double)(clock() - cpu_start) / CLOCKS_PER_SEC;
+    double elapsed = (engine_now_ns() - start) / 1e9;
+
+    printf("%" PRIu64 " messages of %u bytes on %d link(s), %s, window %d\n",
+           b.count, (unsigned) b.size, b.links,
+           b.presettled ? "presettled" : "unsettled", b.window);
+    printf("throughput: %.0f msgs/sec, %.3f usec CPU/msg\n",
+           elapsed > 0 ? b.count / elapsed : 0.0, cpu * 1e6 / b.count);
+    double total_ns = elapsed * 1e9;
+    printf("time: encode %.1f%%, decode %.1f%%, engine and framing %.1f%%\n",
+           100.0 * b.encode_ns / total_ns, 100.0 * b.decode_ns / total_ns,
+           100.0 * (total_ns - b.encode_ns - b.decode_ns) / total_ns);
+    printf("latency (usec): p50 < %" PRIu64 ", p90 < %" PRIu64 ", p99 < %" PRIu64
+           ", p99.9 < %" PRIu64 ", max %.1f\n",
+           percentile(&b, 0.5), percentile(&b, 0.9), percentile(&b, 0.99),
+           percentile(&b, 0.999), b.latency_max / 1000.0);
+    if (histogram) {
+        for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+            if (b.latency[i])
+                printf("  < %10" PRIu64 " usec: %" PRIu64 "\n", (uint64_t) 2 << i, b.latency[i]);
+        }
+    }
+
+    pn_connection_driver_destroy(&client);
+    pn_connection_driver_destroy(&server);
+    pn_message_free(b.out);
+    pn_message_free(b.in);
+    free(b.out_buf);
+    free(b.in_buf);
+    return 0;
+}
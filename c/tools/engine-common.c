@@ -0,0 +1,76 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L  /* for clock_gettime */
+#endif
+
+#include "engine-common.h"
+#include "msgr-common.h"
+
+#include <string.h>
+#include <time.h>
+
+uint64_t engine_now_ns(void)
+{
+#if defined(_WIN32)
+    return (uint64_t) msgr_now() * 1000000;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+size_t engine_xfer(pn_transport_t *src, pn_transport_t *dest)
+{
+    ssize_t out = pn_transport_pending(src);
+    ssize_t in = pn_transport_capacity(dest);
+    if (out > 0 && in > 0) {
+        size_t count = (size_t)((out < in) ? out : in);
+        pn_transport_push(dest, pn_transport_head(src), count);
+        pn_transport_pop(src, count);
+        return count;
+    }
+    return 0;
+}
+
+void engine_pump(pn_transport_t *t1, pn_transport_t *t2)
+{
+    while (engine_xfer(t1, t2) + engine_xfer(t2, t1))
+        ;
+}
+
+size_t engine_driver_xfer(pn_connection_driver_t *src, pn_connection_driver_t *dest)
+{
+    pn_bytes_t wb = pn_connection_driver_write_buffer(src);
+    pn_rwbytes_t rb = pn_connection_driver_read_buffer(dest);
+    size_t size = rb.size < wb.size ? rb.size : wb.size;
+    if (size) {
+        memcpy(rb.start, wb.start, size);
+        pn_connection_driver_write_done(src, size);
+        pn_connection_driver_read_done(dest, size);
+    }
+    return size;
+}
+
+size_t engine_driver_exchange(pn_connection_driver_t *d1, pn_connection_driver_t *d2)
+{
+    return engine_driver_xfer(d1, d2) + engine_driver_xfer(d2, d1);
+}
@@ -0,0 +1,49 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+#ifndef ENGINE_COMMON_H
+#define ENGINE_COMMON_H
+
+/*
+ * Helpers for the tools that run the engine over connections joined in
+ * memory, so no I/O is involved.
+ */
+
+#include "proton/connection_driver.h"
+#include "proton/transport.h"
+#include "proton/types.h"
+
+#include <stddef.h>
+
+/* Monotonic time in nanoseconds */
+uint64_t engine_now_ns(void);
+
+/* Move pending output of src to the input of dest, return bytes moved */
+size_t engine_xfer(pn_transport_t *src, pn_transport_t *dest);
+
+/* Move data both ways till both transports are idle */
+void engine_pump(pn_transport_t *t1, pn_transport_t *t2);
+
+/* Move output of the src driver to the input of dest, return bytes moved */
+size_t engine_driver_xfer(pn_connection_driver_t *src, pn_connection_driver_t *dest);
+
+/* Move output of each driver to the other once, return bytes moved */
+size_t engine_driver_exchange(pn_connection_driver_t *d1, pn_connection_driver_t *d2);
+
+#endif
@@ -0,0 +1,369 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+/*
+ * Topic fan-out benchmark using connection drivers.
+ *
+ * One producer sends to a broker, which delivers every message to each of a
+ * number of consumer links spread over several connections, as the brokers in
+ * the examples would if their queues were topics. All connections are
+ * connection driver pairs joined back to back in memory, so there is no socket
+ * I/O.
+ *
+ * By default the broker sends each message to a subscriber with
+ * pn_link_send(), which copies it into every delivery. With -s it makes one
+ * pn_shared_bytes_t of the message and uses pn_link_send_shared(), so every
+ * delivery and the transports refer to the same bytes.
+ *
+ * The broker only gives the producer credit while every subscriber has credit,
+ * so the slowest consumer sets the pace.
+ */
+
+#include "proton/connection.h"
+#include "proton/connection_driver.h"
+#include "proton/delivery.h"
+#include "proton/event.h"
+#include "proton/link.h"
+#include "proton/message.h"
+#include "proton/session.h"
+#include "proton/shared_bytes.h"
+#include "proton/transport.h"
+#include "engine-common.h"
+#include "msgr-common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static void usage(int rc)
+{
+    printf("Usage: fanout-bench [OPTIONS] \n"
+           " -c # \tNumber of messages to publish [10000]\n"
+           " -b # \tSize of message body in bytes [1024]\n"
+           " -n # \tNumber of consumers [1000]\n"
+           " -C # \tNumber of consumer connections, consumers are spread over them [10]\n"
+           " -w # \tCredit window per consumer [100]\n"
+           " -s   \tShare one copy of each message between all deliveries\n"
+           );
+    exit(rc);
+}
+
+typedef struct {
+    /* Options */
+    uint64_t count;
+    size_t size;
+    int consumers;
+    int connections;
+    int window;
+    bool share;
+
+    /* Producer state */
+    char *out_buf;
+    size_t out_size;
+    pn_link_t *producer;
+    uint64_t published;
+
+    /* Broker state */
+    pn_link_t *receiver;
+    pn_link_t **subscribers;
+    int subscribed;
+    char *in_buf;
+    size_t in_size;
+    uint64_t forwarded;
+    uint64_t fanout_ns;
+
+    /* Consumer state */
+    char *recv_buf;
+    size_t recv_size;
+    uint64_t received;
+} bench_t;
+
+static void grow(char **buf, size_t *size, size_t needed)
+{
+    if (*size < needed) {
+        while (*size < needed) *size *= 2;
+        *buf = (char *) realloc(*buf, *size);
+        check(*buf, "out of memory");
+    }
+}
+
+static void publish(bench_t *b)
+{
+    pn_link_t *l = b->producer;
+    while (l && pn_link_credit(l) > 0 && b->published < b->count) {
+        pn_delivery_t *d = pn_delivery(l, pn_dtag((const char *) &b->published, sizeof(b->published)));
+        pn_link_send(l, b->out_buf, b->out_size);
+        pn_link_advance(l);
+        pn_delivery_settle(d);
+        ++b->published;
+    }
+}
+
+static void producer_event(bench_t *b, pn_event_t *e)
+{
+    switch (pn_event_type(e)) {
+    case PN_CONNECTION_INIT: {
+        pn_connection_t *c = pn_event_connection(e);
+        pn_connection_set_container(c, "fanout-bench-producer");
+        pn_connection_open(c);
+        pn_session_t *ssn = pn_session(c);
+        pn_session_open(ssn);
+        b->producer = pn_sender(ssn, "producer");
+        pn_link_set_snd_settle_mode(b->producer, PN_SND_SETTLED);
+        pn_terminus_set_address(pn_link_target(b->producer), "topic");
+        pn_link_open(b->producer);
+        break;
+    }
+    case PN_LINK_FLOW:
+        publish(b);
+        break;
+    default:
+        break;
+    }
+}
+
+/* Give the producer one credit if every subscriber can take another message */
+static void broker_flow(bench_t *b, pn_link_t *receiver)
+{
+    if (!receiver || b->subscribed < b->consumers) return;
+    if (pn_link_credit(receiver) > 0) return;
+    for (int i = 0; i < b->subscribed; ++i) {
+        if (pn_link_credit(b->subscribers[i]) <= 0) return;
+    }
+    pn_link_flow(receiver, 1);
+}
+
+static void forward(bench_t *b, const char *bytes, size_t size)
+{
+    uint64_t start = engine_now_ns();
+    pn_shared_bytes_t *shared = b->share ? pn_shared_bytes(bytes, size) : NULL;
+    for (int i = 0; i < b->subscribed; ++i) {
+        pn_link_t *l = b->subscribers[i];
+        pn_delivery_t *d = pn_delivery(l, pn_dtag((const char *) &b->forwarded, sizeof(b->forwarded)));
+        if (shared) {
+            pn_link_send_shared(l, shared);
+        } else {
+            pn_link_send(l, bytes, size);
+        }
+        pn_link_advance(l);
+        pn_delivery_settle(d);
+        ++b->forwarded;
+    }
+    pn_shared_bytes_decref(shared);
+    b->fanout_ns += engine_now_ns() - start;
+}
+
+static void broker_event(bench_t *b, pn_event_t *e)
+{
+    switch (pn_event_type(e)) {
+    case PN_CONNECTION_REMOTE_OPEN:
+        pn_connection_open(pn_event_connection(e));
+        break;
+    case PN_SESSION_REMOTE_OPEN:
+        pn_session_open(pn_event_session(e));
+        break;
+    case PN_LINK_REMOTE_OPEN: {
+        pn_link_t *l = pn_event_link(e);
+        pn_terminus_copy(pn_link_source(l), pn_link_remote_source(l));
+        pn_terminus_copy(pn_link_target(l), pn_link_remote_target(l));
+        if (pn_link_is_sender(l)) {
+            pn_link_set_snd_settle_mode(l, PN_SND_SETTLED);
+            b->subscribers[b->subscribed++] = l;
+        } else {
+            b->receiver = l;
+        }
+        pn_link_open(l);
+        broker_flow(b, b->receiver);
+        break;
+    }
+    case PN_LINK_FLOW:
+        if (pn_link_is_sender(pn_event_link(e))) broker_flow(b, b->receiver);
+        break;
+    case PN_DELIVERY: {
+        pn_delivery_t *d = pn_event_delivery(e);
+        pn_link_t *l = pn_delivery_link(d);
+        if (!pn_link_is_receiver(l) || !pn_delivery_readable(d) || pn_delivery_partial(d)) break;
+        size_t size = pn_delivery_pending(d);
+        grow(&b->in_buf, &b->in_size, size);
+        check(pn_link_recv(l, b->in_buf, size) == (ssize_t) size, "receive failed");
+        pn_link_advance(l);
+        pn_delivery_settle(d);
+        forward(b, b->in_buf, size);
+        broker_flow(b, l);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+typedef struct {
+    bench_t *bench;
+    int links;
+} consumer_t;
+
+static void consumer_event(consumer_t *c, pn_event_t *e)
+{
+    bench_t *b = c->bench;
+    switch (pn_event_type(e)) {
+    case PN_CONNECTION_INIT: {
+        pn_connection_t *conn = pn_event_connection(e);
+        pn_connection_set_container(conn, "fanout-bench-consumer");
+        pn_connection_open(conn);
+        pn_session_t *ssn = pn_session(conn);
+        pn_session_open(ssn);
+        for (int i = 0; i < c->links; ++i) {
+            char name[32];
+            snprintf(name, sizeof(name), "consumer-%d", i);
+            pn_link_t *l = pn_receiver(ssn, name);
+            pn_terminus_set_address(pn_link_source(l), "topic");
+            pn_link_open(l);
+            pn_link_flow(l, b->window);
+        }
+        break;
+    }
+    case PN_DELIVERY: {
+        pn_delivery_t *d = pn_event_delivery(e);
+        pn_link_t *l = pn_delivery_link(d);
+        if (!pn_delivery_readable(d) || pn_delivery_partial(d)) break;
+        size_t size = pn_delivery_pending(d);
+        grow(&b->recv_buf, &b->recv_size, size);
+        check(pn_link_recv(l, b->recv_buf, size) == (ssize_t) size, "receive failed");
+        pn_link_advance(l);
+        pn_delivery_settle(d);
+        ++b->received;
+        if (pn_link_credit(l) <= b->window / 2)
+            pn_link_flow(l, b->window - pn_link_credit(l));
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bench_t b;
+    memset(&b, 0, sizeof(b));
+    b.count = 10000;
+    b.size = 1024;
+    b.consumers = 1000;
+    b.connections = 10;
+    b.window = 100;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:b:n:C:w:sh")) != -1) {
+        switch (opt) {
+        case 'c': b.count = strtoull(optarg, NULL, 10); break;
+        case 'b': b.size = strtoul(optarg, NULL, 10); break;
+        case 'n': b.consumers = atoi(optarg); break;
+        case 'C': b.connections = atoi(optarg); break;
+        case 'w': b.window = atoi(optarg); break;
+        case 's': b.share = true; break;
+        case 'h': usage(0); break;
+        default: usage(1);
+        }
+    }
+    check(b.consumers > 0 && b.connections > 0 && b.window > 0, "counts must be positive");
+    if (b.connections > b.consumers) b.connections = b.consumers;
+
+    /* Encode the message once, the producer's cost is not what is measured */
+    pn_message_t *m = pn_message();
+    char *body = (char *) calloc(b.size ? b.size : 1, 1);
+    pn_data_put_binary(pn_message_body(m), pn_bytes(b.size, body));
+    free(body);
+    pn_rwbytes_t encoded = { 0 };
+    ssize_t encoded_size = pn_message_encode2(m, &encoded);
+    check(encoded_size > 0, "message encode failed");
+    pn_message_free(m);
+    b.out_buf = encoded.start;
+    b.out_size = encoded_size;
+    b.in_size = b.recv_size = encoded_size;
+    b.in_buf = (char *) malloc(b.in_size);
+    b.recv_buf = (char *) malloc(b.recv_size);
+    b.subscribers = (pn_link_t **) calloc(b.consumers, sizeof(pn_link_t *));
+
+    /* Driver pairs: index 0 is the producer, the rest are consumer connections */
+    int pairs = 1 + b.connections;
+    pn_connection_driver_t *clients = (pn_connection_driver_t *) calloc(pairs, sizeof(pn_connection_driver_t));
+    pn_connection_driver_t *brokers = (pn_connection_driver_t *) calloc(pairs, sizeof(pn_connection_driver_t));
+    consumer_t *consumers = (consumer_t *) calloc(pairs, sizeof(consumer_t));
+    check(b.in_buf && b.recv_buf && b.subscribers && clients && brokers && consumers, "out of memory");
+    for (int i = 0; i < pairs; ++i) {
+        check(pn_connection_driver_init(&clients[i], NULL, NULL) == 0, "client init failed");
+        check(pn_connection_driver_init(&brokers[i], NULL, NULL) == 0, "broker init failed");
+        pn_transport_set_server(brokers[i].transport);
+        if (i > 0) {
+            consumers[i].bench = &b;
+            consumers[i].links = b.consumers / b.connections + (i <= b.consumers % b.connections);
+        }
+    }
+
+    uint64_t total = b.count * b.consumers;
+    uint64_t start = engine_now_ns();
+    clock_t cpu_start = clock();
+    while (b.received < total) {
+        bool busy = false;
+        for (int i = 0; i < pairs; ++i) {
+            pn_event_t *e;
+            while ((e = pn_connection_driver_next_event(&clients[i]))) {
+                if (i == 0) {
+                    producer_event(&b, e);
+                } else {
+                    consumer_event(&consumers[i], e);
+                }
+                busy = true;
+            }
+            while ((e = pn_connection_driver_next_event(&brokers[i]))) {
+                broker_event(&b, e);
+                busy = true;
+            }
+        }
+        for (int i = 0; i < pairs; ++i) {
+            busy = engine_driver_exchange(&clients[i], &brokers[i]) || busy;
+        }
+        check(busy, "no progress");
+    }
+    double cpu = (double)(clock() - cpu_start) / CLOCKS_PER_SEC;
+    double elapsed = (engine_now_ns() - start) / 1e9;
+
+    printf("%" PRIu64 " messages of %u bytes to %d consumers on %d connection(s), %s\n",
+           b.count, (unsigned) b.out_size, b.consumers, b.connections,
+           b.share ? "shared" : "copied");
+    printf("throughput: %.0f msgs/sec in, %.0f deliveries/sec out, %.3f usec CPU/delivery\n",
+           elapsed > 0 ? b.count / elapsed : 0.0, elapsed > 0 ? total / elapsed : 0.0,
+           cpu * 1e6 / total);
+    printf("broker fan-out: %.1f nsec/delivery, %.1f%% of the time\n",
+           (double) b.fanout_ns / b.forwarded, 100.0 * b.fanout_ns / (elapsed * 1e9));
+
+    for (int i = 0; i < pairs; ++i) {
+        pn_connection_driver_destroy(&clients[i]);
+        pn_connection_driver_destroy(&brokers[i]);
+    }
+    free(consumers);
+    free(brokers);
+    free(clients);
+    free(b.subscribers);
+    free(b.recv_buf);
+    free(b.in_buf);
+    free(b.out_buf);
+    return 0;
+}
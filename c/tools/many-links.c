@@ -0,0 +1,146 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+/*
+ * Measures the per-message cost of the engine when a connection has many
+ * links but messages are only sent on one of them.
+ *
+ * Two connections are bound to transports that are connected in memory, so
+ * no I/O is involved. Ideally the cost per message does not depend on the
+ * number of links.
+ */
+
+#include "proton/connection.h"
+#include "proton/delivery.h"
+#include "proton/link.h"
+#include "proton/session.h"
+#include "proton/transport.h"
+#include "engine-common.h"
+#include "msgr-common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static void usage(int rc)
+{
+    printf("Usage: many-links [OPTIONS] \n"
+           " -l # \tNumber of links on the connection [10000]\n"
+           " -c # \tNumber of messages to send on the first link [100000]\n"
+           " -b # \tSize of message body in bytes [64]\n"
+           );
+    exit(rc);
+}
+
+/* Open everything the peer opened */
+static void open_remote(pn_connection_t *c)
+{
+    pn_session_t *ssn = pn_session_head(c, PN_LOCAL_UNINIT);
+    for (; ssn; ssn = pn_session_next(ssn, PN_LOCAL_UNINIT))
+        pn_session_open(ssn);
+    pn_link_t *link = pn_link_head(c, PN_LOCAL_UNINIT);
+    for (; link; link = pn_link_next(link, PN_LOCAL_UNINIT))
+        pn_link_open(link);
+}
+
+int main(int argc, char** argv)
+{
+    int links = 10000;
+    uint64_t count = 100000;
+    size_t size = 64;
+
+    int c;
+    while ((c = getopt(argc, argv, "l:c:b:h")) != -1) {
+        switch (c) {
+        case 'l': links = atoi(optarg); break;
+        case 'c': count = strtoull(optarg, NULL, 10); break;
+        case 'b': size = strtoul(optarg, NULL, 10); break;
+        case 'h': usage(0); break;
+        default: usage(1);
+        }
+    }
+    check(links > 0, "need at least one link");
+
+    pn_connection_t *c1 = pn_connection();
+    pn_transport_t *t1 = pn_transport();
+    pn_transport_bind(t1, c1);
+    pn_connection_t *c2 = pn_connection();
+    pn_transport_t *t2 = pn_transport();
+    pn_transport_set_server(t2);
+    pn_transport_bind(t2, c2);
+
+    pn_connection_open(c1);
+    pn_connection_open(c2);
+    pn_session_t *ssn = pn_session(c1);
+    pn_session_open(ssn);
+    pn_link_t *snd = NULL;
+    for (int i = 0; i < links; ++i) {
+        char name[32];
+        snprintf(name, sizeof(name), "link-%d", i);
+        pn_link_t *l = pn_sender(ssn, name);
+        pn_link_open(l);
+        if (!snd) snd = l;
+    }
+    engine_pump(t1, t2);
+    open_remote(c2);
+    engine_pump(t1, t2);
+
+    pn_link_t *rcv = pn_link_head(c2, PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE);
+    check(rcv && pn_link_is_receiver(rcv), "no receiver");
+    check(!strcmp(pn_link_name(rcv), pn_link_name(snd)), "unexpected receiver");
+    pn_link_flow(rcv, 1000);
+    engine_pump(t1, t2);
+
+    char *body = (char *) calloc(size, 1);
+    char *buf = (char *) malloc(size);
+    pn_timestamp_t start = msgr_now();
+    clock_t cpu_start = clock();
+    for (uint64_t i = 0; i < count; ++i) {
+        pn_delivery_t *d = pn_delivery(snd, pn_dtag((const char *) &i, sizeof(i)));
+        pn_link_send(snd, body, size);
+        pn_link_advance(snd);
+        pn_delivery_settle(d);
+        engine_pump(t1, t2);
+        pn_delivery_t *r = pn_link_current(rcv);
+        check(r && !pn_delivery_partial(r), "message not received");
+        pn_link_recv(rcv, buf, size);
+        pn_link_advance(rcv);
+        pn_delivery_settle(r);
+        if (pn_link_credit(rcv) < 500) pn_link_flow(rcv, 1000 - pn_link_credit(rcv));
+    }
+    engine_pump(t1, t2);
+    double cpu = (double)(clock() - cpu_start) / CLOCKS_PER_SEC;
+    double elapsed = (msgr_now() - start) / 1000.0;
+
+    printf("%d links, %" PRIu64 " messages of %u bytes: %.0f msgs/sec, %.3f usec CPU/msg\n",
+           links, count, (unsigned) size,
+           elapsed > 0 ? count / elapsed : 0.0, cpu * 1e6 / count);
+
+    free(body);
+    free(buf);
+    pn_transport_unbind(t1);
+    pn_transport_free(t1);
+    pn_connection_free(c1);
+    pn_transport_unbind(t2);
+    pn_transport_free(t2);
+    pn_connection_free(c2);
+    return 0;
+}
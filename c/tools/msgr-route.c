@@ -0,0 +1,116 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+/*
+ * Measures the cost of pn_messenger_put() when the messenger has many
+ * routing rules.
+ *
+ * Each rule routes one host name to a listener on the messenger itself, so
+ * all messages go to a single connection. Messages are only queued, no
+ * message is actually sent.
+ */
+
+#define PN_USE_DEPRECATED_API 1
+
+#include "proton/message.h"
+#include "proton/messenger.h"
+#include "msgr-common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static void usage(int rc)
+{
+    printf("Usage: msgr-route [OPTIONS] \n"
+           " -r # \tNumber of routing rules [1000]\n"
+           " -c # \tNumber of messages to put [100000]\n"
+           " -n # \tNumber of distinct addresses to send to, matching the last rules [1]\n"
+           " -p # \tPort to listen on [5699]\n"
+           );
+    exit(rc);
+}
+
+int main(int argc, char** argv)
+{
+    int rules = 1000;
+    uint64_t count = 100000;
+    int addresses = 1;
+    const char *port = "5699";
+
+    int c;
+    while ((c = getopt(argc, argv, "r:c:n:p:h")) != -1) {
+        switch (c) {
+        case 'r': rules = atoi(optarg); break;
+        case 'c': count = strtoull(optarg, NULL, 10); break;
+        case 'n': addresses = atoi(optarg); break;
+        case 'p': port = optarg; break;
+        case 'h': usage(0); break;
+        default: usage(1);
+        }
+    }
+    check(rules > 0, "need at least one rule");
+    check(addresses > 0 && addresses <= rules, "need between 1 and <rules> addresses");
+
+    pn_messenger_t *m = pn_messenger(NULL);
+    pn_messenger_set_blocking(m, false);
+    pn_messenger_set_outgoing_window(m, 1024);
+    char buf[256];
+    snprintf(buf, sizeof(buf), "amqp://~127.0.0.1:%s", port);
+    pn_messenger_subscribe(m, buf);
+    check_messenger(m);
+    snprintf(buf, sizeof(buf), "amqp://127.0.0.1:%s/$1", port);
+    for (int i = 0; i < rules; ++i) {
+        char pattern[64];
+        snprintf(pattern, sizeof(pattern), "amqp://host-%d/*", i);
+        pn_messenger_route(m, pattern, buf);
+    }
+    pn_messenger_start(m);
+    check_messenger(m);
+
+    char **address = (char **) malloc(addresses * sizeof(char *));
+    for (int i = 0; i < addresses; ++i) {
+        snprintf(buf, sizeof(buf), "amqp://host-%d/queue", rules - 1 - i);
+        address[i] = msgr_strdup(buf);
+    }
+
+    pn_message_t *msg = pn_message();
+    pn_timestamp_t start = msgr_now();
+    clock_t cpu_start = clock();
+    for (uint64_t i = 0; i < count; ++i) {
+        pn_message_set_address(msg, address[i % addresses]);
+        pn_messenger_put(m, msg);
+        check_messenger(m);
+    }
+    double cpu = (double)(clock() - cpu_start) / CLOCKS_PER_SEC;
+    double elapsed = (msgr_now() - start) / 1000.0;
+
+    printf("%d rules, %d addresses, %" PRIu64 " messages: %.0f puts/sec, %.3f usec CPU/put\n",
+           rules, addresses, count,
+           elapsed > 0 ? count / elapsed : 0.0, cpu * 1e6 / count);
+
+    pn_message_free(msg);
+    for (int i = 0; i < addresses; ++i) free(address[i]);
+    free(address);
+    pn_messenger_stop(m);
+    pn_messenger_free(m);
+    return 0;
+}
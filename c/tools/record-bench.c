@@ -0,0 +1,134 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+/*
+ * Event dispatch benchmark for record attachments.
+ *
+ * Link events are put on a collector and dispatched the way a binding does:
+ * each event's link context is looked up in the link's attachment record.
+ * The context is kept once in PN_LEGCTX, which every record holds inline, and
+ * once under a PN_HANDLE handle defined after -a other attachments, and the
+ * cost of dispatching with each is reported.
+ */
+
+#include "proton/connection.h"
+#include "proton/event.h"
+#include "proton/link.h"
+#include "proton/object.h"
+#include "proton/session.h"
+#include "engine-common.h"
+#include "msgr-common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+PN_HANDLE(BENCH_CONTEXT)
+
+static void usage(int rc)
+{
+    printf("Usage: record-bench [OPTIONS] \n"
+           " -c # \tNumber of events to dispatch [10000000]\n"
+           " -l # \tNumber of links the events are for [100]\n"
+           " -a # \tNumber of other attachments on each link [4]\n"
+           );
+    exit(rc);
+}
+
+typedef struct {
+    uint64_t events;
+} context_t;
+
+/* Dispatch count events round-robin over the links, return elapsed nsec */
+static uint64_t dispatch(pn_collector_t *collector, pn_link_t **links, int nlinks, int count, pn_handle_t handle)
+{
+    uint64_t start = engine_now_ns();
+    int done = 0;
+    while (done < count) {
+        for (int i = 0; i < nlinks && done + i < count; ++i) {
+            pn_collector_put(collector, PN_OBJECT, links[i], PN_LINK_FLOW);
+        }
+        pn_event_t *e;
+        while ((e = pn_collector_peek(collector))) {
+            pn_record_t *r = pn_link_attachments(pn_event_link(e));
+            context_t *ctx = (context_t *) pn_record_get(r, handle);
+            ctx->events++;
+            pn_collector_pop(collector);
+            ++done;
+        }
+    }
+    return engine_now_ns() - start;
+}
+
+int main(int argc, char** argv)
+{
+    int count = 10000000;
+    int nlinks = 100;
+    int attachments = 4;
+
+    int c;
+    while ((c = getopt(argc, argv, "c:l:a:h")) != -1) {
+        switch (c) {
+        case 'c': count = atoi(optarg); break;
+        case 'l': nlinks = atoi(optarg); break;
+        case 'a': attachments = atoi(optarg); break;
+        case 'h': usage(0); break;
+        default: usage(1);
+        }
+    }
+    check(count > 0 && nlinks > 0 && attachments >= 0, "invalid option value");
+
+    pn_connection_t *connection = pn_connection();
+    pn_collector_t *collector = pn_collector();
+    pn_session_t *ssn = pn_session(connection);
+    pn_link_t **links = (pn_link_t **) calloc(nlinks, sizeof(pn_link_t *));
+    context_t *contexts = (context_t *) calloc(nlinks, sizeof(context_t));
+    char *keys = (char *) calloc(attachments + 1, 1); /* Addresses are unique handles */
+    check(links && contexts && keys, "out of memory");
+
+    char name[32];
+    for (int i = 0; i < nlinks; ++i) {
+        snprintf(name, sizeof(name), "link-%d", i);
+        links[i] = pn_sender(ssn, name);
+        pn_record_t *r = pn_link_attachments(links[i]);
+        for (int j = 0; j < attachments; ++j) {
+            pn_record_def(r, &keys[j], PN_VOID);
+        }
+        pn_record_def(r, BENCH_CONTEXT, PN_VOID);
+        pn_record_set(r, BENCH_CONTEXT, &contexts[i]);
+        pn_record_set(r, PN_LEGCTX, &contexts[i]);
+    }
+
+    /* Warm up, then measure each way of finding the context */
+    dispatch(collector, links, nlinks, count / 10 + 1, PN_LEGCTX);
+    uint64_t legctx = dispatch(collector, links, nlinks, count, PN_LEGCTX);
+    uint64_t handle = dispatch(collector, links, nlinks, count, BENCH_CONTEXT);
+
+    printf("%d events on %d links with %d other attachments\n", count, nlinks, attachments);
+    printf("%-12s %8.1f nsec/event\n", "legctx", (double) legctx / count);
+    printf("%-12s %8.1f nsec/event\n", "handle", (double) handle / count);
+
+    pn_collector_free(collector);
+    pn_connection_free(connection);
+    free(keys);
+    free(contexts);
+    free(links);
+    return 0;
+}
@@ -0,0 +1,151 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+/*
+ * Prints a frame trace written by pn_transport_dump_trace() in the same
+ * format as PN_TRACE_FRM, with the wall clock time of each frame in UTC.
+ *
+ * The layout of the dump is described in c/src/core/trace_ring.h.
+ */
+
+#include "proton/codec.h"
+#include "proton/object.h"
+#include "msgr-common.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FILE_HEADER (8 + 8 + 8)
+#define RECORD_HEADER (4 + 8 + 4 + 2 + 1 + 1)
+
+static void usage(int rc)
+{
+    printf("Usage: trace-decode FILE\n"
+           "Print the frames in a PN_TRACE_BIN dump written by pn_transport_dump_trace()\n");
+    exit(rc);
+}
+
+static uint64_t get_uint(const unsigned char *p, int size)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < size; ++i) value = (value << 8) | p[i];
+    return value;
+}
+
+/* Append bytes to str quoted as pn_quote_data() does */
+static void quote(pn_string_t *str, const unsigned char *bytes, size_t size)
+{
+    for (size_t i = 0; i < size; ++i) {
+        if (isprint(bytes[i])) {
+            pn_string_addf(str, "%c", bytes[i]);
+        } else {
+            pn_string_addf(str, "\\x%.2x", bytes[i]);
+        }
+    }
+}
+
+static void print_time(uint64_t us)
+{
+    time_t secs = (time_t) (us / 1000000);
+    struct tm *tm = gmtime(&secs);
+    char buf[32];
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", tm);
+    printf("%s.%06u ", buf, (unsigned) (us % 1000000));
+}
+
+static void print_record(pn_data_t *data, pn_string_t *str, uint64_t wall, const unsigned char *r, size_t length)
+{
+    uint32_t size = (uint32_t) get_uint(r + 12, 4);
+    unsigned channel = (unsigned) get_uint(r + 16, 2);
+    bool out = r[19];
+    const unsigned char *body = r + RECORD_HEADER;
+    size_t captured = length - RECORD_HEADER;
+
+    print_time(wall);
+    pn_string_format(str, "%u %s ", channel, out ? "->" : "<-");
+    if (size == 0) {
+        pn_string_addf(str, "(EMPTY FRAME)");
+        printf("%s\n", pn_string_get(str));
+        return;
+    }
+
+    pn_data_clear(data);
+    ssize_t dsize = pn_data_decode(data, (const char *) body, captured);
+    if (dsize < 0) {
+        pn_string_addf(str, "(undecodable frame) (%u) \"", size);
+        quote(str, body, captured);
+        pn_string_addf(str, "\"%s", captured < size ? "... (truncated)" : "");
+        printf("%s\n", pn_string_get(str));
+        return;
+    }
+    pn_inspect(data, str);
+    size_t payload = size - dsize;
+    if (payload) {
+        pn_string_addf(str, " (%lu) \"", (unsigned long) payload);
+        quote(str, body + dsize, captured - dsize);
+        pn_string_addf(str, "\"%s", captured < size ? "... (truncated)" : "");
+    }
+    printf("%s\n", pn_string_get(str));
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2) usage(1);
+    if (!strcmp(argv[1], "-h")) usage(0);
+
+    FILE *file = fopen(argv[1], "rb");
+    check(file, "cannot open file");
+    size_t size = 0, capacity = 64 * 1024;
+    unsigned char *bytes = (unsigned char *) malloc(capacity);
+    size_t n;
+    while ((n = fread(bytes + size, 1, capacity - size, file)) > 0) {
+        size += n;
+        if (size == capacity) {
+            capacity *= 2;
+            bytes = (unsigned char *) realloc(bytes, capacity);
+            check(bytes, "out of memory");
+        }
+    }
+    fclose(file);
+    check(size >= FILE_HEADER && !memcmp(bytes, "PNTRACE1", 8), "not a proton trace dump");
+
+    uint64_t wall = get_uint(bytes + 8, 8);
+    uint64_t clock = get_uint(bytes + 16, 8);
+    pn_data_t *data = pn_data(16);
+    pn_string_t *str = pn_string(NULL);
+    size_t offset = FILE_HEADER;
+    while (offset + RECORD_HEADER <= size) {
+        const unsigned char *r = bytes + offset;
+        size_t length = (size_t) get_uint(r, 4);
+        check(length >= RECORD_HEADER && offset + length <= size, "corrupt record");
+        uint64_t time = get_uint(r + 4, 8);
+        print_record(data, str, wall - (clock - time), r, length);
+        offset += length;
+    }
+    check(offset == size, "trailing bytes after last record");
+
+    pn_free(str);
+    pn_data_free(data);
+    free(bytes);
+    return 0;
+}
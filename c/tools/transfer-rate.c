@@ -0,0 +1,144 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+/*
+ * Measures the engine's per-message cost for a stream of small messages.
+ *
+ * Two connections are bound to transports that are connected in memory, so
+ * no I/O is involved. The sender queues a window of messages before the
+ * transports exchange data, so each output pass encodes many transfers.
+ */
+
+#include "proton/connection.h"
+#include "proton/delivery.h"
+#include "proton/link.h"
+#include "proton/session.h"
+#include "proton/transport.h"
+#include "engine-common.h"
+#include "msgr-common.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static void usage(int rc)
+{
+    printf("Usage: transfer-rate [OPTIONS] \n"
+           " -c # \tNumber of messages to send [1000000]\n"
+           " -b # \tSize of message body in bytes [64]\n"
+           " -w # \tNumber of messages sent per output pass [100]\n"
+           " -u   \tSend unsettled, the receiver settles each message\n"
+           );
+    exit(rc);
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t count = 1000000;
+    size_t size = 64;
+    int window = 100;
+    bool presettled = true;
+
+    int c;
+    while ((c = getopt(argc, argv, "c:b:w:uh")) != -1) {
+        switch (c) {
+        case 'c': count = strtoull(optarg, NULL, 10); break;
+        case 'b': size = strtoul(optarg, NULL, 10); break;
+        case 'w': window = atoi(optarg); break;
+        case 'u': presettled = false; break;
+        case 'h': usage(0); break;
+        default: usage(1);
+        }
+    }
+    check(window > 0, "window must be positive");
+
+    pn_connection_t *c1 = pn_connection();
+    pn_transport_t *t1 = pn_transport();
+    pn_transport_bind(t1, c1);
+    pn_connection_t *c2 = pn_connection();
+    pn_transport_t *t2 = pn_transport();
+    pn_transport_set_server(t2);
+    pn_transport_bind(t2, c2);
+
+    pn_connection_open(c1);
+    pn_connection_open(c2);
+    pn_session_t *ssn = pn_session(c1);
+    pn_session_open(ssn);
+    pn_link_t *snd = pn_sender(ssn, "transfer-rate");
+    pn_link_open(snd);
+    engine_pump(t1, t2);
+    pn_session_open(pn_session_head(c2, PN_LOCAL_UNINIT));
+    pn_link_t *rcv = pn_link_head(c2, PN_LOCAL_UNINIT);
+    check(rcv && pn_link_is_receiver(rcv), "no receiver");
+    pn_link_open(rcv);
+    pn_link_flow(rcv, 2 * window);
+    engine_pump(t1, t2);
+
+    char *body = (char *) calloc(size, 1);
+    char *buf = (char *) malloc(size);
+    pn_timestamp_t start = msgr_now();
+    clock_t cpu_start = clock();
+    uint64_t sent = 0;
+    uint64_t received = 0;
+    while (received < count) {
+        for (int i = 0; i < window && sent < count; ++i, ++sent) {
+            pn_delivery_t *d = pn_delivery(snd, pn_dtag((const char *) &sent, sizeof(sent)));
+            pn_link_send(snd, body, size);
+            pn_link_advance(snd);
+            if (presettled) pn_delivery_settle(d);
+        }
+        engine_pump(t1, t2);
+        pn_delivery_t *r;
+        while ((r = pn_link_current(rcv)) && !pn_delivery_partial(r)) {
+            pn_link_recv(rcv, buf, size);
+            pn_link_advance(rcv);
+            pn_delivery_settle(r);
+            ++received;
+        }
+        pn_link_flow(rcv, 2 * window - pn_link_credit(rcv));
+        if (!presettled) {
+            engine_pump(t1, t2);
+            pn_delivery_t *d;
+            while ((d = pn_work_head(c1))) {
+                check(pn_delivery_remote_state(d) == PN_ACCEPTED || pn_delivery_settled(d),
+                      "unexpected disposition");
+                pn_delivery_settle(d);
+            }
+        }
+    }
+    engine_pump(t1, t2);
+    double cpu = (double)(clock() - cpu_start) / CLOCKS_PER_SEC;
+    double elapsed = (msgr_now() - start) / 1000.0;
+
+    printf("%" PRIu64 " messages of %u bytes, %d per pass, %s: %.0f msgs/sec, %.3f usec CPU/msg\n",
+           count, (unsigned) size, window, presettled ? "presettled" : "unsettled",
+           elapsed > 0 ? count / elapsed : 0.0, cpu * 1e6 / count);
+
+    free(body);
+    free(buf);
+    pn_transport_unbind(t1);
+    pn_transport_free(t1);
+    pn_connection_free(c1);
+    pn_transport_unbind(t2);
+    pn_transport_free(t2);
+    pn_connection_free(c2);
+    return 0;
+}
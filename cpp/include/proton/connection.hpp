@@ -25,6 +25,7 @@
 #include "./fwd.hpp"
 #include "./internal/export.hpp"
 #include "./internal/object.hpp"
+#include "./duration.hpp"
 #include "./endpoint.hpp"
 #include "./session.hpp"
 #include "./symbol.hpp"
@@ -40,6 +41,27 @@ struct pn_connection_t;
 
 namespace proton {
 
+/// **Unsettled API** - Counters for the traffic on a connection.
+///
+/// Bytes are delivery payload bytes, not including framing.
+///
+/// @see connection::stats()
+struct connection_stats {
+    uint64_t deliveries_sent;     ///< Complete deliveries sent
+    uint64_t deliveries_received; ///< Complete deliveries received
+    uint64_t bytes_sent;          ///< Delivery payload bytes sent
+    uint64_t bytes_received;      ///< Delivery payload bytes received
+    uint64_t frames_output;       ///< AMQP frames sent
+    uint64_t frames_input;        ///< AMQP frames received
+    uint64_t dispositions_output; ///< DISPOSITION frames sent
+    uint64_t dispositions_input;  ///< DISPOSITION frames received
+    duration window_blocked;      ///< Time sessions had transfers held back by the peer's incoming window
+
+    connection_stats() : deliveries_sent(0), deliveries_received(0), bytes_sent(0),
+                         bytes_received(0), frames_output(0), frames_input(0),
+                         dispositions_output(0), dispositions_input(0) {}
+};
+
 /// A connection to a remote AMQP peer.
 class
 PN_CPP_CLASS_EXTERN connection : public internal::object<pn_connection_t>, public endpoint {
@@ -181,6 +203,13 @@ PN_CPP_CLASS_EXTERN connection : public internal::object<pn_connection_t>, publi
     /// @see reconnect_options, messaging_handler
     PN_CPP_EXTERN bool reconnected() const;
 
+    /// **Unsettled API** - A snapshot of the counters for this connection.
+    ///
+    /// The counters are cheap to maintain and always enabled. They
+    /// start from zero for each transport, so they restart if the
+    /// connection is re-connected.
+    PN_CPP_EXTERN connection_stats stats() const;
+
     /// @cond INTERNAL
   friend class internal::factory<connection>;
   friend class container;
@@ -39,6 +39,7 @@
 /// @copybrief proton::connection_options
 
 struct pn_connection_t;
+struct pn_listener_t;
 struct pn_transport_t;
 
 namespace proton {
@@ -171,6 +172,37 @@ class connection_options {
     /// **Unsettled API** - Set reconnect and failover options.
     PN_CPP_EXTERN connection_options& reconnect(const reconnect_options &);
 
+    /// **Unsettled API** - Enable or disable TCP_NODELAY on the
+    /// connection's socket.  It is enabled by default.
+    ///
+    /// This and the other socket options below are applied to the
+    /// socket of each connection made by `container::connect` or
+    /// accepted by `container::listen`.  Options passed to
+    /// `container::listen` are also applied to the listening socket.
+    /// Options the platform does not support are ignored.
+    PN_CPP_EXTERN connection_options& tcp_nodelay(bool);
+
+    /// **Unsettled API** - Set the kernel send buffer size in bytes (SO_SNDBUF).
+    PN_CPP_EXTERN connection_options& socket_send_buffer(int);
+
+    /// **Unsettled API** - Set the kernel receive buffer size in bytes (SO_RCVBUF).
+    PN_CPP_EXTERN connection_options& socket_receive_buffer(int);
+
+    /// **Unsettled API** - Send TCP acknowledgements immediately (TCP_QUICKACK).
+    PN_CPP_EXTERN connection_options& tcp_quickack(bool);
+
+    /// **Unsettled API** - Limit the unsent data held in the kernel
+    /// send buffer, in bytes (TCP_NOTSENT_LOWAT).
+    PN_CPP_EXTERN connection_options& tcp_notsent_lowat(int);
+
+    /// **Unsettled API** - Busy poll the network device for up to
+    /// this many microseconds when receiving (SO_BUSY_POLL).
+    PN_CPP_EXTERN connection_options& socket_busy_poll(int);
+
+    /// **Unsettled API** - Close the connection if sent data is not
+    /// acknowledged within this time (TCP_USER_TIMEOUT).
+    PN_CPP_EXTERN connection_options& tcp_user_timeout(duration);
+
     /// Update option values from values set in other.
     PN_CPP_EXTERN connection_options& update(const connection_options& other);
 
@@ -178,6 +210,8 @@ class connection_options {
     void apply_unbound(connection&) const;
     void apply_unbound_client(pn_transport_t*) const;
     void apply_unbound_server(pn_transport_t*) const;
+    void apply_socket(pn_connection_t*) const;
+    void apply_socket(pn_listener_t*) const;
     messaging_handler* handler() const;
 
     class impl;
@@ -24,19 +24,49 @@
 
 #include "./fwd.hpp"
 #include "./returned.hpp"
+#include "./sender.hpp"
 #include "./types_fwd.hpp"
 
 #include "./internal/config.hpp"
 #include "./internal/export.hpp"
 #include "./internal/pn_unique_ptr.hpp"
 
+#include <proton/type_compat.h>
+
 #include <string>
+#include <vector>
 
 /// @file
 /// @copybrief proton::container
 
 namespace proton {
 
+/// **Unsettled API** - Statistics for the threads running a container.
+///
+/// Times are in nanoseconds. `busy_ns / (busy_ns + idle_ns)` is the
+/// utilisation of a thread. The summaries use `latency_summary` for
+/// any distribution, the units are given for each.
+///
+/// @see container::stats()
+struct container_stats {
+    uint64_t polls;               ///< Returns from the poller, e.g. epoll_wait()
+    uint64_t batches;             ///< Event batches handled
+    uint64_t events;              ///< Events handled
+    uint64_t wakes;               ///< Wake ups of connections, listeners or the container handled
+    uint64_t hog_limits;          ///< Batches ended to give other connections a turn
+    uint64_t rearms;              ///< System calls to re-arm a polled file descriptor
+    uint64_t locks;               ///< Times the container's own lock was taken
+    uint64_t lock_held_ns;        ///< Time the container's own lock was held
+    uint64_t busy_ns;             ///< Time spent handling event batches
+    uint64_t idle_ns;             ///< Time spent waiting with nothing to do
+    latency_summary batch_events; ///< Events per batch
+    latency_summary wake_latency; ///< Microseconds from a wake up to it being handled
+    latency_summary lock_held;    ///< Nanoseconds the container's own lock was held each time
+
+    container_stats() : polls(0), batches(0), events(0), wakes(0), hog_limits(0), rearms(0),
+                        locks(0), lock_held_ns(0), busy_ns(0), idle_ns(0) {}
+};
+
 /// A top-level container of connections, sessions, and links.
 ///
 /// A container gives a unique identity to each communicating peer. It
@@ -311,6 +341,33 @@ class PN_CPP_CLASS_EXTERN container {
     /// **Deprecated** - Use `container::schedule(duration, work)`.
     PN_CPP_EXTERN PN_CPP_DEPRECATED("Use 'container::schedule(duration, work)'") void schedule(duration dur, void_function0& fn);
 
+    /// **Unsettled API** - Turn statistics for the container's
+    /// threads on or off. They are off by default, turning them off
+    /// keeps the values recorded so far.
+    ///
+    /// Statistics are only kept by some IO implementations, the
+    /// values stay at zero for others.
+    ///
+    /// **Thread safety** - It is safe to call this method in any thread.
+    PN_CPP_EXTERN void stats_enabled(bool enabled);
+
+    /// **Unsettled API** - True if statistics are on.
+    PN_CPP_EXTERN bool stats_enabled() const;
+
+    /// **Unsettled API** - Statistics totalled over all threads.
+    ///
+    /// **Thread safety** - It is safe to call this method in any thread.
+    PN_CPP_EXTERN container_stats stats() const;
+
+    /// **Unsettled API** - Statistics for each thread that has run
+    /// the container, in the order they started.
+    ///
+    /// **Thread safety** - It is safe to call this method in any thread.
+    PN_CPP_EXTERN std::vector<container_stats> thread_stats() const;
+
+    /// **Unsettled API** - Reset all statistics to zero.
+    PN_CPP_EXTERN void clear_stats();
+
   private:
     /// Declare both v03 and v11 if compiling with c++11 as the library contains both.
     /// A C++11 user should never call the v03 overload so it is private in this case
@@ -0,0 +1,85 @@
+#ifndef PROTON_ENCODED_MESSAGE_HPP
+#define PROTON_ENCODED_MESSAGE_HPP
+
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "./fwd.hpp"
+#include "./internal/export.hpp"
+
+#include <proton/type_compat.h>
+
+#include <cstddef>
+
+/// @file
+/// @copybrief proton::encoded_message
+
+struct pn_shared_bytes_t;
+
+namespace proton {
+
+/// **Unsettled API** - A message encoded once, so it can be sent on
+/// any number of senders without being encoded or copied again.
+///
+/// Copies share the same immutable bytes. A copy can be made on one
+/// thread and used on another, for example to send a message to
+/// subscribers on connections with different work queues.
+///
+/// @see sender::send(const encoded_message&)
+class encoded_message {
+  public:
+    /// Create an empty encoded message.
+    PN_CPP_EXTERN encoded_message();
+
+    /// Encode a message.
+    PN_CPP_EXTERN explicit encoded_message(const message&);
+
+    /// Share the bytes of another encoded message.
+    PN_CPP_EXTERN encoded_message(const encoded_message&);
+
+    /// Share the bytes of another encoded message.
+    PN_CPP_EXTERN encoded_message& operator=(const encoded_message&);
+
+    PN_CPP_EXTERN ~encoded_message();
+
+    /// True if there is no message.
+    PN_CPP_EXTERN bool empty() const;
+
+    /// The size of the encoded message in bytes.
+    PN_CPP_EXTERN size_t size() const;
+
+    /// The encoded bytes, valid for the life of this object.
+    PN_CPP_EXTERN const char* data() const;
+
+    /// Decode into a message.
+    PN_CPP_EXTERN void decode(message&) const;
+
+  private:
+    pn_shared_bytes_t* bytes_;
+
+    /// @cond INTERNAL
+  friend class sender;
+    /// @endcond
+};
+
+} // proton
+
+#endif // PROTON_ENCODED_MESSAGE_HPP
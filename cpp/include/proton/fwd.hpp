@@ -35,6 +35,7 @@ class connection_options;
 class container;
 class delivery;
 class duration;
+class encoded_message;
 class error_condition;
 class event;
 class message;
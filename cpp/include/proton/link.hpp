@@ -24,9 +24,12 @@
 
 #include "./fwd.hpp"
 #include "./internal/export.hpp"
+#include "./duration.hpp"
 #include "./endpoint.hpp"
 #include "./internal/object.hpp"
 
+#include <proton/type_compat.h>
+
 #include <string>
 
 /// @file
@@ -36,6 +39,18 @@ struct pn_link_t;
 
 namespace proton {
 
+/// **Unsettled API** - Counters for the traffic on a link.
+///
+/// @see link::stats()
+struct link_stats {
+    uint64_t deliveries;        ///< Complete deliveries sent (sender) or received (receiver)
+    uint64_t bytes;             ///< Delivery payload bytes sent or received
+    uint64_t settled;           ///< Deliveries settled locally
+    duration credit_blocked;    ///< Time a sender had data to send but no credit
+
+    link_stats() : deliveries(0), bytes(0), settled(0) {}
+};
+
 /// A named channel for sending or receiving messages.  It is the base
 /// class for sender and receiver.
 class
@@ -90,6 +105,11 @@ PN_CPP_CLASS_EXTERN link : public internal::object<pn_link_t> , public endpoint
     /// The session that owns this link.
     PN_CPP_EXTERN class session session() const;
 
+    /// **Unsettled API** - A snapshot of the counters for this link.
+    ///
+    /// The counters are cheap to maintain and always enabled.
+    PN_CPP_EXTERN link_stats stats() const;
+
   protected:
     /// @cond INTERNAL
     
@@ -27,6 +27,9 @@
 #include "./link.hpp"
 #include "./tracker.hpp"
 
+#include <proton/link.h>
+#include <proton/type_compat.h>
+
 /// @file
 /// @copybrief proton::sender
 
@@ -35,6 +38,27 @@ struct pn_session_t;
 
 namespace proton {
 
+/// **Unsettled API** - A summary of the latencies recorded for a
+/// stage of the messages sent on a sender.
+///
+/// All times are in microseconds. Percentiles are accurate to within
+/// 12.5%. Also used to summarize the other distributions in
+/// `container_stats`.
+///
+/// @see sender::latency(), container::stats()
+struct latency_summary {
+    uint64_t count;             ///< Number of messages measured
+    uint64_t min;               ///< Smallest latency
+    uint64_t max;               ///< Largest latency
+    double mean;                ///< Mean latency
+    uint64_t p50;               ///< 50th percentile (median)
+    uint64_t p90;               ///< 90th percentile
+    uint64_t p99;               ///< 99th percentile
+    uint64_t p999;              ///< 99.9th percentile
+
+    latency_summary() : count(0), min(0), max(0), mean(0), p50(0), p90(0), p99(0), p999(0) {}
+};
+
 /// A channel for sending messages.
 class
 PN_CPP_CLASS_EXTERN sender : public link {
@@ -57,6 +81,10 @@ PN_CPP_CLASS_EXTERN sender : public link {
     /// Send a message on the sender.
     PN_CPP_EXTERN tracker send(const message &m);
 
+    /// **Unsettled API** - Send an encoded message on the sender. The
+    /// delivery refers to the encoded bytes rather than copying them.
+    PN_CPP_EXTERN tracker send(const encoded_message &m);
+
     /// Get the source node.
     PN_CPP_EXTERN class source source() const;
 
@@ -71,6 +99,26 @@ PN_CPP_CLASS_EXTERN sender : public link {
     /// @see receiver::drain
     PN_CPP_EXTERN void return_credit();
 
+    /// **Unsettled API** - Stages of a sent message measured when
+    /// latency tracking is enabled.
+    enum latency_stage {
+        QUEUED = PN_LATENCY_QUEUED,   ///< send() to the last frame of the message being encoded
+        WRITTEN = PN_LATENCY_WRITTEN, ///< Frame encoded to its bytes being written to the connection
+        SETTLED = PN_LATENCY_SETTLED, ///< Bytes written to the peer settling the message
+        TOTAL = PN_LATENCY_TOTAL      ///< send() to the peer settling the message
+    };
+
+    /// **Unsettled API** - Enable or disable latency tracking for
+    /// messages sent from now on. Disabled by default.
+    PN_CPP_EXTERN void latency_tracking(bool enabled);
+
+    /// **Unsettled API** - True if latency tracking is enabled.
+    PN_CPP_EXTERN bool latency_tracking() const;
+
+    /// **Unsettled API** - Summarize the latencies recorded for a
+    /// stage. All zero if tracking was never enabled.
+    PN_CPP_EXTERN latency_summary latency(enum latency_stage stage) const;
+
     /// @cond INTERNAL
   friend class internal::factory<sender>;
   friend class sender_iterator;
@@ -32,6 +32,8 @@
 #include <functional>
 #include <utility>
 #if PN_CPP_HAS_LAMBDAS && PN_CPP_HAS_VARIADIC_TEMPLATES
+#include <cstddef>
+#include <new>
 #include <type_traits>
 #endif
 
@@ -73,8 +75,8 @@ struct invocable_wrapper {
         return *this;
     }
 #if PN_CPP_HAS_RVALUE_REFERENCES
-    invocable_wrapper(invocable_wrapper&& w): wrapped_(w.wrapped_) {}
-    invocable_wrapper& operator=(invocable_wrapper&& that) {delete wrapped_; wrapped_ = that.wrapped_; return *this; }
+    invocable_wrapper(invocable_wrapper&& w): wrapped_(w.wrapped_) { w.wrapped_ = 0; }
+    invocable_wrapper& operator=(invocable_wrapper&& that) { std::swap(wrapped_, that.wrapped_); return *this; }
 #endif
     ~invocable_wrapper() { delete wrapped_; }
 
@@ -268,32 +270,133 @@ work make_work(R (*f)(A, B, C), A a, B b, C c) {
 namespace internal { namespace v11 {
 
 class work {
+    // Function objects up to this size are stored inline in the work
+    // item itself; larger ones are allocated on the heap.
+    static const std::size_t inline_size = 4*sizeof(void*);
+    struct storage { alignas(void*) unsigned char bytes[inline_size]; };
+
+    struct operations {
+        void (*invoke)(storage&);
+        void (*copy)(const storage& from, storage& to);
+        void (*move)(storage& from, storage& to);
+        void (*destroy)(storage&);
+    };
+
+    template <class F> struct inline_ops {
+        static F& get(storage& s) { return *reinterpret_cast<F*>(s.bytes); }
+        static const F& get(const storage& s) { return *reinterpret_cast<const F*>(s.bytes); }
+        static void invoke(storage& s) { get(s)(); }
+        static void copy(const storage& from, storage& to) { new (to.bytes) F(get(from)); }
+        static void move(storage& from, storage& to) { new (to.bytes) F(std::move(get(from))); get(from).~F(); }
+        static void destroy(storage& s) { get(s).~F(); }
+        static const operations ops;
+    };
+
+    template <class F> struct heap_ops {
+        static F*& get(storage& s) { return *reinterpret_cast<F**>(s.bytes); }
+        static F* get(const storage& s) { return *reinterpret_cast<F* const*>(s.bytes); }
+        static void invoke(storage& s) { (*get(s))(); }
+        static void copy(const storage& from, storage& to) { get(to) = new F(*get(from)); }
+        static void move(storage& from, storage& to) { get(to) = get(from); get(from) = 0; }
+        static void destroy(storage& s) { delete get(s); }
+        static const operations ops;
+    };
+
+    template <class F> struct fits_inline : std::integral_constant<bool,
+        sizeof(F) <= sizeof(storage) &&
+        alignof(storage) % alignof(F) == 0 &&
+        std::is_nothrow_move_constructible<F>::value> {};
+
+    template <class F, class T> void init(T&& f, std::true_type) {
+        new (store_.bytes) F(std::forward<T>(f));
+        ops_ = &inline_ops<F>::ops;
+    }
+
+    template <class F, class T> void init(T&& f, std::false_type) {
+        heap_ops<F>::get(store_) = new F(std::forward<T>(f));
+        ops_ = &heap_ops<F>::ops;
+    }
+
   public:
     /// **Unsettled API**
-    work() {}
+    work() : ops_(0) {}
 
     /// **Unsettled API**
     ///
     /// Construct a unit of work from anything
     /// function-like that takes no arguments and returns
     /// no result.
+    ///
+    /// Small function objects, such as lambdas capturing a few
+    /// pointers or values, are stored in the work item without any
+    /// heap allocation.
     template <class T,
         // Make sure we don't match the copy or move constructors
         class = typename std::enable_if<!std::is_same<typename std::decay<T>::type,work>::value>::type
     >
-    work(T&& f): item_(std::forward<T>(f)) {}
+    work(T&& f) : ops_(0) {
+        typedef typename std::decay<T>::type F;
+        init<F>(std::forward<T>(f), fits_inline<F>());
+    }
+
+    /// **Unsettled API**
+    work(const work& w) : ops_(w.ops_) {
+        if (ops_) ops_->copy(w.store_, store_);
+    }
+
+    /// **Unsettled API**
+    ///
+    /// Moving a work item never allocates.
+    work(work&& w) noexcept : ops_(w.ops_) {
+        if (ops_) ops_->move(w.store_, store_);
+        w.ops_ = 0;
+    }
+
+    /// **Unsettled API**
+    work& operator=(const work& w) {
+        work tmp(w);
+        return *this = std::move(tmp);
+    }
+
+    /// **Unsettled API**
+    work& operator=(work&& w) noexcept {
+        if (this != &w) {
+            reset();
+            ops_ = w.ops_;
+            if (ops_) ops_->move(w.store_, store_);
+            w.ops_ = 0;
+        }
+        return *this;
+    }
 
     /// **Unsettled API**
     ///
     /// Execute the piece of work
-    void operator()() { item_(); }
+    void operator()() {
+        if (!ops_) throw std::bad_function_call();
+        ops_->invoke(store_);
+    }
 
-    ~work() {}
+    ~work() { reset(); }
 
   private:
-    std::function<void()> item_;
+    void reset() {
+        if (ops_) ops_->destroy(store_);
+        ops_ = 0;
+    }
+
+    const operations* ops_;
+    storage store_;
 };
 
+template <class F> const work::operations work::inline_ops<F>::ops = {
+    &work::inline_ops<F>::invoke, &work::inline_ops<F>::copy,
+    &work::inline_ops<F>::move, &work::inline_ops<F>::destroy };
+
+template <class F> const work::operations work::heap_ops<F>::ops = {
+    &work::heap_ops<F>::invoke, &work::heap_ops<F>::copy,
+    &work::heap_ops<F>::move, &work::heap_ops<F>::destroy };
+
 /// **Unsettled API** - Make a unit of work.
 ///
 /// Make a unit of work from either a function or a member function
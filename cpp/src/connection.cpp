@@ -198,4 +198,19 @@ bool connection::reconnected() const {
     return (rc && rc->reconnected_);
 }
 
+connection_stats connection::stats() const {
+    pn_connection_stats_t s = pn_connection_stats(pn_object());
+    connection_stats stats;
+    stats.deliveries_sent = s.deliveries_sent;
+    stats.deliveries_received = s.deliveries_received;
+    stats.bytes_sent = s.bytes_sent;
+    stats.bytes_received = s.bytes_received;
+    stats.frames_output = s.frames_output;
+    stats.frames_input = s.frames_input;
+    stats.dispositions_output = s.dispositions_output;
+    stats.dispositions_input = s.dispositions_input;
+    stats.window_blocked = duration(s.window_blocked);
+    return stats;
+}
+
 } // namespace proton
@@ -24,6 +24,7 @@
 
 #include "proton/connection.hpp"
 #include "proton/container.hpp"
+#include "proton/encoded_message.hpp"
 #include "proton/io/connection_driver.hpp"
 #include "proton/link.hpp"
 #include "proton/message.hpp"
@@ -490,6 +491,90 @@ void test_message() {
     ASSERT_EQUAL(value("b"), m2.message_annotations().get("a"));
 }
 
+void test_encoded_message() {
+    // Verify one encoded message can be sent on senders of two connections
+    record_handler ha1, hb1, ha2, hb2;
+    driver_pair d1(ha1, hb1);
+    driver_pair d2(ha2, hb2);
+
+    proton::message m("shared");
+    m.properties().put("x", "y");
+    proton::encoded_message em(m);
+    ASSERT(!em.empty());
+    proton::encoded_message copy;
+    ASSERT(copy.empty());
+    ASSERT_EQUAL(0u, copy.size());
+    copy = em;
+    ASSERT_EQUAL(em.size(), copy.size());
+    ASSERT(em.data() == copy.data());
+    proton::message decoded;
+    copy.decode(decoded);
+    ASSERT_EQUAL(value("shared"), decoded.body());
+
+    d1.a.connection().open_sender("x").send(em);
+    d2.a.connection().open_sender("x").send(copy);
+    while (hb1.messages.size() == 0)
+        d1.process();
+    while (hb2.messages.size() == 0)
+        d2.process();
+    proton::message m1 = quick_pop(hb1.messages);
+    proton::message m2 = quick_pop(hb2.messages);
+    ASSERT_EQUAL(value("shared"), m1.body());
+    ASSERT_EQUAL(value("y"), m1.properties().get("x"));
+    ASSERT_EQUAL(value("shared"), m2.body());
+
+    ASSERT_THROWS(proton::error, d1.a.connection().open_sender("y").send(proton::encoded_message()));
+}
+
+void test_stats() {
+    // Verify the link and connection counters follow a delivery
+    record_handler ha, hb;
+    driver_pair d(ha, hb);
+
+    proton::sender s = d.a.connection().open_sender("x");
+    s.send(proton::message("stats"));
+    while (hb.messages.size() == 0)
+        d.process();
+
+    proton::link_stats ls = s.stats();
+    ASSERT_EQUAL(1u, ls.deliveries);
+    ASSERT(ls.bytes > 0);
+    proton::connection_stats sent = d.a.connection().stats();
+    proton::connection_stats received = d.b.connection().stats();
+    ASSERT_EQUAL(1u, sent.deliveries_sent);
+    ASSERT_EQUAL(1u, received.deliveries_received);
+    ASSERT_EQUAL(ls.bytes, sent.bytes_sent);
+    ASSERT_EQUAL(ls.bytes, received.bytes_received);
+    ASSERT(sent.frames_output > 0);
+    ASSERT_EQUAL(sent.frames_output, received.frames_input);
+    ASSERT_EQUAL(1u, quick_pop(hb.receivers).stats().deliveries);
+}
+
+void test_latency() {
+    // Verify latency is only measured while tracking is enabled
+    record_handler ha, hb;
+    driver_pair d(ha, hb);
+
+    proton::sender s = d.a.connection().open_sender("x");
+    s.send(proton::message("untracked"));
+    while (hb.messages.size() == 0)
+        d.process();
+    ASSERT(!s.latency_tracking());
+    ASSERT_EQUAL(0u, s.latency(proton::sender::TOTAL).count);
+
+    s.latency_tracking(true);
+    ASSERT(s.latency_tracking());
+    s.send(proton::message("tracked"));
+    while (hb.messages.size() < 2 || s.latency(proton::sender::TOTAL).count == 0)
+        d.process();
+    ASSERT_EQUAL(1u, s.latency(proton::sender::QUEUED).count);
+    ASSERT_EQUAL(1u, s.latency(proton::sender::WRITTEN).count);
+    ASSERT_EQUAL(1u, s.latency(proton::sender::SETTLED).count);
+    proton::latency_summary total = s.latency(proton::sender::TOTAL);
+    ASSERT_EQUAL(1u, total.count);
+    ASSERT(total.min <= total.p50 && total.p50 <= total.max);
+}
+
 void test_message_timeout_succeed() {
     // Verify a message arrives intact
     record_handler ha, hb;
@@ -549,6 +634,9 @@ int main(int argc, char** argv) {
     RUN_ARGV_TEST(failed, test_link_anonymous_dynamic());
     RUN_ARGV_TEST(failed, test_link_capability_filter());
     RUN_ARGV_TEST(failed, test_message());
+    RUN_ARGV_TEST(failed, test_encoded_message());
+    RUN_ARGV_TEST(failed, test_stats());
+    RUN_ARGV_TEST(failed, test_latency());
     RUN_ARGV_TEST(failed, test_message_timeout_succeed());
     RUN_ARGV_TEST(failed, test_message_timeout_fail());
     return failed;
@@ -69,6 +69,7 @@ class connection_options::impl {
     option<bool> sasl_allow_insecure_mechs;
     option<std::string> sasl_config_name;
     option<std::string> sasl_config_path;
+    option<int> socket_options[PN_SOCKET_USER_TIMEOUT + 1]; // Indexed by pn_socket_option_t
 
     /*
      * There are three types of connection options: the handler
@@ -109,6 +110,21 @@ class connection_options::impl {
             pn_transport_set_idle_timeout(pnt, idle_timeout.value.milliseconds());
     }
 
+    // Socket options are used by the proactor when it connects or accepts
+    void apply_socket(pn_connection_t* pnc) {
+        for (int i = 0; i <= PN_SOCKET_USER_TIMEOUT; ++i) {
+            if (socket_options[i].set)
+                pn_connection_set_socket_option(pnc, pn_socket_option_t(i), socket_options[i].value);
+        }
+    }
+
+    void apply_socket(pn_listener_t* pnl) {
+        for (int i = 0; i <= PN_SOCKET_USER_TIMEOUT; ++i) {
+            if (socket_options[i].set)
+                pn_listener_set_socket_option(pnl, pn_socket_option_t(i), socket_options[i].value);
+        }
+    }
+
     void apply_sasl(pn_transport_t* pnt) {
         // Transport options.  pnt is NULL between reconnect attempts
         // and if there is a pipelined open frame.
@@ -169,6 +185,8 @@ class connection_options::impl {
         sasl_allowed_mechs.update(x.sasl_allowed_mechs);
         sasl_config_name.update(x.sasl_config_name);
         sasl_config_path.update(x.sasl_config_path);
+        for (int i = 0; i <= PN_SOCKET_USER_TIMEOUT; ++i)
+            socket_options[i].update(x.socket_options[i]);
     }
 
 };
@@ -211,10 +229,19 @@ connection_options& connection_options::sasl_allow_insecure_mechs(bool b) { impl
 connection_options& connection_options::sasl_allowed_mechs(const std::string &s) { impl_->sasl_allowed_mechs = s; return *this; }
 connection_options& connection_options::sasl_config_name(const std::string &n) { impl_->sasl_config_name = n; return *this; }
 connection_options& connection_options::sasl_config_path(const std::string &p) { impl_->sasl_config_path = p; return *this; }
+connection_options& connection_options::tcp_nodelay(bool b) { impl_->socket_options[PN_SOCKET_NODELAY] = b; return *this; }
+connection_options& connection_options::socket_send_buffer(int n) { impl_->socket_options[PN_SOCKET_SNDBUF] = n; return *this; }
+connection_options& connection_options::socket_receive_buffer(int n) { impl_->socket_options[PN_SOCKET_RCVBUF] = n; return *this; }
+connection_options& connection_options::tcp_quickack(bool b) { impl_->socket_options[PN_SOCKET_QUICKACK] = b; return *this; }
+connection_options& connection_options::tcp_notsent_lowat(int n) { impl_->socket_options[PN_SOCKET_NOTSENT_LOWAT] = n; return *this; }
+connection_options& connection_options::socket_busy_poll(int usec) { impl_->socket_options[PN_SOCKET_BUSY_POLL] = usec; return *this; }
+connection_options& connection_options::tcp_user_timeout(duration t) { impl_->socket_options[PN_SOCKET_USER_TIMEOUT] = int(t.milliseconds()); return *this; }
 
 void connection_options::apply_unbound(connection& c) const { impl_->apply_unbound(c); }
 void connection_options::apply_unbound_client(pn_transport_t *t) const { impl_->apply_sasl(t); impl_->apply_ssl(t, true); impl_->apply_transport(t); }
 void connection_options::apply_unbound_server(pn_transport_t *t) const { impl_->apply_sasl(t); impl_->apply_ssl(t, false); impl_->apply_transport(t); }
+void connection_options::apply_socket(pn_connection_t *c) const { impl_->apply_socket(c); }
+void connection_options::apply_socket(pn_listener_t *l) const { impl_->apply_socket(l); }
 
 messaging_handler* connection_options::handler() const { return impl_->handler.value; }
 
@@ -28,6 +28,7 @@
 #include "proton/uuid.hpp"
 
 #include "proactor_container_impl.hpp"
+#include "proactor_work_queue_impl.hpp"
 
 namespace proton {
 
@@ -117,11 +118,25 @@ std::string container::id() const { return impl_->id(); }
 
 void container::schedule(duration d, internal::v03::work f) { return impl_->schedule(d, f); }
 #if PN_CPP_HAS_LAMBDAS && PN_CPP_HAS_VARIADIC_TEMPLATES
-void container::schedule(duration d, internal::v11::work f) { return impl_->schedule(d, f); }
+void container::schedule(duration d, internal::v11::work f) { return impl_->schedule(d, move_work(f)); }
 #endif
 
 void container::schedule(duration d, void_function0& f) { return impl_->schedule(d, make_work(&void_function0::operator(), &f)); }
 
+void container::stats_enabled(bool enabled) { impl_->stats_enabled(enabled); }
+bool container::stats_enabled() const { return impl_->stats_enabled(); }
+container_stats container::stats() const { return impl_->stats(-1); }
+
+std::vector<container_stats> container::thread_stats() const {
+    std::vector<container_stats> stats;
+    for (int i = 0, n = impl_->stats_threads(); i < n; ++i) {
+        stats.push_back(impl_->stats(i));
+    }
+    return stats;
+}
+
+void container::clear_stats() { impl_->clear_stats(); }
+
 void container::client_connection_options(const connection_options& c) { impl_->client_connection_options(c); }
 connection_options container::client_connection_options() const { return impl_->client_connection_options(); }
 
@@ -163,6 +163,27 @@ int test_container_no_vhost() {
     return 0;
 }
 
+int test_container_stats() {
+    test_handler th("", proton::connection_options());
+    proton::container c(th);
+    c.stats_enabled(true);
+    if (!c.stats_enabled()) return 0; // Not kept by this proactor
+    c.run();
+    proton::container_stats stats = c.stats();
+    ASSERT(stats.batches > 0);
+    ASSERT(stats.events >= stats.batches);
+    ASSERT(stats.polls > 0);
+    ASSERT(stats.busy_ns > 0);
+    ASSERT_EQUAL(stats.batches, stats.batch_events.count);
+    ASSERT_EQUAL(stats.locks, stats.lock_held.count);
+    std::vector<proton::container_stats> threads = c.thread_stats();
+    ASSERT_EQUAL(1u, threads.size());
+    ASSERT_EQUAL(stats.events, threads[0].events);
+    c.clear_stats();
+    ASSERT_EQUAL(0u, c.stats().batches);
+    return 0;
+}
+
 std::vector<proton::symbol> make_caps(const std::string& s) {
     std::vector<proton::symbol> caps;
     caps.push_back(s);
@@ -417,6 +438,7 @@ int main(int argc, char** argv) {
     RUN_ARGV_TEST(failed, test_container_capabilities());
     RUN_ARGV_TEST(failed, test_container_default_vhost());
     RUN_ARGV_TEST(failed, test_container_no_vhost());
+    RUN_ARGV_TEST(failed, test_container_stats());
     RUN_ARGV_TEST(failed, test_container_bad_address());
     RUN_ARGV_TEST(failed, test_container_stop());
     RUN_ARGV_TEST(failed, test_container_schedule_nohang());
@@ -48,16 +48,12 @@ void cpp_context_finalize(void* v) { reinterpret_cast<context*>(v)->~context();
 #define cpp_context_inspect NULL
 pn_class_t cpp_context_class = PN_CLASS(cpp_context);
 
-// Handles
-PN_HANDLE(CONNECTION_CONTEXT)
-PN_HANDLE(LISTENER_CONTEXT)
-PN_HANDLE(SESSION_CONTEXT)
-PN_HANDLE(LINK_CONTEXT)
-
-template <class T>
-T* get_context(pn_record_t* record, pn_handle_t handle) {
-    return reinterpret_cast<T*>(pn_record_get(record, handle));
-}
+// Handles: each object has only one C++ context so they can all use the
+// well-known PN_CPPCTX handle.
+const pn_handle_t CONNECTION_CONTEXT = PN_CPPCTX;
+const pn_handle_t LISTENER_CONTEXT = PN_CPPCTX;
+const pn_handle_t SESSION_CONTEXT = PN_CPPCTX;
+const pn_handle_t LINK_CONTEXT = PN_CPPCTX;
 
 }
 
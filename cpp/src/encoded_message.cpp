@@ -0,0 +1,63 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "proton/encoded_message.hpp"
+
+#include "proton/error.hpp"
+#include "proton/message.hpp"
+
+#include <proton/shared_bytes.h>
+
+#include <vector>
+
+namespace proton {
+
+encoded_message::encoded_message() : bytes_(0) {}
+
+encoded_message::encoded_message(const message& m) : bytes_(0) {
+    std::vector<char> buf;
+    m.encode(buf);
+    bytes_ = pn_shared_bytes(&buf[0], buf.size());
+    if (!bytes_) throw error("encoded_message: out of memory");
+}
+
+encoded_message::encoded_message(const encoded_message& x) : bytes_(pn_shared_bytes_incref(x.bytes_)) {}
+
+encoded_message& encoded_message::operator=(const encoded_message& x) {
+    pn_shared_bytes_t* old = bytes_;
+    bytes_ = pn_shared_bytes_incref(x.bytes_);
+    pn_shared_bytes_decref(old);
+    return *this;
+}
+
+encoded_message::~encoded_message() { pn_shared_bytes_decref(bytes_); }
+
+bool encoded_message::empty() const { return !bytes_; }
+
+size_t encoded_message::size() const { return bytes_ ? pn_shared_bytes_get(bytes_).size : 0; }
+
+const char* encoded_message::data() const { return bytes_ ? pn_shared_bytes_get(bytes_).start : 0; }
+
+void encoded_message::decode(message& m) const {
+    m.decode(std::vector<char>(data(), data() + size()));
+}
+
+}
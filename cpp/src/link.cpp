@@ -82,6 +82,16 @@ class session link::session() const {
     return make_wrapper(pn_link_session(pn_object()));
 }
 
+link_stats link::stats() const {
+    pn_link_stats_t s = pn_link_stats(pn_object());
+    link_stats stats;
+    stats.deliveries = s.deliveries;
+    stats.bytes = s.bytes;
+    stats.settled = s.settled;
+    stats.credit_blocked = duration(s.credit_blocked);
+    return stats;
+}
+
 error_condition link::error() const {
     return make_wrapper(pn_link_remote_condition(pn_object()));
 }
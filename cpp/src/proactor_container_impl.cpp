@@ -70,6 +70,10 @@ class container::impl::common_work_queue : public work_queue::impl {
     MUTEX(lock_)
     container::impl& container_;
     jobs jobs_;
+    // Jobs taken from jobs_ by run_all_jobs(). Kept between runs and
+    // swapped with jobs_ so that, once both vectors have grown to the
+    // usual batch size, adding work does not allocate.
+    jobs running_jobs_;
     bool finished_;
     bool running_;
 };
@@ -78,24 +82,27 @@ void container::impl::common_work_queue::schedule(duration d, work f) {
     // Note this is an unbounded work queue.
     // A resource-safe implementation should be bounded.
     if (finished_) return;
-    container_.schedule(d, make_work(&work_queue::impl::add_void, (work_queue::impl*)this, f));
+    // The container adds the work to this queue when the timeout fires,
+    // so the work item is not wrapped in another one.
+    container_.schedule(d, move_work(f), this);
 }
 
 void container::impl::common_work_queue::run_all_jobs() {
-    jobs j;
     // Lock this operation for mt
     {
         GUARD(lock_);
         // Ensure that we never run work from this queue concurrently
-        if (running_) return;
+        if (running_ || jobs_.empty()) return;
         running_ = true;
         // But allow adding to the queue concurrently to running
-        std::swap(j, jobs_);
+        std::swap(running_jobs_, jobs_);
     }
     // Run queued work, but ignore any exceptions
-    for (jobs::iterator f = j.begin(); f != j.end(); ++f) try {
+    for (jobs::iterator f = running_jobs_.begin(); f != running_jobs_.end(); ++f) try {
         (*f)();
     } catch (...) {};
+    // Release the work items but keep the capacity for the next batch
+    running_jobs_.clear();
     {
         GUARD(lock_);
         running_ = false;
@@ -117,8 +124,11 @@ bool container::impl::connection_work_queue::add(work f) {
     // A resource-safe implementation should be bounded.
     GUARD(lock_);
     if (finished_) return false;
-    jobs_.push_back(f);
-    pn_connection_wake(connection_);
+    // Only the first job of a batch needs to wake the connection, the
+    // others will be run by the same call to run_all_jobs()
+    bool wake = jobs_.empty();
+    jobs_.push_back(move_work(f));
+    if (wake) pn_connection_wake(connection_);
     return true;
 }
 
@@ -135,7 +145,7 @@ bool container::impl::container_work_queue::add(work f) {
     // A resource-safe implementation should be bounded.
     GUARD(lock_);
     if (finished_) return false;
-    jobs_.push_back(f);
+    jobs_.push_back(move_work(f));
     pn_proactor_set_timeout(container_.proactor_, 0);
     return true;
 }
@@ -216,6 +226,7 @@ void container::impl::start_connection(const url& url, pn_connection_t *pnc) {
     connection_context& cc = connection_context::get(pnc);
     connection_options& co = *cc.connection_options_;
     co.apply_unbound_client(pnt);
+    co.apply_socket(pnc);
     pn_proactor_connect2(proactor_, pnc, pnt, caddr); // Takes ownership of pnc, pnt
 }
 
@@ -403,7 +414,7 @@ returned<receiver> container::impl::open_receiver(const std::string &urlstr, con
     return make_returned<receiver>(pnl);
 }
 
-pn_listener_t* container::impl::listen_common_lh(const std::string& addr) {
+pn_listener_t* container::impl::listen_common_lh(const std::string& addr, const connection_options* opts) {
     if (stopping_)
         throw proton::error("container is stopping");
 
@@ -416,6 +427,10 @@ pn_listener_t* container::impl::listen_common_lh(const std::string& addr) {
 
     pn_listener_t* listener = pn_listener();
     pn_listener_set_context(listener, &container_);
+    // Socket options for the listening socket, accepted connections get them again in on_accept
+    connection_options lopts(server_connection_options_);
+    if (opts) lopts.update(*opts);
+    lopts.apply_socket(listener);
     pn_proactor_listen(proactor_, listener, &caddr[0], 16);
     return listener;
 }
@@ -428,7 +443,7 @@ proton::listener container::impl::listen(const std::string& addr) {
 
 proton::listener container::impl::listen(const std::string& addr, const proton::connection_options& opts) {
     GUARD(lock_);
-    pn_listener_t* listener = listen_common_lh(addr);
+    pn_listener_t* listener = listen_common_lh(addr, &opts);
     listener_context& lc=listener_context::get(listener);
     lc.connection_options_.reset(new connection_options(opts));
     return proton::listener(listener);
@@ -443,12 +458,18 @@ proton::listener container::impl::listen(const std::string& addr, proton::listen
 }
 
 void container::impl::schedule(duration delay, work f) {
+    schedule(delay, move_work(f), 0);
+}
+
+void container::impl::schedule(duration delay, work f, work_queue::impl* queue) {
     GUARD(deferred_lock_);
     timestamp now = timestamp::now();
 
     // Record timeout; Add callback to timeout sorted list
-    scheduled s = {now+delay, f};
-    deferred_.push_back(s);
+    deferred_.push_back(scheduled());
+    deferred_.back().time = now+delay;
+    deferred_.back().task = move_work(f);
+    deferred_.back().queue = queue;
     std::push_heap(deferred_.begin(), deferred_.end());
 
     // Set timeout for current head of timeout queue
@@ -512,8 +533,14 @@ void container::impl::run_timer_jobs() {
             // so don't need to copy and can just swap
             tasks.swap(deferred_);
         } else {
-            // Otherwise just copy the ones we sorted
-            tasks = std::vector<scheduled>(deferred_.end()-i, deferred_.end());
+            // Otherwise just take the ones we sorted
+            tasks.resize(i);
+            for (unsigned j = 0; j < i; ++j) {
+                scheduled& t = deferred_[deferred_.size()-i+j];
+                tasks[j].time = t.time;
+                tasks[j].task = move_work(t.task);
+                tasks[j].queue = t.queue;
+            }
 
             // Remove tasks to be executed
             deferred_.resize(deferred_.size()-i);
@@ -522,7 +549,11 @@ void container::impl::run_timer_jobs() {
     // We've now taken the tasks to run from the deferred tasks
     // so we can run them unlocked
     // NB. We copied the due tasks in reverse order so execute from end
-    for (int i = tasks.size()-1; i>=0; --i) tasks[i].task();
+    for (int i = tasks.size()-1; i>=0; --i) {
+        scheduled& t = tasks[i];
+        if (t.queue) t.queue->add(move_work(t.task));
+        else t.task();
+    }
 }
 
 // Return true if this thread is finished
@@ -610,6 +641,7 @@ container::impl::dispatch_result container::impl::dispatch(pn_event_t* event) {
         pn_transport_t* pnt = pn_transport();
         pn_transport_set_server(pnt);
         opts.apply_unbound_server(pnt);
+        opts.apply_socket(c);
         pn_listener_accept2(l, c, pnt);
         return ContinueLoop;
     }
@@ -816,6 +848,49 @@ void container::impl::auto_stop(bool set) {
     auto_stop_ = set;
 }
 
+void container::impl::stats_enabled(bool enabled) {
+    pn_proactor_set_stats_enabled(proactor_, enabled);
+}
+
+bool container::impl::stats_enabled() const {
+    return pn_proactor_get_stats_enabled(proactor_);
+}
+
+int container::impl::stats_threads() const {
+    return pn_proactor_stats_threads(proactor_);
+}
+
+container_stats container::impl::stats(int thread) const {
+    container_stats stats;
+    pn_proactor_stats_t s;
+    pn_proactor_stats(proactor_, thread, &s);
+    stats.polls = s.polls;
+    stats.batches = s.batches;
+    stats.events = s.events;
+    stats.wakes = s.wakes;
+    stats.hog_limits = s.hog_limits;
+    stats.rearms = s.rearms;
+    stats.locks = s.locks;
+    stats.lock_held_ns = s.lock_held_ns;
+    stats.busy_ns = s.busy_ns;
+    stats.idle_ns = s.idle_ns;
+    pn_histogram_t *h = pn_histogram();
+    if (h) {
+        pn_proactor_stats_distribution(proactor_, thread, PN_PROACTOR_BATCH_EVENTS, h);
+        stats.batch_events = make_latency_summary(h);
+        pn_proactor_stats_distribution(proactor_, thread, PN_PROACTOR_WAKE_LATENCY, h);
+        stats.wake_latency = make_latency_summary(h);
+        pn_proactor_stats_distribution(proactor_, thread, PN_PROACTOR_LOCK_HELD, h);
+        stats.lock_held = make_latency_summary(h);
+        pn_histogram_free(h);
+    }
+    return stats;
+}
+
+void container::impl::clear_stats() {
+    pn_proactor_clear_stats(proactor_);
+}
+
 void container::impl::stop(const proton::error_condition& err) {
     {
         GUARD(lock_);
@@ -92,6 +92,11 @@ class container::impl {
     void stop(const error_condition& err);
     void auto_stop(bool set);
     void schedule(duration, work);
+    void stats_enabled(bool);
+    bool stats_enabled() const;
+    int stats_threads() const;
+    container_stats stats(int thread) const;
+    void clear_stats();
     template <class T> static void set_handler(T s, messaging_handler* h);
     template <class T> static messaging_handler* get_handler(T s);
     messaging_handler* get_handler(pn_event_t *event);
@@ -101,7 +106,7 @@ class container::impl {
     class common_work_queue;
     class connection_work_queue;
     class container_work_queue;
-    pn_listener_t* listen_common_lh(const std::string&);
+    pn_listener_t* listen_common_lh(const std::string&, const connection_options* = 0);
     pn_connection_t* make_connection_lh(const url& url, const connection_options&);
     void setup_connection_lh(const url& url, pn_connection_t *pnc);
     void start_connection(const url& url, pn_connection_t* c);
@@ -116,6 +121,7 @@ class container::impl {
     enum dispatch_result {ContinueLoop, EndBatch, EndLoop};
     dispatch_result dispatch(pn_event_t*);
     void run_timer_jobs();
+    void schedule(duration, work, work_queue::impl*);
 
     int threads_;
     container& container_;
@@ -135,6 +141,9 @@ class container::impl {
     struct scheduled {
         timestamp time; // duration from epoch for task
         work task;
+        work_queue::impl* queue; // If set, add task to this queue when due
+
+        scheduled() : queue(0) {}
 
         // We want to get to get the *earliest* first so test is "reversed"
         bool operator < (const scheduled& r) const { return  r.time < time; }
@@ -23,14 +23,25 @@
  */
 
 #include "proton/fwd.hpp"
+#include "proton/internal/config.hpp"
+
+#include <utility>
 
 namespace proton {
 
+// Hand on a work item without copying the function it wraps where the
+// language allows it.
+#if PN_CPP_HAS_RVALUE_REFERENCES
+inline work&& move_work(work& f) { return std::move(f); }
+#else
+inline work& move_work(work& f) { return f; }
+#endif
+
 class work_queue::impl {
   public:
     virtual ~impl() {};
     virtual bool add(work f) = 0;
-    void add_void(work f) { add(f); }
+    void add_void(work f) { add(move_work(f)); }
     virtual void schedule(duration, work) = 0;
     virtual void run_all_jobs() = 0;
     virtual void finished() = 0;
@@ -19,12 +19,14 @@
 
 #include "proton_bits.hpp"
 #include "proton/error_condition.hpp"
+#include "proton/sender.hpp"
 
 #include <string>
 #include <ostream>
 
 #include <proton/condition.h>
 #include <proton/error.h>
+#include <proton/histogram.h>
 #include <proton/object.h>
 
 namespace proton {
@@ -61,6 +63,19 @@ std::ostream& operator<<(std::ostream& o, const inspectable& object) {
     return o;
 }
 
+latency_summary make_latency_summary(const pn_histogram_t* h) {
+    latency_summary summary;
+    summary.count = pn_histogram_count(h);
+    summary.min = pn_histogram_min(h);
+    summary.max = pn_histogram_max(h);
+    summary.mean = pn_histogram_mean(h);
+    summary.p50 = pn_histogram_percentile(h, 50);
+    summary.p90 = pn_histogram_percentile(h, 90);
+    summary.p99 = pn_histogram_percentile(h, 99);
+    summary.p999 = pn_histogram_percentile(h, 99.9);
+    return summary;
+}
+
 void set_error_condition(const error_condition& e, pn_condition_t *c) {
     pn_condition_clear(c);
 
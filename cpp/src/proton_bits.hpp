@@ -46,6 +46,7 @@ struct pn_acceptor_t;
 struct pn_terminus_t;
 struct pn_reactor_t;
 struct pn_record_t;
+struct pn_histogram_t;
 
 namespace proton {
 
@@ -68,6 +69,7 @@ class source;
 class target;
 class reactor;
 class messaging_handler;
+struct latency_summary;
 
 std::string error_str(long code);
 
@@ -82,6 +84,9 @@ std::ostream& operator<<(std::ostream& o, const inspectable& object);
 
 void set_error_condition(const error_condition&, pn_condition_t*);
 
+/// Summarize the values recorded in a histogram.
+latency_summary make_latency_summary(const pn_histogram_t*);
+
 /// Convert a const char* to std::string, convert NULL to the empty string.
 inline std::string str(const char* s) { return s ? s : std::string(); }
 
@@ -21,6 +21,8 @@
 
 #include "proton/sender.hpp"
 
+#include "proton/encoded_message.hpp"
+#include "proton/error.hpp"
 #include "proton/link.hpp"
 #include "proton/sender_options.hpp"
 #include "proton/source.hpp"
@@ -62,22 +64,38 @@ class target sender::target() const {
 namespace {
 // TODO: revisit if thread safety required
 uint64_t tag_counter = 0;
+
+pn_delivery_t *new_delivery(pn_link_t *l) {
+    uint64_t id = ++tag_counter;
+    return pn_delivery(l, pn_dtag(reinterpret_cast<const char*>(&id), sizeof(id)));
+}
+
+// Finish sending the current delivery
+tracker complete_send(pn_link_t *l, pn_delivery_t *dlv) {
+    pn_link_advance(l);
+    if (pn_link_snd_settle_mode(l) == PN_SND_SETTLED)
+        pn_delivery_settle(dlv);
+    if (!pn_link_credit(l))
+        link_context::get(l).draining = false;
+    return make_wrapper<tracker>(dlv);
+}
 }
 
 tracker sender::send(const message &message) {
-    uint64_t id = ++tag_counter;
-    pn_delivery_t *dlv =
-        pn_delivery(pn_object(), pn_dtag(reinterpret_cast<const char*>(&id), sizeof(id)));
+    pn_delivery_t *dlv = new_delivery(pn_object());
     std::vector<char> buf;
     message.encode(buf);
     assert(!buf.empty());
     pn_link_send(pn_object(), &buf[0], buf.size());
-    pn_link_advance(pn_object());
-    if (pn_link_snd_settle_mode(pn_object()) == PN_SND_SETTLED)
-        pn_delivery_settle(dlv);
-    if (!pn_link_credit(pn_object()))
-        link_context::get(pn_object()).draining = false;
-    return make_wrapper<tracker>(dlv);
+    return complete_send(pn_object(), dlv);
+}
+
+tracker sender::send(const encoded_message &message) {
+    if (message.empty())
+        throw proton::error("sender send: empty encoded message");
+    pn_delivery_t *dlv = new_delivery(pn_object());
+    pn_link_send_shared(pn_object(), message.bytes_);
+    return complete_send(pn_object(), dlv);
 }
 
 void sender::return_credit() {
@@ -86,6 +104,19 @@ void sender::return_credit() {
     pn_link_drained(pn_object());
 }
 
+void sender::latency_tracking(bool enabled) {
+    pn_link_set_latency_tracking(pn_object(), enabled);
+}
+
+bool sender::latency_tracking() const {
+    return pn_link_get_latency_tracking(pn_object());
+}
+
+latency_summary sender::latency(enum latency_stage stage) const {
+    const pn_histogram_t *h = pn_link_latency(pn_object(), pn_latency_stage_t(stage));
+    return h ? make_latency_summary(h) : latency_summary();
+}
+
 sender_iterator sender_iterator::operator++() {
     if (!!obj_) {
         pn_link_t *lnk = pn_link_next(obj_.pn_object(), 0);
@@ -47,7 +47,7 @@ bool work_queue::add(internal::v03::work f) {
 bool work_queue::add(internal::v11::work f) {
     // If we have no actual work queue, then can't defer
     if (!impl_) return false;
-    return impl_->add(f);
+    return impl_->add(move_work(f));
 }
 #endif
 
@@ -65,7 +65,7 @@ void work_queue::schedule(duration d, internal::v03::work f) {
 void work_queue::schedule(duration d, internal::v11::work f) {
     // If we have no actual work queue, then can't defer
     if (!impl_) return;
-    return impl_->schedule(d, f);
+    return impl_->schedule(d, move_work(f));
 }
 #endif
 
@@ -0,0 +1,201 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "proton/container.hpp"
+#include "proton/work_queue.hpp"
+#include "test_bits.hpp"
+
+#if PN_CPP_HAS_LAMBDAS && PN_CPP_HAS_VARIADIC_TEMPLATES
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <utility>
+
+// Count heap allocations made by each thread.
+thread_local unsigned long allocations = 0;
+
+void* operator new(std::size_t n) {
+    ++allocations;
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+
+namespace {
+
+// Take the count before the assertion macros allocate their messages.
+#define ASSERT_ALLOCATED(WANT, BEFORE) do {                     \
+        unsigned long allocated = allocations - (BEFORE);      \
+        ASSERT_EQUAL((WANT), allocated);                        \
+    } while (0)
+
+// Function object that counts its calls and its live copies. PAD makes
+// it too big to store inline.
+template <std::size_t PAD> struct counted {
+    int* calls;
+    int* live;
+    char pad[PAD];
+
+    counted(int& c, int& l) : calls(&c), live(&l) { ++*live; }
+    counted(const counted& x) noexcept : calls(x.calls), live(x.live) { ++*live; }
+    ~counted() { --*live; }
+    void operator()() { ++*calls; }
+};
+
+typedef counted<1> small_fn;
+typedef counted<64> big_fn;
+
+// Aligned more strictly than the inline storage.
+struct alignas(2*alignof(void*)) aligned_fn {
+    std::uintptr_t* address;
+    void operator()() { *address = reinterpret_cast<std::uintptr_t>(this); }
+};
+
+void test_empty() {
+    proton::work w;
+    ASSERT_THROWS(std::bad_function_call, w());
+    proton::work copy(w);
+    ASSERT_THROWS(std::bad_function_call, copy());
+    proton::work moved(std::move(w));
+    ASSERT_THROWS(std::bad_function_call, moved());
+}
+
+template <class F> void check_copy_move(unsigned long allocs_per_copy) {
+    int calls = 0, live = 0;
+    {
+        unsigned long before = allocations;
+        proton::work w(F(calls, live));
+        ASSERT_ALLOCATED(allocs_per_copy, before);
+        ASSERT_EQUAL(1, live);
+        w();
+        ASSERT_EQUAL(1, calls);
+
+        before = allocations;
+        proton::work copy(w);
+        ASSERT_ALLOCATED(allocs_per_copy, before);
+        ASSERT_EQUAL(2, live);
+        copy();
+        w();
+        ASSERT_EQUAL(3, calls);
+
+        // Moving never allocates and leaves the source empty
+        before = allocations;
+        proton::work moved(std::move(w));
+        ASSERT_ALLOCATED(0UL, before);
+        ASSERT_EQUAL(2, live);
+        ASSERT_THROWS(std::bad_function_call, w());
+        moved();
+        ASSERT_EQUAL(4, calls);
+
+        // A moved-from work can be assigned to again
+        w = copy;
+        ASSERT_EQUAL(3, live);
+        w();
+        ASSERT_EQUAL(5, calls);
+
+        before = allocations;
+        copy = std::move(moved);
+        ASSERT_ALLOCATED(0UL, before);
+        ASSERT_EQUAL(2, live);
+        ASSERT_THROWS(std::bad_function_call, moved());
+        copy();
+        ASSERT_EQUAL(6, calls);
+    }
+    ASSERT_EQUAL(0, live);
+}
+
+void test_inline() { check_copy_move<small_fn>(0); }
+
+void test_heap() { check_copy_move<big_fn>(1); }
+
+void test_assign_across() {
+    int small_calls = 0, big_calls = 0, live = 0;
+    {
+        proton::work small(small_fn(small_calls, live));
+        proton::work big(big_fn(big_calls, live));
+        proton::work w(small);
+        ASSERT_EQUAL(3, live);
+        w = big;                // Inline replaced by heap
+        ASSERT_EQUAL(3, live);
+        w();
+        ASSERT_EQUAL(1, big_calls);
+        w = small;              // Heap replaced by inline
+        ASSERT_EQUAL(3, live);
+        w();
+        ASSERT_EQUAL(1, small_calls);
+        w = std::move(big);
+        ASSERT_EQUAL(2, live);
+        w();
+        ASSERT_EQUAL(2, big_calls);
+        w = w;                  // Self assignment keeps the item
+        w();
+        ASSERT_EQUAL(3, big_calls);
+    }
+    ASSERT_EQUAL(0, live);
+}
+
+void test_over_aligned() {
+    std::uintptr_t address = 0;
+    aligned_fn f = { &address };
+    unsigned long before = allocations;
+    proton::work w(f);
+    ASSERT_ALLOCATED(1UL, before);
+    proton::work moved(std::move(w));
+    moved();
+    ASSERT(address != 0);
+    ASSERT_EQUAL(0U, address % alignof(aligned_fn));
+}
+
+// Adding small work to a work queue allocates only to grow the queue.
+void test_work_queue_add() {
+    proton::container c;
+    proton::work_queue q(c);
+    int calls = 0;
+    const int n = 1000;
+    unsigned long before = allocations;
+    for (int i = 0; i < n; ++i)
+        ASSERT(q.add([&calls]() { ++calls; }));
+    // The job vector doubles in size, so 1000 adds need about 10 allocations
+    unsigned long allocated = allocations - before;
+    ASSERT(allocated <= 16);
+    ASSERT_EQUAL(0, calls);
+}
+
+}
+
+int main(int, char**) {
+    int failed = 0;
+    RUN_TEST(failed, test_empty());
+    RUN_TEST(failed, test_inline());
+    RUN_TEST(failed, test_heap());
+    RUN_TEST(failed, test_assign_across());
+    RUN_TEST(failed, test_over_aligned());
+    RUN_TEST(failed, test_work_queue_add());
+    return failed;
+}
+
+#else
+
+int main(int, char**) { return 0; }
+
+#endif
@@ -0,0 +1,267 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+package amqp
+
+//
+// Decoding AMQP bytes directly to common Go types.
+//
+// The counterpart of encode.go: values are decoded to the same Go types that
+// getInterface() would produce. Anything unusual - arrays, decimals, map keys
+// that are not valid Go map keys, truncated or malformed data - reports !ok
+// and the caller falls back to decoding via a pn_data_t, which also takes care
+// of producing the right error.
+//
+
+import (
+	"encoding/binary"
+	"math"
+	"reflect"
+	"time"
+)
+
+// decodeValue decodes the AMQP value at the start of b as getInterface() would.
+// Returns the value and the number of bytes used, or ok == false.
+func decodeValue(b []byte) (v interface{}, n int, ok bool) {
+	if len(b) == 0 {
+		return nil, 0, false
+	}
+	code, b := b[0], b[1:]
+	if code == codeDescribed {
+		var d Described
+		var n1, n2 int
+		if d.Descriptor, n1, ok = decodeValue(b); ok {
+			if d.Value, n2, ok = decodeValue(b[n1:]); ok {
+				return d, 1 + n1 + n2, true
+			}
+		}
+		return nil, 0, false
+	}
+	// Fixed width codes, the width is given by the top 4 bits of the code.
+	switch code {
+	case codeNull:
+		return nil, 1, true
+	case codeTrue:
+		return true, 1, true
+	case codeFalse:
+		return false, 1, true
+	case codeUint0:
+		return uint32(0), 1, true
+	case codeUlong0:
+		return uint64(0), 1, true
+	case codeList0:
+		return List{}, 1, true
+	}
+	if len(b) < 1 {
+		return nil, 0, false
+	}
+	switch code {
+	case codeBool:
+		return b[0] != 0, 2, true
+	case codeUbyte:
+		return uint8(b[0]), 2, true
+	case codeByte:
+		return int8(b[0]), 2, true
+	case codeSmallUint:
+		return uint32(b[0]), 2, true
+	case codeSmallUlong:
+		return uint64(b[0]), 2, true
+	case codeSmallInt:
+		return int32(int8(b[0])), 2, true
+	case codeSmallLong:
+		return int64(int8(b[0])), 2, true
+	case codeBinary8, codeString8, codeSymbol8:
+		if size := int(b[0]); len(b) >= 1+size {
+			return variableValue(code, b[1:1+size]), 2 + size, true
+		}
+		return nil, 0, false
+	case codeList8, codeMap8:
+		// The size includes the count byte
+		if size := int(b[0]); size >= 1 && len(b) >= 1+size {
+			return compoundValue(code, b[2:1+size], int(b[1]), 2+size)
+		}
+		return nil, 0, false
+	}
+	if len(b) < 2 {
+		return nil, 0, false
+	}
+	switch code {
+	case codeUshort:
+		return binary.BigEndian.Uint16(b), 3, true
+	case codeShort:
+		return int16(binary.BigEndian.Uint16(b)), 3, true
+	}
+	if len(b) < 4 {
+		return nil, 0, false
+	}
+	switch code {
+	case codeUint:
+		return binary.BigEndian.Uint32(b), 5, true
+	case codeInt:
+		return int32(binary.BigEndian.Uint32(b)), 5, true
+	case codeFloat:
+		return math.Float32frombits(binary.BigEndian.Uint32(b)), 5, true
+	case codeChar:
+		return Char(binary.BigEndian.Uint32(b)), 5, true
+	case codeBinary32, codeString32, codeSymbol32:
+		size := binary.BigEndian.Uint32(b)
+		if uint64(len(b)) >= 4+uint64(size) {
+			return variableValue(code, b[4:4+size]), 5 + int(size), true
+		}
+		return nil, 0, false
+	case codeList32, codeMap32:
+		size := binary.BigEndian.Uint32(b)
+		if size >= 4 && uint64(len(b)) >= 4+uint64(size) {
+			count := binary.BigEndian.Uint32(b[4:])
+			return compoundValue(code, b[8:4+size], int(count), 5+int(size))
+		}
+		return nil, 0, false
+	}
+	if len(b) < 8 {
+		return nil, 0, false
+	}
+	switch code {
+	case codeUlong:
+		return binary.BigEndian.Uint64(b), 9, true
+	case codeLong:
+		return int64(binary.BigEndian.Uint64(b)), 9, true
+	case codeDouble:
+		return math.Float64frombits(binary.BigEndian.Uint64(b)), 9, true
+	case codeTimestamp:
+		if t := int64(binary.BigEndian.Uint64(b)); t != 0 {
+			return time.Unix(0, t*int64(time.Millisecond)), 9, true
+		}
+		return time.Time{}, 9, true
+	}
+	if len(b) < 16 {
+		return nil, 0, false
+	}
+	if code == codeUUID {
+		var u UUID
+		copy(u[:], b)
+		return u, 17, true
+	}
+	return nil, 0, false // Arrays, decimals or bad data
+}
+
+func variableValue(code byte, b []byte) interface{} {
+	switch code {
+	case codeBinary8, codeBinary32:
+		return Binary(b)
+	case codeSymbol8, codeSymbol32:
+		return Symbol(b)
+	default:
+		return string(b)
+	}
+}
+
+// compoundValue decodes count elements of a list or map from b.
+// n is the total encoded size to return on success.
+func compoundValue(code byte, b []byte, count int, n int) (interface{}, int, bool) {
+	if count > len(b) { // Each element needs at least one byte
+		return nil, 0, false
+	}
+	if code == codeList8 || code == codeList32 {
+		l := make(List, count)
+		for i := range l {
+			x, used, ok := decodeValue(b)
+			if !ok {
+				return nil, 0, false
+			}
+			l[i], b = x, b[used:]
+		}
+		return l, n, true
+	}
+	if count%2 != 0 {
+		return nil, 0, false
+	}
+	m := make(Map, count/2)
+	for i := 0; i < count; i += 2 {
+		k, used, ok := decodeValue(b)
+		if !ok || !hashable(k) {
+			return nil, 0, false // AnyMap, leave it to the pn_data_t decoder
+		}
+		b = b[used:]
+		x, used, ok := decodeValue(b)
+		if !ok {
+			return nil, 0, false
+		}
+		m[k], b = x, b[used:]
+	}
+	return m, n, true
+}
+
+// hashable is true if the decoded value k can be a Map key. A Described is
+// comparable, but not if its descriptor or value is a List or Map.
+func hashable(k interface{}) bool {
+	switch k := k.(type) {
+	case nil:
+		return true
+	case Described:
+		return hashable(k.Descriptor) && hashable(k.Value)
+	default:
+		return reflect.TypeOf(k).Comparable()
+	}
+}
+
+// unmarshalFast decodes the value at the start of bytes into v for the
+// common cases that need no conversion. Returns false if the caller must use
+// unmarshal() via a pn_data_t instead.
+func unmarshalFast(bytes []byte, v interface{}) (n int, ok bool) {
+	x, n, ok := decodeValue(bytes)
+	if !ok {
+		return 0, false
+	}
+	switch v := v.(type) {
+	case *interface{}:
+		*v = x
+		return n, true
+	case *string:
+		switch x := x.(type) {
+		case string:
+			*v = x
+		case Symbol:
+			*v = string(x)
+		case Binary:
+			*v = string(x)
+		default:
+			return 0, false
+		}
+		return n, true
+	case *[]byte:
+		switch x := x.(type) {
+		case string:
+			*v = []byte(x)
+		case Symbol:
+			*v = []byte(x)
+		case Binary:
+			*v = []byte(x)
+		default:
+			return 0, false
+		}
+		return n, true
+	}
+	// Exact type match, e.g. *Map, *List, *Symbol, *int32
+	if rv := reflect.ValueOf(v); x != nil && rv.Kind() == reflect.Ptr && !rv.IsNil() &&
+		rv.Type().Elem() == reflect.TypeOf(x) {
+		rv.Elem().Set(reflect.ValueOf(x))
+		return n, true
+	}
+	return 0, false
+}
@@ -0,0 +1,291 @@
+/*
+Licensed to the Apache Software Foundation (ASF) under one
+or more contributor license agreements.  See the NOTICE file
+distributed with this work for additional information
+regarding copyright ownership.  The ASF licenses this file
+to you under the Apache License, Version 2.0 (the
+"License"); you may not use this file except in compliance
+with the License.  You may obtain a copy of the License at
+
+  http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing,
+software distributed under the License is distributed on an
+"AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+KIND, either express or implied.  See the License for the
+specific language governing permissions and limitations
+under the License.
+*/
+
+package amqp
+
+//
+// Encoding common Go types directly to AMQP bytes.
+//
+// Marshalling through a pn_data_t costs several cgo calls per value. The
+// functions here encode the commonly used types in Go, writing straight into
+// the output slice. They produce the same bytes as marshal() followed by
+// pn_data_encode(), so the two paths can be mixed freely. Described lists keep
+// their trailing nulls, as with marshal(): pn_data_encode() only omits them
+// from lists built with pn_data_fill(). Anything they don't handle (arrays,
+// reflected map and slice types) reports !ok and the caller falls back to
+// marshal().
+//
+
+import (
+	"encoding/binary"
+	"math"
+	"time"
+)
+
+// AMQP 1.0 encoding format codes.
+const (
+	codeDescribed  = 0x00
+	codeNull       = 0x40
+	codeTrue       = 0x41
+	codeFalse      = 0x42
+	codeBool       = 0x56
+	codeUbyte      = 0x50
+	codeUshort     = 0x60
+	codeUint       = 0x70
+	codeSmallUint  = 0x52
+	codeUint0      = 0x43
+	codeUlong      = 0x80
+	codeSmallUlong = 0x53
+	codeUlong0     = 0x44
+	codeByte       = 0x51
+	codeShort      = 0x61
+	codeInt        = 0x71
+	codeSmallInt   = 0x54
+	codeLong       = 0x81
+	codeSmallLong  = 0x55
+	codeFloat      = 0x72
+	codeDouble     = 0x82
+	codeChar       = 0x73
+	codeTimestamp  = 0x83
+	codeUUID       = 0x98
+	codeBinary8    = 0xa0
+	codeBinary32   = 0xb0
+	codeString8    = 0xa1
+	codeString32   = 0xb1
+	codeSymbol8    = 0xa3
+	codeSymbol32   = 0xb3
+	codeList0      = 0x45
+	codeList8      = 0xc0
+	codeList32     = 0xd0
+	codeMap8       = 0xc1
+	codeMap32      = 0xd1
+)
+
+// appendValue appends the AMQP encoding of v to b.
+// Returns ok == false if v contains a type that must be marshalled via a pn_data_t,
+// the returned slice is then meaningless.
+func appendValue(b []byte, v interface{}) ([]byte, bool) {
+	switch v := v.(type) {
+	case nil:
+		return append(b, codeNull), true
+	case bool:
+		if v {
+			return append(b, codeTrue), true
+		}
+		return append(b, codeFalse), true
+
+	case int8:
+		return append(b, codeByte, byte(v)), true
+	case int16:
+		return appendUint16(append(b, codeShort), uint16(v)), true
+	case int32:
+		return appendInt32(b, v), true
+	case int64:
+		return appendInt64(b, v), true
+	case int:
+		if intIs64 {
+			return appendInt64(b, int64(v)), true
+		}
+		return appendInt32(b, int32(v)), true
+
+	case uint8:
+		return append(b, codeUbyte, v), true
+	case uint16:
+		return appendUint16(append(b, codeUshort), v), true
+	case uint32:
+		return appendUint32(b, v), true
+	case uint64:
+		return appendUint64(b, v), true
+	case uint:
+		if intIs64 {
+			return appendUint64(b, uint64(v)), true
+		}
+		return appendUint32(b, uint32(v)), true
+
+	case float32:
+		return appendUint32Raw(append(b, codeFloat), math.Float32bits(v)), true
+	case float64:
+		return appendUint64Raw(append(b, codeDouble), math.Float64bits(v)), true
+
+	case string:
+		return appendVariable(b, codeString8, codeString32, v), true
+	case []byte:
+		return appendVariable(b, codeBinary8, codeBinary32, string(v)), true
+	case Binary:
+		return appendVariable(b, codeBinary8, codeBinary32, string(v)), true
+	case Symbol:
+		return appendVariable(b, codeSymbol8, codeSymbol32, string(v)), true
+
+	case time.Time:
+		return appendUint64Raw(append(b, codeTimestamp), uint64(pnTime(v))), true
+	case UUID:
+		return append(append(b, codeUUID), v[:]...), true
+	case Char:
+		return appendUint32Raw(append(b, codeChar), uint32(v)), true
+
+	case Described:
+		b = append(b, codeDescribed)
+		if b, ok := appendValue(b, v.Descriptor); ok {
+			return appendValue(b, v.Value)
+		}
+		return b, false
+	case AnnotationKey:
+		return appendValue(b, v.Get())
+
+	case List:
+		return appendList(b, []interface{}(v))
+	case []interface{}:
+		return appendList(b, v)
+
+	case Map:
+		b, start := beginCompound(b, codeMap32, 2*len(v))
+		for k, x := range v {
+			var ok bool
+			if b, ok = appendValue(b, k); ok {
+				b, ok = appendValue(b, x)
+			}
+			if !ok {
+				return b, false
+			}
+		}
+		return endCompound(b, start), true
+	case map[string]interface{}:
+		b, start := beginCompound(b, codeMap32, 2*len(v))
+		for k, x := range v {
+			var ok bool
+			if b, ok = appendValue(appendVariable(b, codeString8, codeString32, k), x); !ok {
+				return b, false
+			}
+		}
+		return endCompound(b, start), true
+	case map[Symbol]interface{}:
+		b, start := beginCompound(b, codeMap32, 2*len(v))
+		for k, x := range v {
+			var ok bool
+			if b, ok = appendValue(appendVariable(b, codeSymbol8, codeSymbol32, string(k)), x); !ok {
+				return b, false
+			}
+		}
+		return endCompound(b, start), true
+	case map[AnnotationKey]interface{}:
+		b, start := beginCompound(b, codeMap32, 2*len(v))
+		for k, x := range v {
+			var ok bool
+			if b, ok = appendValue(b, k.Get()); ok {
+				b, ok = appendValue(b, x)
+			}
+			if !ok {
+				return b, false
+			}
+		}
+		return endCompound(b, start), true
+	case AnyMap:
+		b, start := beginCompound(b, codeMap32, 2*len(v))
+		for _, kv := range v {
+			var ok bool
+			if b, ok = appendValue(b, kv.Key); ok {
+				b, ok = appendValue(b, kv.Value)
+			}
+			if !ok {
+				return b, false
+			}
+		}
+		return endCompound(b, start), true
+	}
+	return b, false
+}
+
+func appendList(b []byte, l []interface{}) ([]byte, bool) {
+	if len(l) == 0 {
+		return append(b, codeList0), true
+	}
+	b, start := beginCompound(b, codeList32, len(l))
+	for _, x := range l {
+		var ok bool
+		if b, ok = appendValue(b, x); !ok {
+			return b, false
+		}
+	}
+	return endCompound(b, start), true
+}
+
+// beginCompound appends the code and count of a list or map, leaving space for the size.
+// Returns the offset of the size to be filled in by endCompound.
+func beginCompound(b []byte, code byte, count int) ([]byte, int) {
+	b = append(b, code)
+	start := len(b)
+	return appendUint32Raw(append(b, 0, 0, 0, 0), uint32(count)), start
+}
+
+// endCompound fills in the size of the list or map started at start.
+func endCompound(b []byte, start int) []byte {
+	binary.BigEndian.PutUint32(b[start:], uint32(len(b)-start-4))
+	return b
+}
+
+// appendVariable appends a string, symbol or binary using the 8-bit size form if possible.
+func appendVariable(b []byte, code8, code32 byte, s string) []byte {
+	if len(s) < 256 {
+		b = append(b, code8, byte(len(s)))
+	} else {
+		b = appendUint32Raw(append(b, code32), uint32(len(s)))
+	}
+	return append(b, s...)
+}
+
+func appendInt32(b []byte, v int32) []byte {
+	if -128 <= v && v <= 127 {
+		return append(b, codeSmallInt, byte(v))
+	}
+	return appendUint32Raw(append(b, codeInt), uint32(v))
+}
+
+func appendInt64(b []byte, v int64) []byte {
+	if -128 <= v && v <= 127 {
+		return append(b, codeSmallLong, byte(v))
+	}
+	return appendUint64Raw(append(b, codeLong), uint64(v))
+}
+
+func appendUint32(b []byte, v uint32) []byte {
+	if v < 256 {
+		return append(b, codeSmallUint, byte(v))
+	}
+	return appendUint32Raw(append(b, codeUint), v)
+}
+
+func appendUint64(b []byte, v uint64) []byte {
+	if v < 256 {
+		return append(b, codeSmallUlong, byte(v))
+	}
+	return appendUint64Raw(append(b, codeUlong), v)
+}
+
+func appendUint16(b []byte, v uint16) []byte {
+	return append(b, byte(v>>8), byte(v))
+}
+
+func appendUint32Raw(b []byte, v uint32) []byte {
+	return append(b, byte(v>>24), byte(v>>16), byte(v>>8), byte(v))
+}
+
+func appendUint64Raw(b []byte, v uint64) []byte {
+	return append(b, byte(v>>56), byte(v>>48), byte(v>>40), byte(v>>32),
+		byte(v>>24), byte(v>>16), byte(v>>8), byte(v))
+}
@@ -102,9 +102,20 @@ Go types are encoded as follows
 The following Go types cannot be marshaled: uintptr, function, channel, struct, complex64/128
 
 AMQP types not yet supported: decimal32/64/128
+
+Common types are encoded directly in Go; arrays and other reflected map and
+slice types are encoded via the proton C library. Both give the same bytes.
 */
 
 func Marshal(v interface{}, buffer []byte) (outbuf []byte, err error) {
+	if b, ok := appendValue(buffer[:0], v); ok {
+		return b, nil
+	}
+	return marshalData(v, buffer)
+}
+
+// marshalData marshals v via a pn_data_t, for types that appendValue() can't handle.
+func marshalData(v interface{}, buffer []byte) (outbuf []byte, err error) {
 	data := C.pn_data(0)
 	defer C.pn_data_free(data)
 	if err = recoverMarshal(v, data); err != nil {
@@ -20,8 +20,10 @@ under the License.
 package amqp
 
 import (
+	"bytes"
 	"strings"
 	"testing"
+	"time"
 
 	"qpid.apache.org/internal/test"
 )
@@ -143,6 +145,28 @@ func TestAnyMap(t *testing.T) {
 	}
 }
 
+// A described list is comparable but cannot be a Go map key
+func TestUnmarshalDescribedKey(t *testing.T) {
+	in := AnyMap{{Described{Symbol("d"), List{int32(1), nil}}, "v"}, {"k", "v"}}
+	bytes, err := Marshal(in, nil)
+	test.ErrorIf(t, err)
+	var x interface{}
+	if _, ok := unmarshalFast(bytes, &x); ok {
+		t.Errorf("%#v: decoded a map with an unhashable key", x)
+	}
+	_, err = Unmarshal(bytes, &x)
+	test.ErrorIf(t, err)
+	test.ErrorIf(t, test.Differ(in, x))
+
+	// Other described keys are fine
+	m := Map{Described{Symbol("d"), "x"}: "v", Described{uint64(1), nil}: "w"}
+	bytes, err = Marshal(m, nil)
+	test.ErrorIf(t, err)
+	_, err = Unmarshal(bytes, &x)
+	test.ErrorIf(t, err)
+	test.ErrorIf(t, test.Differ(m, x))
+}
+
 func TestBadMap(t *testing.T) {
 	// unmarshal map with invalid keys
 	in := AnyMap{{"k", "v"}, {[]string{"x", "y"}, "invalid-key"}}
@@ -186,3 +210,110 @@ func TestBadMap(t *testing.T) {
 		t.Error(err)
 	}
 }
+
+// Values that exercise the size dependent encodings as well as allValues.
+var sizedValues = []interface{}{
+	int32(127), int32(-128), int32(128), int32(-129),
+	int64(127), int64(-129), int64(1 << 40),
+	uint32(0), uint32(255), uint32(256), uint64(0), uint64(255), uint64(256),
+	strings.Repeat("x", 255), strings.Repeat("x", 256),
+	Binary(strings.Repeat("x", 256)), Symbol(strings.Repeat("x", 256)),
+	time.Time{},
+	Described{uint64(0x70), List{true, nil}},
+	List{Map{"k": List{}}, Described{Symbol("d"), nil}, uint16(1)},
+	map[string]interface{}{"key": int32(1)},
+	map[Symbol]interface{}{"key": "value"},
+	map[AnnotationKey]interface{}{AnnotationKeyUint64(1): "value"},
+}
+
+// The Go encoder must produce the same bytes as pn_data_encode()
+func TestMarshalSameBytes(t *testing.T) {
+	for _, x := range append(allValues, sizedValues...) {
+		got, err := Marshal(x, nil)
+		test.ErrorIf(t, err)
+		want, err := marshalData(x, nil)
+		test.ErrorIf(t, err)
+		if !bytes.Equal(want, got) {
+			t.Errorf("%#v: want %x, got %x", x, want, got)
+		}
+	}
+}
+
+// The Go decoder must produce the same values as unmarshalling via a pn_data_t
+func TestUnmarshalSameValues(t *testing.T) {
+	for _, x := range append(allValues, sizedValues...) {
+		bytes, err := marshalData(x, nil)
+		test.ErrorIf(t, err)
+		var got, want interface{}
+		n, ok := unmarshalFast(bytes, &got)
+		if !ok {
+			continue // Not handled by the Go decoder
+		}
+		_, err = unmarshalData(bytes, &want)
+		test.ErrorIf(t, err)
+		test.ErrorIf(t, test.Differ(want, got))
+		test.ErrorIf(t, test.Differ(len(bytes), n))
+		// Truncated data is left to the pn_data_t decoder
+		if _, ok := unmarshalFast(bytes[:len(bytes)-1], &got); ok {
+			t.Errorf("%#v: decoded truncated data", x)
+		}
+	}
+}
+
+// Malformed data is an error, not a panic
+func TestUnmarshalMalformed(t *testing.T) {
+	for _, b := range [][]byte{
+		{0xc0, 0x00, 0x00},       // list8 with a size too small for the count
+		{0xc1, 0x00, 0x00},       // map8
+		{0xc0, 0x00},             // list8 with no count
+		{0xc0, 0x01},             // list8 with no room for the count
+		{0xd0, 0, 0, 0, 0},       // list32 with a size too small for the count
+		{0xd1, 0, 0, 0, 2, 0, 0}, // map32
+	} {
+		var v interface{}
+		if _, err := Unmarshal(b, &v); err == nil {
+			t.Errorf("Unmarshal(%x): want error, got %#v", b, v)
+		}
+		if err := NewDecoder(bytes.NewReader(b)).Decode(&v); err == nil {
+			t.Errorf("Decode(%x): want error, got %#v", b, v)
+		}
+	}
+}
+
+var bmValue = map[string]interface{}{"int": int32(32), "bool": true, "string": "hello", "list": List{uint64(1), Symbol("x")}}
+
+func BenchmarkMarshal(b *testing.B) {
+	for n := 0; n < b.N; n++ {
+		if bmBuf, bmErr = Marshal(bmValue, bmBuf); bmErr != nil {
+			b.Fatal(bmErr)
+		}
+	}
+}
+
+func BenchmarkMarshalData(b *testing.B) {
+	for n := 0; n < b.N; n++ {
+		if bmBuf, bmErr = marshalData(bmValue, bmBuf); bmErr != nil {
+			b.Fatal(bmErr)
+		}
+	}
+}
+
+func BenchmarkUnmarshal(b *testing.B) {
+	bytes, _ := Marshal(bmValue, nil)
+	var v interface{}
+	for n := 0; n < b.N; n++ {
+		if _, bmErr = Unmarshal(bytes, &v); bmErr != nil {
+			b.Fatal(bmErr)
+		}
+	}
+}
+
+func BenchmarkUnmarshalData(b *testing.B) {
+	bytes, _ := Marshal(bmValue, nil)
+	var v interface{}
+	for n := 0; n < b.N; n++ {
+		if _, bmErr = unmarshalData(bytes, &v); bmErr != nil {
+			b.Fatal(bmErr)
+		}
+	}
+}
@@ -352,6 +352,14 @@ func (mc *MessageCodec) Close() {
 }
 
 func (mc *MessageCodec) Decode(m Message, data []byte) error {
+	if m.(*message).decode(data) {
+		return nil
+	}
+	return mc.decodeData(m, data)
+}
+
+// decodeData decodes via the pn_message_t, for messages that message.decode() can't handle.
+func (mc *MessageCodec) decodeData(m Message, data []byte) error {
 	pn := mc.pnMessage()
 	if C.pn_message_decode(pn, cPtr(data), cLen(data)) < 0 {
 		return fmt.Errorf("decoding message: %s", PnError(C.pn_message_error(pn)))
@@ -375,6 +383,14 @@ func DecodeMessage(data []byte) (m Message, err error) {
 // Encode m using buffer. Return the final buffer used to hold m,
 // may be different if the initial buffer was not large enough.
 func (mc *MessageCodec) Encode(m Message, buffer []byte) ([]byte, error) {
+	if b, ok := m.(*message).encode(buffer[:0]); ok {
+		return b, nil
+	}
+	return mc.encodeData(m, buffer)
+}
+
+// encodeData encodes via the pn_message_t, for messages that message.encode() can't handle.
+func (mc *MessageCodec) encodeData(m Message, buffer []byte) ([]byte, error) {
 	pn := mc.pnMessage()
 	m.(*message).put(pn)
 	encode := func(buf []byte) ([]byte, error) {
@@ -559,6 +575,232 @@ func (m *message) put(pn *C.pn_message_t) {
 	putData(m.body, C.pn_message_body(pn))
 }
 
+// ==== encode and decode without a pn_message_t
+
+// Section descriptors
+const (
+	header                = 0x70
+	deliveryAnnotations   = 0x71
+	messageAnnotations    = 0x72
+	properties            = 0x73
+	applicationProperties = 0x74
+	dataSection           = 0x75
+	amqpSequence          = 0x76
+	amqpValue             = 0x77
+	footer                = 0x78
+)
+
+// encode appends the encoded message to b, producing the same bytes as put() followed by
+// pn_message_encode(). Returns ok == false if a field holds a value that needs marshal().
+func (m *message) encode(b []byte) ([]byte, bool) {
+	var ok bool
+	var f [13]interface{}
+	if m.durable {
+		f[0] = true
+	}
+	if m.priority != 4 {
+		f[1] = m.priority
+	}
+	if ttl := uint32(m.ttl / time.Millisecond); ttl != 0 {
+		f[2] = ttl
+	}
+	if m.firstAcquirer {
+		f[3] = true
+	}
+	if m.deliveryCount != 0 {
+		f[4] = m.deliveryCount
+	}
+	b, _ = appendSection(b, header, f[:5])
+
+	if len(m.deliveryAnnotations) != 0 {
+		if b, ok = appendValue(append(b, codeDescribed, codeSmallUlong, deliveryAnnotations), m.deliveryAnnotations); !ok {
+			return b, false
+		}
+	}
+	if len(m.messageAnnotations) != 0 {
+		if b, ok = appendValue(append(b, codeDescribed, codeSmallUlong, messageAnnotations), m.messageAnnotations); !ok {
+			return b, false
+		}
+	}
+
+	f = [13]interface{}{m.messageId, nil, nil, nil, nil, m.correlationId}
+	setString := func(i int, s string) {
+		if s != "" {
+			f[i] = s
+		}
+	}
+	if m.userId != "" {
+		f[1] = Binary(m.userId)
+	}
+	setString(2, m.address)
+	setString(3, m.subject)
+	setString(4, m.replyTo)
+	if m.contentType != "" {
+		f[6] = Symbol(m.contentType)
+	}
+	if m.contentEncoding != "" {
+		f[7] = Symbol(m.contentEncoding)
+	}
+	if !m.expiryTime.IsZero() {
+		f[8] = m.expiryTime
+	}
+	if !m.creationTime.IsZero() {
+		f[9] = m.creationTime
+	}
+	setString(10, m.groupId)
+	if m.groupId != "" || m.groupSequence != 0 {
+		f[11] = uint32(m.groupSequence)
+	}
+	setString(12, m.replyToGroupId)
+	if b, ok = appendSection(b, properties, f[:]); !ok {
+		return b, false
+	}
+
+	if len(m.applicationProperties) != 0 {
+		if b, ok = appendValue(append(b, codeDescribed, codeSmallUlong, applicationProperties), m.applicationProperties); !ok {
+			return b, false
+		}
+	}
+	if m.body != nil {
+		descriptor := byte(amqpValue)
+		if m.inferred {
+			switch m.body.(type) {
+			case Binary, []byte:
+				descriptor = dataSection
+			case List, []interface{}:
+				descriptor = amqpSequence
+			}
+		}
+		return appendValue(append(b, codeDescribed, codeSmallUlong, descriptor), m.body)
+	}
+	return b, true
+}
+
+// appendSection appends a section that is a described list of fields.
+// Trailing null fields are omitted.
+func appendSection(b []byte, descriptor byte, fields []interface{}) ([]byte, bool) {
+	for len(fields) > 0 && fields[len(fields)-1] == nil {
+		fields = fields[:len(fields)-1]
+	}
+	return appendList(append(b, codeDescribed, codeSmallUlong, descriptor), fields)
+}
+
+// decode sets m from an encoded message, with the same results as pn_message_decode()
+// followed by get(). Returns false if the message needs the pn_message_t decoder.
+func (m *message) decode(b []byte) bool {
+	m.Clear()
+	for len(b) > 0 {
+		x, n, ok := decodeValue(b)
+		if !ok {
+			return false
+		}
+		b = b[n:]
+		section, ok := x.(Described)
+		if !ok {
+			return false
+		}
+		descriptor, ok := section.Descriptor.(uint64)
+		if !ok {
+			return false
+		}
+		switch descriptor {
+		case header:
+			f, ok := section.Value.(List)
+			if !ok {
+				return false
+			}
+			m.durable, _ = field(f, 0).(bool)
+			if p, ok := field(f, 1).(uint8); ok {
+				m.priority = p
+			}
+			ttl, _ := field(f, 2).(uint32)
+			m.ttl = time.Duration(ttl) * time.Millisecond
+			m.firstAcquirer, _ = field(f, 3).(bool)
+			m.deliveryCount, _ = field(f, 4).(uint32)
+
+		case properties:
+			f, ok := section.Value.(List)
+			if !ok {
+				return false
+			}
+			m.messageId = field(f, 0)
+			userId, _ := field(f, 1).(Binary)
+			m.userId = string(userId)
+			m.address, _ = field(f, 2).(string)
+			m.subject, _ = field(f, 3).(string)
+			m.replyTo, _ = field(f, 4).(string)
+			m.correlationId = field(f, 5)
+			contentType, _ := field(f, 6).(Symbol)
+			m.contentType = string(contentType)
+			contentEncoding, _ := field(f, 7).(Symbol)
+			m.contentEncoding = string(contentEncoding)
+			m.expiryTime, _ = field(f, 8).(time.Time)
+			m.creationTime, _ = field(f, 9).(time.Time)
+			m.groupId, _ = field(f, 10).(string)
+			groupSequence, _ := field(f, 11).(uint32)
+			m.groupSequence = int32(groupSequence)
+			m.replyToGroupId, _ = field(f, 12).(string)
+
+		case deliveryAnnotations, messageAnnotations:
+			in, ok := section.Value.(Map)
+			if !ok {
+				return false
+			}
+			out := make(map[AnnotationKey]interface{}, len(in))
+			for k, v := range in {
+				switch k.(type) {
+				case uint64, Symbol, string:
+					out[AnnotationKey{k}] = v
+				default:
+					return false
+				}
+			}
+			if descriptor == deliveryAnnotations {
+				m.deliveryAnnotations = out
+			} else {
+				m.messageAnnotations = out
+			}
+
+		case applicationProperties:
+			in, ok := section.Value.(Map)
+			if !ok {
+				return false
+			}
+			m.applicationProperties = make(map[string]interface{}, len(in))
+			for k, v := range in {
+				switch k := k.(type) {
+				case string:
+					m.applicationProperties[k] = v
+				case Symbol:
+					m.applicationProperties[string(k)] = v
+				case Binary:
+					m.applicationProperties[string(k)] = v
+				default:
+					return false
+				}
+			}
+
+		case dataSection, amqpSequence, amqpValue:
+			m.inferred = descriptor != amqpValue
+			m.body = section.Value
+
+		case footer:
+
+		default:
+			return false
+		}
+	}
+	return true
+}
+
+// field returns f[i] or nil if the list is too short.
+func field(f List, i int) interface{} {
+	if i < len(f) {
+		return f[i]
+	}
+	return nil
+}
+
 // ==== Deprecated functions
 
 func oldAnnotations(in map[AnnotationKey]interface{}) (out map[string]interface{}) {
@@ -20,6 +20,7 @@ under the License.
 package amqp
 
 import (
+	"bytes"
 	"reflect"
 	"testing"
 	"time"
@@ -245,9 +246,59 @@ func TestMessageBodyTypes(t *testing.T) {
 	// TODO aconway 2015-09-08: array etc.
 }
 
+// Messages covering the optional fields and body sections
+func sameBytesMessages() []Message {
+	var msgs []Message
+	add := func(body interface{}, set func(m Message)) {
+		m := NewMessageWith(body)
+		set(m)
+		msgs = append(msgs, m)
+	}
+	add(nil, func(m Message) {})
+	add("hello", func(m Message) { setMessageProperties(m) })
+	add(Binary("data"), func(m Message) { m.SetInferred(true) })
+	add(List{"a", int32(1)}, func(m Message) { m.SetInferred(true) })
+	add(List{"a", int32(1)}, func(m Message) { m.SetFirstAcquirer(true) })
+	add(int64(42), func(m Message) {
+		m.SetTTL(time.Second)
+		m.SetDeliveryCount(3)
+		m.SetExpiryTime(timeValue)
+		m.SetCreationTime(timeValue)
+		m.SetGroupSequence(7)
+	})
+	add(Map{"k": "v"}, func(m Message) {
+		m.SetMessageId(uint64(42))
+		m.SetCorrelationId(UUID{1, 2, 3})
+		m.SetReplyToGroupId("group")
+	})
+	return msgs
+}
+
+// The Go message encoder and decoder must agree with pn_message_t
+func TestMessageSameBytes(t *testing.T) {
+	var mc MessageCodec
+	defer mc.Close()
+	for _, m := range sameBytesMessages() {
+		got, err := mc.Encode(m, nil)
+		test.ErrorIf(t, err)
+		want, err := mc.encodeData(m, nil)
+		test.ErrorIf(t, err)
+		if !bytes.Equal(want, got) {
+			t.Errorf("%v: want %x, got %x", m, want, got)
+		}
+		m1, m2 := NewMessage(), NewMessage()
+		if !m1.(*message).decode(want) {
+			t.Errorf("%v: not decoded", m)
+		}
+		test.ErrorIf(t, mc.decodeData(m2, want))
+		test.ErrorIf(t, test.Differ(m2, m1))
+	}
+}
+
 // Benchmarks assign to package-scope variables to prevent being optimized out.
 var bmM Message
 var bmBuf []byte
+var bmErr error
 
 func BenchmarkNewMessageEmpty(b *testing.B) {
 	for n := 0; n < b.N; n++ {
@@ -294,3 +345,34 @@ func BenchmarkDecode(b *testing.B) {
 		bmM = m
 	}
 }
+
+func BenchmarkEncodeData(b *testing.B) {
+	var mc MessageCodec
+	defer mc.Close()
+	m := setMessageProperties(NewMessageWith("hello"))
+	b.ResetTimer()
+	for n := 0; n < b.N; n++ {
+		buf, err := mc.encodeData(m, nil)
+		if err != nil {
+			b.Fatal(err)
+		}
+		bmBuf = buf
+	}
+}
+
+func BenchmarkDecodeData(b *testing.B) {
+	var mc MessageCodec
+	defer mc.Close()
+	buf, err := setMessageProperties(NewMessageWith("hello")).Encode(nil)
+	if err != nil {
+		b.Fatal(err)
+	}
+	m := NewMessage()
+	b.ResetTimer()
+	for n := 0; n < b.N; n++ {
+		if err := mc.decodeData(m, buf); err != nil {
+			b.Fatal(err)
+		}
+		bmM = m
+	}
+}
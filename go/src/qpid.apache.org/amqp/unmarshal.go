@@ -128,6 +128,10 @@ func (d *Decoder) Buffered() io.Reader {
 // See the documentation for Unmarshal for details about the conversion of AMQP into a Go value.
 //
 func (d *Decoder) Decode(v interface{}) (err error) {
+	if n, ok := unmarshalFast(d.buffer.Bytes(), v); ok {
+		d.buffer.Next(n)
+		return nil
+	}
 	data := C.pn_data(0)
 	defer C.pn_data_free(data)
 	var n int
@@ -243,6 +247,14 @@ channel, array (use slice), struct
 AMQP types not yet supported: decimal32/64/128
 */
 func Unmarshal(bytes []byte, v interface{}) (n int, err error) {
+	if n, ok := unmarshalFast(bytes, v); ok {
+		return n, nil
+	}
+	return unmarshalData(bytes, v)
+}
+
+// unmarshalData unmarshals via a pn_data_t, for cases that unmarshalFast() can't handle.
+func unmarshalData(bytes []byte, v interface{}) (n int, err error) {
 	data := C.pn_data(0)
 	defer C.pn_data_free(data)
 	n, err = decode(data, bytes)
@@ -663,7 +675,7 @@ func getMap(data *C.pn_data_t, v interface{}) {
 	for i := 0; i < n; i++ {
 		data.next(v)
 		unmarshal(keyPtr.Interface(), data)
-		if keyType.Kind() == reflect.Interface && !keyPtr.Elem().Elem().Type().Comparable() {
+		if !hashable(keyPtr.Elem().Interface()) {
 			doPanicMsg(data, v, fmt.Sprintf("key %#v is not comparable", keyPtr.Elem().Interface()))
 		}
 		data.next(v)
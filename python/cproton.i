@@ -474,4 +474,396 @@ int pn_ssl_get_cert_fingerprint(pn_ssl_t *ssl, char *OUTPUT, size_t MAX_OUTPUT_S
 
 %}
 
+/*
+ * Bulk conversion between pn_data_t trees and Python objects.
+ *
+ * Converting a message section with proton.Data makes several wrapped calls
+ * per AMQP value. These helpers walk the whole tree in C instead. The Python
+ * classes for AMQP types that have no native Python equivalent are registered
+ * by proton._data with pn_data_pytypes().
+ */
+%{
+/* Order of the classes in the tuple passed to pn_data_pytypes() */
+enum {
+  PNI_PY_ULONG, PNI_PY_TIMESTAMP, PNI_PY_SYMBOL, PNI_PY_CHAR,
+  PNI_PY_BYTE, PNI_PY_SHORT, PNI_PY_INT32,
+  PNI_PY_UBYTE, PNI_PY_USHORT, PNI_PY_UINT,
+  PNI_PY_FLOAT32, PNI_PY_DECIMAL32, PNI_PY_DECIMAL64, PNI_PY_DECIMAL128,
+  PNI_PY_DESCRIBED, PNI_PY_ARRAY, PNI_PY_UNDESCRIBED, PNI_PY_UUID,
+  PNI_PY_TYPES
+};
+
+static PyObject *pni_pytypes = NULL;
+
+#define PNI_PYTYPE(i) PyTuple_GET_ITEM(pni_pytypes, (i))
+
+PyObject *pn_data_pytypes(PyObject *types) {
+  if (!PyTuple_Check(types) || PyTuple_GET_SIZE(types) != PNI_PY_TYPES) {
+    PyErr_SetString(PyExc_ValueError, "pn_data_pytypes: wrong number of types");
+    return NULL;
+  }
+  Py_INCREF(types);
+  Py_XDECREF(pni_pytypes);
+  pni_pytypes = types;
+  Py_RETURN_NONE;
+}
+
+/* Call a registered class with a single argument, steals the argument */
+static PyObject *pni_pynew(int type, PyObject *arg) {
+  PyObject *result = NULL;
+  if (arg) {
+    result = PyObject_CallFunctionObjArgs(PNI_PYTYPE(type), arg, NULL);
+    Py_DECREF(arg);
+  }
+  return result;
+}
+
+static PyObject *pni_data_get_py(pn_data_t *data);
+
+/* Get the next child of an entered node, None if there is none */
+static PyObject *pni_data_next_py(pn_data_t *data) {
+  if (pn_data_next(data)) {
+    return pni_data_get_py(data);
+  }
+  Py_RETURN_NONE;
+}
+
+/* Append the remaining children of an entered node to list */
+static PyObject *pni_data_append_py(pn_data_t *data, PyObject *list) {
+  while (list && pn_data_next(data)) {
+    PyObject *item = pni_data_get_py(data);
+    if (!item || PyList_Append(list, item)) {
+      Py_CLEAR(list);
+    }
+    Py_XDECREF(item);
+  }
+  return list;
+}
+
+static PyObject *pni_data_get_pymap(pn_data_t *data) {
+  PyObject *dict = PyDict_New();
+  while (dict && pn_data_next(data)) {
+    PyObject *key = pni_data_get_py(data);
+    PyObject *value = key ? pni_data_next_py(data) : NULL;
+    if (!value || PyDict_SetItem(dict, key, value)) {
+      Py_CLEAR(dict);
+    }
+    Py_XDECREF(key);
+    Py_XDECREF(value);
+  }
+  return dict;
+}
+
+static PyObject *pni_data_get_pyarray(pn_data_t *data) {
+  pn_type_t type = pn_data_get_array_type(data);
+  bool described = pn_data_is_array_described(data);
+  PyObject *args, *result = NULL;
+  if ((int) type == -1) {
+    Py_RETURN_NONE;
+  }
+  args = PyList_New(2);
+  if (!args) return NULL;
+  pn_data_enter(data);
+  if (described) {
+    PyList_SET_ITEM(args, 0, pni_data_next_py(data));
+  } else {
+    Py_INCREF(PNI_PYTYPE(PNI_PY_UNDESCRIBED));
+    PyList_SET_ITEM(args, 0, PNI_PYTYPE(PNI_PY_UNDESCRIBED));
+  }
+  PyList_SET_ITEM(args, 1, PyInt_FromLong(type));
+  if (PyList_GET_ITEM(args, 0) && PyList_GET_ITEM(args, 1) && pni_data_append_py(data, args)) {
+    PyObject *tuple = PyList_AsTuple(args);
+    if (tuple) {
+      result = PyObject_CallObject(PNI_PYTYPE(PNI_PY_ARRAY), tuple);
+      Py_DECREF(tuple);
+    }
+  }
+  pn_data_exit(data);
+  Py_DECREF(args);
+  return result;
+}
+
+/* Convert the current node, mapping types the same way as Data.get_object() */
+static PyObject *pni_data_get_py(pn_data_t *data) {
+  switch (pn_data_type(data)) {
+  case PN_NULL: Py_RETURN_NONE;
+  case PN_BOOL: return PyBool_FromLong(pn_data_get_bool(data));
+  case PN_UBYTE: return pni_pynew(PNI_PY_UBYTE, PyInt_FromLong(pn_data_get_ubyte(data)));
+  case PN_BYTE: return pni_pynew(PNI_PY_BYTE, PyInt_FromLong(pn_data_get_byte(data)));
+  case PN_USHORT: return pni_pynew(PNI_PY_USHORT, PyInt_FromLong(pn_data_get_ushort(data)));
+  case PN_SHORT: return pni_pynew(PNI_PY_SHORT, PyInt_FromLong(pn_data_get_short(data)));
+  case PN_UINT: return pni_pynew(PNI_PY_UINT, PyLong_FromUnsignedLong(pn_data_get_uint(data)));
+  case PN_INT: return pni_pynew(PNI_PY_INT32, PyInt_FromLong(pn_data_get_int(data)));
+  case PN_CHAR: return pni_pynew(PNI_PY_CHAR, PyUnicode_FromOrdinal(pn_data_get_char(data)));
+  case PN_ULONG: return pni_pynew(PNI_PY_ULONG, PyLong_FromUnsignedLongLong(pn_data_get_ulong(data)));
+  case PN_LONG: return PyLong_FromLongLong(pn_data_get_long(data));
+  case PN_TIMESTAMP: return pni_pynew(PNI_PY_TIMESTAMP, PyLong_FromLongLong(pn_data_get_timestamp(data)));
+  case PN_FLOAT: return pni_pynew(PNI_PY_FLOAT32, PyFloat_FromDouble(pn_data_get_float(data)));
+  case PN_DOUBLE: return PyFloat_FromDouble(pn_data_get_double(data));
+  case PN_DECIMAL32: return pni_pynew(PNI_PY_DECIMAL32, PyLong_FromUnsignedLong(pn_data_get_decimal32(data)));
+  case PN_DECIMAL64: return pni_pynew(PNI_PY_DECIMAL64, PyLong_FromUnsignedLongLong(pn_data_get_decimal64(data)));
+  case PN_DECIMAL128: {
+    pn_decimal128_t d = pn_data_get_decimal128(data);
+    return pni_pynew(PNI_PY_DECIMAL128, PyBytes_FromStringAndSize(d.bytes, 16));
+  }
+  case PN_UUID: {
+    pn_uuid_t u = pn_data_get_uuid(data);
+    PyObject *args = PyTuple_New(0);
+    PyObject *kwargs = Py_BuildValue("{s:N}", "bytes", PyBytes_FromStringAndSize(u.bytes, 16));
+    PyObject *result = (args && kwargs) ? PyObject_Call(PNI_PYTYPE(PNI_PY_UUID), args, kwargs) : NULL;
+    Py_XDECREF(args);
+    Py_XDECREF(kwargs);
+    return result;
+  }
+  case PN_BINARY: {
+    pn_bytes_t b = pn_data_get_binary(data);
+    return PyBytes_FromStringAndSize(b.start, b.size);
+  }
+  case PN_STRING: {
+    pn_bytes_t s = pn_data_get_string(data);
+    return PyUnicode_DecodeUTF8(s.start, s.size, NULL);
+  }
+  case PN_SYMBOL: {
+    pn_bytes_t s = pn_data_get_symbol(data);
+    return pni_pynew(PNI_PY_SYMBOL, PyUnicode_DecodeASCII(s.start, s.size, NULL));
+  }
+  case PN_DESCRIBED: {
+    PyObject *descriptor, *value, *result = NULL;
+    pn_data_enter(data);
+    descriptor = pni_data_next_py(data);
+    value = descriptor ? pni_data_next_py(data) : NULL;
+    pn_data_exit(data);
+    if (value) {
+      result = PyObject_CallFunctionObjArgs(PNI_PYTYPE(PNI_PY_DESCRIBED), descriptor, value, NULL);
+    }
+    Py_XDECREF(descriptor);
+    Py_XDECREF(value);
+    return result;
+  }
+  case PN_ARRAY: return pni_data_get_pyarray(data);
+  case PN_LIST: {
+    PyObject *list;
+    pn_data_enter(data);
+    list = pni_data_append_py(data, PyList_New(0));
+    pn_data_exit(data);
+    return list;
+  }
+  case PN_MAP: {
+    PyObject *dict;
+    pn_data_enter(data);
+    dict = pni_data_get_pymap(data);
+    pn_data_exit(data);
+    return dict;
+  }
+  default: Py_RETURN_NONE;
+  }
+}
+
+/* Put a Python integer if it is in [min, max], PN_OVERFLOW otherwise */
+#define PNI_PUT_INT(data, put, obj, min, max) do {                     \
+    PY_LONG_LONG v = PyLong_AsLongLong(obj);                           \
+    if ((v == -1 && PyErr_Occurred()) || v < (min) || v > (max)) {     \
+      return PN_OVERFLOW;                                              \
+    }                                                                  \
+    return put(data, v);                                               \
+  } while (0)
+
+/*
+ * Put obj, mapping types the same way as Data.put_object().
+ * Returns non-zero for values the caller must put with Data.put_object(),
+ * either because they are unusual or because they are invalid. Data.put_object()
+ * then raises the appropriate exception.
+ */
+static int pni_data_put_py(pn_data_t *data, PyObject *obj) {
+  PyObject *type = (PyObject *) Py_TYPE(obj);
+  int err = 0;
+  if (obj == Py_None) {
+    return pn_data_put_null(data);
+  } else if (PyBool_Check(obj)) {
+    return pn_data_put_bool(data, obj == Py_True);
+  } else if (PyLong_CheckExact(obj)) {
+    PNI_PUT_INT(data, pn_data_put_long, obj, INT64_MIN, INT64_MAX);
+#if PY_MAJOR_VERSION < 3
+  } else if (PyInt_CheckExact(obj)) {
+    PNI_PUT_INT(data, pn_data_put_int, obj, INT32_MIN, INT32_MAX);
+#endif
+  } else if (PyFloat_CheckExact(obj)) {
+    return pn_data_put_double(data, PyFloat_AS_DOUBLE(obj));
+  } else if (PyBytes_CheckExact(obj)) {
+    return pn_data_put_binary(data, pn_bytes(PyBytes_GET_SIZE(obj), PyBytes_AS_STRING(obj)));
+  } else if (PyUnicode_CheckExact(obj)) {
+    PyObject *utf8 = PyUnicode_AsUTF8String(obj);
+    if (!utf8) return PN_ERR;
+    err = pn_data_put_string(data, pn_bytes(PyBytes_GET_SIZE(utf8), PyBytes_AS_STRING(utf8)));
+    Py_DECREF(utf8);
+    return err;
+  } else if (PyList_CheckExact(obj) || PyTuple_CheckExact(obj)) {
+    PyObject *seq = PySequence_Fast(obj, "");
+    Py_ssize_t i, n = seq ? PySequence_Fast_GET_SIZE(seq) : 0;
+    if (!seq) return PN_ERR;
+    pn_data_put_list(data);
+    pn_data_enter(data);
+    for (i = 0; i < n && !err; ++i) {
+      err = pni_data_put_py(data, PySequence_Fast_GET_ITEM(seq, i));
+    }
+    pn_data_exit(data);
+    Py_DECREF(seq);
+    return err;
+  } else if (PyDict_CheckExact(obj)) {
+    PyObject *key, *value;
+    Py_ssize_t pos = 0;
+    pn_data_put_map(data);
+    pn_data_enter(data);
+    while (!err && PyDict_Next(obj, &pos, &key, &value)) {
+      err = pni_data_put_py(data, key);
+      if (!err) err = pni_data_put_py(data, value);
+    }
+    pn_data_exit(data);
+    return err;
+  } else if (!pni_pytypes) {
+    return PN_ERR;
+  } else if (type == PNI_PYTYPE(PNI_PY_SYMBOL)) {
+    PyObject *ascii = PyUnicode_AsASCIIString(obj);
+    if (!ascii) return PN_ERR;
+    err = pn_data_put_symbol(data, pn_bytes(PyBytes_GET_SIZE(ascii), PyBytes_AS_STRING(ascii)));
+    Py_DECREF(ascii);
+    return err;
+  } else if (type == PNI_PYTYPE(PNI_PY_ULONG)) {
+    unsigned PY_LONG_LONG v = PyLong_AsUnsignedLongLong(obj);
+    if (v == (unsigned PY_LONG_LONG) -1 && PyErr_Occurred()) return PN_OVERFLOW;
+    return pn_data_put_ulong(data, v);
+  } else if (type == PNI_PYTYPE(PNI_PY_UINT)) {
+    PNI_PUT_INT(data, pn_data_put_uint, obj, 0, UINT32_MAX);
+  } else if (type == PNI_PYTYPE(PNI_PY_USHORT)) {
+    PNI_PUT_INT(data, pn_data_put_ushort, obj, 0, UINT16_MAX);
+  } else if (type == PNI_PYTYPE(PNI_PY_UBYTE)) {
+    PNI_PUT_INT(data, pn_data_put_ubyte, obj, 0, UINT8_MAX);
+  } else if (type == PNI_PYTYPE(PNI_PY_INT32)) {
+    PNI_PUT_INT(data, pn_data_put_int, obj, INT32_MIN, INT32_MAX);
+  } else if (type == PNI_PYTYPE(PNI_PY_SHORT)) {
+    PNI_PUT_INT(data, pn_data_put_short, obj, INT16_MIN, INT16_MAX);
+  } else if (type == PNI_PYTYPE(PNI_PY_BYTE)) {
+    PNI_PUT_INT(data, pn_data_put_byte, obj, INT8_MIN, INT8_MAX);
+  } else if (type == PNI_PYTYPE(PNI_PY_TIMESTAMP)) {
+    PNI_PUT_INT(data, pn_data_put_timestamp, obj, INT64_MIN, INT64_MAX);
+  } else if (type == PNI_PYTYPE(PNI_PY_FLOAT32)) {
+    return pn_data_put_float(data, (float) PyFloat_AS_DOUBLE(obj));
+  } else if (type == PNI_PYTYPE(PNI_PY_UUID)) {
+    PyObject *bytes = PyObject_GetAttrString(obj, "bytes");
+    if (!bytes || !PyBytes_Check(bytes) || PyBytes_GET_SIZE(bytes) != 16) {
+      err = PN_ERR;
+    } else {
+      pn_uuid_t u;
+      memcpy(u.bytes, PyBytes_AS_STRING(bytes), 16);
+      err = pn_data_put_uuid(data, u);
+    }
+    Py_XDECREF(bytes);
+    return err;
+  } else if (type == PNI_PYTYPE(PNI_PY_DESCRIBED)) {
+    PyObject *descriptor = PyObject_GetAttrString(obj, "descriptor");
+    PyObject *value = descriptor ? PyObject_GetAttrString(obj, "value") : NULL;
+    if (value) {
+      pn_data_put_described(data);
+      pn_data_enter(data);
+      err = pni_data_put_py(data, descriptor);
+      if (!err) err = pni_data_put_py(data, value);
+      pn_data_exit(data);
+    } else {
+      err = PN_ERR;
+    }
+    Py_XDECREF(descriptor);
+    Py_XDECREF(value);
+    return err;
+  }
+  /* char, decimals, arrays, memoryview and anything Data.put_object() doesn't know */
+  return PN_ARG_ERR;
+}
+
+PyObject *pn_data_get_pyobject(pn_data_t *data) {
+  if (!pni_pytypes) {
+    PyErr_SetString(PyExc_RuntimeError, "pn_data_pytypes has not been called");
+    return NULL;
+  }
+  return pni_data_get_py(data);
+}
+
+int pn_data_put_pyobject(pn_data_t *data, PyObject *obj) {
+  int err = pni_data_put_py(data, obj);
+  if (err) PyErr_Clear();
+  return err;
+}
+
+/*
+ * Get the instructions, annotations, properties and body of msg as a tuple.
+ * Sections that are not present are None.
+ */
+PyObject *pn_message_get_pysections(pn_message_t *msg) {
+  pn_data_t *sections[4];
+  PyObject *result;
+  int i;
+  if (!pni_pytypes) {
+    PyErr_SetString(PyExc_RuntimeError, "pn_data_pytypes has not been called");
+    return NULL;
+  }
+  sections[0] = pn_message_instructions(msg);
+  sections[1] = pn_message_annotations(msg);
+  sections[2] = pn_message_properties(msg);
+  sections[3] = pn_message_body(msg);
+  result = PyTuple_New(4);
+  for (i = 0; result && i < 4; ++i) {
+    PyObject *section;
+    pn_data_rewind(sections[i]);
+    section = pni_data_next_py(sections[i]);
+    pn_data_rewind(sections[i]);
+    if (!section) {
+      Py_CLEAR(result);
+    } else {
+      PyTuple_SET_ITEM(result, i, section);
+    }
+  }
+  return result;
+}
+
+/*
+ * Set the instructions, annotations, properties and body of msg, None clears a section.
+ * Returns non-zero if a section must be set with Data.put_object() instead.
+ */
+int pn_message_set_pysections(pn_message_t *msg, PyObject *instructions, PyObject *annotations,
+                              PyObject *properties, PyObject *body)
+{
+  pn_data_t *sections[4];
+  PyObject *values[4];
+  int i, err = 0;
+  sections[0] = pn_message_instructions(msg);
+  sections[1] = pn_message_annotations(msg);
+  sections[2] = pn_message_properties(msg);
+  sections[3] = pn_message_body(msg);
+  values[0] = instructions;
+  values[1] = annotations;
+  values[2] = properties;
+  values[3] = body;
+  for (i = 0; i < 4 && !err; ++i) {
+    pn_data_clear(sections[i]);
+    if (values[i] != Py_None) {
+      err = pn_data_put_pyobject(sections[i], values[i]);
+    }
+  }
+  return err;
+}
+%}
+
+/* These only touch Python objects, keep the GIL held */
+%nothread pn_data_pytypes;
+%nothread pn_data_get_pyobject;
+%nothread pn_data_put_pyobject;
+%nothread pn_message_get_pysections;
+%nothread pn_message_set_pysections;
+
+PyObject *pn_data_pytypes(PyObject *types);
+PyObject *pn_data_get_pyobject(pn_data_t *data);
+int pn_data_put_pyobject(pn_data_t *data, PyObject *obj);
+PyObject *pn_message_get_pysections(pn_message_t *msg);
+int pn_message_set_pysections(pn_message_t *msg, PyObject *instructions, PyObject *annotations,
+                              PyObject *properties, PyObject *body);
+
 %include "proton/cproton.i"
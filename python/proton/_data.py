@@ -39,7 +39,7 @@ from cproton import PN_TIMESTAMP, PN_FLOAT, PN_DESCRIBED, PN_DECIMAL64, PN_UBYTE
     pn_data_get_int, pn_data_get_list, pn_data_get_ulong, pn_data_put_ubyte, \
     pn_data_format, pn_data_dump, pn_data_get_uuid, pn_data_get_decimal32, \
     pn_data_put_binary, pn_data_get_timestamp, pn_data_decode, pn_data_next, pn_data_put_null, pn_data_put_long, \
-    pn_error_text
+    pn_data_pytypes, pn_error_text
 
 from ._common import Constant
 from ._exceptions import EXCEPTIONS, DataException
@@ -1127,3 +1127,8 @@ def obj2dat(obj, dimpl):
     if obj is not None:
         d = Data(dimpl)
         d.put_object(obj)
+
+
+# Classes used by the C conversion of message sections, see cproton.i
+pn_data_pytypes((ulong, timestamp, symbol, char, byte, short, int32, ubyte, ushort, uint,
+                 float32, decimal32, decimal64, decimal128, Described, Array, UNDESCRIBED, uuid.UUID))
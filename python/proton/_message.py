@@ -36,6 +36,7 @@ from cproton import PN_DEFAULT_PRIORITY, PN_OVERFLOW, \
     pn_message_instructions, pn_message_get_content_type, \
     pn_message_get_reply_to_group_id, pn_message_get_ttl, pn_message_encode, pn_message_get_expiry_time, \
     pn_message_set_group_sequence, pn_message_set_inferred, \
+    pn_message_get_pysections, pn_message_set_pysections, \
     pn_inspect, pn_string, pn_string_get, pn_free, pn_error_text
 
 from . import _compat
@@ -108,6 +109,14 @@ class Message(object):
                 raise MessageException('Application property key is not string type: key=%s %s' % (str(k), type(k)))
 
     def _pre_encode(self):
+        if self.properties is not None:
+            self._check_property_keys()
+        # Sections containing types the C conversion doesn't handle go through Data
+        if pn_message_set_pysections(self._msg, self.instructions, self.annotations,
+                                     self.properties, self.body):
+            self._pre_encode_data()
+
+    def _pre_encode_data(self):
         inst = Data(pn_message_instructions(self._msg))
         ann = Data(pn_message_annotations(self._msg))
         props = Data(pn_message_properties(self._msg))
@@ -121,34 +130,14 @@ class Message(object):
             ann.put_object(self.annotations)
         props.clear()
         if self.properties is not None:
-            self._check_property_keys()
             props.put_object(self.properties)
         body.clear()
         if self.body is not None:
             body.put_object(self.body)
 
     def _post_decode(self):
-        inst = Data(pn_message_instructions(self._msg))
-        ann = Data(pn_message_annotations(self._msg))
-        props = Data(pn_message_properties(self._msg))
-        body = Data(pn_message_body(self._msg))
-
-        if inst.next():
-            self.instructions = inst.get_object()
-        else:
-            self.instructions = None
-        if ann.next():
-            self.annotations = ann.get_object()
-        else:
-            self.annotations = None
-        if props.next():
-            self.properties = props.get_object()
-        else:
-            self.properties = None
-        if body.next():
-            self.body = body.get_object()
-        else:
-            self.body = None
+        self.instructions, self.annotations, self.properties, self.body = \
+            pn_message_get_pysections(self._msg)
 
     def clear(self):
         """
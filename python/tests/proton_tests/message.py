@@ -21,6 +21,9 @@ from __future__ import absolute_import
 
 from uuid import uuid4
 
+from cproton import pn_message_encode, pn_message_decode, pn_message_instructions, pn_message_annotations, \
+    pn_message_properties, pn_message_body
+
 from proton import *
 
 from . import common
@@ -276,3 +279,94 @@ class CodecTest(Test):
     msg4 = Message()
     msg4.decode(data)
     assert msg4.priority == 4, (msg4.priority)
+
+
+class SectionsTest(Test):
+  """
+  Message sections are converted to and from Python in C, falling back to
+  proton.Data for values the C conversion doesn't handle. Both must agree.
+  """
+
+  VALUES = [None, True, False, 0, -2**63, 2**63 - 1, 1.5, b"binary", u"string", u"ሴ" * 300,
+            symbol("sym"), ulong(2**64 - 1), uint(7), ushort(65535), ubyte(255),
+            int32(-5), short(-300), byte(-128), timestamp(1234567), float32(2.5), uuid4(),
+            Described(symbol("desc"), [1, u"two"]),
+            [1, [u"a", {u"k": None}], (3, 4), []],
+            {symbol("a"): 1, u"b": [b"x"], ulong(3): {}}]
+
+  FALLBACK = [char(u"c"), decimal32(1), decimal64(2), decimal128(b"0123456789abcdef"),
+              Array(UNDESCRIBED, Data.INT, 1, 2), Array(symbol("d"), Data.STRING, u"a"),
+              [1, char(u"x")], {u"k": [decimal32(3)]}]
+
+  def _message(self, value):
+    msg = Message()
+    msg.instructions = {symbol("x-opt-i"): value}
+    msg.annotations = {symbol("x-opt-a"): value}
+    msg.properties = {u"p": value}
+    msg.body = value
+    return msg
+
+  def _data_encode(self, msg):
+    msg._pre_encode_data()
+    err, data = pn_message_encode(msg._msg, 65536)
+    msg._check(err)
+    return data
+
+  def _data_decode(self, data):
+    msg = Message()
+    msg._check(pn_message_decode(msg._msg, data))
+    sections = []
+    for section in [pn_message_instructions, pn_message_annotations, pn_message_properties, pn_message_body]:
+      d = Data(section(msg._msg))
+      sections.append(d.get_object() if d.next() else None)
+    return sections
+
+  def _decode(self, data):
+    msg = Message()
+    msg.decode(data)
+    return [msg.instructions, msg.annotations, msg.properties, msg.body]
+
+  def _same(self, a, b):
+    assert a == b and type(a) == type(b), (a, b)
+
+  def testSameBytes(self):
+    for value in self.VALUES + self.FALLBACK:
+      msg = self._message(value)
+      encoded = msg.encode()
+      self._same(encoded, self._data_encode(msg))
+      self._same(self._decode(encoded), self._data_decode(encoded))
+
+  def testFastPath(self):
+    # Both paths give the same bytes, so check which one is taken
+    for values, fallback in [(self.VALUES, False), (self.FALLBACK, True)]:
+      for value in values:
+        used = []
+        msg = self._message(value)
+        msg._pre_encode_data = lambda: used.append(True) or Message._pre_encode_data(msg)
+        encoded = msg.encode()
+        assert bool(used) == fallback, "proton.Data used=%s for %r" % (bool(used), value)
+        self._same(self._decode(encoded), self._data_decode(encoded))
+
+  def testEmpty(self):
+    self._same(self._decode(self.msg.encode()), [None, None, None, None])
+
+  def testInvalid(self):
+    for value in [2**64, ubyte(256), uint(-1), symbol(u"ሴ")]:
+      msg = self._message(value)
+      try:
+        msg.encode()
+      except (DataException, OverflowError, UnicodeError):
+        continue
+      assert False, "expected error for %r" % (value,)
+
+  def testReuse(self):
+    # Re-encoding a message must replace every section, whichever path set it before
+    msg = Message()
+    for value in [self.FALLBACK[0], self.VALUES[-1], self.FALLBACK[-1], None, self.VALUES[-2]]:
+      msg.instructions = {symbol("x-opt-i"): value}
+      msg.annotations = None
+      msg.properties = {u"p": value} if value is not None else None
+      msg.body = value
+      encoded = msg.encode()
+      self._same(encoded, self._data_encode(msg))
+      self._same(self._decode(encoded), self._data_decode(encoded))
@@ -258,6 +258,20 @@ class MessengerTests(AppTests):
         self._ssl_check()
         self._do_echo_test(MessengerReceiverC(), MessengerSenderC(), "amqps")
 
+    def test_oneway_C_large_window(self):
+        sender = MessengerSenderC()
+        sender.outgoing_window = 100000
+        self._do_oneway_test(MessengerReceiverC(), sender)
+
+    def test_echo_C_large_window(self):
+        receiver = MessengerReceiverC()
+        receiver.incoming_window = 100000
+        receiver.outgoing_window = 100000
+        sender = MessengerSenderC()
+        sender.outgoing_window = 100000
+        sender.incoming_window = 100000
+        self._do_echo_test(receiver, sender)
+
     def test_star_topology_C(self):
         self._do_star_topology_test( MessengerReceiverC, MessengerSenderC )
 
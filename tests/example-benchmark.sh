@@ -22,6 +22,11 @@ CPP=$BLD/cpp/examples
 CPP_BROKER="$CPP/broker"
 CPP_SEND="$CPP/simple_send -a /x -m $MESSAGES"
 CPP_RECV="$CPP/simple_recv -a /x -m $MESSAGES"
+# Sends from a separate thread via proton::work_queue and receives its own
+# messages, so it is run with NONE as the receiver.
+CPP_MT_SEND="$CPP/multithreaded_client //localhost x $MESSAGES"
+
+NONE=true
 
 amqp_busy() { ss -tlp | grep $* amqp; }
 
@@ -45,7 +50,7 @@ run() {
     start_broker $BROKER
     time {
         $RECV > /dev/null& RECV_PID=$!
-        $SEND
+        $SEND | tail -n1     # Only the summary, per-message output slows the run
         wait $RECV_PID
     }
     stop_broker
@@ -56,6 +61,7 @@ if test -z "$*"; then
     run C_BROKER C_SEND C_RECV
     run GO_BROKER GO_SEND GO_RECV
     run CPP_BROKER CPP_SEND CPP_RECV
+    run CPP_BROKER CPP_MT_SEND NONE
 else
     while test -n "$*"; do
         run ${1}_BROKER ${2}_SEND ${3}_RECV